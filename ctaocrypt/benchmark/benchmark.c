@@ -40,10 +40,13 @@
 #include <cyassl/ctaocrypt/sha.h>
 #include <cyassl/ctaocrypt/sha256.h>
 #include <cyassl/ctaocrypt/sha512.h>
+#include <cyassl/ctaocrypt/hmac.h>
 #include <cyassl/ctaocrypt/rsa.h>
 #include <cyassl/ctaocrypt/asn.h>
 #include <cyassl/ctaocrypt/ripemd.h>
 #include <cyassl/ctaocrypt/ecc.h>
+#include <cyassl/ctaocrypt/siphash.h>
+#include <cyassl/ctaocrypt/random.h>
 
 #include <cyassl/ctaocrypt/dh.h>
 #ifdef HAVE_CAVIUM
@@ -83,8 +86,11 @@ void bench_arc4(void);
 void bench_hc128(void);
 void bench_rabbit(void);
 void bench_aes(int);
+void bench_aesmulti(void);
+void bench_aeshmac(void);
 void bench_aesgcm(void);
 void bench_aesccm(void);
+void bench_aesctr(void);
 void bench_camellia(void);
 
 void bench_md5(void);
@@ -92,6 +98,8 @@ void bench_sha(void);
 void bench_sha256(void);
 void bench_sha512(void);
 void bench_ripemd(void);
+void bench_sessionhash(void);
+void bench_rng(void);
 
 void bench_rsa(void);
 void bench_rsaKeyGen(void);
@@ -103,6 +111,20 @@ void bench_eccKeyAgree(void);
 
 double current_time(int);
 
+#ifdef USE_INTEL_SPEEDUP
+/* TRANSFORM_* names */
+static const char* transformName[] = { "C", "SSSE3", "AVX2", "SHA-NI" };
+
+static word64 rdtsc(void)
+{
+    word32 lo, hi;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+
+    return ((word64)hi << 32) | lo;
+}
+#endif
+
 
 #ifdef HAVE_CAVIUM
 
@@ -151,6 +173,12 @@ int benchmark_test(void *args)
 #ifndef NO_AES
     bench_aes(0);
     bench_aes(1);
+#ifndef HAVE_CAVIUM
+    bench_aesmulti();
+#ifndef NO_HMAC
+    bench_aeshmac();
+#endif
+#endif
 #endif
 #ifdef HAVE_AESGCM
     bench_aesgcm();
@@ -158,6 +186,9 @@ int benchmark_test(void *args)
 #ifdef HAVE_AESCCM
     bench_aesccm();
 #endif
+#ifdef CYASSL_AES_COUNTER
+    bench_aesctr();
+#endif
 #ifdef HAVE_CAMELLIA
     bench_camellia();
 #endif
@@ -194,6 +225,8 @@ int benchmark_test(void *args)
 #ifdef HAVE_BLAKE2
     bench_blake2();
 #endif
+    bench_sessionhash();
+    bench_rng();
 
     printf("\n");
 
@@ -224,12 +257,14 @@ const char blockType[] = "kB";  /* used in printf output */
 const int times      = 1;        /* public key iterations */
 const int genTimes   = 5;
 const int agreeTimes = 5;
+const int lookups    = 10000;    /* session cache row hashes */
 #else
 const int numBlocks = 5;
 const char blockType[] = "megs";
 const int times      = 100;
 const int genTimes   = 100;
 const int agreeTimes = 100;
+const int lookups    = 1000000;
 #endif
 
 const byte key[] = 
@@ -287,11 +322,166 @@ void bench_aes(int show)
     if (show)
         printf("AES      %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
                                                   blockType, total, persec);
+
+    AesSetKey(&enc, key, 16, iv, AES_DECRYPTION);
+    start = current_time(1);
+
+    for(i = 0; i < numBlocks; i++)
+        AesCbcDecrypt(&enc, plain, cipher, sizeof(plain));
+
+    total = current_time(0) - start;
+
+    persec = 1 / total * numBlocks;
+#ifdef BENCH_EMBEDDED
+    /* since using kB, convert to MB/s */
+    persec = persec / 1024;
+#endif
+
+    if (show)
+        printf("AES dec  %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
+                                                  blockType, total, persec);
 #ifdef HAVE_CAVIUM
     AesFreeCavium(&enc);
 #endif
 }
+
+
+#ifndef HAVE_CAVIUM
+enum {
+    BENCH_RECORDS   = 8,    /* connections decrypted together */
+    BENCH_RECORD_SZ = 64    /* short records, where batching matters */
+};
+
+/* CBC decrypt of short records spread over several keys, one record at a
+   time and then BENCH_RECORDS at a time through AesCbcDecryptMulti */
+void bench_aesmulti(void)
+{
+    Aes         dec[BENCH_RECORDS];
+    Aes*        pDec[BENCH_RECORDS];
+    byte*       out[BENCH_RECORDS];
+    const byte* in[BENCH_RECORDS];
+    word32      sz[BENCH_RECORDS];
+    double      start, total, persec;
+    word32      off;
+    int         i, j;
+
+    for (j = 0; j < BENCH_RECORDS; j++) {
+        AesSetKey(&dec[j], key, 16, iv, AES_DECRYPTION);
+        pDec[j] = &dec[j];
+        sz[j]   = BENCH_RECORD_SZ;
+    }
+
+    start = current_time(1);
+
+    for(i = 0; i < numBlocks; i++)
+        for (off = 0; off < sizeof(plain); off += BENCH_RECORD_SZ)
+            AesCbcDecrypt(&dec[(off / BENCH_RECORD_SZ) % BENCH_RECORDS],
+                          plain + off, cipher + off, BENCH_RECORD_SZ);
+
+    total = current_time(0) - start;
+
+    persec = 1 / total * numBlocks;
+#ifdef BENCH_EMBEDDED
+    /* since using kB, convert to MB/s */
+    persec = persec / 1024;
+#endif
+
+    printf("AES dec  %d byte records    %d %s took %5.3f seconds, "
+           "%6.2f MB/s\n", BENCH_RECORD_SZ, numBlocks, blockType, total,
+           persec);
+
+    start = current_time(1);
+
+    for(i = 0; i < numBlocks; i++) {
+        for (off = 0; off < sizeof(plain);
+                                      off += BENCH_RECORDS * BENCH_RECORD_SZ) {
+            for (j = 0; j < BENCH_RECORDS; j++) {
+                out[j] = plain  + off + j * BENCH_RECORD_SZ;
+                in[j]  = cipher + off + j * BENCH_RECORD_SZ;
+            }
+            AesCbcDecryptMulti(pDec, out, in, sz, BENCH_RECORDS);
+        }
+    }
+
+    total = current_time(0) - start;
+
+    persec = 1 / total * numBlocks;
+#ifdef BENCH_EMBEDDED
+    /* since using kB, convert to MB/s */
+    persec = persec / 1024;
+#endif
+
+    printf("AES dec  %d byte records x%d %d %s took %5.3f seconds, "
+           "%6.2f MB/s\n", BENCH_RECORD_SZ, BENCH_RECORDS, numBlocks,
+           blockType, total, persec);
+}
+
+
+#ifndef NO_HMAC
+enum {
+    BENCH_TLS_RECORD_SZ = 16384     /* full TLS records */
+};
+
+/* HMAC then AES-CBC over full records, as the record layer does for MAC then
+   encrypt suites, run one after the other or stitched */
+static void bench_aeshmacOnce(int type, const char* label, int stitched)
+{
+    Aes    enc;
+    Hmac   hmac;
+    byte   digest[MAX_DIGEST_SIZE];
+    double start, total, persec;
+    word32 off, done;
+    int    i;
+
+    AesSetKey(&enc, key, 16, iv, AES_ENCRYPTION);
+    start = current_time(1);
+
+    for(i = 0; i < numBlocks; i++) {
+        for (off = 0; off + BENCH_TLS_RECORD_SZ <= sizeof(plain);
+                                                 off += BENCH_TLS_RECORD_SZ) {
+            HmacSetKey(&hmac, type, key, 20);
+            done = 0;
+            if (stitched)
+                HmacUpdateAesCbcEncrypt(&hmac, plain + off,
+                                BENCH_TLS_RECORD_SZ, &enc, plain + off, &done);
+            else
+                HmacUpdate(&hmac, plain + off, BENCH_TLS_RECORD_SZ);
+            HmacFinal(&hmac, digest);
+            AesCbcEncrypt(&enc, plain + off + done, plain + off + done,
+                          BENCH_TLS_RECORD_SZ - done);
+        }
+    }
+
+    total = current_time(0) - start;
+
+    persec = 1 / total * numBlocks;
+#ifdef BENCH_EMBEDDED
+    /* since using kB, convert to MB/s */
+    persec = persec / 1024;
+#endif
+
+    printf("%-22s %d %s took %5.3f seconds, %6.2f MB/s\n", label, numBlocks,
+                                                  blockType, total, persec);
+}
+
+
+void bench_aeshmac(void)
+{
+    if (sizeof(plain) < BENCH_TLS_RECORD_SZ)
+        return;
+
+#ifndef NO_SHA
+    bench_aeshmacOnce(SHA, "AES+HMAC-SHA", 0);
+    bench_aeshmacOnce(SHA, "AES+HMAC-SHA stitch", 1);
 #endif
+#ifndef NO_SHA256
+    bench_aeshmacOnce(SHA256, "AES+HMAC-SHA256", 0);
+    bench_aeshmacOnce(SHA256, "AES+HMAC-SHA256 stitch", 1);
+#endif
+}
+#endif /* NO_HMAC */
+#endif /* HAVE_CAVIUM */
+#endif /* NO_AES */
 
 
 byte additional[13];
@@ -299,17 +489,15 @@ byte tag[16];
 
 
 #ifdef HAVE_AESGCM
-void bench_aesgcm(void)
+static void bench_aesgcmEncrypt(Aes* enc, const char* label)
 {
-    Aes    enc;
     double start, total, persec;
     int    i;
 
-    AesGcmSetKey(&enc, key, 16);
     start = current_time(1);
 
     for(i = 0; i < numBlocks; i++)
-        AesGcmEncrypt(&enc, cipher, plain, sizeof(plain), iv, 12,
+        AesGcmEncrypt(enc, cipher, plain, sizeof(plain), iv, 12,
                         tag, 16, additional, 13);
 
     total = current_time(0) - start;
@@ -320,9 +508,26 @@ void bench_aesgcm(void)
     persec = persec / 1024;
 #endif
 
-    printf("AES-GCM  %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
+    printf("%s %d %s took %5.3f seconds, %6.2f MB/s\n", label, numBlocks,
                                               blockType, total, persec);
 }
+
+
+void bench_aesgcm(void)
+{
+    Aes    enc;
+
+    AesGcmSetKey(&enc, key, 16);
+    bench_aesgcmEncrypt(&enc, "AES-GCM ");
+
+#ifdef CYASSL_AESNI
+    if (enc.use_pclmul) {
+        /* same key through the block at a time path for comparison */
+        enc.use_pclmul = 0;
+        bench_aesgcmEncrypt(&enc, "AES-GCM  generic");
+    }
+#endif
+}
 #endif
 
 
@@ -354,6 +559,33 @@ void bench_aesccm(void)
 #endif
 
 
+#ifdef CYASSL_AES_COUNTER
+void bench_aesctr(void)
+{
+    Aes    enc;
+    double start, total, persec;
+    int    i;
+
+    AesSetKey(&enc, key, 16, iv, AES_ENCRYPTION);
+    start = current_time(1);
+
+    for(i = 0; i < numBlocks; i++)
+        AesCtrEncrypt(&enc, cipher, plain, sizeof(plain));
+
+    total = current_time(0) - start;
+
+    persec = 1 / total * numBlocks;
+#ifdef BENCH_EMBEDDED
+    /* since using kB, convert to MB/s */
+    persec = persec / 1024;
+#endif
+
+    printf("AES-CTR  %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
+                                              blockType, total, persec);
+}
+#endif
+
+
 #ifdef HAVE_CAMELLIA
 void bench_camellia(void)
 {
@@ -531,14 +763,20 @@ void bench_md5(void)
 
 
 #ifndef NO_SHA
-void bench_sha(void)
+static void bench_shaOnce(const char* label)
 {
     Sha    hash;
     byte   digest[SHA_DIGEST_SIZE];
     double start, total, persec;
     int    i;
-        
+#ifdef USE_INTEL_SPEEDUP
+    word64 cycles;
+#endif
+
     InitSha(&hash);
+#ifdef USE_INTEL_SPEEDUP
+    cycles = rdtsc();
+#endif
     start = current_time(1);
     
     for(i = 0; i < numBlocks; i++)
@@ -547,27 +785,61 @@ void bench_sha(void)
     ShaFinal(&hash, digest);
 
     total = current_time(0) - start;
+#ifdef USE_INTEL_SPEEDUP
+    cycles = rdtsc() - cycles;
+#endif
     persec = 1 / total * numBlocks;
 #ifdef BENCH_EMBEDDED
     /* since using kB, convert to MB/s */
     persec = persec / 1024;
 #endif
 
+#ifdef USE_INTEL_SPEEDUP
+    printf("SHA      %-7s %d %s took %5.3f seconds, %6.2f MB/s, %5.2f "
+           "cycles/byte\n", label, numBlocks, blockType, total, persec,
+           (double)cycles / (numBlocks * sizeof(plain)));
+#else
+    (void)label;
     printf("SHA      %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
                                               blockType, total, persec);
+#endif
+}
+
+
+void bench_sha(void)
+{
+#ifdef USE_INTEL_SPEEDUP
+    int best = ShaGetTransform();
+    int t;
+
+    /* each backend this cpu can run */
+    for (t = TRANSFORM_C; t <= TRANSFORM_SHANI; t++) {
+        if (ShaSetTransform(t) == 0)
+            bench_shaOnce(transformName[t]);
+    }
+    ShaSetTransform(best);
+#else
+    bench_shaOnce(NULL);
+#endif
 }
 #endif /* NO_SHA */
 
 
 #ifndef NO_SHA256
-void bench_sha256(void)
+static void bench_sha256Once(const char* label)
 {
     Sha256 hash;
     byte   digest[SHA256_DIGEST_SIZE];
     double start, total, persec;
     int    i;
-        
+#ifdef USE_INTEL_SPEEDUP
+    word64 cycles;
+#endif
+
     InitSha256(&hash);
+#ifdef USE_INTEL_SPEEDUP
+    cycles = rdtsc();
+#endif
     start = current_time(1);
     
     for(i = 0; i < numBlocks; i++)
@@ -576,14 +848,42 @@ void bench_sha256(void)
     Sha256Final(&hash, digest);
 
     total = current_time(0) - start;
+#ifdef USE_INTEL_SPEEDUP
+    cycles = rdtsc() - cycles;
+#endif
     persec = 1 / total * numBlocks;
 #ifdef BENCH_EMBEDDED
     /* since using kB, convert to MB/s */
     persec = persec / 1024;
 #endif
 
+#ifdef USE_INTEL_SPEEDUP
+    printf("SHA-256  %-7s %d %s took %5.3f seconds, %6.2f MB/s, %5.2f "
+           "cycles/byte\n", label, numBlocks, blockType, total, persec,
+           (double)cycles / (numBlocks * sizeof(plain)));
+#else
+    (void)label;
     printf("SHA-256  %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
                                               blockType, total, persec);
+#endif
+}
+
+
+void bench_sha256(void)
+{
+#ifdef USE_INTEL_SPEEDUP
+    int best = Sha256GetTransform();
+    int t;
+
+    /* each backend this cpu can run */
+    for (t = TRANSFORM_C; t <= TRANSFORM_SHANI; t++) {
+        if (Sha256SetTransform(t) == 0)
+            bench_sha256Once(transformName[t]);
+    }
+    Sha256SetTransform(best);
+#else
+    bench_sha256Once(NULL);
+#endif
 }
 #endif
 
@@ -673,6 +973,102 @@ void bench_blake2(void)
 #endif
 
 
+/* cost of picking a session cache row from a 32 byte session ID, the MD5
+   digest the cache used to take against the keyed HalfSipHash it uses now */
+void bench_sessionhash(void)
+{
+    byte   id[32];
+    double start, total;
+    word32 row = 0;
+    int    i;
+#ifndef NO_MD5
+    Md5    md5;
+    byte   digest[MD5_DIGEST_SIZE];
+
+    memcpy(id, plain, sizeof(id));
+    start = current_time(1);
+
+    for(i = 0; i < lookups; i++) {
+        id[0] = (byte)i;
+        InitMd5(&md5);
+        Md5Update(&md5, id, sizeof(id));
+        Md5Final(&md5, digest);
+        row += digest[0];
+    }
+
+    total = current_time(0) - start;
+    printf("MD5 row  %d lookups took %5.3f seconds, %6.1f ns/lookup\n",
+                                     lookups, total, total * 1e9 / lookups);
+#endif
+
+    memcpy(id, plain, sizeof(id));
+    start = current_time(1);
+
+    for(i = 0; i < lookups; i++) {
+        id[0] = (byte)i;
+        row += HalfSipHash24(key, id, sizeof(id));
+    }
+
+    total = current_time(0) - start;
+    printf("SipHash  %d lookups took %5.3f seconds, %6.1f ns/lookup\n",
+                                     lookups, total, total * 1e9 / lookups);
+    (void)row;
+}
+
+
+void bench_rng(void)
+{
+    RNG    drbg;
+    byte   out[32];
+    double start, total, persec;
+    int    i;
+
+    if (InitRng(&drbg) != 0) {
+        printf("InitRng failed\n");
+        return;
+    }
+
+    start = current_time(1);
+
+    for(i = 0; i < numBlocks; i++)
+        RNG_GenerateBlock(&drbg, cipher, sizeof(cipher));
+
+    total = current_time(0) - start;
+    persec = 1 / total * numBlocks;
+#ifdef BENCH_EMBEDDED
+    /* since using kB, convert to MB/s */
+    persec = persec / 1024;
+#endif
+
+    printf("RNG      %d %s took %5.3f seconds, %6.2f MB/s\n", numBlocks,
+                                              blockType, total, persec);
+
+    /* handshake sized draws, one per random, IV or session id */
+    start = current_time(1);
+
+    for(i = 0; i < lookups; i++)
+        RNG_GenerateBlock(&drbg, out, sizeof(out));
+
+    total = current_time(0) - start;
+    printf("RNG 32B  %d draws   took %5.3f seconds, %6.1f ns/draw\n",
+                                     lookups, total, total * 1e9 / lookups);
+
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    RNG_SetBuffered(&drbg, 1);
+    start = current_time(1);
+
+    for(i = 0; i < lookups; i++)
+        RNG_GenerateBlock(&drbg, out, sizeof(out));
+
+    total = current_time(0) - start;
+    printf("RNG buf  %d draws   took %5.3f seconds, %6.1f ns/draw\n",
+                                     lookups, total, total * 1e9 / lookups);
+
+    FreeRng(&drbg);
+#endif
+}
+
+
 #if !defined(NO_RSA) || !defined(NO_DH) \
                                 || defined(CYASSL_KEYGEN) || defined(HAVE_ECC)
 RNG rng;
@@ -768,7 +1164,21 @@ void bench_rsa(void)
     each  = total / times;   /* per second   */
     milliEach = each * 1000; /* milliseconds */
 
-    printf("RSA %d decryption took %6.2f milliseconds, avg over %d" 
+    printf("RSA %d decryption took %6.2f milliseconds, avg over %d"
+           " iterations\n", rsaKeySz, milliEach, times);
+
+    start = current_time(1);
+
+    for (i = 0; i < times; i++) {
+         byte  sig[512];  /* for up to 4096 bit */
+         RsaSSL_Sign(message, len, sig, sizeof(sig), &rsaKey, &rng);
+    }
+
+    total = current_time(0) - start;
+    each  = total / times;   /* per second   */
+    milliEach = each * 1000; /* milliseconds */
+
+    printf("RSA %d sign (blinded) took %6.2f milliseconds, avg over %d"
            " iterations\n", rsaKeySz, milliEach, times);
 
     FreeRsaKey(&rsaKey);
@@ -918,35 +1328,82 @@ void bench_rsaKeyGen(void)
 #endif /* CYASSL_KEY_GEN */
 
 #ifdef HAVE_ECC 
-void bench_eccKeyGen(void)
+#ifdef HAVE_ECC_P256
+/* ecc.c only sends the built in P-256 set to the dedicated code, a copy of
+   the params runs the generic code so the two can be compared */
+static ecc_set_type genericP256;
+
+static const ecc_set_type* bench_eccGenericSet(void)
+{
+    ecc_key tmpKey;
+
+    ecc_init(&tmpKey);
+    if (ecc_make_key(&rng, 32, &tmpKey) != 0)
+        return NULL;
+
+    genericP256 = *tmpKey.dp;
+    ecc_free(&tmpKey);
+
+    return &genericP256;
+}
+#endif
+
+
+/* dp NULL for the default P-256 key */
+static int bench_eccMakeKey(ecc_key* eccKey, const ecc_set_type* dp)
+{
+    if (dp == NULL)
+        return ecc_make_key(&rng, 32, eccKey);
+    return ecc_make_key_ex(&rng, eccKey, dp);
+}
+
+
+static void bench_eccKeyGenSet(const ecc_set_type* dp)
 {
     ecc_key genKey;
     double start, total, each, milliEach;
-    int    i, ret;
-  
-    ret = InitRng(&rng);
-    if (ret < 0) {
-        printf("InitRNG failed\n");
-        return;
-    }
+    int    i;
+
     /* 256 bit */ 
     start = current_time(1);
 
     for(i = 0; i < genTimes; i++) {
-        ecc_make_key(&rng, 32, &genKey);
+        bench_eccMakeKey(&genKey, dp);
         ecc_free(&genKey);
     }
 
     total = current_time(0) - start;
     each  = total / genTimes;  /* per second  */
     milliEach = each * 1000;   /* millisconds */
+    printf("%s %6.2f milliseconds, avg over %d iterations\n",
+           dp ? "ECC  256 generic key gen" : "ECC  256 key generation ",
+           milliEach, genTimes);
+}
+
+
+void bench_eccKeyGen(void)
+{
+    int ret;
+#ifdef HAVE_ECC_P256
+    const ecc_set_type* dp;
+#endif
+  
+    ret = InitRng(&rng);
+    if (ret < 0) {
+        printf("InitRNG failed\n");
+        return;
+    }
+
     printf("\n");
-    printf("ECC  256 key generation  %6.2f milliseconds, avg over %d" 
-           " iterations\n", milliEach, genTimes);
+    bench_eccKeyGenSet(NULL);
+#ifdef HAVE_ECC_P256
+    if ((dp = bench_eccGenericSet()) != NULL)
+        bench_eccKeyGenSet(dp);
+#endif
 }
 
 
-void bench_eccKeyAgree(void)
+static void bench_eccKeyAgreeSet(const ecc_set_type* dp)
 {
     ecc_key genKey, genKey2;
     double start, total, each, milliEach;
@@ -959,18 +1416,12 @@ void bench_eccKeyAgree(void)
     ecc_init(&genKey);
     ecc_init(&genKey2);
 
-    ret = InitRng(&rng);
-    if (ret < 0) {
-        printf("InitRNG failed\n");
-        return;
-    }
-
-    ret = ecc_make_key(&rng, 32, &genKey);
+    ret = bench_eccMakeKey(&genKey, dp);
     if (ret != 0) {
         printf("ecc_make_key failed\n");
         return;
     }
-    ret = ecc_make_key(&rng, 32, &genKey2);
+    ret = bench_eccMakeKey(&genKey2, dp);
     if (ret != 0) {
         printf("ecc_make_key failed\n");
         return;
@@ -991,8 +1442,9 @@ void bench_eccKeyAgree(void)
     total = current_time(0) - start;
     each  = total / agreeTimes;  /* per second  */
     milliEach = each * 1000;   /* millisconds */
-    printf("EC-DHE   key agreement   %6.2f milliseconds, avg over %d" 
-           " iterations\n", milliEach, agreeTimes);
+    printf("%s %6.2f milliseconds, avg over %d iterations\n",
+           dp ? "EC-DHE   generic agree  " : "EC-DHE   key agreement  ",
+           milliEach, agreeTimes);
 
     /* make dummy digest */
     for (i = 0; i < (int)sizeof(digest); i++)
@@ -1013,8 +1465,9 @@ void bench_eccKeyAgree(void)
     total = current_time(0) - start;
     each  = total / agreeTimes;  /* per second  */
     milliEach = each * 1000;   /* millisconds */
-    printf("EC-DSA   sign   time     %6.2f milliseconds, avg over %d" 
-           " iterations\n", milliEach, agreeTimes);
+    printf("%s %6.2f milliseconds, avg over %d iterations\n",
+           dp ? "EC-DSA   generic sign   " : "EC-DSA   sign   time    ",
+           milliEach, agreeTimes);
 
     start = current_time(1);
 
@@ -1030,12 +1483,34 @@ void bench_eccKeyAgree(void)
     total = current_time(0) - start;
     each  = total / agreeTimes;  /* per second  */
     milliEach = each * 1000;     /* millisconds */
-    printf("EC-DSA   verify time     %6.2f milliseconds, avg over %d" 
-           " iterations\n", milliEach, agreeTimes);
+    printf("%s %6.2f milliseconds, avg over %d iterations\n",
+           dp ? "EC-DSA   generic verify " : "EC-DSA   verify time    ",
+           milliEach, agreeTimes);
 
     ecc_free(&genKey2);
     ecc_free(&genKey);
 }
+
+
+void bench_eccKeyAgree(void)
+{
+    int ret;
+#ifdef HAVE_ECC_P256
+    const ecc_set_type* dp;
+#endif
+
+    ret = InitRng(&rng);
+    if (ret < 0) {
+        printf("InitRNG failed\n");
+        return;
+    }
+
+    bench_eccKeyAgreeSet(NULL);
+#ifdef HAVE_ECC_P256
+    if ((dp = bench_eccGenericSet()) != NULL)
+        bench_eccKeyAgreeSet(dp);
+#endif
+}
 #endif /* HAVE_ECC */
 
 
@@ -1268,23 +1268,25 @@ static int Check_CPU_support_AES(void)
     return 0;
 }
 
+
+static int Check_CPU_support_PCLMUL(void)
+{
+    unsigned int a,b,c,d;
+    cpuid(1,a,b,c,d);
+
+    if (c & 0x2)
+        return 1;
+
+    return 0;
+}
+
 static int checkAESNI = 0;
 static int haveAESNI  = 0;
+static int havePCLMUL = 0;
 
 
 /* tell C compiler these are asm functions in case any mix up of ABI underscore
    prefix between clang/gcc/llvm etc */
-void AES_CBC_encrypt(const unsigned char* in, unsigned char* out,
-                     unsigned char* ivec, unsigned long length,
-                     const unsigned char* KS, int nr)
-                     asm ("AES_CBC_encrypt");
-
-
-void AES_CBC_decrypt(const unsigned char* in, unsigned char* out,
-                     unsigned char* ivec, unsigned long length,
-                     const unsigned char* KS, int nr)
-                     asm ("AES_CBC_decrypt");
-
 void AES_ECB_encrypt(const unsigned char* in, unsigned char* out,
                      unsigned long length, const unsigned char* KS, int nr)
                      asm ("AES_ECB_encrypt");
@@ -1373,6 +1375,307 @@ static int AES_set_decrypt_key(const unsigned char* userKey, const int bits,
 }
 
 
+/* Single block and interleaved multi block AES-NI encryption for the modes
+ * that go through the intrinsics instead of aes_asm.s. aesenc has a latency
+ * of several cycles but can start a new block every cycle, so independent
+ * blocks are worked on round by round. */
+
+enum {
+    AES_NI_BLOCKS = 8     /* blocks in flight for the parallel modes */
+};
+
+static INLINE __m128i AesNiEncryptBlock(const Aes* aes, __m128i b)
+{
+    const __m128i* KEY = (const __m128i*)aes->key;
+    int nr = (int)aes->rounds;
+    int r;
+
+    b = _mm_xor_si128(b, KEY[0]);
+    for (r = 1; r < nr; r++)
+        b = _mm_aesenc_si128(b, KEY[r]);
+
+    return _mm_aesenclast_si128(b, KEY[nr]);
+}
+
+
+/* two independent blocks, such as a CBC-MAC chain and a counter block */
+static INLINE void AesNiEncrypt2(const Aes* aes, __m128i* a, __m128i* b)
+{
+    const __m128i* KEY = (const __m128i*)aes->key;
+    int nr = (int)aes->rounds;
+    int r;
+    __m128i x = _mm_xor_si128(*a, KEY[0]);
+    __m128i y = _mm_xor_si128(*b, KEY[0]);
+
+    for (r = 1; r < nr; r++) {
+        x = _mm_aesenc_si128(x, KEY[r]);
+        y = _mm_aesenc_si128(y, KEY[r]);
+    }
+    *a = _mm_aesenclast_si128(x, KEY[nr]);
+    *b = _mm_aesenclast_si128(y, KEY[nr]);
+}
+
+
+#define AES_NI_ROUND_8(op, rk) do {       \
+        __m128i k_ = (rk);                \
+        b0 = op(b0, k_);                  \
+        b1 = op(b1, k_);                  \
+        b2 = op(b2, k_);                  \
+        b3 = op(b3, k_);                  \
+        b4 = op(b4, k_);                  \
+        b5 = op(b5, k_);                  \
+        b6 = op(b6, k_);                  \
+        b7 = op(b7, k_);                  \
+    } while (0)
+
+#define AES_NI_ENC_8(rk)     AES_NI_ROUND_8(_mm_aesenc_si128, rk)
+#define AES_NI_ENCLAST_8(rk) AES_NI_ROUND_8(_mm_aesenclast_si128, rk)
+#define AES_NI_DEC_8(rk)     AES_NI_ROUND_8(_mm_aesdec_si128, rk)
+#define AES_NI_DECLAST_8(rk) AES_NI_ROUND_8(_mm_aesdeclast_si128, rk)
+
+
+#define AES_NI_LOAD(p, j) \
+    _mm_loadu_si128((const __m128i*)((p) + (j) * AES_BLOCK_SIZE))
+#define AES_NI_STORE(p, j, b) \
+    _mm_storeu_si128((__m128i*)((p) + (j) * AES_BLOCK_SIZE), b)
+
+/* out = in xor E(K, ctr) for eight counter blocks, in may equal out */
+static INLINE void AesNiCtr8(const Aes* aes, const byte* ctr, const byte* in,
+                             byte* out)
+{
+    const __m128i* KEY = (const __m128i*)aes->key;
+    int nr = (int)aes->rounds;
+    int r;
+    __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+    b0 = _mm_xor_si128(AES_NI_LOAD(ctr, 0), KEY[0]);
+    b1 = _mm_xor_si128(AES_NI_LOAD(ctr, 1), KEY[0]);
+    b2 = _mm_xor_si128(AES_NI_LOAD(ctr, 2), KEY[0]);
+    b3 = _mm_xor_si128(AES_NI_LOAD(ctr, 3), KEY[0]);
+    b4 = _mm_xor_si128(AES_NI_LOAD(ctr, 4), KEY[0]);
+    b5 = _mm_xor_si128(AES_NI_LOAD(ctr, 5), KEY[0]);
+    b6 = _mm_xor_si128(AES_NI_LOAD(ctr, 6), KEY[0]);
+    b7 = _mm_xor_si128(AES_NI_LOAD(ctr, 7), KEY[0]);
+
+    for (r = 1; r < nr; r++)
+        AES_NI_ENC_8(KEY[r]);
+    AES_NI_ENCLAST_8(KEY[nr]);
+
+    AES_NI_STORE(out, 0, _mm_xor_si128(b0, AES_NI_LOAD(in, 0)));
+    AES_NI_STORE(out, 1, _mm_xor_si128(b1, AES_NI_LOAD(in, 1)));
+    AES_NI_STORE(out, 2, _mm_xor_si128(b2, AES_NI_LOAD(in, 2)));
+    AES_NI_STORE(out, 3, _mm_xor_si128(b3, AES_NI_LOAD(in, 3)));
+    AES_NI_STORE(out, 4, _mm_xor_si128(b4, AES_NI_LOAD(in, 4)));
+    AES_NI_STORE(out, 5, _mm_xor_si128(b5, AES_NI_LOAD(in, 5)));
+    AES_NI_STORE(out, 6, _mm_xor_si128(b6, AES_NI_LOAD(in, 6)));
+    AES_NI_STORE(out, 7, _mm_xor_si128(b7, AES_NI_LOAD(in, 7)));
+}
+
+
+
+/* CBC decrypt of eight blocks, returns the last cipher text block as the
+ * next iv. The chaining xor only needs the previous cipher text block, so
+ * the outputs are written last to first and each cipher text block is read
+ * before anything can overwrite it, in may equal out. */
+static INLINE __m128i AesNiCbcDecrypt8(const Aes* aes, __m128i iv,
+                                       const byte* in, byte* out)
+{
+    const __m128i* KEY = (const __m128i*)aes->key;
+    int nr = (int)aes->rounds;
+    int r;
+    __m128i b0, b1, b2, b3, b4, b5, b6, b7, last;
+
+    b0 = _mm_xor_si128(AES_NI_LOAD(in, 0), KEY[0]);
+    b1 = _mm_xor_si128(AES_NI_LOAD(in, 1), KEY[0]);
+    b2 = _mm_xor_si128(AES_NI_LOAD(in, 2), KEY[0]);
+    b3 = _mm_xor_si128(AES_NI_LOAD(in, 3), KEY[0]);
+    b4 = _mm_xor_si128(AES_NI_LOAD(in, 4), KEY[0]);
+    b5 = _mm_xor_si128(AES_NI_LOAD(in, 5), KEY[0]);
+    b6 = _mm_xor_si128(AES_NI_LOAD(in, 6), KEY[0]);
+    b7 = _mm_xor_si128(AES_NI_LOAD(in, 7), KEY[0]);
+
+    for (r = 1; r < nr; r++)
+        AES_NI_DEC_8(KEY[r]);
+    AES_NI_DECLAST_8(KEY[nr]);
+
+    last = AES_NI_LOAD(in, 7);
+    AES_NI_STORE(out, 7, _mm_xor_si128(b7, AES_NI_LOAD(in, 6)));
+    AES_NI_STORE(out, 6, _mm_xor_si128(b6, AES_NI_LOAD(in, 5)));
+    AES_NI_STORE(out, 5, _mm_xor_si128(b5, AES_NI_LOAD(in, 4)));
+    AES_NI_STORE(out, 4, _mm_xor_si128(b4, AES_NI_LOAD(in, 3)));
+    AES_NI_STORE(out, 3, _mm_xor_si128(b3, AES_NI_LOAD(in, 2)));
+    AES_NI_STORE(out, 2, _mm_xor_si128(b2, AES_NI_LOAD(in, 1)));
+    AES_NI_STORE(out, 1, _mm_xor_si128(b1, AES_NI_LOAD(in, 0)));
+    AES_NI_STORE(out, 0, _mm_xor_si128(b0, iv));
+
+    return last;
+}
+
+
+/* CBC encrypt is serial, unaligned buffers are fine so no bounce copy */
+static void AesNiCbcEncrypt(Aes* aes, byte* out, const byte* in, word32 blocks)
+{
+    __m128i iv = _mm_loadu_si128((const __m128i*)aes->reg);
+
+    while (blocks--) {
+        iv = AesNiEncryptBlock(aes, _mm_xor_si128(AES_NI_LOAD(in, 0), iv));
+        AES_NI_STORE(out, 0, iv);
+
+        in  += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+
+    _mm_storeu_si128((__m128i*)aes->reg, iv);
+}
+
+
+/* CBC decrypt with eight blocks in flight, the tail one block at a time */
+static void AesNiCbcDecrypt(Aes* aes, byte* out, const byte* in, word32 blocks)
+{
+    const __m128i* KEY = (const __m128i*)aes->key;
+    int nr = (int)aes->rounds;
+    int r;
+    __m128i iv = _mm_loadu_si128((const __m128i*)aes->reg);
+    __m128i b, c;
+
+    while (blocks >= AES_NI_BLOCKS) {
+        iv = AesNiCbcDecrypt8(aes, iv, in, out);
+
+        in     += AES_NI_BLOCKS * AES_BLOCK_SIZE;
+        out    += AES_NI_BLOCKS * AES_BLOCK_SIZE;
+        blocks -= AES_NI_BLOCKS;
+    }
+    while (blocks--) {
+        c = AES_NI_LOAD(in, 0);
+        b = _mm_xor_si128(c, KEY[0]);
+        for (r = 1; r < nr; r++)
+            b = _mm_aesdec_si128(b, KEY[r]);
+        AES_NI_STORE(out, 0, _mm_aesdeclast_si128(b,
+                                                  _mm_xor_si128(KEY[nr], iv)));
+        iv = c;
+
+        in  += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+
+    _mm_storeu_si128((__m128i*)aes->reg, iv);
+}
+
+
+#define AES_NI_LANE_LOAD(j)                                                 \
+    b##j = _mm_loadu_si128((const __m128i*)(p[j] + off));                   \
+    lastKey[j] = _mm_xor_si128(key[j][nr], iv[j]);                          \
+    iv[j] = b##j;                                                           \
+    b##j = _mm_xor_si128(b##j, key[j][0])
+
+#define AES_NI_LANE_STORE(j)                                                \
+    _mm_storeu_si128((__m128i*)(o[j] + off),                                \
+                     _mm_aesdeclast_si128(b##j, lastKey[j]))
+
+#define AES_NI_LANES_DEC_8(r) do {          \
+        b0 = _mm_aesdec_si128(b0, key[0][r]); \
+        b1 = _mm_aesdec_si128(b1, key[1][r]); \
+        b2 = _mm_aesdec_si128(b2, key[2][r]); \
+        b3 = _mm_aesdec_si128(b3, key[3][r]); \
+        b4 = _mm_aesdec_si128(b4, key[4][r]); \
+        b5 = _mm_aesdec_si128(b5, key[5][r]); \
+        b6 = _mm_aesdec_si128(b6, key[6][r]); \
+        b7 = _mm_aesdec_si128(b7, key[7][r]); \
+    } while (0)
+
+/* One lane per buffer of AesCbcDecryptMulti, only the buffers whose keys
+ * have nr rounds. While eight buffers are live each pass takes a block from
+ * every lane, each with its own key schedule, so separate short records keep
+ * the AES unit as busy as one long one. Lanes are refilled as buffers run
+ * out and the last few finish on their own. The chaining xor is folded into
+ * the last round key, aesdeclast ends with that xor anyway. */
+static void AesNiCbcDecryptLanes(Aes** aes, byte** out, const byte** in,
+                                 const word32* sz, word32 count, int nr)
+{
+    const __m128i* key[AES_NI_BLOCKS];
+    __m128i        iv[AES_NI_BLOCKS], lastKey[AES_NI_BLOCKS];
+    byte*          o[AES_NI_BLOCKS];
+    const byte*    p[AES_NI_BLOCKS];
+    word32         left[AES_NI_BLOCKS];
+    word32         job[AES_NI_BLOCKS];
+    word32         next = 0;
+    word32         steps, off;
+    int            lanes = 0;
+    int            j, r;
+    __m128i        b0, b1, b2, b3, b4, b5, b6, b7;
+
+    for (;;) {
+        /* retire finished lanes, then refill with waiting buffers */
+        for (j = 0; j < lanes; j++) {
+            if (left[j] == 0) {
+                _mm_storeu_si128((__m128i*)aes[job[j]]->reg, iv[j]);
+                lanes--;
+                job[j]  = job[lanes];
+                key[j]  = key[lanes];
+                iv[j]   = iv[lanes];
+                o[j]    = o[lanes];
+                p[j]    = p[lanes];
+                left[j] = left[lanes];
+                j--;
+            }
+        }
+        while (lanes < AES_NI_BLOCKS && next < count) {
+            if (sz[next] >= AES_BLOCK_SIZE && (int)aes[next]->rounds == nr) {
+                job[lanes]  = next;
+                key[lanes]  = (const __m128i*)aes[next]->key;
+                iv[lanes]   = _mm_loadu_si128((const __m128i*)aes[next]->reg);
+                o[lanes]    = out[next];
+                p[lanes]    = in[next];
+                left[lanes] = sz[next] / AES_BLOCK_SIZE;
+                lanes++;
+            }
+            next++;
+        }
+        if (lanes < AES_NI_BLOCKS)
+            break;
+
+        /* run all eight until the shortest is done */
+        steps = left[0];
+        for (j = 1; j < AES_NI_BLOCKS; j++)
+            if (left[j] < steps)
+                steps = left[j];
+
+        for (off = 0; off < steps * AES_BLOCK_SIZE; off += AES_BLOCK_SIZE) {
+            AES_NI_LANE_LOAD(0);
+            AES_NI_LANE_LOAD(1);
+            AES_NI_LANE_LOAD(2);
+            AES_NI_LANE_LOAD(3);
+            AES_NI_LANE_LOAD(4);
+            AES_NI_LANE_LOAD(5);
+            AES_NI_LANE_LOAD(6);
+            AES_NI_LANE_LOAD(7);
+
+            for (r = 1; r < nr; r++)
+                AES_NI_LANES_DEC_8(r);
+
+            AES_NI_LANE_STORE(0);
+            AES_NI_LANE_STORE(1);
+            AES_NI_LANE_STORE(2);
+            AES_NI_LANE_STORE(3);
+            AES_NI_LANE_STORE(4);
+            AES_NI_LANE_STORE(5);
+            AES_NI_LANE_STORE(6);
+            AES_NI_LANE_STORE(7);
+        }
+
+        for (j = 0; j < AES_NI_BLOCKS; j++) {
+            p[j]    += steps * AES_BLOCK_SIZE;
+            o[j]    += steps * AES_BLOCK_SIZE;
+            left[j] -= steps;
+        }
+    }
+
+    /* fewer than eight left, finish each on its own */
+    for (j = 0; j < lanes; j++) {
+        _mm_storeu_si128((__m128i*)aes[job[j]]->reg, iv[j]);
+        AesNiCbcDecrypt(aes[job[j]], o[j], p[j], left[j]);
+    }
+}
 
 #endif /* CYASSL_AESNI */
 
@@ -1526,6 +1829,7 @@ int AesSetKey(Aes* aes, const byte* userKey, word32 keylen, const byte* iv,
 #ifdef CYASSL_AESNI
     if (checkAESNI == 0) {
         haveAESNI  = Check_CPU_support_AES();
+        havePCLMUL = Check_CPU_support_PCLMUL();
         checkAESNI = 1;
     }
     if (haveAESNI) {
@@ -1904,31 +2208,7 @@ int AesCbcEncrypt(Aes* aes, byte* out, const byte* in, word32 sz)
             printf("sz = %d\n", sz);
         #endif
 
-        /* check alignment, decrypt doesn't need alignment */
-        if ((word)in % 16) {
-        #ifndef NO_CYASSL_ALLOC_ALIGN
-            byte* tmp = (byte*)XMALLOC(sz, NULL, DYNAMIC_TYPE_TMP_BUFFER);
-            if (tmp == NULL) return MEMORY_E;
-
-            XMEMCPY(tmp, in, sz);
-            AES_CBC_encrypt(tmp, tmp, (byte*)aes->reg, sz, (byte*)aes->key,
-                        aes->rounds);
-            /* store iv for next call */
-            XMEMCPY(aes->reg, tmp + sz - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
-
-            XMEMCPY(out, tmp, sz);
-            XFREE(tmp, NULL, DYNAMIC_TYPE_TMP_BUFFER);
-            return 0;
-        #else
-            return BAD_ALIGN_E;
-        #endif
-        }
-
-        AES_CBC_encrypt(in, out, (byte*)aes->reg, sz, (byte*)aes->key,
-                        aes->rounds);
-        /* store iv for next call */
-        XMEMCPY(aes->reg, out + sz - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
-
+        AesNiCbcEncrypt(aes, out, in, blocks);
         return 0;
     }
 #endif
@@ -1967,12 +2247,7 @@ int AesCbcDecrypt(Aes* aes, byte* out, const byte* in, word32 sz)
             printf("sz = %d\n", sz);
         #endif
 
-        /* if input and output same will overwrite input iv */
-        XMEMCPY(aes->tmp, in + sz - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
-        AES_CBC_decrypt(in, out, (byte*)aes->reg, sz, (byte*)aes->key,
-                        aes->rounds);
-        /* store iv for next call */
-        XMEMCPY(aes->reg, aes->tmp, AES_BLOCK_SIZE);
+        AesNiCbcDecrypt(aes, out, in, blocks);
         return 0;
     }
 #endif
@@ -2012,11 +2287,11 @@ void AesDecryptDirect(Aes* aes, byte* out, const byte* in)
 
 #if defined(CYASSL_AES_DIRECT) || defined(CYASSL_AES_COUNTER)
 
-/* AES-CTR and AES-DIRECT need to use this for key setup, no aesni yet */
+/* AES-CTR and AES-DIRECT need to use this for key setup, picks up AES-NI */
 int AesSetKeyDirect(Aes* aes, const byte* userKey, word32 keylen,
                     const byte* iv, int dir)
 {
-    return AesSetKeyLocal(aes, userKey, keylen, iv, dir);
+    return AesSetKey(aes, userKey, keylen, iv, dir);
 }
 
 #endif /* CYASSL_AES_DIRECT || CYASSL_AES_COUNTER */
@@ -2041,10 +2316,41 @@ void AesCtrEncrypt(Aes* aes, byte* out, const byte* in, word32 sz)
 {
     word32 blocks = sz / AES_BLOCK_SIZE;
 
+#ifdef CYASSL_AESNI
+    if (haveAESNI && aes->use_aesni) {
+        ALIGN16 byte ctr[AES_NI_BLOCKS * AES_BLOCK_SIZE];
+        int i;
+
+        while (blocks >= AES_NI_BLOCKS) {
+            for (i = 0; i < AES_NI_BLOCKS; i++) {
+                XMEMCPY(ctr + i * AES_BLOCK_SIZE, aes->reg, AES_BLOCK_SIZE);
+                IncrementAesCounter((byte*)aes->reg);
+            }
+            AesNiCtr8(aes, ctr, in, out);
+
+            out    += AES_NI_BLOCKS * AES_BLOCK_SIZE;
+            in     += AES_NI_BLOCKS * AES_BLOCK_SIZE;
+            blocks -= AES_NI_BLOCKS;
+        }
+        while (blocks--) {
+            __m128i b = AesNiEncryptBlock(aes,
+                                _mm_loadu_si128((const __m128i*)aes->reg));
+            IncrementAesCounter((byte*)aes->reg);
+            AES_NI_STORE(out, 0, _mm_xor_si128(b, AES_NI_LOAD(in, 0)));
+
+            out += AES_BLOCK_SIZE;
+            in  += AES_BLOCK_SIZE;
+        }
+        return;
+    }
+#endif /* CYASSL_AESNI */
+
     while (blocks--) {
-        AesEncrypt(aes, (byte*)aes->reg, out);
+        /* key stream through tmp so in may equal out */
+        AesEncrypt(aes, (byte*)aes->reg, (byte*)aes->tmp);
         IncrementAesCounter((byte*)aes->reg);
-        xorbuf(out, in, AES_BLOCK_SIZE);
+        xorbuf((byte*)aes->tmp, in, AES_BLOCK_SIZE);
+        XMEMCPY(out, aes->tmp, AES_BLOCK_SIZE);
 
         out += AES_BLOCK_SIZE;
         in  += AES_BLOCK_SIZE; 
@@ -2159,6 +2465,346 @@ static void GenerateM0(Aes* aes)
 #endif /* GCM_TABLE */
 
 
+#ifdef CYASSL_AESNI
+
+/* AES-NI GCM, used when the CPU also has PCLMULQDQ. Blocks are kept byte
+ * reversed in the xmm registers so the carry-less products line up with the
+ * GHASH bit order (Gueron and Kounavis, "Intel Carry-Less Multiplication
+ * Instruction and its Usage for Computing the GCM Mode"). Eight counter
+ * blocks are in flight per pass and the GHASH of eight blocks is summed
+ * against H^8..H^1 before a single reduction, stitched in between the AES
+ * rounds of the next eight. */
+
+#include <tmmintrin.h>
+
+#define GCM_NI_BSWAP _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, \
+                                  13, 14, 15)
+
+
+/* lo:mid:hi += a * b, without the reduction */
+static INLINE void GcmNiMulAcc(__m128i a, __m128i b, __m128i* lo,
+                               __m128i* mid, __m128i* hi)
+{
+    *lo  = _mm_xor_si128(*lo,  _mm_clmulepi64_si128(a, b, 0x00));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, b, 0x01));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(a, b, 0x10));
+    *hi  = _mm_xor_si128(*hi,  _mm_clmulepi64_si128(a, b, 0x11));
+}
+
+
+static INLINE __m128i GcmNiReduce(__m128i lo, __m128i mid, __m128i hi)
+{
+    __m128i t2, t3, t4, t5, t6, t7, t8, t9;
+
+    t3 = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    t6 = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    /* shift the 256 bit product left one bit for the reflected order */
+    t7 = _mm_srli_epi32(t3, 31);
+    t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+    t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+
+    return _mm_xor_si128(t6, t3);
+}
+
+
+static INLINE __m128i GcmNiMul(__m128i a, __m128i b)
+{
+    __m128i lo  = _mm_setzero_si128();
+    __m128i mid = _mm_setzero_si128();
+    __m128i hi  = _mm_setzero_si128();
+
+    GcmNiMulAcc(a, b, &lo, &mid, &hi);
+
+    return GcmNiReduce(lo, mid, hi);
+}
+
+
+static INLINE __m128i GcmNiLoad(const byte* in)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in), GCM_NI_BSWAP);
+}
+
+
+/* precompute H^1..H^8 for the aggregated GHASH */
+static void GcmNiSetKey(Aes* aes)
+{
+    __m128i H = GcmNiLoad(aes->H);
+    __m128i P = H;
+    int i;
+
+    _mm_storeu_si128((__m128i*)aes->Hp[0], H);
+    for (i = 1; i < AES_NI_BLOCKS; i++) {
+        P = GcmNiMul(P, H);
+        _mm_storeu_si128((__m128i*)aes->Hp[i], P);
+    }
+}
+
+
+/* fold sz bytes of in into the GHASH state X, last block zero padded */
+static __m128i GcmNiGhash(const Aes* aes, __m128i X, const byte* in, word32 sz)
+{
+    const __m128i H = _mm_loadu_si128((const __m128i*)aes->Hp[0]);
+    __m128i lo, mid, hi;
+    int j;
+
+    while (sz >= AES_NI_BLOCKS * AES_BLOCK_SIZE) {
+        lo = mid = hi = _mm_setzero_si128();
+        X  = _mm_xor_si128(X, GcmNiLoad(in));
+        GcmNiMulAcc(X, _mm_loadu_si128((const __m128i*)aes->Hp[7]),
+                    &lo, &mid, &hi);
+        for (j = 1; j < AES_NI_BLOCKS; j++)
+            GcmNiMulAcc(GcmNiLoad(in + j * AES_BLOCK_SIZE),
+                        _mm_loadu_si128((const __m128i*)aes->Hp[7 - j]),
+                        &lo, &mid, &hi);
+        X = GcmNiReduce(lo, mid, hi);
+
+        in += AES_NI_BLOCKS * AES_BLOCK_SIZE;
+        sz -= AES_NI_BLOCKS * AES_BLOCK_SIZE;
+    }
+    while (sz >= AES_BLOCK_SIZE) {
+        X = GcmNiMul(_mm_xor_si128(X, GcmNiLoad(in)), H);
+        in += AES_BLOCK_SIZE;
+        sz -= AES_BLOCK_SIZE;
+    }
+    if (sz != 0) {
+        byte scratch[AES_BLOCK_SIZE];
+
+        XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+        XMEMCPY(scratch, in, sz);
+        X = GcmNiMul(_mm_xor_si128(X, GcmNiLoad(scratch)), H);
+    }
+
+    return X;
+}
+
+
+#define GCM_NI_GHASH_STEP(j)                                                \
+    GcmNiMulAcc(GcmNiLoad(c + (j) * AES_BLOCK_SIZE),                        \
+                _mm_loadu_si128((const __m128i*)aes->Hp[7 - (j)]),          \
+                &lo, &mid, &hi)
+
+#define GCM_NI_CTR(b, n)                                                    \
+    b = _mm_xor_si128(_mm_shuffle_epi8(_mm_add_epi32(Y,                     \
+                      _mm_set_epi32(0, 0, 0, n)), GCM_NI_BSWAP), KEY[0])
+
+#define GCM_NI_XOR_OUT(b, j) \
+    AES_NI_STORE(out, j, _mm_xor_si128(b, AES_NI_LOAD(in, j)))
+
+/* CTR encrypt the eight blocks after counter Y from in to out. If c isn't
+ * NULL the eight cipher text blocks there are folded into X between the AES
+ * rounds. c is read before out is written so it may be in == out. */
+static INLINE __m128i GcmNiCtr8(const Aes* aes, __m128i Y, __m128i X,
+                                const byte* c, const byte* in, byte* out)
+{
+    const __m128i* KEY = (const __m128i*)aes->key;
+    int nr = (int)aes->rounds;
+    int r = 1;
+    __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+    GCM_NI_CTR(b0, 1);
+    GCM_NI_CTR(b1, 2);
+    GCM_NI_CTR(b2, 3);
+    GCM_NI_CTR(b3, 4);
+    GCM_NI_CTR(b4, 5);
+    GCM_NI_CTR(b5, 6);
+    GCM_NI_CTR(b6, 7);
+    GCM_NI_CTR(b7, 8);
+
+    if (c != NULL) {
+        __m128i lo  = _mm_setzero_si128();
+        __m128i mid = _mm_setzero_si128();
+        __m128i hi  = _mm_setzero_si128();
+
+        GcmNiMulAcc(_mm_xor_si128(X, GcmNiLoad(c)),
+                    _mm_loadu_si128((const __m128i*)aes->Hp[7]),
+                    &lo, &mid, &hi);
+        AES_NI_ENC_8(KEY[1]);
+        GCM_NI_GHASH_STEP(1);
+        AES_NI_ENC_8(KEY[2]);
+        GCM_NI_GHASH_STEP(2);
+        AES_NI_ENC_8(KEY[3]);
+        GCM_NI_GHASH_STEP(3);
+        AES_NI_ENC_8(KEY[4]);
+        GCM_NI_GHASH_STEP(4);
+        AES_NI_ENC_8(KEY[5]);
+        GCM_NI_GHASH_STEP(5);
+        AES_NI_ENC_8(KEY[6]);
+        GCM_NI_GHASH_STEP(6);
+        AES_NI_ENC_8(KEY[7]);
+        GCM_NI_GHASH_STEP(7);
+        AES_NI_ENC_8(KEY[8]);
+        X = GcmNiReduce(lo, mid, hi);
+        r = 9;
+    }
+    for (; r < nr; r++)
+        AES_NI_ENC_8(KEY[r]);
+
+    AES_NI_ENCLAST_8(KEY[nr]);
+
+    GCM_NI_XOR_OUT(b0, 0);
+    GCM_NI_XOR_OUT(b1, 1);
+    GCM_NI_XOR_OUT(b2, 2);
+    GCM_NI_XOR_OUT(b3, 3);
+    GCM_NI_XOR_OUT(b4, 4);
+    GCM_NI_XOR_OUT(b5, 5);
+    GCM_NI_XOR_OUT(b6, 6);
+    GCM_NI_XOR_OUT(b7, 7);
+
+    return X;
+}
+
+
+/* fold in the lengths and produce E(K,Y0) xor GHASH */
+static INLINE void GcmNiTag(const Aes* aes, __m128i X, __m128i EKY0,
+                            word32 aSz, word32 cSz, byte* s)
+{
+    const __m128i H = _mm_loadu_si128((const __m128i*)aes->Hp[0]);
+
+    X = _mm_xor_si128(X, _mm_set_epi64x((long long)aSz * 8,
+                                        (long long)cSz * 8));
+    X = GcmNiMul(X, H);
+    X = _mm_xor_si128(_mm_shuffle_epi8(X, GCM_NI_BSWAP), EKY0);
+
+    _mm_storeu_si128((__m128i*)s, X);
+}
+
+
+/* ctr is the initial counter block Y0 */
+static void AES_GCM_encrypt(const Aes* aes, byte* out, const byte* in,
+                            word32 sz, const byte* ctr,
+                            byte* authTag, word32 authTagSz,
+                            const byte* authIn, word32 authInSz)
+{
+    const __m128i ONE   = _mm_set_epi32(0, 0, 0, 1);
+    const __m128i EIGHT = _mm_set_epi32(0, 0, 0, AES_NI_BLOCKS);
+    const __m128i H = _mm_loadu_si128((const __m128i*)aes->Hp[0]);
+    word32 blocks  = sz / AES_BLOCK_SIZE;
+    word32 partial = sz % AES_BLOCK_SIZE;
+    word32 i = 0;
+    __m128i Y, X, EKY0, b;
+    byte scratch[AES_BLOCK_SIZE];
+
+    Y    = _mm_loadu_si128((const __m128i*)ctr);
+    EKY0 = AesNiEncryptBlock(aes, Y);
+    Y    = _mm_shuffle_epi8(Y, GCM_NI_BSWAP);
+    X    = GcmNiGhash(aes, _mm_setzero_si128(), authIn, authInSz);
+
+    if (blocks >= AES_NI_BLOCKS) {
+        /* hash each batch of cipher text while encrypting the next one */
+        GcmNiCtr8(aes, Y, X, NULL, in, out);
+        Y = _mm_add_epi32(Y, EIGHT);
+        for (i = AES_NI_BLOCKS; i + AES_NI_BLOCKS <= blocks;
+                                                        i += AES_NI_BLOCKS) {
+            X = GcmNiCtr8(aes, Y, X,
+                          out + (i - AES_NI_BLOCKS) * AES_BLOCK_SIZE,
+                          in + i * AES_BLOCK_SIZE, out + i * AES_BLOCK_SIZE);
+            Y = _mm_add_epi32(Y, EIGHT);
+        }
+        X = GcmNiGhash(aes, X, out + (i - AES_NI_BLOCKS) * AES_BLOCK_SIZE,
+                       AES_NI_BLOCKS * AES_BLOCK_SIZE);
+    }
+    for (; i < blocks; i++) {
+        Y = _mm_add_epi32(Y, ONE);
+        b = AesNiEncryptBlock(aes, _mm_shuffle_epi8(Y, GCM_NI_BSWAP));
+        b = _mm_xor_si128(b, _mm_loadu_si128(
+                                 (const __m128i*)(in + i * AES_BLOCK_SIZE)));
+        _mm_storeu_si128((__m128i*)(out + i * AES_BLOCK_SIZE), b);
+        X = GcmNiMul(_mm_xor_si128(X, _mm_shuffle_epi8(b, GCM_NI_BSWAP)), H);
+    }
+    if (partial != 0) {
+        Y = _mm_add_epi32(Y, ONE);
+        b = AesNiEncryptBlock(aes, _mm_shuffle_epi8(Y, GCM_NI_BSWAP));
+        _mm_storeu_si128((__m128i*)scratch, b);
+        xorbuf(scratch, in + i * AES_BLOCK_SIZE, partial);
+        XMEMCPY(out + i * AES_BLOCK_SIZE, scratch, partial);
+        X = GcmNiGhash(aes, X, scratch, partial);
+    }
+
+    GcmNiTag(aes, X, EKY0, authInSz, sz, scratch);
+    XMEMCPY(authTag, scratch, authTagSz);
+}
+
+
+static int AES_GCM_decrypt(const Aes* aes, byte* out, const byte* in,
+                           word32 sz, const byte* ctr,
+                           const byte* authTag, word32 authTagSz,
+                           const byte* authIn, word32 authInSz)
+{
+    const __m128i ONE   = _mm_set_epi32(0, 0, 0, 1);
+    const __m128i EIGHT = _mm_set_epi32(0, 0, 0, AES_NI_BLOCKS);
+    const __m128i H = _mm_loadu_si128((const __m128i*)aes->Hp[0]);
+    word32 blocks  = sz / AES_BLOCK_SIZE;
+    word32 partial = sz % AES_BLOCK_SIZE;
+    word32 i;
+    __m128i Y, X, EKY0, b, c;
+    byte scratch[AES_BLOCK_SIZE];
+
+    Y    = _mm_loadu_si128((const __m128i*)ctr);
+    EKY0 = AesNiEncryptBlock(aes, Y);
+    Y    = _mm_shuffle_epi8(Y, GCM_NI_BSWAP);
+    X    = GcmNiGhash(aes, _mm_setzero_si128(), authIn, authInSz);
+
+    /* the cipher text is already here, hash it alongside the decryption */
+    for (i = 0; i + AES_NI_BLOCKS <= blocks; i += AES_NI_BLOCKS) {
+        X = GcmNiCtr8(aes, Y, X, in + i * AES_BLOCK_SIZE,
+                      in + i * AES_BLOCK_SIZE, out + i * AES_BLOCK_SIZE);
+        Y = _mm_add_epi32(Y, EIGHT);
+    }
+    for (; i < blocks; i++) {
+        c = _mm_loadu_si128((const __m128i*)(in + i * AES_BLOCK_SIZE));
+        X = GcmNiMul(_mm_xor_si128(X, _mm_shuffle_epi8(c, GCM_NI_BSWAP)), H);
+        Y = _mm_add_epi32(Y, ONE);
+        b = AesNiEncryptBlock(aes, _mm_shuffle_epi8(Y, GCM_NI_BSWAP));
+        _mm_storeu_si128((__m128i*)(out + i * AES_BLOCK_SIZE),
+                         _mm_xor_si128(b, c));
+    }
+    if (partial != 0) {
+        X = GcmNiGhash(aes, X, in + i * AES_BLOCK_SIZE, partial);
+        Y = _mm_add_epi32(Y, ONE);
+        b = AesNiEncryptBlock(aes, _mm_shuffle_epi8(Y, GCM_NI_BSWAP));
+        _mm_storeu_si128((__m128i*)scratch, b);
+        xorbuf(scratch, in + i * AES_BLOCK_SIZE, partial);
+        XMEMCPY(out + i * AES_BLOCK_SIZE, scratch, partial);
+    }
+
+    GcmNiTag(aes, X, EKY0, authInSz, sz, scratch);
+    if (XMEMCMP(authTag, scratch, authTagSz) != 0) {
+        /* single pass, don't hand back unauthenticated plain text */
+        XMEMSET(out, 0, sz);
+        return AES_GCM_AUTH_E;
+    }
+
+    return 0;
+}
+
+#endif /* CYASSL_AESNI */
+
+
 void AesGcmSetKey(Aes* aes, const byte* key, word32 len)
 {
     byte iv[AES_BLOCK_SIZE];
@@ -2173,6 +2819,13 @@ void AesGcmSetKey(Aes* aes, const byte* key, word32 len)
 #ifdef GCM_TABLE
     GenerateM0(aes);
 #endif /* GCM_TABLE */
+#ifdef CYASSL_AESNI
+    aes->use_pclmul = 0;
+    if (aes->use_aesni && havePCLMUL) {
+        GcmNiSetKey(aes);
+        aes->use_pclmul = 1;
+    }
+#endif /* CYASSL_AESNI */
 }
 
 
@@ -2697,6 +3350,14 @@ void AesGcmEncrypt(Aes* aes, byte* out, const byte* in, word32 sz,
     XMEMCPY(ctr, iv, ivSz);
     InitGcmCounter(ctr);
 
+#ifdef CYASSL_AESNI
+    if (aes->use_pclmul) {
+        AES_GCM_encrypt(aes, out, in, sz, ctr, authTag, authTagSz,
+                        authIn, authInSz);
+        return;
+    }
+#endif /* CYASSL_AESNI */
+
     while (blocks--) {
         IncrementGcmCounter(ctr);
         AesEncrypt(aes, ctr, scratch);
@@ -2737,6 +3398,12 @@ int  AesGcmDecrypt(Aes* aes, byte* out, const byte* in, word32 sz,
     XMEMCPY(ctr, iv, ivSz);
     InitGcmCounter(ctr);
 
+#ifdef CYASSL_AESNI
+    if (aes->use_pclmul)
+        return AES_GCM_decrypt(aes, out, in, sz, ctr, authTag, authTagSz,
+                               authIn, authInSz);
+#endif /* CYASSL_AESNI */
+
     /* Calculate the authTag again using the received auth data and the
      * cipher text. */
     {
@@ -2875,6 +3542,87 @@ static INLINE void AesCcmCtrInc(byte* B, word32 lenSz)
 }
 
 
+#ifdef CYASSL_AESNI
+
+/* The CBC-MAC is a serial chain, so with AES-NI each MAC block is run in
+ * lock step with a counter block, the CTR pass rides along for free. A holds
+ * the MAC so far and B the first counter block, both are updated. */
+static void AesNiCcmEncrypt(Aes* aes, byte* out, const byte* in, word32 inSz,
+                            byte* A, byte* B, word32 lenSz)
+{
+    __m128i mac = _mm_loadu_si128((const __m128i*)A);
+    __m128i k, p;
+    byte scratch[AES_BLOCK_SIZE];
+
+    while (inSz >= AES_BLOCK_SIZE) {
+        p   = AES_NI_LOAD(in, 0);
+        mac = _mm_xor_si128(mac, p);
+        k   = _mm_loadu_si128((const __m128i*)B);
+        AesNiEncrypt2(aes, &mac, &k);
+        AES_NI_STORE(out, 0, _mm_xor_si128(k, p));
+
+        AesCcmCtrInc(B, lenSz);
+        inSz -= AES_BLOCK_SIZE;
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+    if (inSz > 0) {
+        XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+        XMEMCPY(scratch, in, inSz);
+        p   = _mm_loadu_si128((const __m128i*)scratch);
+        mac = _mm_xor_si128(mac, p);
+        k   = _mm_loadu_si128((const __m128i*)B);
+        AesNiEncrypt2(aes, &mac, &k);
+        _mm_storeu_si128((__m128i*)scratch, _mm_xor_si128(k, p));
+        XMEMCPY(out, scratch, inSz);
+        XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+    }
+
+    _mm_storeu_si128((__m128i*)A, mac);
+}
+
+
+/* Decryption has to finish a block before it can be MACed, so the next
+ * counter block is run alongside the MAC of the current one instead. */
+static void AesNiCcmDecrypt(Aes* aes, byte* out, const byte* in, word32 inSz,
+                            byte* A, byte* B, word32 lenSz)
+{
+    __m128i mac = _mm_loadu_si128((const __m128i*)A);
+    __m128i k, p;
+    byte scratch[AES_BLOCK_SIZE];
+
+    k = AesNiEncryptBlock(aes, _mm_loadu_si128((const __m128i*)B));
+    AesCcmCtrInc(B, lenSz);
+
+    while (inSz >= AES_BLOCK_SIZE) {
+        p = _mm_xor_si128(AES_NI_LOAD(in, 0), k);
+        AES_NI_STORE(out, 0, p);
+
+        mac = _mm_xor_si128(mac, p);
+        k   = _mm_loadu_si128((const __m128i*)B);
+        AesNiEncrypt2(aes, &mac, &k);
+
+        AesCcmCtrInc(B, lenSz);
+        inSz -= AES_BLOCK_SIZE;
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+    if (inSz > 0) {
+        _mm_storeu_si128((__m128i*)scratch, k);
+        xorbuf(scratch, in, inSz);
+        XMEMCPY(out, scratch, inSz);
+        XMEMSET(scratch + inSz, 0, AES_BLOCK_SIZE - inSz);
+        mac = AesNiEncryptBlock(aes, _mm_xor_si128(mac,
+                                    _mm_loadu_si128((const __m128i*)scratch)));
+        XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+    }
+
+    _mm_storeu_si128((__m128i*)A, mac);
+}
+
+#endif /* CYASSL_AESNI */
+
+
 void AesCcmEncrypt(Aes* aes, byte* out, const byte* in, word32 inSz,
                    const byte* nonce, word32 nonceSz,
                    byte* authTag, word32 authTagSz,
@@ -2896,6 +3644,27 @@ void AesCcmEncrypt(Aes* aes, byte* out, const byte* in, word32 inSz,
     AesEncrypt(aes, B, A);
     if (authInSz > 0)
         roll_auth(aes, authIn, authInSz, A);
+
+#ifdef CYASSL_AESNI
+    if (haveAESNI && aes->use_aesni) {
+        B[0] = lenSz - 1;
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        B[15] = 1;
+        AesNiCcmEncrypt(aes, out, in, inSz, A, B, lenSz);
+        XMEMCPY(authTag, A, authTagSz);
+
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        AesEncrypt(aes, B, A);
+        xorbuf(authTag, A, authTagSz);
+
+        XMEMSET(A, 0, AES_BLOCK_SIZE);
+        XMEMSET(B, 0, AES_BLOCK_SIZE);
+        return;
+    }
+#endif /* CYASSL_AESNI */
+
     if (inSz > 0)
         roll_x(aes, in, inSz, A);
     XMEMCPY(authTag, A, authTagSz);
@@ -2945,51 +3714,79 @@ int  AesCcmDecrypt(Aes* aes, byte* out, const byte* in, word32 inSz,
     XMEMCPY(B+1, nonce, nonceSz);
     lenSz = AES_BLOCK_SIZE - 1 - (byte)nonceSz;
 
-    B[0] = lenSz - 1;
-    for (i = 0; i < lenSz; i++)
-        B[AES_BLOCK_SIZE - 1 - i] = 0;
-    B[15] = 1;
-    
-    while (oSz >= AES_BLOCK_SIZE) {
-        AesEncrypt(aes, B, A);
-        xorbuf(A, in, AES_BLOCK_SIZE);
-        XMEMCPY(o, A, AES_BLOCK_SIZE);
+#ifdef CYASSL_AESNI
+    if (haveAESNI && aes->use_aesni) {
+        /* MAC and decrypt in one pass, see AesNiCcmDecrypt */
+        B[0] = (authInSz > 0 ? 64 : 0)
+             + (8 * (((byte)authTagSz - 2) / 2))
+             + (lenSz - 1);
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = (inSz >> (8 * i)) & 0xFF;
 
-        AesCcmCtrInc(B, lenSz);
-        oSz -= AES_BLOCK_SIZE;
-        in += AES_BLOCK_SIZE;
-        o += AES_BLOCK_SIZE;
-    }
-    if (inSz > 0) {
         AesEncrypt(aes, B, A);
-        xorbuf(A, in, oSz);
-        XMEMCPY(o, A, oSz);
+        if (authInSz > 0)
+            roll_auth(aes, authIn, authInSz, A);
+
+        B[0] = lenSz - 1;
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        B[15] = 1;
+        AesNiCcmDecrypt(aes, out, in, inSz, A, B, lenSz);
+
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        AesEncrypt(aes, B, B);
+        xorbuf(A, B, authTagSz);
     }
+    else
+#endif /* CYASSL_AESNI */
+    {
+        B[0] = lenSz - 1;
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        B[15] = 1;
+    
+        while (oSz >= AES_BLOCK_SIZE) {
+            AesEncrypt(aes, B, A);
+            xorbuf(A, in, AES_BLOCK_SIZE);
+            XMEMCPY(o, A, AES_BLOCK_SIZE);
+
+            AesCcmCtrInc(B, lenSz);
+            oSz -= AES_BLOCK_SIZE;
+            in += AES_BLOCK_SIZE;
+            o += AES_BLOCK_SIZE;
+        }
+        if (inSz > 0) {
+            AesEncrypt(aes, B, A);
+            xorbuf(A, in, oSz);
+            XMEMCPY(o, A, oSz);
+        }
 
-    for (i = 0; i < lenSz; i++)
-        B[AES_BLOCK_SIZE - 1 - i] = 0;
-    AesEncrypt(aes, B, A);
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        AesEncrypt(aes, B, A);
 
-    o = out;
-    oSz = inSz;
+        o = out;
+        oSz = inSz;
 
-    B[0] = (authInSz > 0 ? 64 : 0)
-         + (8 * (((byte)authTagSz - 2) / 2))
-         + (lenSz - 1);
-    for (i = 0; i < lenSz; i++)
-        B[AES_BLOCK_SIZE - 1 - i] = (inSz >> (8 * i)) & 0xFF;
+        B[0] = (authInSz > 0 ? 64 : 0)
+             + (8 * (((byte)authTagSz - 2) / 2))
+             + (lenSz - 1);
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = (inSz >> (8 * i)) & 0xFF;
 
-    AesEncrypt(aes, B, A);
-    if (authInSz > 0)
-        roll_auth(aes, authIn, authInSz, A);
-    if (inSz > 0)
-        roll_x(aes, o, oSz, A);
+        AesEncrypt(aes, B, A);
+        if (authInSz > 0)
+            roll_auth(aes, authIn, authInSz, A);
+        if (inSz > 0)
+            roll_x(aes, o, oSz, A);
 
-    B[0] = lenSz - 1;
-    for (i = 0; i < lenSz; i++)
-        B[AES_BLOCK_SIZE - 1 - i] = 0;
-    AesEncrypt(aes, B, B);
-    xorbuf(A, B, authTagSz);
+        B[0] = lenSz - 1;
+        for (i = 0; i < lenSz; i++)
+            B[AES_BLOCK_SIZE - 1 - i] = 0;
+        AesEncrypt(aes, B, B);
+        xorbuf(A, B, authTagSz);
+    }
 
     if (XMEMCMP(A, authTag, authTagSz) != 0) {
         /* If the authTag check fails, don't keep the decrypted data.
@@ -3024,6 +3821,38 @@ int AesSetIV(Aes* aes, const byte* iv)
 }
 
 
+/* Decrypt count independent buffers, the same as AesCbcDecrypt on each in
+ * turn, every buffer with its own Aes. With AES-NI the blocks of up to eight
+ * buffers are worked on together, which pays off for short records from
+ * different connections. */
+int AesCbcDecryptMulti(Aes** aes, byte** out, const byte** in,
+                       const word32* sz, word32 count)
+{
+    word32 i;
+    int    ret;
+
+    if (aes == NULL || out == NULL || in == NULL || sz == NULL)
+        return BAD_FUNC_ARG;
+
+#if defined(CYASSL_AESNI) && !defined(HAVE_CAVIUM)
+    if (haveAESNI) {
+        AesNiCbcDecryptLanes(aes, out, in, sz, count, 10);
+        AesNiCbcDecryptLanes(aes, out, in, sz, count, 12);
+        AesNiCbcDecryptLanes(aes, out, in, sz, count, 14);
+        return 0;
+    }
+#endif
+
+    for (i = 0; i < count; i++) {
+        ret = AesCbcDecrypt(aes[i], out[i], in[i], sz[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+
 #ifdef HAVE_CAVIUM
 
 #include <cyassl/ctaocrypt/logging.h>
@@ -728,6 +728,9 @@ int RsaPrivateKeyDecode(const byte* input, word32* inOutIdx, RsaKey* key,
         GetInt(&key->dQ, input, inOutIdx, inSz) < 0 ||
         GetInt(&key->u,  input, inOutIdx, inSz) < 0 )  return ASN_RSA_KEY_E;
 
+    if (RsaPrecompute(key) != 0)
+        return ASN_RSA_KEY_E;
+
     return 0;
 }
 
@@ -3133,11 +3136,45 @@ int ParseCert(DecodedCert* cert, int type, int verify, void* cm)
     #ifndef NO_SKID
         CYASSL_LOCAL Signer* GetCAByName(void* signers, byte* hash);
     #endif
+    #ifndef NO_CERT_VERIFY_CACHE
+        CYASSL_LOCAL int  CertVerifyCacheFind(void* cm, const byte* der,
+                                    word32 derSz, const Signer* ca, byte* key);
+        CYASSL_LOCAL void CertVerifyCacheAdd(void* cm, const byte* key);
+    #endif
 #ifdef __cplusplus
     } 
 #endif
 
 
+/* confirm cert is signed by ca, certs the cert manager has already seen
+   verified against the same ca key skip the public key operation, dates and
+   revocation are still checked by the callers every time, 1 on success */
+static int ConfirmCertSignature(DecodedCert* cert, Signer* ca, void* cm)
+{
+#ifndef NO_CERT_VERIFY_CACHE
+    byte key[CERT_VERIFY_DIGEST_SIZE];
+
+    if (CertVerifyCacheFind(cm, cert->source, cert->maxIdx, ca, key))
+        return 1;
+#endif
+
+    if (!ConfirmSignature(cert->source + cert->certBegin,
+                cert->sigIndex - cert->certBegin,
+            ca->publicKey, ca->pubKeySize, ca->keyOID,
+            cert->signature, cert->sigLength, cert->signatureOID,
+            cert->heap))
+        return 0;
+
+#ifndef NO_CERT_VERIFY_CACHE
+    CertVerifyCacheAdd(cm, key);
+#else
+    (void)cm;
+#endif
+
+    return 1;
+}
+
+
 int ParseCertRelative(DecodedCert* cert, int type, int verify, void* cm)
 {
     word32 confirmOID;
@@ -3207,11 +3244,7 @@ int ParseCertRelative(DecodedCert* cert, int type, int verify, void* cm)
             }
 #endif /* HAVE_OCSP */
             /* try to confirm/verify signature */
-            if (!ConfirmSignature(cert->source + cert->certBegin,
-                        cert->sigIndex - cert->certBegin,
-                    ca->publicKey, ca->pubKeySize, ca->keyOID,
-                    cert->signature, cert->sigLength, cert->signatureOID,
-                    cert->heap)) {
+            if (!ConfirmCertSignature(cert, ca, cm)) {
                 CYASSL_MSG("Confirm signature failed");
                 return ASN_SIG_CONFIRM_E;
             }
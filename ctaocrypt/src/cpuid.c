@@ -0,0 +1,89 @@
+/* cpuid.c
+ *
+ * Copyright (C) 2006-2013 wolfSSL Inc.
+ *
+ * This file is part of CyaSSL.
+ *
+ * CyaSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * CyaSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+
+#include <cyassl/ctaocrypt/settings.h>
+
+#ifdef USE_INTEL_SPEEDUP
+
+#include <cyassl/ctaocrypt/cpuid.h>
+
+
+#define cpuid(func,sub,ax,bx,cx,dx)\
+    __asm__ __volatile__ ("cpuid":\
+                   "=a" (ax), "=b" (bx), "=c" (cx), "=d" (dx) :\
+                   "a" (func), "c" (sub));
+
+
+/* extended control register 0, which register state the OS saves */
+static word32 xgetbv0(void)
+{
+    word32 a, d;
+
+    __asm__ __volatile__ ("xgetbv" : "=a" (a), "=d" (d) : "c" (0));
+
+    return a;
+}
+
+
+static int    cpuidChecked = 0;
+static word32 cpuidFlags   = 0;
+
+
+word32 cpuid_get_flags(void)
+{
+    word32 a, b, c, d;
+    word32 flags = 0;
+    word32 maxLeaf;
+    int    ymm = 0;
+
+    if (cpuidChecked)
+        return cpuidFlags;
+
+    cpuid(0, 0, maxLeaf, b, c, d);
+    cpuid(1, 0, a, b, c, d);
+
+    if (c & 0x200)                                  /* SSSE3 */
+        flags |= CPUID_SSSE3;
+
+    if ((c & 0x18000000) == 0x18000000)             /* AVX and OSXSAVE */
+        ymm = (xgetbv0() & 0x6) == 0x6;             /* xmm and ymm saved */
+
+    if (maxLeaf >= 7) {
+        word32 sse41 = c & 0x80000;
+
+        cpuid(7, 0, a, b, c, d);
+        if (ymm && (b & 0x120) == 0x120)            /* AVX2 and BMI2 */
+            flags |= CPUID_AVX2;
+        if (sse41 && (flags & CPUID_SSSE3) && (b & 0x20000000))     /* SHA */
+            flags |= CPUID_SHA;
+    }
+
+    cpuidFlags   = flags;
+    cpuidChecked = 1;
+
+    return flags;
+}
+
+#endif /* USE_INTEL_SPEEDUP */
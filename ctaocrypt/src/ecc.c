@@ -38,6 +38,10 @@
     #include <cyassl/ctaocrypt/aes.h>
 #endif
 
+#ifdef HAVE_ECC_P256
+    #include <cyassl/ctaocrypt/ecc_p256.h>
+#endif
+
 
 /* map
 
@@ -1215,6 +1219,27 @@ static int ecc_is_valid_idx(int n)
 }
 
 
+#ifdef HAVE_ECC_P256
+
+/** Returns whether the P-256 code handles these domain params
+  dp     The curve in use
+  return 1 for the built in P-256 set, 0 otherwise, a user supplied copy
+         of the same params goes through the generic code
+*/
+static INLINE int ecc_use_p256(const ecc_set_type* dp)
+{
+   int x;
+
+   for (x = 0; ecc_sets[x].size != 0; x++) {
+      if (ecc_sets[x].size == 32)
+         return dp == &ecc_sets[x];
+   }
+   return 0;
+}
+
+#endif /* HAVE_ECC_P256 */
+
+
 /**
   Create an ECC shared secret between two keys
   private_key      The private ECC key
@@ -1261,6 +1286,11 @@ int ecc_shared_secret(ecc_key* private_key, ecc_key* public_key, byte* out,
 
    err = mp_read_radix(&prime, (char *)private_key->dp->prime, 16);
 
+#ifdef HAVE_ECC_P256
+   if (err == MP_OKAY && ecc_use_p256(private_key->dp))
+       err = ecc_p256_mulmod(&private_key->k, &public_key->pubkey, result);
+   else
+#endif
    if (err == MP_OKAY)
        err = ecc_mulmod(&private_key->k, &public_key->pubkey, result, &prime,1);
 
@@ -1284,8 +1314,6 @@ int ecc_shared_secret(ecc_key* private_key, ecc_key* public_key, byte* out,
 }
 
 
-int ecc_make_key_ex(RNG* rng, ecc_key* key, const ecc_set_type* dp);
-
 /**
   Make a new ECC key 
   rng          An active RNG state
@@ -1312,6 +1340,14 @@ int ecc_make_key(RNG* rng, int keysize, ecc_key* key)
    return err;
 }
 
+/**
+  Make a new ECC key on the given domain params
+  rng          An active RNG state
+  key          [out] Destination of the newly created key
+  dp           The curve to use, ecc_sets entry or user supplied
+  return       MP_OKAY if successful,
+                       upon error all allocated memory will be freed
+*/
 int ecc_make_key_ex(RNG* rng, ecc_key* key, const ecc_set_type* dp)
 {
    int            err;
@@ -1365,6 +1401,11 @@ int ecc_make_key_ex(RNG* rng, ecc_key* key, const ecc_set_type* dp)
            err = mp_mod(&key->k, &order, &key->k);
    }
    /* make the public key */
+#ifdef HAVE_ECC_P256
+   if (err == MP_OKAY && ecc_use_p256(dp))
+       err = ecc_p256_mulmod_base(&key->k, &key->pubkey);
+   else
+#endif
    if (err == MP_OKAY)
        err = ecc_mulmod(&key->k, base, &key->pubkey, &prime, 1);
    if (err == MP_OKAY)
@@ -1893,6 +1934,12 @@ int ecc_verify_hash(const byte* sig, word32 siglen, const byte* hash,
    if (err == MP_OKAY)
        err = mp_copy(&key->pubkey.z, &mQ->z);
 
+#ifdef HAVE_ECC_P256
+   /* compute u1*mG + u2*mQ = mG */
+   if (err == MP_OKAY && ecc_use_p256(key->dp))
+       err = ecc_p256_mul2add(&u1, &u2, mQ, mG);
+   else
+#endif
 #ifndef ECC_SHAMIR
     {
        mp_digit      mp;
@@ -2161,6 +2208,23 @@ static THREAD_LS_T fp_cache_t fp_cache[FP_ENTRIES];
     static CyaSSL_Mutex ecc_fp_lock;
 #endif /* HAVE_THREAD_LS */
 
+/* the standard curve generators get one process wide table each instead,
+   built once on first use and read only after that, so threads share it and
+   lookups don't need a lock */
+#define FP_SHARED_ENTRIES (sizeof(ecc_sets) / sizeof(ecc_sets[0]) - 1)
+
+typedef struct {
+   ecc_point*   base;          /* generator from ecc_sets */
+   mp_int       prime;         /* modulus of the generator's curve */
+   fp_cache_t   cache;         /* fixed point table for base */
+   volatile int built;         /* 0 not yet, 1 ready, -1 build failed */
+} fp_shared_t;
+
+static fp_shared_t  fp_shared[FP_SHARED_ENTRIES];
+static volatile int fp_shared_init  = 0;  /* generators loaded */
+static int          fp_shared_mutex = 0;  /* lock set up by ecc_fp_init */
+static CyaSSL_Mutex fp_shared_lock;
+
 /* simple table to help direct the generation of the LUT */
 static const struct {
    int ham, terma, termb;
@@ -2743,40 +2807,40 @@ static int find_base(ecc_point* g)
 }
 
 /* add a new base to the cache */
-static int add_entry(int idx, ecc_point *g)
+static int add_entry(fp_cache_t* c, ecc_point *g)
 {
    unsigned x, y;
 
    /* allocate base and LUT */
-   fp_cache[idx].g = ecc_new_point();
-   if (fp_cache[idx].g == NULL) {
+   c->g = ecc_new_point();
+   if (c->g == NULL) {
       return GEN_MEM_ERR;
    }
 
    /* copy x and y */
-   if ((mp_copy(&g->x, &fp_cache[idx].g->x) != MP_OKAY) ||
-       (mp_copy(&g->y, &fp_cache[idx].g->y) != MP_OKAY) ||
-       (mp_copy(&g->z, &fp_cache[idx].g->z) != MP_OKAY)) {
-      ecc_del_point(fp_cache[idx].g);
-      fp_cache[idx].g = NULL;
+   if ((mp_copy(&g->x, &c->g->x) != MP_OKAY) ||
+       (mp_copy(&g->y, &c->g->y) != MP_OKAY) ||
+       (mp_copy(&g->z, &c->g->z) != MP_OKAY)) {
+      ecc_del_point(c->g);
+      c->g = NULL;
       return GEN_MEM_ERR;
    }              
 
    for (x = 0; x < (1U<<FP_LUT); x++) {
-      fp_cache[idx].LUT[x] = ecc_new_point();
-      if (fp_cache[idx].LUT[x] == NULL) {
+      c->LUT[x] = ecc_new_point();
+      if (c->LUT[x] == NULL) {
          for (y = 0; y < x; y++) {
-            ecc_del_point(fp_cache[idx].LUT[y]);
-            fp_cache[idx].LUT[y] = NULL;
+            ecc_del_point(c->LUT[y]);
+            c->LUT[y] = NULL;
          }
-         ecc_del_point(fp_cache[idx].g);
-         fp_cache[idx].g         = NULL;
-         fp_cache[idx].lru_count = 0;
+         ecc_del_point(c->g);
+         c->g         = NULL;
+         c->lru_count = 0;
          return GEN_MEM_ERR;
       }
    }
    
-   fp_cache[idx].lru_count = 0;
+   c->lru_count = 0;
 
    return MP_OKAY;
 }
@@ -2786,7 +2850,7 @@ static int add_entry(int idx, ecc_point *g)
  * The algorithm builds patterns in increasing bit order by first making all 
  * single bit input patterns, then all two bit input patterns and so on
  */
-static int build_lut(int idx, mp_int* modulus, mp_digit* mp, mp_int* mu)
+static int build_lut(fp_cache_t* c, mp_int* modulus, mp_digit* mp, mp_int* mu)
 { 
    unsigned x, y, err, bitlen, lut_gap;
    mp_int tmp;
@@ -2809,17 +2873,14 @@ static int build_lut(int idx, mp_int* modulus, mp_digit* mp, mp_int* mu)
     lut_gap = bitlen / FP_LUT;
 
     /* init the mu */
-    err = mp_init_copy(&fp_cache[idx].mu, mu);
+    err = mp_init_copy(&c->mu, mu);
    }
    
    /* copy base */
    if (err == MP_OKAY) {
-     if ((mp_mulmod(&fp_cache[idx].g->x, mu, modulus,
-                  &fp_cache[idx].LUT[1]->x) != MP_OKAY) || 
-         (mp_mulmod(&fp_cache[idx].g->y, mu, modulus,
-                  &fp_cache[idx].LUT[1]->y) != MP_OKAY) || 
-         (mp_mulmod(&fp_cache[idx].g->z, mu, modulus,
-                  &fp_cache[idx].LUT[1]->z) != MP_OKAY)) {
+     if ((mp_mulmod(&c->g->x, mu, modulus, &c->LUT[1]->x) != MP_OKAY) || 
+         (mp_mulmod(&c->g->y, mu, modulus, &c->LUT[1]->y) != MP_OKAY) || 
+         (mp_mulmod(&c->g->z, mu, modulus, &c->LUT[1]->z) != MP_OKAY)) {
        err = MP_MULMOD_E; 
      }
    }
@@ -2828,20 +2889,17 @@ static int build_lut(int idx, mp_int* modulus, mp_digit* mp, mp_int* mu)
    for (x = 1; x < FP_LUT; x++) {
       if (err != MP_OKAY)
           break;
-      if ((mp_copy(&fp_cache[idx].LUT[1<<(x-1)]->x,
-                   &fp_cache[idx].LUT[1<<x]->x) != MP_OKAY) || 
-          (mp_copy(&fp_cache[idx].LUT[1<<(x-1)]->y,
-                   &fp_cache[idx].LUT[1<<x]->y) != MP_OKAY) || 
-          (mp_copy(&fp_cache[idx].LUT[1<<(x-1)]->z,
-                   &fp_cache[idx].LUT[1<<x]->z) != MP_OKAY)){
+      if ((mp_copy(&c->LUT[1<<(x-1)]->x, &c->LUT[1<<x]->x) != MP_OKAY) || 
+          (mp_copy(&c->LUT[1<<(x-1)]->y, &c->LUT[1<<x]->y) != MP_OKAY) || 
+          (mp_copy(&c->LUT[1<<(x-1)]->z, &c->LUT[1<<x]->z) != MP_OKAY)){
           err = MP_INIT_E;
           break;
       } else {
           
          /* now double it bitlen/FP_LUT times */
          for (y = 0; y < lut_gap; y++) {
-             if ((err = ecc_projective_dbl_point(fp_cache[idx].LUT[1<<x],
-                            fp_cache[idx].LUT[1<<x], modulus, mp)) != MP_OKAY) {
+             if ((err = ecc_projective_dbl_point(c->LUT[1<<x], c->LUT[1<<x],
+                                                 modulus, mp)) != MP_OKAY) {
                  break;
              }
          }
@@ -2859,9 +2917,9 @@ static int build_lut(int idx, mp_int* modulus, mp_digit* mp, mp_int* mu)
                      
            /* perform the add */
            if ((err = ecc_projective_add_point(
-                           fp_cache[idx].LUT[lut_orders[y].terma],
-                           fp_cache[idx].LUT[lut_orders[y].termb],
-                           fp_cache[idx].LUT[y], modulus, mp)) != MP_OKAY) {
+                           c->LUT[lut_orders[y].terma],
+                           c->LUT[lut_orders[y].termb],
+                           c->LUT[y], modulus, mp)) != MP_OKAY) {
               break;
            }
        }
@@ -2873,34 +2931,31 @@ static int build_lut(int idx, mp_int* modulus, mp_digit* mp, mp_int* mu)
            break;
 
        /* convert z to normal from montgomery */
-       err = mp_montgomery_reduce(&fp_cache[idx].LUT[x]->z, modulus, *mp);
+       err = mp_montgomery_reduce(&c->LUT[x]->z, modulus, *mp);
  
        /* invert it */
        if (err == MP_OKAY)
-         err = mp_invmod(&fp_cache[idx].LUT[x]->z, modulus,
-                         &fp_cache[idx].LUT[x]->z);
+         err = mp_invmod(&c->LUT[x]->z, modulus, &c->LUT[x]->z);
 
        if (err == MP_OKAY)
          /* now square it */
-         err = mp_sqrmod(&fp_cache[idx].LUT[x]->z, modulus, &tmp);
+         err = mp_sqrmod(&c->LUT[x]->z, modulus, &tmp);
        
        if (err == MP_OKAY)
          /* fix x */
-         err = mp_mulmod(&fp_cache[idx].LUT[x]->x, &tmp, modulus,
-                         &fp_cache[idx].LUT[x]->x);
+         err = mp_mulmod(&c->LUT[x]->x, &tmp, modulus, &c->LUT[x]->x);
 
        if (err == MP_OKAY)
          /* get 1/z^3 */
-         err = mp_mulmod(&tmp, &fp_cache[idx].LUT[x]->z, modulus, &tmp);
+         err = mp_mulmod(&tmp, &c->LUT[x]->z, modulus, &tmp);
 
        if (err == MP_OKAY)
          /* fix y */
-         err = mp_mulmod(&fp_cache[idx].LUT[x]->y, &tmp, modulus,
-                         &fp_cache[idx].LUT[x]->y);
+         err = mp_mulmod(&c->LUT[x]->y, &tmp, modulus, &c->LUT[x]->y);
 
        if (err == MP_OKAY)
          /* free z */
-         mp_clear(&fp_cache[idx].LUT[x]->z);
+         mp_clear(&c->LUT[x]->z);
    }
    mp_clear(&tmp);
 
@@ -2909,21 +2964,146 @@ static int build_lut(int idx, mp_int* modulus, mp_digit* mp, mp_int* mu)
 
    /* err cleanup */
    for (y = 0; y < (1U<<FP_LUT); y++) {
-      ecc_del_point(fp_cache[idx].LUT[y]);
-      fp_cache[idx].LUT[y] = NULL;
+      ecc_del_point(c->LUT[y]);
+      c->LUT[y] = NULL;
    }
-   ecc_del_point(fp_cache[idx].g);
-   fp_cache[idx].g         = NULL;
-   fp_cache[idx].lru_count = 0;
-   mp_clear(&fp_cache[idx].mu);
+   ecc_del_point(c->g);
+   c->g         = NULL;
+   c->lru_count = 0;
+   mp_clear(&c->mu);
    mp_clear(&tmp);
 
    return err;
 }
 
+/* free the shared generator tables ...
+   must be called with fp_shared_lock locked */
+static void ecc_fp_free_shared(void)
+{
+   unsigned x, y;
+   for (x = 0; x < FP_SHARED_ENTRIES; x++) {
+      if (fp_shared[x].cache.g != NULL) {
+         for (y = 0; y < (1U<<FP_LUT); y++) {
+            ecc_del_point(fp_shared[x].cache.LUT[y]);
+            fp_shared[x].cache.LUT[y] = NULL;
+         }
+         ecc_del_point(fp_shared[x].cache.g);
+         fp_shared[x].cache.g = NULL;
+         mp_clear(&fp_shared[x].cache.mu);
+      }
+      if (fp_shared[x].base != NULL) {
+         ecc_del_point(fp_shared[x].base);
+         fp_shared[x].base = NULL;
+         mp_clear(&fp_shared[x].prime);
+      }
+      fp_shared[x].built = 0;
+   }
+   fp_shared_init = 0;
+}
+
+/* read in the ecc_sets generators to match against ...
+   must be called with fp_shared_lock locked */
+static int load_shared(void)
+{
+   unsigned x;
+   int      err = MP_OKAY;
+
+   for (x = 0; x < FP_SHARED_ENTRIES && err == MP_OKAY; x++) {
+      fp_shared[x].base = ecc_new_point();
+      if (fp_shared[x].base == NULL) {
+         err = GEN_MEM_ERR;
+         break;
+      }
+      err = mp_init(&fp_shared[x].prime);
+      if (err == MP_OKAY)
+         err = mp_read_radix(&fp_shared[x].prime, (char*)ecc_sets[x].prime,16);
+      if (err == MP_OKAY)
+         err = mp_read_radix(&fp_shared[x].base->x, (char*)ecc_sets[x].Gx, 16);
+      if (err == MP_OKAY)
+         err = mp_read_radix(&fp_shared[x].base->y, (char*)ecc_sets[x].Gy, 16);
+      if (err == MP_OKAY)
+         mp_set(&fp_shared[x].base->z, 1);
+   }
+
+   if (err != MP_OKAY)
+      ecc_fp_free_shared();
+
+   return err;
+}
+
+/* build the table for a shared entry ...
+   must be called with fp_shared_lock locked */
+static int build_shared(fp_shared_t* s, mp_int* modulus)
+{
+   int      err;
+   mp_digit mp;
+   mp_int   mu;
+
+   if (mp_init(&mu) != MP_OKAY)
+      return MP_INIT_E;
+
+   err = mp_montgomery_setup(modulus, &mp);
+   if (err == MP_OKAY)
+      err = mp_montgomery_calc_normalization(&mu, modulus);
+   if (err == MP_OKAY)
+      err = add_entry(&s->cache, s->base);
+   if (err == MP_OKAY)
+      err = build_lut(&s->cache, modulus, &mp, &mu);
+
+   mp_clear(&mu);
+
+   return err;
+}
+
+/* return the shared table if g is a standard curve generator, building it on
+   first use, or NULL if g should go through the per thread cache */
+static fp_cache_t* find_shared_base(ecc_point* g, mp_int* modulus)
+{
+   unsigned     x;
+   fp_shared_t* s = NULL;
+
+   /* no ecc_fp_init, everything stays in the per thread cache */
+   if (fp_shared_mutex == 0)
+      return NULL;
+
+   if (fp_shared_init == 0) {
+      if (LockMutex(&fp_shared_lock) != 0)
+         return NULL;
+      if (fp_shared_init == 0 && load_shared() == MP_OKAY)
+         fp_shared_init = 1;
+      UnLockMutex(&fp_shared_lock);
+
+      if (fp_shared_init == 0)
+         return NULL;
+   }
+
+   for (x = 0; x < FP_SHARED_ENTRIES; x++) {
+      if (mp_cmp(&fp_shared[x].base->x, &g->x) == MP_EQ &&
+          mp_cmp(&fp_shared[x].base->y, &g->y) == MP_EQ &&
+          mp_cmp(&fp_shared[x].base->z, &g->z) == MP_EQ &&
+          mp_cmp(&fp_shared[x].prime, modulus) == MP_EQ) {
+         s = &fp_shared[x];
+         break;
+      }
+   }
+   if (s == NULL)
+      return NULL;
+
+   if (s->built == 0) {
+      if (LockMutex(&fp_shared_lock) != 0)
+         return NULL;
+      /* another thread may have built it while we waited */
+      if (s->built == 0)
+         s->built = (build_shared(s, modulus) == MP_OKAY) ? 1 : -1;
+      UnLockMutex(&fp_shared_lock);
+   }
+
+   return (s->built == 1) ? &s->cache : NULL;
+}
+
 /* perform a fixed point ECC mulmod */
-static int accel_fp_mul(int idx, mp_int* k, ecc_point *R, mp_int* modulus,
-                        mp_digit* mp, int map)
+static int accel_fp_mul(fp_cache_t* c, mp_int* k, ecc_point *R,
+                        mp_int* modulus, mp_digit* mp, int map)
 {
    unsigned char kb[128];
    int      x;
@@ -3023,14 +3203,14 @@ static int accel_fp_mul(int idx, mp_int* k, ecc_point *R, mp_int* modulus,
        
        /* add if not first, otherwise copy */          
        if (!first && z) {
-          if ((err = ecc_projective_add_point(R, fp_cache[idx].LUT[z], R,
+          if ((err = ecc_projective_add_point(R, c->LUT[z], R,
                                               modulus, mp)) != MP_OKAY) {
              return err;
           }
        } else if (z) {
-          if ((mp_copy(&fp_cache[idx].LUT[z]->x, &R->x) != MP_OKAY) || 
-              (mp_copy(&fp_cache[idx].LUT[z]->y, &R->y) != MP_OKAY) || 
-              (mp_copy(&fp_cache[idx].mu,        &R->z) != MP_OKAY)) {
+          if ((mp_copy(&c->LUT[z]->x, &R->x) != MP_OKAY) || 
+              (mp_copy(&c->LUT[z]->y, &R->y) != MP_OKAY) || 
+              (mp_copy(&c->mu,          &R->z) != MP_OKAY)) {
               return GEN_MEM_ERR;
           }
               first = 0;              
@@ -3050,7 +3230,7 @@ static int accel_fp_mul(int idx, mp_int* k, ecc_point *R, mp_int* modulus,
 
 #ifdef ECC_SHAMIR
 /* perform a fixed point ECC mulmod */
-static int accel_fp_mul2add(int idx1, int idx2, 
+static int accel_fp_mul2add(fp_cache_t* c1, fp_cache_t* c2,
                             mp_int* kA, mp_int* kB,
                             ecc_point *R, mp_int* modulus, mp_digit* mp)
 {
@@ -3212,37 +3392,37 @@ static int accel_fp_mul2add(int idx1, int idx2,
        /* add if not first, otherwise copy */          
        if (!first) {
           if (zA) {
-             if ((err = ecc_projective_add_point(R, fp_cache[idx1].LUT[zA],
+             if ((err = ecc_projective_add_point(R, c1->LUT[zA],
                                                  R, modulus, mp)) != MP_OKAY) {
                 return err;
              }
           }
           if (zB) {
-             if ((err = ecc_projective_add_point(R, fp_cache[idx2].LUT[zB],
+             if ((err = ecc_projective_add_point(R, c2->LUT[zB],
                                                  R, modulus, mp)) != MP_OKAY) {
                 return err;
              }
           }
        } else {
           if (zA) {
-              if ((mp_copy(&fp_cache[idx1].LUT[zA]->x, &R->x) != MP_OKAY) || 
-                 (mp_copy(&fp_cache[idx1].LUT[zA]->y, &R->y) != MP_OKAY) || 
-                 (mp_copy(&fp_cache[idx1].mu,        &R->z) != MP_OKAY)) {
+              if ((mp_copy(&c1->LUT[zA]->x, &R->x) != MP_OKAY) || 
+                 (mp_copy(&c1->LUT[zA]->y, &R->y) != MP_OKAY) || 
+                 (mp_copy(&c1->mu,          &R->z) != MP_OKAY)) {
                   return GEN_MEM_ERR;
               }
                  first = 0;              
           }
           if (zB && first == 0) {
              if (zB) {
-                if ((err = ecc_projective_add_point(R, fp_cache[idx2].LUT[zB],
+                if ((err = ecc_projective_add_point(R, c2->LUT[zB],
                                                    R, modulus, mp)) != MP_OKAY){
                    return err;
                 }
              }
           } else if (zB && first == 1) {
-              if ((mp_copy(&fp_cache[idx2].LUT[zB]->x, &R->x) != MP_OKAY) || 
-                 (mp_copy(&fp_cache[idx2].LUT[zB]->y, &R->y) != MP_OKAY) || 
-                 (mp_copy(&fp_cache[idx2].mu,        &R->z) != MP_OKAY)) {
+              if ((mp_copy(&c2->LUT[zB]->x, &R->x) != MP_OKAY) || 
+                 (mp_copy(&c2->LUT[zB]->y, &R->y) != MP_OKAY) || 
+                 (mp_copy(&c2->mu,          &R->z) != MP_OKAY)) {
                   return GEN_MEM_ERR;
               }
                  first = 0;              
@@ -3268,14 +3448,18 @@ int ecc_mul2add(ecc_point* A, mp_int* kA,
                 ecc_point* B, mp_int* kB,
                 ecc_point* C, mp_int* modulus)
 {
-   int  idx1, idx2, err = MP_OKAY, mpInit = 0;
+   int  idx1 = -1, idx2 = -1, err = MP_OKAY, mpInit = 0;
    mp_digit mp;
    mp_int   mu;
+   fp_cache_t* shared;
   
    err = mp_init(&mu);
    if (err != MP_OKAY)
        return err;
 
+   /* A is normally the curve generator, use the shared table if so */
+   shared = find_shared_base(A, modulus);
+
 #ifndef HAVE_THREAD_LS
    if (initMutex == 0) {
         InitMutex(&ecc_fp_lock);
@@ -3285,19 +3469,21 @@ int ecc_mul2add(ecc_point* A, mp_int* kA,
       return BAD_MUTEX_E;
 #endif /* HAVE_THREAD_LS */
 
-      /* find point */
-      idx1 = find_base(A);
+      if (shared == NULL) {
+         /* find point */
+         idx1 = find_base(A);
 
-      /* no entry? */
-      if (idx1 == -1) {
-         /* find hole and add it */
-         if ((idx1 = find_hole()) >= 0) {
-            err = add_entry(idx1, A);
+         /* no entry? */
+         if (idx1 == -1) {
+            /* find hole and add it */
+            if ((idx1 = find_hole()) >= 0) {
+               err = add_entry(&fp_cache[idx1], A);
+            }
+         }
+         if (err == MP_OKAY && idx1 != -1) {
+            /* increment LRU */
+            ++(fp_cache[idx1].lru_count);
          }
-      }
-      if (err == MP_OKAY && idx1 != -1) {
-         /* increment LRU */
-         ++(fp_cache[idx1].lru_count);
       }
 
       if (err == MP_OKAY)
@@ -3309,7 +3495,7 @@ int ecc_mul2add(ecc_point* A, mp_int* kA,
         if (idx2 == -1) {
            /* find hole and add it */
            if ((idx2 = find_hole()) >= 0)
-              err = add_entry(idx2, B);
+              err = add_entry(&fp_cache[idx2], B);
          }
       }
 
@@ -3331,7 +3517,7 @@ int ecc_mul2add(ecc_point* A, mp_int* kA,
                  
            if (err == MP_OKAY)
              /* build the LUT */
-               err = build_lut(idx1, modulus, &mp, &mu);
+               err = build_lut(&fp_cache[idx1], modulus, &mp, &mu);
         }
       }
 
@@ -3349,20 +3535,23 @@ int ecc_mul2add(ecc_point* A, mp_int* kA,
                  
             if (err == MP_OKAY) 
             /* build the LUT */
-              err = build_lut(idx2, modulus, &mp, &mu);
+              err = build_lut(&fp_cache[idx2], modulus, &mp, &mu);
         }
       }
 
 
       if (err == MP_OKAY) {
-        if (idx1 >=0 && idx2 >= 0 && fp_cache[idx1].lru_count >= 2 &&
-                                     fp_cache[idx2].lru_count >= 2) {
+        if (shared == NULL && idx1 >= 0 && fp_cache[idx1].lru_count >= 2)
+           shared = &fp_cache[idx1];
+
+        if (shared != NULL && idx2 >= 0 && fp_cache[idx2].lru_count >= 2) {
            if (mpInit == 0) {
               /* compute mp */
               err = mp_montgomery_setup(modulus, &mp);
            }
            if (err == MP_OKAY)
-             err = accel_fp_mul2add(idx1, idx2, kA, kB, C, modulus, &mp);
+             err = accel_fp_mul2add(shared, &fp_cache[idx2], kA, kB, C,
+                                    modulus, &mp);
         } else {
            err = normal_ecc_mul2add(A, kA, B, kB, C, modulus);
         }
@@ -3393,6 +3582,16 @@ int ecc_mulmod(mp_int* k, ecc_point *G, ecc_point *R, mp_int* modulus,
    mp_digit mp;
    mp_int   mu;
    int      mpSetup = 0;
+   fp_cache_t* shared;
+
+   /* curve generators use the shared table, no cache lock needed */
+   shared = find_shared_base(G, modulus);
+   if (shared != NULL) {
+      err = mp_montgomery_setup(modulus, &mp);
+      if (err == MP_OKAY)
+         err = accel_fp_mul(shared, k, R, modulus, &mp, map);
+      return err;
+   }
 
    if (mp_init(&mu) != MP_OKAY)
        return MP_INIT_E;
@@ -3416,7 +3615,7 @@ int ecc_mulmod(mp_int* k, ecc_point *G, ecc_point *R, mp_int* modulus,
          idx = find_hole();
 
          if (idx >= 0)
-            err = add_entry(idx, G);
+            err = add_entry(&fp_cache[idx], G);
       }
       if (err == MP_OKAY && idx != -1) {
          /* increment LRU */
@@ -3438,7 +3637,7 @@ int ecc_mulmod(mp_int* k, ecc_point *G, ecc_point *R, mp_int* modulus,
                  
            if (err == MP_OKAY) 
              /* build the LUT */
-             err = build_lut(idx, modulus, &mp, &mu);
+             err = build_lut(&fp_cache[idx], modulus, &mp, &mu);
         }
       }
 
@@ -3449,7 +3648,7 @@ int ecc_mulmod(mp_int* k, ecc_point *G, ecc_point *R, mp_int* modulus,
               err = mp_montgomery_setup(modulus, &mp);
            }
            if (err == MP_OKAY)
-             err = accel_fp_mul(idx, k, R, modulus, &mp, map);
+             err = accel_fp_mul(&fp_cache[idx], k, R, modulus, &mp, map);
         } else {
            err = normal_ecc_mulmod(k, G, R, modulus, map);
         }
@@ -3483,7 +3682,34 @@ static void ecc_fp_free_cache(void)
    }
 }         
 
-/** Free the Fixed Point cache */
+/** Set up the shared generator tables, call once before any thread uses
+    fixed point ECC, CyaSSL_Init does */
+int ecc_fp_init(void)
+{
+   if (fp_shared_mutex == 0) {
+      if (InitMutex(&fp_shared_lock) != 0)
+         return BAD_MUTEX_E;
+      fp_shared_mutex = 1;
+   }
+
+   return 0;
+}
+
+/** Free the shared generator tables, only once no thread uses fixed point
+    ECC anymore, CyaSSL_Cleanup does on the last release */
+void ecc_fp_cleanup(void)
+{
+   if (fp_shared_mutex) {
+       if (LockMutex(&fp_shared_lock) == 0) {
+           ecc_fp_free_shared();
+           UnLockMutex(&fp_shared_lock);
+       }
+       FreeMutex(&fp_shared_lock);
+       fp_shared_mutex = 0;
+   }
+}
+
+/** Free the Fixed Point cache, the calling thread's own with HAVE_THREAD_LS */
 void ecc_fp_free(void)
 {
 #ifndef HAVE_THREAD_LS
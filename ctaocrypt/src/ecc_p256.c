@@ -0,0 +1,772 @@
+/* ecc_p256.c
+ *
+ * Copyright (C) 2006-2013 wolfSSL Inc.
+ *
+ * This file is part of CyaSSL.
+ *
+ * CyaSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * CyaSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+
+/* in case user set HAVE_ECC there */
+#include <cyassl/ctaocrypt/settings.h>
+
+#if defined(HAVE_ECC) && defined(HAVE_ECC_P256)
+
+#include <cyassl/ctaocrypt/ecc_p256.h>
+#include <cyassl/ctaocrypt/error.h>
+
+#ifdef NO_INLINE
+    #include <cyassl/ctaocrypt/misc.h>
+#else
+    #include <ctaocrypt/src/misc.c>
+#endif
+
+
+/* Field elements are 4 x 64 bit limbs, least significant first, kept in
+   Montgomery form (a * 2^256 mod p) and always fully reduced. The NIST prime
+   p = 2^256 - 2^224 + 2^192 + 2^96 - 1 is -1 mod 2^64 and its limbs are
+   2^64 - 1, 2^32 - 1, 0 and 2^64 - 2^32 + 1, so each reduction round takes
+   the low limb as its quotient digit and needs only two multiplies.
+
+   Points are homogeneous projective (X:Y:Z), x = X/Z and y = Y/Z, with the
+   identity as (0:1:0) so the complete formulas of Renes, Costello and Batina
+   (eprint 2015/1060, a = -3) need no special cases. */
+
+__extension__ typedef unsigned __int128 p256_word128;
+
+typedef word64 p256_fe[4];
+
+typedef struct {
+    p256_fe x, y, z;
+} p256_point;
+
+typedef struct {
+    p256_fe x, y;
+} p256_affine;
+
+enum {
+    P256_BYTES     = 32,
+    P256_WINDOW    = 16,    /* variable base table, 4 bit window */
+    P256_COMB      = 15     /* base comb table, 4 teeth, identity left out */
+};
+
+#define P256_P0 W64LIT(0xffffffffffffffff)
+#define P256_P1 W64LIT(0x00000000ffffffff)
+#define P256_P3 W64LIT(0xffffffff00000001)
+
+
+/* p - 2, the Fermat inversion exponent */
+static const p256_fe p256_p2 = {
+    W64LIT(0xfffffffffffffffd), W64LIT(0x00000000ffffffff),
+    W64LIT(0x0000000000000000), W64LIT(0xffffffff00000001)
+};
+
+/* 1, Montgomery form */
+static const p256_fe p256_one = {
+    W64LIT(0x0000000000000001), W64LIT(0xffffffff00000000),
+    W64LIT(0xffffffffffffffff), W64LIT(0x00000000fffffffe)
+};
+
+/* 2^512 mod p, converts into Montgomery form */
+static const p256_fe p256_r2 = {
+    W64LIT(0x0000000000000003), W64LIT(0xfffffffbffffffff),
+    W64LIT(0xfffffffffffffffe), W64LIT(0x00000004fffffffd)
+};
+
+/* curve b, Montgomery form */
+static const p256_fe p256_b = {
+    W64LIT(0xd89cdf6229c4bddf), W64LIT(0xacf005cd78843090),
+    W64LIT(0xe5a220abf7212ed6), W64LIT(0xdc30061d04874834)
+};
+
+/* Comb tables for G, affine, Montgomery form. p256_comb[0][v-1] is the sum
+   over the set bits j of v of 2^(64j) * G, p256_comb[1] is that times 2^32. */
+static const p256_affine p256_comb[2][P256_COMB] = {
+    {
+        { { W64LIT(0x79e730d418a9143c), W64LIT(0x75ba95fc5fedb601),
+            W64LIT(0x79fb732b77622510), W64LIT(0x18905f76a53755c6) },
+          { W64LIT(0xddf25357ce95560a), W64LIT(0x8b4ab8e4ba19e45c),
+            W64LIT(0xd2e88688dd21f325), W64LIT(0x8571ff1825885d85) } },
+        { { W64LIT(0x4f922fc516a0d2bb), W64LIT(0x0d5cc16c1a623499),
+            W64LIT(0x9241cf3a57c62c8b), W64LIT(0x2f5e6961fd1b667f) },
+          { W64LIT(0x5c15c70bf5a01797), W64LIT(0x3d20b44d60956192),
+            W64LIT(0x04911b37071fdb52), W64LIT(0xf648f9168d6f0f7b) } },
+        { { W64LIT(0x9e566847e137bbbc), W64LIT(0xe434469e8a6a0bec),
+            W64LIT(0xb1c4276179d73463), W64LIT(0x5abe0285133d0015) },
+          { W64LIT(0x92aa837cc04c7dab), W64LIT(0x573d9f4c43260c07),
+            W64LIT(0x0c93156278e6cc37), W64LIT(0x94bb725b6b6f7383) } },
+        { { W64LIT(0x62a8c244bfe20925), W64LIT(0x91c19ac38fdce867),
+            W64LIT(0x5a96a5d5dd387063), W64LIT(0x61d587d421d324f6) },
+          { W64LIT(0xe87673a2a37173ea), W64LIT(0x2384800853778b65),
+            W64LIT(0x10f8441e05bab43e), W64LIT(0xfa11fe124621efbe) } },
+        { { W64LIT(0x1c891f2b2cb19ffd), W64LIT(0x01ba8d5bb1923c23),
+            W64LIT(0xb6d03d678ac5ca8e), W64LIT(0x586eb04c1f13bedc) },
+          { W64LIT(0x0c35c6e527e8ed09), W64LIT(0x1e81a33c1819ede2),
+            W64LIT(0x278fd6c056c652fa), W64LIT(0x19d5ac0870864f11) } },
+        { { W64LIT(0x62577734d2b533d5), W64LIT(0x673b8af6a1bdddc0),
+            W64LIT(0x577e7c9aa79ec293), W64LIT(0xbb6de651c3b266b1) },
+          { W64LIT(0xe7e9303ab65259b3), W64LIT(0xd6a0afd3d03a7480),
+            W64LIT(0xc5ac83d19b3cfc27), W64LIT(0x60b4619a5d18b99b) } },
+        { { W64LIT(0xbd6a38e11ae5aa1c), W64LIT(0xb8b7652b49e73658),
+            W64LIT(0x0b130014ee5f87ed), W64LIT(0x9d0f27b2aeebffcd) },
+          { W64LIT(0xca9246317a730a55), W64LIT(0x9c955b2fddbbc83a),
+            W64LIT(0x07c1dfe0ac019a71), W64LIT(0x244a566d356ec48d) } },
+        { { W64LIT(0x56f8410ef4f8b16a), W64LIT(0x97241afec47b266a),
+            W64LIT(0x0a406b8e6d9c87c1), W64LIT(0x803f3e02cd42ab1b) },
+          { W64LIT(0x7f0309a804dbec69), W64LIT(0xa83b85f73bbad05f),
+            W64LIT(0xc6097273ad8e197f), W64LIT(0xc097440e5067adc1) } },
+        { { W64LIT(0x846a56f2c379ab34), W64LIT(0xa8ee068b841df8d1),
+            W64LIT(0x20314459176c68ef), W64LIT(0xf1af32d5915f1f30) },
+          { W64LIT(0x99c375315d75bd50), W64LIT(0x837cffbaf72f67bc),
+            W64LIT(0x0613a41848d7723f), W64LIT(0x23d0f130e2d41c8b) } },
+        { { W64LIT(0xed93e225d5be5a2b), W64LIT(0x6fe799835934f3c6),
+            W64LIT(0x4314092622626ffc), W64LIT(0x50bbb4d97990216a) },
+          { W64LIT(0x378191c6e57ec63e), W64LIT(0x65422c40181dcdb2),
+            W64LIT(0x41a8099b0236e0f6), W64LIT(0x2b10011801fe49c3) } },
+        { { W64LIT(0xfc68b5c59b391593), W64LIT(0xc385f5a2598270fc),
+            W64LIT(0x7144f3aad19adcbb), W64LIT(0xdd55899983fbae0c) },
+          { W64LIT(0x93b88b8e74b82ff4), W64LIT(0xd2e03c4071e734c9),
+            W64LIT(0x9a7a9eaf43c0322a), W64LIT(0xe6e4c551149d6041) } },
+        { { W64LIT(0x5fe14bfe80ec21fe), W64LIT(0xf6ce116ac255be82),
+            W64LIT(0x98bc5a072f4a5d67), W64LIT(0xfad27148db7e63af) },
+          { W64LIT(0x90c0b6ac29ab05b3), W64LIT(0x37a9a83c4e251ae6),
+            W64LIT(0x0a7dc875c2aade7d), W64LIT(0x77387de39f0e1a84) } },
+        { { W64LIT(0x1e9ecc49a56c0dd7), W64LIT(0xa5cffcd846086c74),
+            W64LIT(0x8f7a1408f505aece), W64LIT(0xb37b85c0bef0c47e) },
+          { W64LIT(0x3596b6e4cc0e6a8f), W64LIT(0xfd6d4bbf6b388f23),
+            W64LIT(0xaba453fac39cef4e), W64LIT(0x9c135ac8f9f628d5) } },
+        { { W64LIT(0x0a1c729495c8f8be), W64LIT(0x2961c4803bf362bf),
+            W64LIT(0x9e418403df63d4ac), W64LIT(0xc109f9cb91ece900) },
+          { W64LIT(0xc2d095d058945705), W64LIT(0xb9083d96ddeb85c0),
+            W64LIT(0x84692b8d7a40449b), W64LIT(0x9bc3344f2eee1ee1) } },
+        { { W64LIT(0x0d5ae35642913074), W64LIT(0x55491b2748a542b1),
+            W64LIT(0x469ca665b310732a), W64LIT(0x29591d525f1a4cc1) },
+          { W64LIT(0xe76f5b6bb84f983f), W64LIT(0xbe7eef419f5f84e1),
+            W64LIT(0x1200d49680baa189), W64LIT(0x6376551f18ef332c) } }
+    },
+    {
+        { { W64LIT(0x202886024147519a), W64LIT(0xd0981eac26b372f0),
+            W64LIT(0xa9d4a7caa785ebc8), W64LIT(0xd953c50ddbdf58e9) },
+          { W64LIT(0x9d6361ccfd590f8f), W64LIT(0x72e9626b44e6c917),
+            W64LIT(0x7fd9611022eb64cf), W64LIT(0x863ebb7e9eb288f3) } },
+        { { W64LIT(0x4fe7ee31b0e63d34), W64LIT(0xf4600572a9e54fab),
+            W64LIT(0xc0493334d5e7b5a4), W64LIT(0x8589fb9206d54831) },
+          { W64LIT(0xaa70f5cc6583553a), W64LIT(0x0879094ae25649e5),
+            W64LIT(0xcc90450710044652), W64LIT(0xebb0696d02541c4f) } },
+        { { W64LIT(0xabbaa0c03b89da99), W64LIT(0xa6f2d79eb8284022),
+            W64LIT(0x27847862b81c05e8), W64LIT(0x337a4b5905e54d63) },
+          { W64LIT(0x3c67500d21f7794a), W64LIT(0x207005b77d6d7f61),
+            W64LIT(0x0a5a378104cfd6e8), W64LIT(0x0d65e0d5f4c2fbd6) } },
+        { { W64LIT(0xd433e50f6d3549cf), W64LIT(0x6f33696ffacd665e),
+            W64LIT(0x695bfdacce11fcb4), W64LIT(0x810ee252af7c9860) },
+          { W64LIT(0x65450fe17159bb2c), W64LIT(0xf7dfbebe758b357b),
+            W64LIT(0x2b057e74d69fea72), W64LIT(0xd485717a92731745) } },
+        { { W64LIT(0xce1f69bbe83f7669), W64LIT(0x09f8ae8272877d6b),
+            W64LIT(0x9548ae543244278d), W64LIT(0x207755dee3c2c19c) },
+          { W64LIT(0x87bd61d96fef1945), W64LIT(0x18813cefb12d28c3),
+            W64LIT(0x9fbcd1d672df64aa), W64LIT(0x48dc5ee57154b00d) } },
+        { { W64LIT(0xef0f469ef49a3154), W64LIT(0x3e85a5956e2b2e9a),
+            W64LIT(0x45aaec1eaa924a9c), W64LIT(0xaa12dfc8a09e4719) },
+          { W64LIT(0x26f272274df69f1d), W64LIT(0xe0e4c82ca2ff5e73),
+            W64LIT(0xb9d8ce73b7a9dd44), W64LIT(0x6c036e73e48ca901) } },
+        { { W64LIT(0xe1e421e1a47153f0), W64LIT(0xb86c3b79920418c9),
+            W64LIT(0x93bdce87705d7672), W64LIT(0xf25ae793cab79a77) },
+          { W64LIT(0x1f3194a36d869d0c), W64LIT(0x9d55c8824986c264),
+            W64LIT(0x49fb5ea3096e945e), W64LIT(0x39b8e65313db0a3e) } },
+        { { W64LIT(0xe3417bc035d0b34a), W64LIT(0x440b386b8327c0a7),
+            W64LIT(0x8fb7262dac0362d1), W64LIT(0x2c41114ce0cdf943) },
+          { W64LIT(0x2ba5cef1ad95a0b1), W64LIT(0xc09b37a867d54362),
+            W64LIT(0x26d6cdd201e486c9), W64LIT(0x20477abf42ff9297) } },
+        { { W64LIT(0x0f121b41bc0a67d2), W64LIT(0x62d4760a444d248a),
+            W64LIT(0x0e044f1d659b4737), W64LIT(0x08fde365250bb4a8) },
+          { W64LIT(0xaceec3da848bf287), W64LIT(0xc2a62182d3369d6e),
+            W64LIT(0x3582dfdc92449482), W64LIT(0x2f7e2fd2565d6cd7) } },
+        { { W64LIT(0x0a0122b5178a876b), W64LIT(0x51ff96ff085104b4),
+            W64LIT(0x050b31ab14f29f76), W64LIT(0x84abb28b5f87d4e6) },
+          { W64LIT(0xd5ed439f8270790a), W64LIT(0x2d6cb59d85e3f46b),
+            W64LIT(0x75f55c1b6c1e2212), W64LIT(0xe5436f6717655640) } },
+        { { W64LIT(0xc2965ecc9aeb596d), W64LIT(0x01ea03e7023c92b4),
+            W64LIT(0x4704b4b62e013961), W64LIT(0x0ca8fd3f905ea367) },
+          { W64LIT(0x92523a42551b2b61), W64LIT(0x1eb7a89c390fcd06),
+            W64LIT(0xe7f1d2be0392a63e), W64LIT(0x96dca2644ddb0c33) } },
+        { { W64LIT(0x231c210e15339848), W64LIT(0xe87a28e870778c8d),
+            W64LIT(0x9d1de6616956e170), W64LIT(0x4ac3c9382bb09c0b) },
+          { W64LIT(0x19be05516998987d), W64LIT(0x8b2376c4ae09f4d6),
+            W64LIT(0x1de0b7651a3f933d), W64LIT(0x380d94c7e39705f4) } },
+        { { W64LIT(0x3685954b8c31c31d), W64LIT(0x68533d005bf21a0c),
+            W64LIT(0x0bd7626e75c79ec9), W64LIT(0xca17754742c69d54) },
+          { W64LIT(0xcc6edafff6d2dbb2), W64LIT(0xfd0d8cbd174a9d18),
+            W64LIT(0x875e8793aa4578e8), W64LIT(0xa976a7139cab2ce6) } },
+        { { W64LIT(0xce37ab11b43ea1db), W64LIT(0x0a7ff1a95259d292),
+            W64LIT(0x851b02218f84f186), W64LIT(0xa7222beadefaad13) },
+          { W64LIT(0xa2ac78ec2b0a9144), W64LIT(0x5a024051f2fa59c5),
+            W64LIT(0x91d1eca56147ce38), W64LIT(0xbe94d523bc2ac690) } },
+        { { W64LIT(0x2d8daefd79ec1a0f), W64LIT(0x3bbcd6fdceb39c97),
+            W64LIT(0xf5575ffc58f61a95), W64LIT(0xdbd986c4adf7b420) },
+          { W64LIT(0x81aa881415f39eb7), W64LIT(0x6ee2fcf5b98d976c),
+            W64LIT(0x5465475dcf2f717d), W64LIT(0x8e24d3c46860bbd0) } }
+    }
+};
+
+
+/* all ones if a == b, zero otherwise */
+static INLINE word64 p256_eq_mask(word32 a, word32 b)
+{
+    return (word64)0 - (((word64)(a ^ b) - 1) >> 63);
+}
+
+
+/* r = t - p if t >= p, t is t0..t3 plus the bit t4 and below 2p */
+static INLINE void p256_fe_norm(p256_fe r, word64 t0, word64 t1, word64 t2,
+                                word64 t3, word64 t4)
+{
+    p256_word128 acc;
+    word64 s0, s1, s2, s3, mask;
+
+    acc = (p256_word128)t0 - P256_P0;
+    s0  = (word64)acc;
+    acc = (p256_word128)t1 - P256_P1 - ((word64)(acc >> 64) & 1);
+    s1  = (word64)acc;
+    acc = (p256_word128)t2 - ((word64)(acc >> 64) & 1);
+    s2  = (word64)acc;
+    acc = (p256_word128)t3 - P256_P3 - ((word64)(acc >> 64) & 1);
+    s3  = (word64)acc;
+
+    /* keep t - p unless that borrowed past the top bit */
+    mask = (word64)0 - (t4 | (((word64)(acc >> 64) & 1) ^ 1));
+
+    r[0] = (s0 & mask) | (t0 & ~mask);
+    r[1] = (s1 & mask) | (t1 & ~mask);
+    r[2] = (s2 & mask) | (t2 & ~mask);
+    r[3] = (s3 & mask) | (t3 & ~mask);
+}
+
+
+static void p256_fe_add(p256_fe r, const p256_fe a, const p256_fe b)
+{
+    p256_word128 acc;
+    word64 t0, t1, t2, t3;
+
+    acc = (p256_word128)a[0] + b[0];
+    t0  = (word64)acc;
+    acc = (p256_word128)a[1] + b[1] + (word64)(acc >> 64);
+    t1  = (word64)acc;
+    acc = (p256_word128)a[2] + b[2] + (word64)(acc >> 64);
+    t2  = (word64)acc;
+    acc = (p256_word128)a[3] + b[3] + (word64)(acc >> 64);
+    t3  = (word64)acc;
+
+    p256_fe_norm(r, t0, t1, t2, t3, (word64)(acc >> 64));
+}
+
+
+static void p256_fe_sub(p256_fe r, const p256_fe a, const p256_fe b)
+{
+    p256_word128 acc;
+    word64 t0, t1, t2, t3, mask;
+
+    acc = (p256_word128)a[0] - b[0];
+    t0  = (word64)acc;
+    acc = (p256_word128)a[1] - b[1] - ((word64)(acc >> 64) & 1);
+    t1  = (word64)acc;
+    acc = (p256_word128)a[2] - b[2] - ((word64)(acc >> 64) & 1);
+    t2  = (word64)acc;
+    acc = (p256_word128)a[3] - b[3] - ((word64)(acc >> 64) & 1);
+    t3  = (word64)acc;
+
+    /* add p back if it went negative */
+    mask = (word64)0 - ((word64)(acc >> 64) & 1);
+
+    acc  = (p256_word128)t0 + (P256_P0 & mask);
+    r[0] = (word64)acc;
+    acc  = (p256_word128)t1 + (P256_P1 & mask) + (word64)(acc >> 64);
+    r[1] = (word64)acc;
+    acc  = (p256_word128)t2 + (word64)(acc >> 64);
+    r[2] = (word64)acc;
+    acc  = (p256_word128)t3 + (P256_P3 & mask) + (word64)(acc >> 64);
+    r[3] = (word64)acc;
+}
+
+
+/* One round of Montgomery multiplication: t += ai * b, then add m * p with
+   m = t0 to clear the low limb and shift down a limb. m * p0 + t0 is just
+   m * 2^64 since p0 = 2^64 - 1, and p2 is zero. */
+#define P256_MONT_ROUND(ai)                                             \
+    acc = (p256_word128)(ai) * b0 + t0;                                 \
+    t0  = (word64)acc;                                                  \
+    acc = (p256_word128)(ai) * b1 + t1 + (word64)(acc >> 64);           \
+    t1  = (word64)acc;                                                  \
+    acc = (p256_word128)(ai) * b2 + t2 + (word64)(acc >> 64);           \
+    t2  = (word64)acc;                                                  \
+    acc = (p256_word128)(ai) * b3 + t3 + (word64)(acc >> 64);           \
+    t3  = (word64)acc;                                                  \
+    acc = (p256_word128)t4 + (word64)(acc >> 64);                       \
+    t4  = (word64)acc;                                                  \
+    t5  = (word64)(acc >> 64);                                          \
+    m   = t0;                                                           \
+    acc = (p256_word128)m * P256_P1 + t1 + m;                           \
+    t0  = (word64)acc;                                                  \
+    acc = (p256_word128)t2 + (word64)(acc >> 64);                       \
+    t1  = (word64)acc;                                                  \
+    acc = (p256_word128)m * P256_P3 + t3 + (word64)(acc >> 64);         \
+    t2  = (word64)acc;                                                  \
+    acc = (p256_word128)t4 + (word64)(acc >> 64);                       \
+    t3  = (word64)acc;                                                  \
+    t4  = t5 + (word64)(acc >> 64)
+
+
+/* r = a * b / 2^256 mod p, r may alias a or b */
+static void p256_fe_mul(p256_fe r, const p256_fe a, const p256_fe b)
+{
+    p256_word128 acc;
+    word64 t0 = 0, t1 = 0, t2 = 0, t3 = 0, t4 = 0, t5, m;
+    word64 a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+    word64 b0 = b[0], b1 = b[1], b2 = b[2], b3 = b[3];
+
+    P256_MONT_ROUND(a0);
+    P256_MONT_ROUND(a1);
+    P256_MONT_ROUND(a2);
+    P256_MONT_ROUND(a3);
+
+    p256_fe_norm(r, t0, t1, t2, t3, t4);
+}
+
+
+/* r = a^(p-2) = 1/a, the exponent is public so this is constant time */
+static void p256_fe_inv(p256_fe r, const p256_fe a)
+{
+    p256_fe t;
+    int i;
+
+    XMEMCPY(t, p256_one, sizeof(p256_fe));
+
+    for (i = 255; i >= 0; i--) {
+        p256_fe_mul(t, t, t);
+        if ((p256_p2[i / 64] >> (i % 64)) & 1)
+            p256_fe_mul(t, t, a);
+    }
+
+    XMEMCPY(r, t, sizeof(p256_fe));
+}
+
+
+/* load a 256 bit mp_int as plain limbs, scalars and coordinates */
+static int p256_from_mp(p256_fe r, mp_int* a)
+{
+    byte buf[P256_BYTES];
+    int  sz = mp_unsigned_bin_size(a);
+    int  i, j;
+
+    if (sz > P256_BYTES)
+        return ECC_BAD_ARG_E;
+
+    XMEMSET(buf, 0, sizeof(buf));
+    if (mp_to_unsigned_bin(a, buf + P256_BYTES - sz) != MP_OKAY)
+        return MP_TO_E;
+
+    for (i = 0; i < 4; i++) {
+        r[i] = 0;
+        for (j = 0; j < 8; j++)
+            r[i] |= (word64)buf[P256_BYTES - 1 - (i * 8 + j)] << (8 * j);
+    }
+    XMEMSET(buf, 0, sizeof(buf));
+
+    return MP_OKAY;
+}
+
+
+/* store a field element, out of Montgomery form */
+static int p256_to_mp(mp_int* r, const p256_fe a)
+{
+    byte    buf[P256_BYTES];
+    p256_fe t;
+    int     i, j;
+
+    XMEMSET(t, 0, sizeof(t));
+    t[0] = 1;
+    p256_fe_mul(t, a, t);
+
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 8; j++)
+            buf[P256_BYTES - 1 - (i * 8 + j)] = (byte)(t[i] >> (8 * j));
+
+    return mp_read_unsigned_bin(r, buf, P256_BYTES);
+}
+
+
+/* load a coordinate into Montgomery form, anything under 2^256 is fine */
+static int p256_coord_from_mp(p256_fe r, mp_int* a)
+{
+    int err = p256_from_mp(r, a);
+
+    if (err == MP_OKAY) {
+        p256_fe_norm(r, r[0], r[1], r[2], r[3], 0);
+        p256_fe_mul(r, r, p256_r2);
+    }
+
+    return err;
+}
+
+
+/* complete addition, RCB algorithm 4, r may alias p or q */
+static void p256_point_add(p256_point* r, const p256_point* p,
+                           const p256_point* q)
+{
+    p256_fe t0, t1, t2, t3, t4, x3, y3, z3;
+
+    p256_fe_mul(t0, p->x, q->x);
+    p256_fe_mul(t1, p->y, q->y);
+    p256_fe_mul(t2, p->z, q->z);
+    p256_fe_add(t3, p->x, p->y);
+    p256_fe_add(t4, q->x, q->y);
+    p256_fe_mul(t3, t3, t4);
+    p256_fe_add(t4, t0, t1);
+    p256_fe_sub(t3, t3, t4);
+    p256_fe_add(t4, p->y, p->z);
+    p256_fe_add(x3, q->y, q->z);
+    p256_fe_mul(t4, t4, x3);
+    p256_fe_add(x3, t1, t2);
+    p256_fe_sub(t4, t4, x3);
+    p256_fe_add(x3, p->x, p->z);
+    p256_fe_add(y3, q->x, q->z);
+    p256_fe_mul(x3, x3, y3);
+    p256_fe_add(y3, t0, t2);
+    p256_fe_sub(y3, x3, y3);
+    p256_fe_mul(z3, p256_b, t2);
+    p256_fe_sub(x3, y3, z3);
+    p256_fe_add(z3, x3, x3);
+    p256_fe_add(x3, x3, z3);
+    p256_fe_sub(z3, t1, x3);
+    p256_fe_add(x3, t1, x3);
+    p256_fe_mul(y3, p256_b, y3);
+    p256_fe_add(t1, t2, t2);
+    p256_fe_add(t2, t1, t2);
+    p256_fe_sub(y3, y3, t2);
+    p256_fe_sub(y3, y3, t0);
+    p256_fe_add(t1, y3, y3);
+    p256_fe_add(y3, t1, y3);
+    p256_fe_add(t1, t0, t0);
+    p256_fe_add(t0, t1, t0);
+    p256_fe_sub(t0, t0, t2);
+    p256_fe_mul(t1, t4, y3);
+    p256_fe_mul(t2, t0, y3);
+    p256_fe_mul(y3, x3, z3);
+    p256_fe_add(y3, y3, t2);
+    p256_fe_mul(x3, t3, x3);
+    p256_fe_sub(x3, x3, t1);
+    p256_fe_mul(z3, t4, z3);
+    p256_fe_mul(t1, t3, t0);
+    p256_fe_add(z3, z3, t1);
+
+    XMEMCPY(r->x, x3, sizeof(p256_fe));
+    XMEMCPY(r->y, y3, sizeof(p256_fe));
+    XMEMCPY(r->z, z3, sizeof(p256_fe));
+}
+
+
+/* complete doubling, RCB algorithm 6, r may alias p */
+static void p256_point_dbl(p256_point* r, const p256_point* p)
+{
+    p256_fe t0, t1, t2, t3, x3, y3, z3;
+
+    p256_fe_mul(t0, p->x, p->x);
+    p256_fe_mul(t1, p->y, p->y);
+    p256_fe_mul(t2, p->z, p->z);
+    p256_fe_mul(t3, p->x, p->y);
+    p256_fe_add(t3, t3, t3);
+    p256_fe_mul(z3, p->x, p->z);
+    p256_fe_add(z3, z3, z3);
+    p256_fe_mul(y3, p256_b, t2);
+    p256_fe_sub(y3, y3, z3);
+    p256_fe_add(x3, y3, y3);
+    p256_fe_add(y3, x3, y3);
+    p256_fe_sub(x3, t1, y3);
+    p256_fe_add(y3, t1, y3);
+    p256_fe_mul(y3, x3, y3);
+    p256_fe_mul(x3, x3, t3);
+    p256_fe_add(t3, t2, t2);
+    p256_fe_add(t2, t2, t3);
+    p256_fe_mul(z3, p256_b, z3);
+    p256_fe_sub(z3, z3, t2);
+    p256_fe_sub(z3, z3, t0);
+    p256_fe_add(t3, z3, z3);
+    p256_fe_add(z3, z3, t3);
+    p256_fe_add(t3, t0, t0);
+    p256_fe_add(t0, t3, t0);
+    p256_fe_sub(t0, t0, t2);
+    p256_fe_mul(t0, t0, z3);
+    p256_fe_add(y3, y3, t0);
+    p256_fe_mul(t0, p->y, p->z);
+    p256_fe_add(t0, t0, t0);
+    p256_fe_mul(z3, t0, z3);
+    p256_fe_sub(x3, x3, z3);
+    p256_fe_mul(z3, t0, t1);
+    p256_fe_add(z3, z3, z3);
+    p256_fe_add(z3, z3, z3);
+
+    XMEMCPY(r->x, x3, sizeof(p256_fe));
+    XMEMCPY(r->y, y3, sizeof(p256_fe));
+    XMEMCPY(r->z, z3, sizeof(p256_fe));
+}
+
+
+static void p256_point_identity(p256_point* r)
+{
+    XMEMSET(r, 0, sizeof(p256_point));
+    XMEMCPY(r->y, p256_one, sizeof(p256_fe));
+}
+
+
+/* r = table[idx], reading every entry */
+static void p256_select(p256_point* r, const p256_point* table, word32 idx)
+{
+    word64 mask;
+    int i, j;
+
+    XMEMSET(r, 0, sizeof(p256_point));
+
+    for (i = 0; i < P256_WINDOW; i++) {
+        mask = p256_eq_mask((word32)i, idx);
+        for (j = 0; j < 4; j++) {
+            r->x[j] |= table[i].x[j] & mask;
+            r->y[j] |= table[i].y[j] & mask;
+            r->z[j] |= table[i].z[j] & mask;
+        }
+    }
+}
+
+
+/* r = comb entry idx, 0 the identity, reading every entry */
+static void p256_select_comb(p256_point* r, const p256_affine* table,
+                             word32 idx)
+{
+    word64 mask;
+    int i, j;
+
+    XMEMSET(r, 0, sizeof(p256_point));
+
+    for (i = 0; i < P256_COMB; i++) {
+        mask = p256_eq_mask((word32)i + 1, idx);
+        for (j = 0; j < 4; j++) {
+            r->x[j] |= table[i].x[j] & mask;
+            r->y[j] |= table[i].y[j] & mask;
+        }
+    }
+
+    mask = p256_eq_mask(0, idx);
+    for (j = 0; j < 4; j++) {
+        r->y[j] |= p256_one[j] & mask;
+        r->z[j]  = p256_one[j] & ~mask;
+    }
+}
+
+
+/* r = k * G, comb with 4 teeth 64 bits apart over two tables */
+static void p256_mul_base(p256_point* r, const p256_fe k)
+{
+    p256_point t;
+    word32 idx;
+    int i, j;
+
+    p256_point_identity(r);
+
+    for (i = 31; i >= 0; i--) {
+        p256_point_dbl(r, r);
+
+        idx = 0;
+        for (j = 0; j < 4; j++)
+            idx |= (word32)((k[j] >> i) & 1) << j;
+        p256_select_comb(&t, p256_comb[0], idx);
+        p256_point_add(r, r, &t);
+
+        idx = 0;
+        for (j = 0; j < 4; j++)
+            idx |= (word32)((k[j] >> (i + 32)) & 1) << j;
+        p256_select_comb(&t, p256_comb[1], idx);
+        p256_point_add(r, r, &t);
+    }
+
+    XMEMSET(&t, 0, sizeof(t));
+}
+
+
+/* r = k * p, fixed 4 bit window */
+static void p256_mul(p256_point* r, const p256_point* p, const p256_fe k)
+{
+    p256_point table[P256_WINDOW];
+    p256_point t;
+    word32 idx;
+    int i;
+
+    p256_point_identity(&table[0]);
+    XMEMCPY(&table[1], p, sizeof(p256_point));
+    for (i = 2; i < P256_WINDOW; i++)
+        p256_point_add(&table[i], &table[i - 1], p);
+
+    p256_point_identity(r);
+
+    for (i = 63; i >= 0; i--) {
+        p256_point_dbl(r, r);
+        p256_point_dbl(r, r);
+        p256_point_dbl(r, r);
+        p256_point_dbl(r, r);
+
+        idx = (word32)(k[i / 16] >> ((i % 16) * 4)) & 0xf;
+        p256_select(&t, table, idx);
+        p256_point_add(r, r, &t);
+    }
+
+    XMEMSET(&t, 0, sizeof(t));
+    XMEMSET(table, 0, sizeof(table));
+}
+
+
+/* load an ecc.c point, which is jacobian with x = X/Z^2 and y = Y/Z^3, so
+   (XZ : Y : Z^3) is the same point in homogeneous coordinates */
+static int p256_point_from_ecc(p256_point* r, ecc_point* p)
+{
+    p256_fe z2;
+    int err;
+
+    err = p256_coord_from_mp(r->x, &p->x);
+    if (err == MP_OKAY)
+        err = p256_coord_from_mp(r->y, &p->y);
+    if (err == MP_OKAY)
+        err = p256_coord_from_mp(r->z, &p->z);
+    if (err != MP_OKAY)
+        return err;
+
+    if (mp_cmp_d(&p->z, 1) != MP_EQ) {
+        p256_fe_mul(r->x, r->x, r->z);
+        p256_fe_mul(z2, r->z, r->z);
+        p256_fe_mul(r->z, z2, r->z);
+    }
+
+    return MP_OKAY;
+}
+
+
+/* store as an affine ecc.c point */
+static int p256_point_to_ecc(ecc_point* r, const p256_point* p)
+{
+    p256_fe zi, x, y;
+    int err;
+
+    p256_fe_inv(zi, p->z);
+    p256_fe_mul(x, p->x, zi);
+    p256_fe_mul(y, p->y, zi);
+
+    err = p256_to_mp(&r->x, x);
+    if (err == MP_OKAY)
+        err = p256_to_mp(&r->y, y);
+    if (err == MP_OKAY)
+        mp_set(&r->z, 1);
+
+    return err;
+}
+
+
+/** P-256 base point multiply
+    k        The multiplicand, at most 256 bits
+    R        [out] Destination of k * G, affine
+    return MP_OKAY if successful
+*/
+int ecc_p256_mulmod_base(mp_int* k, ecc_point* R)
+{
+    p256_point r;
+    p256_fe    sk;
+    int        err;
+
+    if (k == NULL || R == NULL)
+        return ECC_BAD_ARG_E;
+
+    err = p256_from_mp(sk, k);
+    if (err == MP_OKAY) {
+        p256_mul_base(&r, sk);
+        err = p256_point_to_ecc(R, &r);
+    }
+
+    XMEMSET(sk, 0, sizeof(sk));
+
+    return err;
+}
+
+
+/** P-256 point multiply
+    k        The multiplicand, at most 256 bits
+    P        Point to multiply
+    R        [out] Destination of k * P, affine, may be P
+    return MP_OKAY if successful
+*/
+int ecc_p256_mulmod(mp_int* k, ecc_point* P, ecc_point* R)
+{
+    p256_point p, r;
+    p256_fe    sk;
+    int        err;
+
+    if (k == NULL || P == NULL || R == NULL)
+        return ECC_BAD_ARG_E;
+
+    err = p256_from_mp(sk, k);
+    if (err == MP_OKAY)
+        err = p256_point_from_ecc(&p, P);
+    if (err == MP_OKAY) {
+        p256_mul(&r, &p, sk);
+        err = p256_point_to_ecc(R, &r);
+    }
+
+    XMEMSET(sk, 0, sizeof(sk));
+
+    return err;
+}
+
+
+/** P-256 kG * G + kP * P, for signature verification
+    kG       What to multiply G by
+    kP       What to multiply P by
+    P        Second point
+    R        [out] Destination, affine, may be P
+    return MP_OKAY if successful
+*/
+int ecc_p256_mul2add(mp_int* kG, mp_int* kP, ecc_point* P, ecc_point* R)
+{
+    p256_point p, r, t;
+    p256_fe    sg, sp;
+    int        err;
+
+    if (kG == NULL || kP == NULL || P == NULL || R == NULL)
+        return ECC_BAD_ARG_E;
+
+    err = p256_from_mp(sg, kG);
+    if (err == MP_OKAY)
+        err = p256_from_mp(sp, kP);
+    if (err == MP_OKAY)
+        err = p256_point_from_ecc(&p, P);
+    if (err == MP_OKAY) {
+        p256_mul_base(&r, sg);
+        p256_mul(&t, &p, sp);
+        p256_point_add(&r, &r, &t);
+        err = p256_point_to_ecc(R, &r);
+    }
+
+    return err;
+}
+
+#endif /* HAVE_ECC && HAVE_ECC_P256 */
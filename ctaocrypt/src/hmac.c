@@ -93,6 +93,52 @@ static int InitHmac(Hmac* hmac, int type)
 }
 
 
+/* add one block of key pad to state */
+static void HmacHashPad(Hmac* hmac, Hash* state, const byte* pad)
+{
+    switch (hmac->macType) {
+        #ifndef NO_MD5
+        case MD5:
+            Md5Update(&state->md5, pad, MD5_BLOCK_SIZE);
+        break;
+        #endif
+
+        #ifndef NO_SHA
+        case SHA:
+            ShaUpdate(&state->sha, pad, SHA_BLOCK_SIZE);
+        break;
+        #endif
+
+        #ifndef NO_SHA256
+        case SHA256:
+            Sha256Update(&state->sha256, pad, SHA256_BLOCK_SIZE);
+        break;
+        #endif
+
+        #ifdef CYASSL_SHA384
+        case SHA384:
+            Sha384Update(&state->sha384, pad, SHA384_BLOCK_SIZE);
+        break;
+        #endif
+
+        #ifdef CYASSL_SHA512
+        case SHA512:
+            Sha512Update(&state->sha512, pad, SHA512_BLOCK_SIZE);
+        break;
+        #endif
+
+        #ifdef HAVE_BLAKE2 
+        case BLAKE2B_ID:
+            Blake2bUpdate(&state->blake2b, pad, BLAKE2B_BLOCKBYTES);
+        break;
+        #endif
+
+        default:
+        break;
+    }
+}
+
+
 int HmacSetKey(Hmac* hmac, int type, const byte* key, word32 length)
 {
     byte*  ip = (byte*) hmac->ipad;
@@ -216,58 +262,42 @@ int HmacSetKey(Hmac* hmac, int type, const byte* key, word32 length)
         op[i] = ip[i] ^ OPAD;
         ip[i] ^= IPAD;
     }
+
+#ifdef HMAC_PAD_STATES
+    /* hash the pads once, each message then starts from a copy */
+    ret = InitHmac(hmac, type);
+    if (ret != 0)
+        return ret;
+    XMEMCPY(&hmac->innerState, &hmac->hash, sizeof(Hash));
+    XMEMCPY(&hmac->outerState, &hmac->hash, sizeof(Hash));
+    HmacHashPad(hmac, &hmac->innerState, ip);
+    HmacHashPad(hmac, &hmac->outerState, op);
+#endif
+
     return 0;
 }
 
 
 static void HmacKeyInnerHash(Hmac* hmac)
 {
-    switch (hmac->macType) {
-        #ifndef NO_MD5
-        case MD5:
-            Md5Update(&hmac->hash.md5, (byte*) hmac->ipad, MD5_BLOCK_SIZE);
-        break;
-        #endif
-
-        #ifndef NO_SHA
-        case SHA:
-            ShaUpdate(&hmac->hash.sha, (byte*) hmac->ipad, SHA_BLOCK_SIZE);
-        break;
-        #endif
-
-        #ifndef NO_SHA256
-        case SHA256:
-            Sha256Update(&hmac->hash.sha256,
-                                         (byte*) hmac->ipad, SHA256_BLOCK_SIZE);
-        break;
-        #endif
-
-        #ifdef CYASSL_SHA384
-        case SHA384:
-            Sha384Update(&hmac->hash.sha384,
-                                         (byte*) hmac->ipad, SHA384_BLOCK_SIZE);
-        break;
-        #endif
-
-        #ifdef CYASSL_SHA512
-        case SHA512:
-            Sha512Update(&hmac->hash.sha512,
-                                         (byte*) hmac->ipad, SHA512_BLOCK_SIZE);
-        break;
-        #endif
+#ifdef HMAC_PAD_STATES
+    XMEMCPY(&hmac->hash, &hmac->innerState, sizeof(Hash));
+#else
+    HmacHashPad(hmac, &hmac->hash, (byte*) hmac->ipad);
+#endif
 
-        #ifdef HAVE_BLAKE2 
-        case BLAKE2B_ID:
-            Blake2bUpdate(&hmac->hash.blake2b,
-                                         (byte*) hmac->ipad,BLAKE2B_BLOCKBYTES);
-        break;
-        #endif
+    hmac->innerHashKeyed = 1;
+}
 
-        default:
-        break;
-    }
 
-    hmac->innerHashKeyed = 1;
+/* start the outer hash, hash holds a fresh state after the inner final */
+static void HmacKeyOuterHash(Hmac* hmac)
+{
+#ifdef HMAC_PAD_STATES
+    XMEMCPY(&hmac->hash, &hmac->outerState, sizeof(Hash));
+#else
+    HmacHashPad(hmac, &hmac->hash, (byte*) hmac->opad);
+#endif
 }
 
 
@@ -341,7 +371,7 @@ void HmacFinal(Hmac* hmac, byte* hash)
         {
             Md5Final(&hmac->hash.md5, (byte*) hmac->innerHash);
 
-            Md5Update(&hmac->hash.md5, (byte*) hmac->opad, MD5_BLOCK_SIZE);
+            HmacKeyOuterHash(hmac);
             Md5Update(&hmac->hash.md5,
                                      (byte*) hmac->innerHash, MD5_DIGEST_SIZE);
 
@@ -355,7 +385,7 @@ void HmacFinal(Hmac* hmac, byte* hash)
         {
             ShaFinal(&hmac->hash.sha, (byte*) hmac->innerHash);
 
-            ShaUpdate(&hmac->hash.sha, (byte*) hmac->opad, SHA_BLOCK_SIZE);
+            HmacKeyOuterHash(hmac);
             ShaUpdate(&hmac->hash.sha,
                                      (byte*) hmac->innerHash, SHA_DIGEST_SIZE);
 
@@ -369,8 +399,7 @@ void HmacFinal(Hmac* hmac, byte* hash)
         {
             Sha256Final(&hmac->hash.sha256, (byte*) hmac->innerHash);
 
-            Sha256Update(&hmac->hash.sha256,
-                                (byte*) hmac->opad, SHA256_BLOCK_SIZE);
+            HmacKeyOuterHash(hmac);
             Sha256Update(&hmac->hash.sha256,
                                 (byte*) hmac->innerHash, SHA256_DIGEST_SIZE);
 
@@ -384,8 +413,7 @@ void HmacFinal(Hmac* hmac, byte* hash)
         {
             Sha384Final(&hmac->hash.sha384, (byte*) hmac->innerHash);
 
-            Sha384Update(&hmac->hash.sha384,
-                                 (byte*) hmac->opad, SHA384_BLOCK_SIZE);
+            HmacKeyOuterHash(hmac);
             Sha384Update(&hmac->hash.sha384,
                                  (byte*) hmac->innerHash, SHA384_DIGEST_SIZE);
 
@@ -399,8 +427,7 @@ void HmacFinal(Hmac* hmac, byte* hash)
         {
             Sha512Final(&hmac->hash.sha512, (byte*) hmac->innerHash);
 
-            Sha512Update(&hmac->hash.sha512,
-                                 (byte*) hmac->opad, SHA512_BLOCK_SIZE);
+            HmacKeyOuterHash(hmac);
             Sha512Update(&hmac->hash.sha512,
                                  (byte*) hmac->innerHash, SHA512_DIGEST_SIZE);
 
@@ -414,8 +441,7 @@ void HmacFinal(Hmac* hmac, byte* hash)
         {
             Blake2bFinal(&hmac->hash.blake2b, (byte*) hmac->innerHash,
                          BLAKE2B_256);
-            Blake2bUpdate(&hmac->hash.blake2b,
-                                 (byte*) hmac->opad, BLAKE2B_BLOCKBYTES);
+            HmacKeyOuterHash(hmac);
             Blake2bUpdate(&hmac->hash.blake2b,
                                  (byte*) hmac->innerHash, BLAKE2B_256);
             Blake2bFinal(&hmac->hash.blake2b, hash, BLAKE2B_256);
@@ -431,6 +457,173 @@ void HmacFinal(Hmac* hmac, byte* hash)
 }
 
 
+
+#ifndef NO_AES
+
+enum {
+    HMAC_CBC_DEC_STEP = 256   /* decrypt ahead, two eight block AES-NI runs */
+};
+
+
+/* block size of the hash under hmac and how much of the current block is
+   filled, 0 for hashes the stitched CBC loops leave alone */
+static word32 HmacHashBlock(Hmac* hmac, word32* used)
+{
+    switch (hmac->macType) {
+        #ifndef NO_MD5
+        case MD5:
+            *used = hmac->hash.md5.buffLen;
+            return MD5_BLOCK_SIZE;
+        #endif
+
+        #ifndef NO_SHA
+        case SHA:
+            *used = hmac->hash.sha.buffLen;
+            return SHA_BLOCK_SIZE;
+        #endif
+
+        #ifndef NO_SHA256
+        case SHA256:
+            *used = hmac->hash.sha256.buffLen;
+            return SHA256_BLOCK_SIZE;
+        #endif
+
+        #ifdef CYASSL_SHA384
+        case SHA384:
+            *used = hmac->hash.sha384.buffLen;
+            return SHA384_BLOCK_SIZE;
+        #endif
+
+        default:
+            return 0;
+    }
+}
+
+
+/* can hmac and aes take the stitched loops, sets up the inner hash */
+static word32 HmacCbcStitch(Hmac* hmac, Aes* aes, word32* used)
+{
+#ifdef HAVE_CAVIUM
+    if (hmac->magic == CYASSL_HMAC_CAVIUM_MAGIC ||
+                                        aes->magic == CYASSL_AES_CAVIUM_MAGIC)
+        return 0;
+#else
+    (void)aes;
+#endif
+
+    if (!hmac->innerHashKeyed)
+        HmacKeyInnerHash(hmac);
+
+    return HmacHashBlock(hmac, used);
+}
+
+
+/* HMAC update stitched with in place AES-CBC encryption of the record it
+   covers, for MAC then encrypt. Encryption starts at cbc, at or before msg.
+   Each whole hash block is followed by CBC up to where hashing got to, so
+   the serial CBC chain runs while the next block is compressed. *cbcSz gets
+   how much was encrypted, the caller does the rest once the MAC and padding
+   are in place. */
+int HmacUpdateAesCbcEncrypt(Hmac* hmac, const byte* msg, word32 length,
+                            Aes* aes, byte* cbc, word32* cbcSz)
+{
+    word32 end  = (word32)(msg - cbc);      /* hashed up to here from cbc */
+    word32 done = 0;                        /* encrypted from cbc */
+    word32 used = 0;
+    word32 blockSz, n;
+    int    ret;
+
+    *cbcSz = 0;
+
+    blockSz = HmacCbcStitch(hmac, aes, &used);
+    if (blockSz == 0) {
+        HmacUpdate(hmac, msg, length);
+        return 0;
+    }
+
+    /* top up the partial block, then whole blocks go straight from msg */
+    n = (blockSz - used) % blockSz;
+    if (n > length)
+        n = length;
+    HmacUpdate(hmac, msg, n);
+    msg    += n;
+    length -= n;
+    end    += n;
+
+    while (length >= blockSz) {
+        HmacUpdate(hmac, msg, blockSz);
+        msg    += blockSz;
+        length -= blockSz;
+        end    += blockSz;
+
+        n = (end - done) & ~(AES_BLOCK_SIZE - 1);
+        ret = AesCbcEncrypt(aes, cbc + done, cbc + done, n);
+        if (ret != 0)
+            return ret;
+        done += n;
+    }
+    HmacUpdate(hmac, msg, length);
+
+    *cbcSz = done;
+
+    return 0;
+}
+
+
+/* HMAC update over msg while AES-CBC decrypts cbcSz bytes in place from cbc,
+   msg has to lie inside that span. Decryption stays a few blocks ahead,
+   wide enough for the parallel CBC decrypt, and hashing follows in whole
+   blocks so nothing goes through the hash buffer. */
+int HmacUpdateAesCbcDecrypt(Hmac* hmac, const byte* msg, word32 length,
+                            Aes* aes, byte* cbc, word32 cbcSz)
+{
+    word32 start  = (word32)(msg - cbc);    /* msg offset from cbc */
+    word32 done   = 0;                      /* decrypted from cbc */
+    word32 hashed = 0;                      /* hashed from msg */
+    word32 used   = 0;
+    word32 blockSz, n;
+    int    ret;
+
+    blockSz = HmacCbcStitch(hmac, aes, &used);
+    if (blockSz == 0) {
+        ret = AesCbcDecrypt(aes, cbc, cbc, cbcSz);
+        if (ret == 0)
+            HmacUpdate(hmac, msg, length);
+        return ret;
+    }
+
+    while (done < cbcSz) {
+        n = cbcSz - done;
+        if (n > HMAC_CBC_DEC_STEP)
+            n = HMAC_CBC_DEC_STEP;
+        ret = AesCbcDecrypt(aes, cbc + done, cbc + done, n);
+        if (ret != 0)
+            return ret;
+        done += n;
+
+        if (done <= start)
+            continue;
+        n = done - start;
+        if (n > length)
+            n = length;
+        n -= hashed;
+
+        if (done < cbcSz) {
+            HmacHashBlock(hmac, &used);
+            if (used + n < blockSz)
+                continue;
+            n -= (used + n) % blockSz;
+        }
+        HmacUpdate(hmac, msg + hashed, n);
+        hashed += n;
+    }
+
+    return 0;
+}
+
+#endif /* NO_AES */
+
+
 #ifdef HAVE_CAVIUM
 
 /* Initiliaze Hmac for use with Nitrox device */
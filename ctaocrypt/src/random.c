@@ -33,8 +33,12 @@
 #include <cyassl/ctaocrypt/random.h>
 #include <cyassl/ctaocrypt/error.h>
 
-#ifdef NO_RC4
-    #include <cyassl/ctaocrypt/sha256.h>
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    #ifdef HAVE_CTR_DRBG
+        #include <cyassl/ctaocrypt/aes.h>
+    #else
+        #include <cyassl/ctaocrypt/sha256.h>
+    #endif
 
     #ifdef NO_INLINE
         #include <cyassl/ctaocrypt/misc.h>
@@ -62,7 +66,7 @@
 #endif /* USE_WINDOWS_API */
 
 
-#ifdef NO_RC4
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
 
 /* Start NIST DRBG code */
 
@@ -86,6 +90,209 @@ enum {
 };
 
 
+static INLINE void array_add_one(byte* data, word32 dataSz)
+{
+    int i;
+
+    for (i = dataSz - 1; i >= 0; i--)
+    {
+        data[i]++;
+        if (data[i] != 0) break;
+    }
+}
+
+
+#ifdef HAVE_CTR_DRBG
+
+/* CTR_DRBG of SP 800-90A 10.2 with AES-256 and the derivation function, so
+   any length of seed material works. The DRBG Key is the key schedule of
+   rng->aes and V lives in aes.reg one ahead, the next counter block, so the
+   keystream comes straight out of AesCtrEncrypt and AES-NI when built */
+
+#define CTR_DRBG_KEY_SZ   32
+#define CTR_DRBG_SEED_LEN (CTR_DRBG_KEY_SZ + AES_BLOCK_SIZE)
+#define CTR_DRBG_MAX_REQ  0x10000                 /* 2^19 bits per request */
+
+
+/* BCC of 10.3.3 over IV || S, S = L || N || input || 0x80 || 0 pad, the
+   CBC-MAC of the block cipher derivation function */
+static void Ctr_DRBG_BCC(Aes* aes, byte* mac, word32 i, const byte* in,
+                         word32 inSz)
+{
+    byte   block[AES_BLOCK_SIZE];
+    word32 idx;
+
+    XMEMSET(block, 0, sizeof(block));
+    block[0] = (byte)(i >> 24);
+    block[1] = (byte)(i >> 16);
+    block[2] = (byte)(i >>  8);
+    block[3] = (byte) i;
+    AesSetIV(aes, NULL);
+    AesCbcEncrypt(aes, block, block, AES_BLOCK_SIZE);
+
+    block[0] = (byte)(inSz >> 24);
+    block[1] = (byte)(inSz >> 16);
+    block[2] = (byte)(inSz >>  8);
+    block[3] = (byte) inSz;
+    block[4] = 0;
+    block[5] = 0;
+    block[6] = 0;
+    block[7] = CTR_DRBG_SEED_LEN;
+    idx = 8;
+
+    while (inSz > 0) {
+        word32 n = AES_BLOCK_SIZE - idx;
+
+        if (n > inSz)
+            n = inSz;
+        XMEMCPY(block + idx, in, n);
+        idx  += n;
+        in   += n;
+        inSz -= n;
+        if (idx == AES_BLOCK_SIZE) {
+            AesCbcEncrypt(aes, block, block, AES_BLOCK_SIZE);
+            idx = 0;
+        }
+    }
+    block[idx++] = 0x80;
+    XMEMSET(block + idx, 0, AES_BLOCK_SIZE - idx);
+    AesCbcEncrypt(aes, mac, block, AES_BLOCK_SIZE);
+
+    XMEMSET(block, 0, sizeof(block));
+}
+
+
+/* Block_Cipher_df of 10.3.2, seed material to CTR_DRBG_SEED_LEN bytes */
+static void Ctr_DRBG_df(byte* out, const byte* in, word32 inSz)
+{
+    Aes    aes;
+    byte   temp[CTR_DRBG_SEED_LEN];
+    byte*  x;
+    word32 i;
+
+    for (i = 0; i < CTR_DRBG_KEY_SZ; i++)
+        temp[i] = (byte)i;
+    AesSetKey(&aes, temp, CTR_DRBG_KEY_SZ, NULL, AES_ENCRYPTION);
+
+    for (i = 0; i < CTR_DRBG_SEED_LEN / AES_BLOCK_SIZE; i++)
+        Ctr_DRBG_BCC(&aes, temp + i * AES_BLOCK_SIZE, i, in, inSz);
+
+    /* K is the left of temp and X the rest, out is E(K, X), E(K, E(K, X)) .. */
+    AesSetKey(&aes, temp, CTR_DRBG_KEY_SZ, NULL, AES_ENCRYPTION);
+    x = temp + CTR_DRBG_KEY_SZ;
+    for (i = 0; i < CTR_DRBG_SEED_LEN / AES_BLOCK_SIZE; i++) {
+        AesSetIV(&aes, NULL);
+        AesCbcEncrypt(&aes, out, x, AES_BLOCK_SIZE);
+        x    = out;
+        out += AES_BLOCK_SIZE;
+    }
+
+    XMEMSET(temp, 0, sizeof(temp));
+    XMEMSET(&aes, 0, sizeof(aes));
+}
+
+
+/* CTR_DRBG_Update of 10.2.1.2, provided is CTR_DRBG_SEED_LEN bytes or NULL
+   for all zeros */
+static void Ctr_DRBG_Update(RNG* rng, const byte* provided)
+{
+    byte temp[CTR_DRBG_SEED_LEN];
+
+    if (provided)
+        XMEMCPY(temp, provided, sizeof(temp));
+    else
+        XMEMSET(temp, 0, sizeof(temp));
+
+    AesCtrEncrypt(&rng->aes, temp, temp, sizeof(temp));
+    AesSetKey(&rng->aes, temp, CTR_DRBG_KEY_SZ, temp + CTR_DRBG_KEY_SZ,
+              AES_ENCRYPTION);
+    array_add_one((byte*)rng->aes.reg, AES_BLOCK_SIZE);
+
+    XMEMSET(temp, 0, sizeof(temp));
+}
+
+
+static int Ctr_DRBG_Reseed(RNG* rng, byte* entropy, word32 entropySz)
+{
+    byte seed[CTR_DRBG_SEED_LEN];
+
+    Ctr_DRBG_df(seed, entropy, entropySz);
+    Ctr_DRBG_Update(rng, seed);
+    XMEMSET(seed, 0, sizeof(seed));
+
+    rng->reseed_ctr = 1;
+    return 0;
+}
+
+
+static int Ctr_DRBG_Generate(RNG* rng, byte* out, word32 outSz)
+{
+    while (outSz > 0) {
+        word32 sz = outSz < CTR_DRBG_MAX_REQ ? outSz : CTR_DRBG_MAX_REQ;
+        word32 tail = sz % AES_BLOCK_SIZE;
+
+        if (rng->reseed_ctr == RESEED_MAX)
+            return DBRG_NEED_RESEED;
+
+        XMEMSET(out, 0, sz);
+        AesCtrEncrypt(&rng->aes, out, out, sz - tail);
+        if (tail) {
+            byte block[AES_BLOCK_SIZE];
+
+            XMEMSET(block, 0, sizeof(block));
+            AesCtrEncrypt(&rng->aes, block, block, AES_BLOCK_SIZE);
+            XMEMCPY(out + sz - tail, block, tail);
+            XMEMSET(block, 0, sizeof(block));
+        }
+        Ctr_DRBG_Update(rng, NULL);
+        rng->reseed_ctr++;
+
+        out   += sz;
+        outSz -= sz;
+    }
+
+    return DBRG_SUCCESS;
+}
+
+
+static void Ctr_DRBG_Instantiate(RNG* rng, byte* seed, word32 seedSz)
+{
+    byte material[CTR_DRBG_SEED_LEN];
+
+    XMEMSET(rng, 0, sizeof(*rng));
+
+    /* Key and V start all zeros */
+    XMEMSET(material, 0, sizeof(material));
+    AesSetKey(&rng->aes, material, CTR_DRBG_KEY_SZ, NULL, AES_ENCRYPTION);
+    AesSetIV(&rng->aes, NULL);
+    array_add_one((byte*)rng->aes.reg, AES_BLOCK_SIZE);
+
+    Ctr_DRBG_df(material, seed, seedSz);
+    Ctr_DRBG_Update(rng, material);
+    XMEMSET(material, 0, sizeof(material));
+    rng->reseed_ctr = 1;
+}
+
+
+static int Ctr_DRBG_Uninstantiate(RNG* rng)
+{
+    int result = DBRG_ERROR;
+
+    if (rng != NULL) {
+        XMEMSET(rng, 0, sizeof(*rng));
+        result = DBRG_SUCCESS;
+    }
+
+    return result;
+}
+
+#define DRBG_Instantiate   Ctr_DRBG_Instantiate
+#define DRBG_Reseed        Ctr_DRBG_Reseed
+#define DRBG_Generate      Ctr_DRBG_Generate
+#define DRBG_Uninstantiate Ctr_DRBG_Uninstantiate
+
+#else /* HAVE_CTR_DRBG */
+
 static int Hash_df(RNG* rng, byte* out, word32 outSz, byte type, byte* inA, word32 inASz,
                                byte* inB, word32 inBSz, byte* inC, word32 inCSz)
 {
@@ -145,17 +352,6 @@ static int Hash_DBRG_Reseed(RNG* rng, byte* entropy, word32 entropySz)
     return 0;
 }
 
-static INLINE void array_add_one(byte* data, word32 dataSz)
-{
-    int i;
-
-    for (i = dataSz - 1; i >= 0; i--)
-    {
-        data[i]++;
-        if (data[i] != 0) break;
-    }
-}
-
 static void Hash_gen(RNG* rng, byte* out, word32 outSz, byte* V)
 {
     byte data[DBRG_SEED_LEN];
@@ -249,6 +445,13 @@ static int Hash_DBRG_Uninstantiate(RNG* rng)
     return result;
 }
 
+#define DRBG_Instantiate   Hash_DBRG_Instantiate
+#define DRBG_Reseed        Hash_DBRG_Reseed
+#define DRBG_Generate      Hash_DBRG_Generate
+#define DRBG_Uninstantiate Hash_DBRG_Uninstantiate
+
+#endif /* HAVE_CTR_DRBG */
+
 /* End NIST DRBG Code */
 
 
@@ -260,7 +463,7 @@ int InitRng(RNG* rng)
     int  ret = DBRG_ERROR;
 
     if (GenerateSeed(&rng->seed, entropy, sizeof(entropy)) == 0) {
-        Hash_DBRG_Instantiate(rng, entropy, sizeof(entropy));
+        DRBG_Instantiate(rng, entropy, sizeof(entropy));
         ret = DBRG_SUCCESS;
     }
     XMEMSET(entropy, 0, sizeof(entropy));
@@ -268,19 +471,19 @@ int InitRng(RNG* rng)
 }
 
 
-/* place a generated block in output */
-void RNG_GenerateBlock(RNG* rng, byte* output, word32 sz)
+/* generate straight from the DRBG, reseeding from the OS when it asks */
+static void DRBG_GenerateBlock(RNG* rng, byte* output, word32 sz)
 {
     int ret;
 
     XMEMSET(output, 0, sz);
-    ret = Hash_DBRG_Generate(rng, output, sz);
+    ret = DRBG_Generate(rng, output, sz);
     if (ret == DBRG_NEED_RESEED) {
         byte entropy[ENTROPY_SZ];
         ret = GenerateSeed(&rng->seed, entropy, sizeof(entropy));
         if (ret == 0) {
-            Hash_DBRG_Reseed(rng, entropy, sizeof(entropy));
-            ret = Hash_DBRG_Generate(rng, output, sz);
+            DRBG_Reseed(rng, entropy, sizeof(entropy));
+            ret = DRBG_Generate(rng, output, sz);
         }
         else
             ret = DBRG_ERROR;
@@ -289,6 +492,35 @@ void RNG_GenerateBlock(RNG* rng, byte* output, word32 sz)
 }
 
 
+/* place a generated block in output, small requests on a buffered RNG come
+   out of one RNG_BUFFER_SZ batch instead of a DRBG generate each */
+void RNG_GenerateBlock(RNG* rng, byte* output, word32 sz)
+{
+    if (!rng->buffered || sz > RNG_BUFFER_SZ / 4) {
+        DRBG_GenerateBlock(rng, output, sz);
+        return;
+    }
+
+    while (sz > 0) {
+        byte*  out;
+        word32 n;
+
+        if (rng->outSz == 0) {
+            DRBG_GenerateBlock(rng, rng->out, RNG_BUFFER_SZ);
+            rng->outSz = RNG_BUFFER_SZ;
+        }
+        n   = sz < rng->outSz ? sz : rng->outSz;
+        out = rng->out + RNG_BUFFER_SZ - rng->outSz;
+
+        XMEMCPY(output, out, n);
+        XMEMSET(out, 0, n);         /* handed out bytes don't stay behind */
+        rng->outSz -= n;
+        output     += n;
+        sz         -= n;
+    }
+}
+
+
 byte RNG_GenerateByte(RNG* rng)
 {
     byte b;
@@ -298,12 +530,63 @@ byte RNG_GenerateByte(RNG* rng)
 }
 
 
+/* instantiate from caller supplied seed material instead of the OS, e.g.
+   output of another DRBG */
+int InitRngSeed(RNG* rng, const byte* seed, word32 sz)
+{
+    if (rng == NULL || seed == NULL || sz == 0)
+        return BAD_FUNC_ARG;
+
+    DRBG_Instantiate(rng, (byte*)seed, sz);
+
+    return 0;
+}
+
+
+/* mix fresh OS entropy into the DRBG state, buffered output made before
+   doesn't survive it */
+int RNG_Reseed(RNG* rng)
+{
+    byte entropy[ENTROPY_SZ];
+    int  ret;
+
+    if (rng == NULL)
+        return BAD_FUNC_ARG;
+
+    ret = GenerateSeed(&rng->seed, entropy, sizeof(entropy));
+    if (ret == 0) {
+        DRBG_Reseed(rng, entropy, sizeof(entropy));
+        XMEMSET(rng->out, 0, sizeof(rng->out));
+        rng->outSz = 0;
+    }
+    XMEMSET(entropy, 0, sizeof(entropy));
+
+    return ret;
+}
+
+
+/* turn buffered output on or off, off drops anything left in the buffer */
+int RNG_SetBuffered(RNG* rng, int on)
+{
+    if (rng == NULL)
+        return BAD_FUNC_ARG;
+
+    if (!on) {
+        XMEMSET(rng->out, 0, sizeof(rng->out));
+        rng->outSz = 0;
+    }
+    rng->buffered = (on != 0);
+
+    return 0;
+}
+
+
 void FreeRng(RNG* rng)
 {
-    Hash_DBRG_Uninstantiate(rng);
+    DRBG_Uninstantiate(rng);
 }
 
-#else /* NO_RC4 */
+#else /* NO_RC4 || HAVE_CTR_DRBG */
 
 /* Get seed and key cipher */
 int InitRng(RNG* rng)
@@ -351,6 +634,52 @@ byte RNG_GenerateByte(RNG* rng)
 }
 
 
+/* key from caller supplied seed material instead of the OS, e.g. output of
+   another RNG */
+int InitRngSeed(RNG* rng, const byte* seed, word32 sz)
+{
+    byte junk[256];
+
+    if (rng == NULL || seed == NULL || sz == 0)
+        return BAD_FUNC_ARG;
+
+#ifdef HAVE_CAVIUM
+    rng->magic = 0;
+#endif
+    Arc4SetKey(&rng->cipher, seed, sz);
+    RNG_GenerateBlock(rng, junk, sizeof(junk));  /* rid initial state */
+
+    return 0;
+}
+
+
+/* rekey with fresh OS entropy mixed with current output */
+int RNG_Reseed(RNG* rng)
+{
+    byte key[32];
+    byte mix[32];
+    byte junk[256];
+    int  ret;
+    word32 i;
+
+    if (rng == NULL)
+        return BAD_FUNC_ARG;
+
+    ret = GenerateSeed(&rng->seed, key, sizeof(key));
+    if (ret == 0) {
+        RNG_GenerateBlock(rng, mix, sizeof(mix));
+        for (i = 0; i < sizeof(key); i++)
+            key[i] ^= mix[i];
+        Arc4SetKey(&rng->cipher, key, sizeof(key));
+        RNG_GenerateBlock(rng, junk, sizeof(junk));  /* rid initial state */
+    }
+    XMEMSET(key, 0, sizeof(key));
+    XMEMSET(mix, 0, sizeof(mix));
+
+    return ret;
+}
+
+
 #ifdef HAVE_CAVIUM
 
 #include <cyassl/ctaocrypt/logging.h>
@@ -394,7 +723,7 @@ static void CaviumRNG_GenerateBlock(RNG* rng, byte* output, word32 sz)
 
 #endif /* HAVE_CAVIUM */
 
-#endif /* NO_RC4 */
+#endif /* NO_RC4 || HAVE_CTR_DRBG */
 
 
 #if defined(USE_WINDOWS_API)
@@ -79,6 +79,14 @@ void InitRsaKey(RsaKey* key, void* heap)
 
     key->type = -1;  /* haven't decided yet */
     key->heap = heap;
+#ifdef USE_FAST_MATH
+    key->montSet   = 0;
+    key->blindSet  = 0;
+    key->blindUses = 0;
+    mp_init(&key->blind);
+    mp_init(&key->blindInv);
+    InitMutex(&key->blindLock);
+#endif
 
 /* TomsFastMath doesn't use memory allocation */
 #ifndef USE_FAST_MATH
@@ -100,6 +108,13 @@ void FreeRsaKey(RsaKey* key)
         return FreeCaviumRsaKey(key);
 #endif
 
+#ifdef USE_FAST_MATH
+    key->blindSet = 0;
+    mp_clear(&key->blind);
+    mp_clear(&key->blindInv);
+    FreeMutex(&key->blindLock);
+#endif
+
 /* TomsFastMath doesn't use memory allocation */
 #ifndef USE_FAST_MATH
     if (key->type == RSA_PRIVATE) {
@@ -178,8 +193,150 @@ static word32 RsaUnPad(const byte *pkcsBlock, unsigned int pkcsBlockLen,
 }
 
 
+/* set up what the private key operation can reuse, called once the key
+   parts are loaded so a decoded key can be shared read only */
+int RsaPrecompute(RsaKey* key)
+{
+#ifdef USE_FAST_MATH
+    key->montSet  = 0;
+    key->blindSet = 0;
+    if (key->type != RSA_PRIVATE)
+        return 0;
+
+    if (mp_mont_setup(&key->p, &key->pMont) != MP_OKAY ||
+        mp_mont_setup(&key->q, &key->qMont) != MP_OKAY)
+        return MP_EXPTMOD_E;
+    key->montSet = 1;
+#else
+    (void)key;
+#endif
+
+    return 0;
+}
+
+
+#ifndef RSA_LOW_MEM
+
+/* tmpa = tmp^dP mod p, tmpb = tmp^dQ mod q */
+static int RsaCrtExptMod(RsaKey* key, mp_int* tmp, mp_int* tmpa, mp_int* tmpb)
+{
+#ifdef USE_FAST_MATH
+    /* constant time, with the Montgomery constants cached in the key */
+    mp_mont  pm, qm;
+    mp_mont* pMont = &key->pMont;
+    mp_mont* qMont = &key->qMont;
+
+    if (!key->montSet) {
+        if (mp_mont_setup(&key->p, &pm) != MP_OKAY ||
+            mp_mont_setup(&key->q, &qm) != MP_OKAY)
+            return MP_EXPTMOD_E;
+        pMont = &pm;
+        qMont = &qm;
+    }
+
+    if (mp_exptmod_ct(tmp, &key->dP, &key->p, pMont, tmpa) != MP_OKAY ||
+        mp_exptmod_ct(tmp, &key->dQ, &key->q, qMont, tmpb) != MP_OKAY)
+        return MP_EXPTMOD_E;
+#else
+    if (mp_exptmod(tmp, &key->dP, &key->p, tmpa) != MP_OKAY ||
+        mp_exptmod(tmp, &key->dQ, &key->q, tmpb) != MP_OKAY)
+        return MP_EXPTMOD_E;
+#endif
+
+    return 0;
+}
+
+#endif /* RSA_LOW_MEM */
+
+
+#ifndef RSA_BLIND_REFRESH
+    #define RSA_BLIND_REFRESH 32   /* squarings before a fresh r is drawn */
+#endif
+
+/* blind = r^e mod n for a random r, blindInv = 1/r mod n */
+static int RsaBlindPair(RsaKey* key, RNG* rng, mp_int* blind, mp_int* blindInv)
+{
+    byte   rnd[RSA_MAX_SIZE / 8];
+    word32 sz = mp_unsigned_bin_size(&key->n);
+    int    ret = 0;
+
+    if (sz > sizeof(rnd))
+        sz = sizeof(rnd);
+
+    RNG_GenerateBlock(rng, rnd, sz);
+
+    if (mp_read_unsigned_bin(blind, rnd, sz) != MP_OKAY)
+        ret = MP_READ_E;
+    else if (mp_mod(blind, &key->n, blind) != MP_OKAY)
+        ret = MP_MOD_E;
+    else if (mp_invmod(blind, &key->n, blindInv) != MP_OKAY)
+        ret = MP_INVMOD_E;
+    else if (mp_exptmod(blind, &key->e, &key->n, blind) != MP_OKAY)
+        ret = MP_EXPTMOD_E;
+
+    XMEMSET(rnd, 0, sizeof(rnd));
+
+    return ret;
+}
+
+
+/* blind tmp with r^e for a random r so the private key operation never
+   sees the caller's value, rInv = 1/r mod n takes it back out */
+static int RsaBlind(RsaKey* key, RNG* rng, mp_int* tmp, mp_int* rInv)
+{
+    mp_int r;
+    int    ret = 0;
+
+    if (mp_init(&r) != MP_OKAY)
+        return MP_INIT_E;
+
+#ifdef USE_FAST_MATH
+    /* the pair is kept in the key and squared after each use, (r^2)^e and
+       1/r^2 are still a matching pair, so only every RSA_BLIND_REFRESH
+       operations pay for the invmod and exptmod of a fresh r */
+    if (LockMutex(&key->blindLock) != 0) {
+        mp_clear(&r);
+        return BAD_MUTEX_E;
+    }
+
+    if (!key->blindSet || key->blindUses >= RSA_BLIND_REFRESH) {
+        key->blindSet = 0;
+        ret = RsaBlindPair(key, rng, &key->blind, &key->blindInv);
+        if (ret == 0) {
+            key->blindSet  = 1;
+            key->blindUses = 0;
+        }
+    }
+
+    if (ret == 0) {
+        if (mp_copy(&key->blind, &r) != MP_OKAY ||
+            mp_copy(&key->blindInv, rInv) != MP_OKAY)
+            ret = MP_READ_E;
+        else if (mp_mulmod(&key->blind, &key->blind, &key->n,
+                           &key->blind) != MP_OKAY ||
+                 mp_mulmod(&key->blindInv, &key->blindInv, &key->n,
+                           &key->blindInv) != MP_OKAY)
+            key->blindSet = 0;          /* draw a fresh r next time */
+        else
+            key->blindUses++;
+    }
+
+    UnLockMutex(&key->blindLock);
+#else
+    ret = RsaBlindPair(key, rng, &r, rInv);
+#endif
+
+    if (ret == 0 && mp_mulmod(tmp, &r, &key->n, tmp) != MP_OKAY)
+        ret = MP_MULMOD_E;
+
+    mp_clear(&r);
+
+    return ret;
+}
+
+
 static int RsaFunction(const byte* in, word32 inLen, byte* out, word32* outLen,
-                       int type, RsaKey* key)
+                       int type, RsaKey* key, RNG* rng)
 {
     #define ERROR_OUT(x) { ret = x; goto done;}
 
@@ -194,29 +351,39 @@ static int RsaFunction(const byte* in, word32 inLen, byte* out, word32* outLen,
         ERROR_OUT(MP_READ_E);
 
     if (type == RSA_PRIVATE_DECRYPT || type == RSA_PRIVATE_ENCRYPT) {
+        mp_int rInv;
+    #ifndef RSA_LOW_MEM
+        mp_int tmpa, tmpb;
+    #endif
+
+        if (mp_init(&rInv) != MP_OKAY)
+            ERROR_OUT(MP_INIT_E);
+
+        if (rng && (ret = RsaBlind(key, rng, &tmp, &rInv)) != 0) {
+            mp_clear(&rInv);
+            goto done;
+        }
+
         #ifdef RSA_LOW_MEM      /* half as much memory but twice as slow */
             if (mp_exptmod(&tmp, &key->d, &key->n, &tmp) != MP_OKAY)
-                ERROR_OUT(MP_EXPTMOD_E);
+                ret = MP_EXPTMOD_E;
         #else
             #define INNER_ERROR_OUT(x) { ret = x; goto inner_done; }
 
-            mp_int tmpa, tmpb;
-
-            if (mp_init(&tmpa) != MP_OKAY)
+            if (mp_init(&tmpa) != MP_OKAY) {
+                mp_clear(&rInv);
                 ERROR_OUT(MP_INIT_E);
+            }
 
             if (mp_init(&tmpb) != MP_OKAY) {
                 mp_clear(&tmpa);
+                mp_clear(&rInv);
                 ERROR_OUT(MP_INIT_E);
             }
 
-            /* tmpa = tmp^dP mod p */
-            if (mp_exptmod(&tmp, &key->dP, &key->p, &tmpa) != MP_OKAY)
-                INNER_ERROR_OUT(MP_EXPTMOD_E);
-
-            /* tmpb = tmp^dQ mod q */
-            if (mp_exptmod(&tmp, &key->dQ, &key->q, &tmpb) != MP_OKAY)
-                INNER_ERROR_OUT(MP_EXPTMOD_E);
+            /* tmpa = tmp^dP mod p, tmpb = tmp^dQ mod q */
+            if ((ret = RsaCrtExptMod(key, &tmp, &tmpa, &tmpb)) != 0)
+                goto inner_done;
 
             /* tmp = (tmpa - tmpb) * qInv (mod p) */
             if (mp_sub(&tmpa, &tmpb, &tmp) != MP_OKAY)
@@ -235,10 +402,16 @@ static int RsaFunction(const byte* in, word32 inLen, byte* out, word32* outLen,
         inner_done:
             mp_clear(&tmpa);
             mp_clear(&tmpb);
+        #endif   /* RSA_LOW_MEM */
 
-            if (ret != 0) return ret;
+        /* undo the blinding */
+        if (ret == 0 && rng &&
+                        mp_mulmod(&tmp, &rInv, &key->n, &tmp) != MP_OKAY)
+            ret = MP_MULMOD_E;
 
-        #endif   /* RSA_LOW_MEM */
+        mp_clear(&rInv);
+        if (ret != 0)
+            goto done;
     }
     else if (type == RSA_PUBLIC_ENCRYPT || type == RSA_PUBLIC_DECRYPT) {
         if (mp_exptmod(&tmp, &key->e, &key->n, &tmp) != MP_OKAY)
@@ -290,7 +463,8 @@ int RsaPublicEncrypt(const byte* in, word32 inLen, byte* out, word32 outLen,
 
     RsaPad(in, inLen, out, sz, RSA_BLOCK_TYPE_2, rng);
 
-    if ((ret = RsaFunction(out, sz, out, &outLen, RSA_PUBLIC_ENCRYPT, key)) < 0)
+    if ((ret = RsaFunction(out, sz, out, &outLen, RSA_PUBLIC_ENCRYPT, key,
+                           NULL)) < 0)
         sz = ret;
 
     return sz;
@@ -298,6 +472,14 @@ int RsaPublicEncrypt(const byte* in, word32 inLen, byte* out, word32 outLen,
 
 
 int RsaPrivateDecryptInline(byte* in, word32 inLen, byte** out, RsaKey* key)
+{
+    return RsaPrivateDecryptInline_ex(in, inLen, out, key, NULL);
+}
+
+
+/* with an rng the private key operation is blinded */
+int RsaPrivateDecryptInline_ex(byte* in, word32 inLen, byte** out,
+                               RsaKey* key, RNG* rng)
 {
     int plainLen, ret;
 
@@ -310,8 +492,8 @@ int RsaPrivateDecryptInline(byte* in, word32 inLen, byte** out, RsaKey* key)
     }
 #endif
 
-    if ((ret = RsaFunction(in, inLen, in, &inLen, RSA_PRIVATE_DECRYPT, key))
-            < 0) {
+    if ((ret = RsaFunction(in, inLen, in, &inLen, RSA_PRIVATE_DECRYPT, key,
+                           rng)) < 0) {
         return ret;
     }
  
@@ -370,8 +552,8 @@ int RsaSSL_VerifyInline(byte* in, word32 inLen, byte** out, RsaKey* key)
     }
 #endif
 
-    if ((ret = RsaFunction(in, inLen, in, &inLen, RSA_PUBLIC_DECRYPT, key))
-            < 0) {
+    if ((ret = RsaFunction(in, inLen, in, &inLen, RSA_PUBLIC_DECRYPT, key,
+                           NULL)) < 0) {
         return ret;
     }
   
@@ -437,7 +619,8 @@ int RsaSSL_Sign(const byte* in, word32 inLen, byte* out, word32 outLen,
 
     RsaPad(in, inLen, out, sz, RSA_BLOCK_TYPE_1, rng);
 
-    if ((ret = RsaFunction(out, sz, out, &outLen, RSA_PRIVATE_ENCRYPT,key)) < 0)
+    if ((ret = RsaFunction(out, sz, out, &outLen, RSA_PRIVATE_ENCRYPT, key,
+                           rng)) < 0)
         sz = ret;
     
     return sz;
@@ -624,7 +807,7 @@ int MakeRsaKey(RsaKey* key, int size, long e, RNG* rng)
         return err;
     }
 
-    return 0;
+    return RsaPrecompute(key);
 }
 
 
@@ -29,6 +29,11 @@
 #ifndef NO_SHA
 
 #include <cyassl/ctaocrypt/sha.h>
+#ifdef USE_INTEL_SPEEDUP
+    #include <cyassl/ctaocrypt/cpuid.h>
+    #include <cyassl/ctaocrypt/error.h>
+    #include <immintrin.h>
+#endif
 #ifdef NO_INLINE
     #include <cyassl/ctaocrypt/misc.h>
 #else
@@ -162,20 +167,7 @@
 #endif /* min */
 
 
-void InitSha(Sha* sha)
-{
-    sha->digest[0] = 0x67452301L;
-    sha->digest[1] = 0xEFCDAB89L;
-    sha->digest[2] = 0x98BADCFEL;
-    sha->digest[3] = 0x10325476L;
-    sha->digest[4] = 0xC3D2E1F0L;
-
-    sha->buffLen = 0;
-    sha->loLen   = 0;
-    sha->hiLen   = 0;
-}
-
-#define blk0(i) (W[i] = sha->buffer[i])
+#define blk0(i) (W[i])
 #define blk1(i) (W[i&15] = \
                    rotlFixed(W[(i+13)&15]^W[(i+8)&15]^W[(i+2)&15]^W[i&15],1))
 
@@ -197,10 +189,9 @@ void InitSha(Sha* sha)
                         rotlFixed(v,5); w = rotlFixed(w,30);
 
 
-static void Transform(Sha* sha)
+/* one block, W holds the message words and is used for the schedule */
+static INLINE void TransformW(Sha* sha, word32* W)
 {
-    word32 W[SHA_BLOCK_SIZE / sizeof(word32)];
-
     /* Copy context->state[] to working vars */ 
     word32 a = sha->digest[0];
     word32 b = sha->digest[1];
@@ -273,6 +264,327 @@ static void Transform(Sha* sha)
 }
 
 
+/* Transforms take whole big endian blocks straight from the message, the
+   buffer only holds a partial block */
+static void Transform(Sha* sha, const byte* data, word32 blocks)
+{
+    word32 W[SHA_BLOCK_SIZE / sizeof(word32)];
+
+    for (; blocks; blocks--, data += SHA_BLOCK_SIZE) {
+        XMEMCPY(W, data, SHA_BLOCK_SIZE);
+        #ifdef LITTLE_ENDIAN_ORDER
+            ByteReverseWords(W, W, SHA_BLOCK_SIZE);
+        #endif
+        TransformW(sha, W);
+    }
+}
+
+
+#ifdef USE_INTEL_SPEEDUP
+
+static const word32 roundK[4] = {
+    0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+};
+
+
+/* Rounds over a schedule that already has the round constant added in */
+#define RK(f,v,w,x,y,z,i) z+= f(w,x,y) + WK[i] + rotlFixed(v,5); \
+                          w = rotlFixed(w,30);
+
+#define RK4(f,a,b,c,d,e,i) \
+    RK(f,a,b,c,d,e,i)   RK(f,e,a,b,c,d,i+1) \
+    RK(f,d,e,a,b,c,i+2) RK(f,c,d,e,a,b,i+3)
+
+/* twenty rounds, SCHED(i) works out the words for round i + 16 in between
+   so the vector schedule overlaps the scalar rounds */
+#define RK20(f,i,SCHED) \
+    SCHED(i);    RK4(f,a,b,c,d,e,i)    SCHED(i+4);  RK4(f,b,c,d,e,a,i+4)  \
+    SCHED(i+8);  RK4(f,c,d,e,a,b,i+8)  SCHED(i+12); RK4(f,d,e,a,b,c,i+12) \
+    SCHED(i+16); RK4(f,e,a,b,c,d,i+16)
+
+#define RK80(SCHED) \
+    a = sha->digest[0]; b = sha->digest[1]; c = sha->digest[2];           \
+    d = sha->digest[3]; e = sha->digest[4];                                \
+    RK20(f1,0,SCHED) RK20(f2,20,SCHED) RK20(f3,40,SCHED) RK20(f4,60,SCHED) \
+    sha->digest[0] += a; sha->digest[1] += b; sha->digest[2] += c;        \
+    sha->digest[3] += d; sha->digest[4] += e
+
+#define SCHED_NONE(i)
+
+
+/* message schedule four words at a time from the four groups before, g4
+   oldest. W[t+3] needs W[t], so it's left out of the first pass and
+   fixed up from lane 0 after. p and v pick the 128 or 256 bit
+   intrinsics, 256 bit byte shifts and alignr work per 128 bit lane. */
+#define SCHED_ROL1(p, v, w) \
+    p##_or_##v(p##_slli_epi32(w, 1), p##_srli_epi32(w, 31))
+
+#define SCHED_4(p, v, w, g4, g3, g2, g1) do {                              \
+        w = p##_xor_##v(p##_xor_##v(g4, p##_alignr_epi8(g3, g4, 8)),       \
+                        p##_xor_##v(g2, p##_srli_##v(g1, 4)));             \
+        w = SCHED_ROL1(p, v, w);                                           \
+        w = p##_xor_##v(w, SCHED_ROL1(p, v, p##_slli_##v(w, 12)));         \
+        g4 = g3; g3 = g2; g2 = g1; g1 = w;                                 \
+    } while (0)
+
+#define SCHED_SSSE3(i) \
+    if ((i) < 64) {                                                        \
+        SCHED_4(_mm, si128, w, g4, g3, g2, g1);                            \
+        _mm_storeu_si128((__m128i*)&WK[(i)+16], _mm_add_epi32(w,           \
+                                _mm_set1_epi32(roundK[((i)+16) / 20])));   \
+    }
+
+/* SSSE3 message schedule, scalar rounds */
+INTEL_TARGET("ssse3")
+static void TransformSsse3(Sha* sha, const byte* data, word32 blocks)
+{
+    word32 WK[80];
+    word32 a, b, c, d, e;
+    const __m128i flip = _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                      0,1,2,3);
+    const __m128i k0 = _mm_set1_epi32(roundK[0]);
+    __m128i g4, g3, g2, g1, w;
+
+    for (; blocks; blocks--, data += SHA_BLOCK_SIZE) {
+        g4 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), flip);
+        g3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+1), flip);
+        g2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+2), flip);
+        g1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+3), flip);
+
+        _mm_storeu_si128((__m128i*)&WK[0],  _mm_add_epi32(g4, k0));
+        _mm_storeu_si128((__m128i*)&WK[4],  _mm_add_epi32(g3, k0));
+        _mm_storeu_si128((__m128i*)&WK[8],  _mm_add_epi32(g2, k0));
+        _mm_storeu_si128((__m128i*)&WK[12], _mm_add_epi32(g1, k0));
+
+        RK80(SCHED_SSSE3);
+    }
+}
+
+
+/* a in the low lane, b in the high one */
+#define LOAD_2(a, b) \
+    _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(a)),   \
+                            _mm_loadu_si128(b), 1)
+
+#define STORE_2(i, x) \
+    _mm_storeu_si128((__m128i*)&wk[0][i], _mm256_castsi256_si128(x));     \
+    _mm_storeu_si128((__m128i*)&wk[1][i], _mm256_extracti128_si256(x, 1))
+
+#define SCHED_AVX2(i) \
+    if ((i) < 64) {                                                        \
+        SCHED_4(_mm256, si256, w, g4, g3, g2, g1);                         \
+        w = _mm256_add_epi32(w, _mm256_set1_epi32(roundK[((i)+16) / 20])); \
+        STORE_2((i)+16, w);                                                \
+    }
+
+/* AVX2 schedules two blocks at once, one per 128 bit lane, while the first
+   one's rounds run, the second block's rounds then have nothing else to
+   do. BMI2 gives the rounds flag free rotates. */
+INTEL_TARGET("avx2,bmi2")
+static void TransformAvx2(Sha* sha, const byte* data, word32 blocks)
+{
+    word32 wk[2][80];
+    const word32* WK;
+    word32 a, b, c, d, e;
+    const __m256i flip = _mm256_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                         0,1,2,3,
+                                         12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                         0,1,2,3);
+    const __m256i k0 = _mm256_set1_epi32(roundK[0]);
+    __m256i g4, g3, g2, g1, w;
+
+    for (; blocks >= 2; blocks -= 2, data += 2 * SHA_BLOCK_SIZE) {
+        const __m128i* x = (const __m128i*)data;
+        const __m128i* y = (const __m128i*)(data + SHA_BLOCK_SIZE);
+
+        g4 = _mm256_shuffle_epi8(LOAD_2(x,   y),   flip);
+        g3 = _mm256_shuffle_epi8(LOAD_2(x+1, y+1), flip);
+        g2 = _mm256_shuffle_epi8(LOAD_2(x+2, y+2), flip);
+        g1 = _mm256_shuffle_epi8(LOAD_2(x+3, y+3), flip);
+
+        STORE_2(0,  _mm256_add_epi32(g4, k0));
+        STORE_2(4,  _mm256_add_epi32(g3, k0));
+        STORE_2(8,  _mm256_add_epi32(g2, k0));
+        STORE_2(12, _mm256_add_epi32(g1, k0));
+
+        WK = wk[0];
+        RK80(SCHED_AVX2);
+        WK = wk[1];
+        RK80(SCHED_NONE);
+    }
+
+    if (blocks)
+        TransformSsse3(sha, data, blocks);
+}
+
+
+/* SHA extensions, four rounds per sha1rnds4 with f picked by the
+   immediate. sha1nexte adds the next group's words to the E from four
+   rounds back, e0 and e1 take turns. */
+#define SHA_NI_RNDS(ea, eb, m, f) \
+    ea   = _mm_sha1nexte_epu32(ea, m);                                     \
+    eb   = abcd;                                                           \
+    abcd = _mm_sha1rnds4_epu32(abcd, ea, f)
+
+/* finish the next group, start the one after and fold in the next but
+   one, all from the group just used */
+#define SHA_NI_SCHED(next, prev, after, m) \
+    next  = _mm_sha1msg2_epu32(next, m);                                   \
+    prev  = _mm_sha1msg1_epu32(prev, m);                                   \
+    after = _mm_xor_si128(after, m)
+
+INTEL_TARGET("sha,sse4.1")
+static void TransformShaNi(Sha* sha, const byte* data, word32 blocks)
+{
+    const __m128i flip = _mm_set_epi8(0,1,2,3, 4,5,6,7, 8,9,10,11,
+                                      12,13,14,15);
+    __m128i abcd, e0, e1, abcdSave, eSave;
+    __m128i m0, m1, m2, m3;
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)sha->digest),
+                             0x1B);
+    e0   = _mm_set_epi32((int)sha->digest[4], 0, 0, 0);
+
+    for (; blocks; blocks--, data += SHA_BLOCK_SIZE) {
+        abcdSave = abcd;
+        eSave    = e0;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), flip);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+1), flip);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+2), flip);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+3), flip);
+
+        /* rounds 0-3, there is no earlier E to carry */
+        e0   = _mm_add_epi32(e0, m0);
+        e1   = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+        SHA_NI_RNDS(e1, e0, m1, 0);
+        m0 = _mm_sha1msg1_epu32(m0, m1);
+        SHA_NI_RNDS(e0, e1, m2, 0);
+        m1 = _mm_sha1msg1_epu32(m1, m2);
+        m0 = _mm_xor_si128(m0, m2);
+
+        SHA_NI_RNDS(e1, e0, m3, 0);  SHA_NI_SCHED(m0, m2, m1, m3);
+        SHA_NI_RNDS(e0, e1, m0, 0);  SHA_NI_SCHED(m1, m3, m2, m0);
+        SHA_NI_RNDS(e1, e0, m1, 1);  SHA_NI_SCHED(m2, m0, m3, m1);
+        SHA_NI_RNDS(e0, e1, m2, 1);  SHA_NI_SCHED(m3, m1, m0, m2);
+        SHA_NI_RNDS(e1, e0, m3, 1);  SHA_NI_SCHED(m0, m2, m1, m3);
+        SHA_NI_RNDS(e0, e1, m0, 1);  SHA_NI_SCHED(m1, m3, m2, m0);
+        SHA_NI_RNDS(e1, e0, m1, 1);  SHA_NI_SCHED(m2, m0, m3, m1);
+        SHA_NI_RNDS(e0, e1, m2, 2);  SHA_NI_SCHED(m3, m1, m0, m2);
+        SHA_NI_RNDS(e1, e0, m3, 2);  SHA_NI_SCHED(m0, m2, m1, m3);
+        SHA_NI_RNDS(e0, e1, m0, 2);  SHA_NI_SCHED(m1, m3, m2, m0);
+        SHA_NI_RNDS(e1, e0, m1, 2);  SHA_NI_SCHED(m2, m0, m3, m1);
+        SHA_NI_RNDS(e0, e1, m2, 2);  SHA_NI_SCHED(m3, m1, m0, m2);
+        SHA_NI_RNDS(e1, e0, m3, 3);  SHA_NI_SCHED(m0, m2, m1, m3);
+        SHA_NI_RNDS(e0, e1, m0, 3);  SHA_NI_SCHED(m1, m3, m2, m0);
+
+        /* rounds 68-79, the schedule winds down */
+        SHA_NI_RNDS(e1, e0, m1, 3);
+        m2 = _mm_sha1msg2_epu32(m2, m1);
+        m3 = _mm_xor_si128(m3, m1);
+        SHA_NI_RNDS(e0, e1, m2, 3);
+        m3 = _mm_sha1msg2_epu32(m3, m2);
+        SHA_NI_RNDS(e1, e0, m3, 3);
+
+        e0   = _mm_sha1nexte_epu32(e0, eSave);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+    }
+
+    _mm_storeu_si128((__m128i*)sha->digest, _mm_shuffle_epi32(abcd, 0x1B));
+    sha->digest[4] = (word32)_mm_extract_epi32(e0, 3);
+}
+
+
+static void (*transform)(Sha*, const byte*, word32) = Transform;
+static int transformType = -1;
+
+
+/* pick the transform for TRANSFORM_* type, BAD_FUNC_ARG if this cpu can't
+   run it. Meant for startup, tests and benchmarks, not while hashing. */
+int ShaSetTransform(int type)
+{
+    word32 flags = cpuid_get_flags();
+
+    switch (type) {
+        case TRANSFORM_C:
+            transform = Transform;
+            break;
+        case TRANSFORM_SSSE3:
+            if (!(flags & CPUID_SSSE3))
+                return BAD_FUNC_ARG;
+            transform = TransformSsse3;
+            break;
+        case TRANSFORM_AVX2:
+            if (!(flags & CPUID_AVX2) || !(flags & CPUID_SSSE3))
+                return BAD_FUNC_ARG;
+            transform = TransformAvx2;
+            break;
+        case TRANSFORM_SHANI:
+            if (!(flags & CPUID_SHA))
+                return BAD_FUNC_ARG;
+            transform = TransformShaNi;
+            break;
+        default:
+            return BAD_FUNC_ARG;
+    }
+    transformType = type;
+
+    return 0;
+}
+
+
+/* best one this cpu supports, done once */
+static void ShaPickTransform(void)
+{
+    int type = TRANSFORM_SHANI;
+
+    while (ShaSetTransform(type) != 0)
+        type--;
+}
+
+
+int ShaGetTransform(void)
+{
+    if (transformType < 0)
+        ShaPickTransform();
+
+    return transformType;
+}
+
+#endif /* USE_INTEL_SPEEDUP */
+
+
+static INLINE void ShaBlocks(Sha* sha, const byte* data, word32 blocks)
+{
+#ifdef USE_INTEL_SPEEDUP
+    transform(sha, data, blocks);
+#else
+    Transform(sha, data, blocks);
+#endif
+}
+
+
+void InitSha(Sha* sha)
+{
+    sha->digest[0] = 0x67452301L;
+    sha->digest[1] = 0xEFCDAB89L;
+    sha->digest[2] = 0x98BADCFEL;
+    sha->digest[3] = 0x10325476L;
+    sha->digest[4] = 0xC3D2E1F0L;
+
+    sha->buffLen = 0;
+    sha->loLen   = 0;
+    sha->hiLen   = 0;
+
+#ifdef USE_INTEL_SPEEDUP
+    if (transformType < 0)
+        ShaPickTransform();
+#endif
+}
+
+
 static INLINE void AddLength(Sha* sha, word32 len)
 {
     word32 tmp = sha->loLen;
@@ -283,10 +595,10 @@ static INLINE void AddLength(Sha* sha, word32 len)
 
 void ShaUpdate(Sha* sha, const byte* data, word32 len)
 {
-    /* do block size increments */
     byte* local = (byte*)sha->buffer;
 
-    while (len) {
+    /* top up a partial block first */
+    if (sha->buffLen) {
         word32 add = min(len, SHA_BLOCK_SIZE - sha->buffLen);
         XMEMCPY(&local[sha->buffLen], data, add);
 
@@ -295,14 +607,26 @@ void ShaUpdate(Sha* sha, const byte* data, word32 len)
         len          -= add;
 
         if (sha->buffLen == SHA_BLOCK_SIZE) {
-            #ifdef LITTLE_ENDIAN_ORDER
-                ByteReverseBytes(local, local, SHA_BLOCK_SIZE);
-            #endif
-            Transform(sha);
+            ShaBlocks(sha, local, 1);
             AddLength(sha, SHA_BLOCK_SIZE);
             sha->buffLen = 0;
         }
     }
+
+    /* whole blocks straight from the input */
+    if (len >= SHA_BLOCK_SIZE) {
+        word32 blocks = len / SHA_BLOCK_SIZE;
+
+        ShaBlocks(sha, data, blocks);
+        AddLength(sha, blocks * SHA_BLOCK_SIZE);
+        data += blocks * SHA_BLOCK_SIZE;
+        len  -= blocks * SHA_BLOCK_SIZE;
+    }
+
+    if (len) {
+        XMEMCPY(local, data, len);
+        sha->buffLen = len;
+    }
 }
 
 
@@ -317,12 +641,7 @@ void ShaFinal(Sha* sha, byte* hash)
     /* pad with zeros */
     if (sha->buffLen > SHA_PAD_SIZE) {
         XMEMSET(&local[sha->buffLen], 0, SHA_BLOCK_SIZE - sha->buffLen);
-        sha->buffLen += SHA_BLOCK_SIZE - sha->buffLen;
-
-        #ifdef LITTLE_ENDIAN_ORDER
-            ByteReverseBytes(local, local, SHA_BLOCK_SIZE);
-        #endif
-        Transform(sha);
+        ShaBlocks(sha, local, 1);
         sha->buffLen = 0;
     }
     XMEMSET(&local[sha->buffLen], 0, SHA_PAD_SIZE - sha->buffLen);
@@ -332,15 +651,15 @@ void ShaFinal(Sha* sha, byte* hash)
                  (sha->hiLen << 3);
     sha->loLen = sha->loLen << 3;
 
-    /* store lengths */
+    /* store lengths, big endian like the message */
     #ifdef LITTLE_ENDIAN_ORDER
-        ByteReverseBytes(local, local, SHA_BLOCK_SIZE);
+        sha->hiLen = ByteReverseWord32(sha->hiLen);
+        sha->loLen = ByteReverseWord32(sha->loLen);
     #endif
-    /* ! length ordering dependent on digest endian type ! */
     XMEMCPY(&local[SHA_PAD_SIZE], &sha->hiLen, sizeof(word32));
     XMEMCPY(&local[SHA_PAD_SIZE + sizeof(word32)], &sha->loLen, sizeof(word32));
 
-    Transform(sha);
+    ShaBlocks(sha, local, 1);
     #ifdef LITTLE_ENDIAN_ORDER
         ByteReverseWords(sha->digest, sha->digest, SHA_DIGEST_SIZE);
     #endif
@@ -31,6 +31,11 @@
 #ifndef NO_SHA256
 
 #include <cyassl/ctaocrypt/sha256.h>
+#ifdef USE_INTEL_SPEEDUP
+    #include <cyassl/ctaocrypt/cpuid.h>
+    #include <cyassl/ctaocrypt/error.h>
+    #include <immintrin.h>
+#endif
 #ifdef NO_INLINE
     #include <cyassl/ctaocrypt/misc.h>
 #else
@@ -48,22 +53,6 @@
 #endif /* min */
 
 
-void InitSha256(Sha256* sha256)
-{
-    sha256->digest[0] = 0x6A09E667L;
-    sha256->digest[1] = 0xBB67AE85L;
-    sha256->digest[2] = 0x3C6EF372L;
-    sha256->digest[3] = 0xA54FF53AL;
-    sha256->digest[4] = 0x510E527FL;
-    sha256->digest[5] = 0x9B05688CL;
-    sha256->digest[6] = 0x1F83D9ABL;
-    sha256->digest[7] = 0x5BE0CD19L;
-
-    sha256->buffLen = 0;
-    sha256->loLen   = 0;
-    sha256->hiLen   = 0;
-}
-
 static const word32 K[64] = {
     0x428A2F98L, 0x71374491L, 0xB5C0FBCFL, 0xE9B5DBA5L, 0x3956C25BL,
     0x59F111F1L, 0x923F82A4L, 0xAB1C5ED5L, 0xD807AA98L, 0x12835B01L,
@@ -96,39 +85,367 @@ static const word32 K[64] = {
      h  = t0 + t1;
 
 
-static void Transform(Sha256* sha256)
+/* Transforms take whole big endian blocks straight from the message, the
+   buffer only holds a partial block */
+static void Transform(Sha256* sha256, const byte* data, word32 blocks)
 {
     word32 S[8], W[64], t0, t1;
     int i;
 
-    /* Copy context->state[] to working vars */
-    for (i = 0; i < 8; i++)
-        S[i] = sha256->digest[i];
-
-    for (i = 0; i < 16; i++)
-        W[i] = sha256->buffer[i];
-
-    for (i = 16; i < 64; i++)
-        W[i] = Gamma1(W[i-2]) + W[i-7] + Gamma0(W[i-15]) + W[i-16];
-
-    for (i = 0; i < 64; i += 8) {
-        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],i+0);
-        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],i+1);
-        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],i+2);
-        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],i+3);
-        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],i+4);
-        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],i+5);
-        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],i+6);
-        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],i+7);
+    for (; blocks; blocks--, data += SHA256_BLOCK_SIZE) {
+        /* Copy context->state[] to working vars */
+        for (i = 0; i < 8; i++)
+            S[i] = sha256->digest[i];
+
+        XMEMCPY(W, data, SHA256_BLOCK_SIZE);
+        #ifdef LITTLE_ENDIAN_ORDER
+            ByteReverseWords(W, W, SHA256_BLOCK_SIZE);
+        #endif
+
+        for (i = 16; i < 64; i++)
+            W[i] = Gamma1(W[i-2]) + W[i-7] + Gamma0(W[i-15]) + W[i-16];
+
+        for (i = 0; i < 64; i += 8) {
+            RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],i+0);
+            RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],i+1);
+            RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],i+2);
+            RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],i+3);
+            RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],i+4);
+            RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],i+5);
+            RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],i+6);
+            RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],i+7);
+        }
+
+        /* Add the working vars back into digest state[] */
+        for (i = 0; i < 8; i++) {
+            sha256->digest[i] += S[i];
+        }
     }
+}
+
 
-    /* Add the working vars back into digest state[] */
-    for (i = 0; i < 8; i++) {
-        sha256->digest[i] += S[i];
+#ifdef USE_INTEL_SPEEDUP
+
+/* Rounds over a schedule that already has K added in, W[i] + K[i] */
+#define RNDK(a,b,c,d,e,f,g,h,i) \
+     t0 = h + Sigma1(e) + Ch(e, f, g) + WK[i]; \
+     t1 = Sigma0(a) + Maj(a, b, c); \
+     d += t0; \
+     h  = t0 + t1;
+
+/* all 64 rounds, SCHED(i) works out the words for round i + 16 in between
+   so the vector schedule overlaps the scalar rounds */
+#define RNDK64(SCHED) \
+    for (i = 0; i < 8; i++)                                                \
+        S[i] = sha256->digest[i];                                          \
+    for (i = 0; i < 64; i += 8) {                                          \
+        SCHED(i);                                                          \
+        RNDK(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],i+0);                 \
+        RNDK(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],i+1);                 \
+        RNDK(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],i+2);                 \
+        RNDK(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],i+3);                 \
+        SCHED(i+4);                                                        \
+        RNDK(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],i+4);                 \
+        RNDK(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],i+5);                 \
+        RNDK(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],i+6);                 \
+        RNDK(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],i+7);                 \
+    }                                                                      \
+    for (i = 0; i < 8; i++)                                                \
+        sha256->digest[i] += S[i]
+
+#define SCHED_NONE(i)
+
+
+/* message schedule four words at a time, x0..x3 are the previous sixteen
+   words oldest first. W[t+2] and W[t+3] depend on W[t] and W[t+1] so the
+   Gamma1 term goes in as two halves. p and v pick the 128 or 256 bit
+   intrinsics, 256 bit byte shifts and alignr work per 128 bit lane. */
+#define SCHED_GAMMA0(p, v, w) \
+    p##_xor_##v(p##_xor_##v(                                               \
+        p##_or_##v(p##_srli_epi32(w, 7),  p##_slli_epi32(w, 25)),          \
+        p##_or_##v(p##_srli_epi32(w, 18), p##_slli_epi32(w, 14))),         \
+        p##_srli_epi32(w, 3))
+
+#define SCHED_GAMMA1(p, v, w) \
+    p##_xor_##v(p##_xor_##v(                                               \
+        p##_or_##v(p##_srli_epi32(w, 17), p##_slli_epi32(w, 15)),          \
+        p##_or_##v(p##_srli_epi32(w, 19), p##_slli_epi32(w, 13))),         \
+        p##_srli_epi32(w, 10))
+
+#define SCHED_4(p, v, w, x0, x1, x2, x3) do {                              \
+        w = p##_add_epi32(p##_add_epi32(x0,                                \
+                SCHED_GAMMA0(p, v, p##_alignr_epi8(x1, x0, 4))),           \
+                p##_alignr_epi8(x3, x2, 4));                               \
+        w = p##_add_epi32(w, SCHED_GAMMA1(p, v, p##_srli_##v(x3, 8)));     \
+        w = p##_add_epi32(w, SCHED_GAMMA1(p, v, p##_slli_##v(w, 8)));      \
+        x0 = x1; x1 = x2; x2 = x3; x3 = w;                                 \
+    } while (0)
+
+#define SCHED_SSSE3(i) \
+    if ((i) < 48) {                                                        \
+        SCHED_4(_mm, si128, w, x0, x1, x2, x3);                            \
+        _mm_storeu_si128((__m128i*)&WK[(i)+16], _mm_add_epi32(w,           \
+                         _mm_loadu_si128((const __m128i*)&K[(i)+16])));    \
+    }
+
+/* SSSE3 message schedule, scalar rounds */
+INTEL_TARGET("ssse3")
+static void TransformSsse3(Sha256* sha256, const byte* data, word32 blocks)
+{
+    word32 WK[64], S[8], t0, t1;
+    const __m128i flip = _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                      0,1,2,3);
+    const __m128i* k = (const __m128i*)K;
+    __m128i x0, x1, x2, x3, w;
+    int i;
+
+    for (; blocks; blocks--, data += SHA256_BLOCK_SIZE) {
+        x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), flip);
+        x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+1), flip);
+        x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+2), flip);
+        x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+3), flip);
+
+        _mm_storeu_si128((__m128i*)&WK[0],
+                         _mm_add_epi32(x0, _mm_loadu_si128(k)));
+        _mm_storeu_si128((__m128i*)&WK[4],
+                         _mm_add_epi32(x1, _mm_loadu_si128(k+1)));
+        _mm_storeu_si128((__m128i*)&WK[8],
+                         _mm_add_epi32(x2, _mm_loadu_si128(k+2)));
+        _mm_storeu_si128((__m128i*)&WK[12],
+                         _mm_add_epi32(x3, _mm_loadu_si128(k+3)));
+
+        RNDK64(SCHED_SSSE3);
+    }
+}
+
+
+/* a in the low lane, b in the high one */
+#define LOAD_2(a, b) \
+    _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(a)),   \
+                            _mm_loadu_si128(b), 1)
+
+#define ADD_K_2(x, i) \
+    _mm256_add_epi32(x, _mm256_broadcastsi128_si256(                       \
+                         _mm_loadu_si128((const __m128i*)&K[i])))
+
+#define STORE_2(i, x) \
+    _mm_storeu_si128((__m128i*)&wk[0][i], _mm256_castsi256_si128(x));     \
+    _mm_storeu_si128((__m128i*)&wk[1][i], _mm256_extracti128_si256(x, 1))
+
+#define SCHED_AVX2(i) \
+    if ((i) < 48) {                                                        \
+        SCHED_4(_mm256, si256, w, x0, x1, x2, x3);                         \
+        STORE_2((i)+16, ADD_K_2(w, (i)+16));                               \
     }
+
+/* AVX2 schedules two blocks at once, one per 128 bit lane, while the first
+   one's rounds run, the second block's rounds then have nothing else to
+   do. BMI2 gives the rounds flag free rotates. */
+INTEL_TARGET("avx2,bmi2")
+static void TransformAvx2(Sha256* sha256, const byte* data, word32 blocks)
+{
+    word32 wk[2][64], S[8], t0, t1;
+    const word32* WK;
+    const __m256i flip = _mm256_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                         0,1,2,3,
+                                         12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                         0,1,2,3);
+    __m256i x0, x1, x2, x3, w;
+    int i;
+
+    for (; blocks >= 2; blocks -= 2, data += 2 * SHA256_BLOCK_SIZE) {
+        const __m128i* a = (const __m128i*)data;
+        const __m128i* b = (const __m128i*)(data + SHA256_BLOCK_SIZE);
+
+        x0 = _mm256_shuffle_epi8(LOAD_2(a,   b),   flip);
+        x1 = _mm256_shuffle_epi8(LOAD_2(a+1, b+1), flip);
+        x2 = _mm256_shuffle_epi8(LOAD_2(a+2, b+2), flip);
+        x3 = _mm256_shuffle_epi8(LOAD_2(a+3, b+3), flip);
+
+        STORE_2(0,  ADD_K_2(x0, 0));
+        STORE_2(4,  ADD_K_2(x1, 4));
+        STORE_2(8,  ADD_K_2(x2, 8));
+        STORE_2(12, ADD_K_2(x3, 12));
+
+        WK = wk[0];
+        RNDK64(SCHED_AVX2);
+        WK = wk[1];
+        RNDK64(SCHED_NONE);
+    }
+
+    if (blocks)
+        TransformSsse3(sha256, data, blocks);
 }
 
 
+/* SHA extensions, state is kept as ABEF and CDGH */
+#define SHA_NI_RNDS(m, i) \
+    msg = _mm_add_epi32(m, _mm_loadu_si128((const __m128i*)&K[i]));       \
+    st1 = _mm_sha256rnds2_epu32(st1, st0, msg);                            \
+    st0 = _mm_sha256rnds2_epu32(st0, st1, _mm_shuffle_epi32(msg, 0x0E))
+
+/* next W from cur and prev, then the first half of the one after */
+#define SHA_NI_MSG(next, cur, prev) \
+    next = _mm_sha256msg2_epu32(                                           \
+               _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)), cur)
+
+#define SHA_NI_STEP(i, cur, prev, next) \
+    SHA_NI_RNDS(cur, i);                                                   \
+    SHA_NI_MSG(next, cur, prev);                                           \
+    prev = _mm_sha256msg1_epu32(prev, cur)
+
+INTEL_TARGET("sha,sse4.1")
+static void TransformShaNi(Sha256* sha256, const byte* data, word32 blocks)
+{
+    const __m128i flip = _mm_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7,
+                                      0,1,2,3);
+    __m128i st0, st1, abef, cdgh, msg, tmp;
+    __m128i m0, m1, m2, m3;
+
+    tmp = _mm_loadu_si128((const __m128i*)&sha256->digest[0]);
+    st1 = _mm_loadu_si128((const __m128i*)&sha256->digest[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);                 /* CDAB */
+    st1 = _mm_shuffle_epi32(st1, 0x1B);                 /* EFGH */
+    st0 = _mm_alignr_epi8(tmp, st1, 8);                 /* ABEF */
+    st1 = _mm_blend_epi16(st1, tmp, 0xF0);              /* CDGH */
+
+    for (; blocks; blocks--, data += SHA256_BLOCK_SIZE) {
+        abef = st0;
+        cdgh = st1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), flip);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+1), flip);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+2), flip);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data+3), flip);
+
+        SHA_NI_RNDS(m0, 0);
+        SHA_NI_RNDS(m1, 4);
+        m0 = _mm_sha256msg1_epu32(m0, m1);
+        SHA_NI_RNDS(m2, 8);
+        m1 = _mm_sha256msg1_epu32(m1, m2);
+
+        SHA_NI_STEP(12, m3, m2, m0);
+        SHA_NI_STEP(16, m0, m3, m1);
+        SHA_NI_STEP(20, m1, m0, m2);
+        SHA_NI_STEP(24, m2, m1, m3);
+        SHA_NI_STEP(28, m3, m2, m0);
+        SHA_NI_STEP(32, m0, m3, m1);
+        SHA_NI_STEP(36, m1, m0, m2);
+        SHA_NI_STEP(40, m2, m1, m3);
+        SHA_NI_STEP(44, m3, m2, m0);
+        SHA_NI_STEP(48, m0, m3, m1);
+
+        SHA_NI_RNDS(m1, 52);
+        SHA_NI_MSG(m2, m1, m0);
+        SHA_NI_RNDS(m2, 56);
+        SHA_NI_MSG(m3, m2, m1);
+        SHA_NI_RNDS(m3, 60);
+
+        st0 = _mm_add_epi32(st0, abef);
+        st1 = _mm_add_epi32(st1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(st0, 0x1B);                 /* FEBA */
+    st1 = _mm_shuffle_epi32(st1, 0xB1);                 /* DCHG */
+    st0 = _mm_blend_epi16(tmp, st1, 0xF0);              /* DCBA */
+    st1 = _mm_alignr_epi8(st1, tmp, 8);                 /* HGFE */
+
+    _mm_storeu_si128((__m128i*)&sha256->digest[0], st0);
+    _mm_storeu_si128((__m128i*)&sha256->digest[4], st1);
+}
+
+
+static void (*transform)(Sha256*, const byte*, word32) = Transform;
+static int transformType = -1;
+
+
+/* pick the transform for TRANSFORM_* type, BAD_FUNC_ARG if this cpu can't
+   run it. Meant for startup, tests and benchmarks, not while hashing. */
+int Sha256SetTransform(int type)
+{
+    word32 flags = cpuid_get_flags();
+
+    switch (type) {
+        case TRANSFORM_C:
+            transform = Transform;
+            break;
+        case TRANSFORM_SSSE3:
+            if (!(flags & CPUID_SSSE3))
+                return BAD_FUNC_ARG;
+            transform = TransformSsse3;
+            break;
+        case TRANSFORM_AVX2:
+            if (!(flags & CPUID_AVX2) || !(flags & CPUID_SSSE3))
+                return BAD_FUNC_ARG;
+            transform = TransformAvx2;
+            break;
+        case TRANSFORM_SHANI:
+            if (!(flags & CPUID_SHA))
+                return BAD_FUNC_ARG;
+            transform = TransformShaNi;
+            break;
+        default:
+            return BAD_FUNC_ARG;
+    }
+    transformType = type;
+
+    return 0;
+}
+
+
+/* best one this cpu supports, done once */
+static void Sha256PickTransform(void)
+{
+    int type = TRANSFORM_SHANI;
+
+    while (Sha256SetTransform(type) != 0)
+        type--;
+}
+
+
+int Sha256GetTransform(void)
+{
+    if (transformType < 0)
+        Sha256PickTransform();
+
+    return transformType;
+}
+
+#endif /* USE_INTEL_SPEEDUP */
+
+
+static INLINE void Sha256Blocks(Sha256* sha256, const byte* data,
+                                word32 blocks)
+{
+#ifdef USE_INTEL_SPEEDUP
+    transform(sha256, data, blocks);
+#else
+    Transform(sha256, data, blocks);
+#endif
+}
+
+
+void InitSha256(Sha256* sha256)
+{
+    sha256->digest[0] = 0x6A09E667L;
+    sha256->digest[1] = 0xBB67AE85L;
+    sha256->digest[2] = 0x3C6EF372L;
+    sha256->digest[3] = 0xA54FF53AL;
+    sha256->digest[4] = 0x510E527FL;
+    sha256->digest[5] = 0x9B05688CL;
+    sha256->digest[6] = 0x1F83D9ABL;
+    sha256->digest[7] = 0x5BE0CD19L;
+
+    sha256->buffLen = 0;
+    sha256->loLen   = 0;
+    sha256->hiLen   = 0;
+
+#ifdef USE_INTEL_SPEEDUP
+    if (transformType < 0)
+        Sha256PickTransform();
+#endif
+}
+
 static INLINE void AddLength(Sha256* sha256, word32 len)
 {
     word32 tmp = sha256->loLen;
@@ -139,10 +456,10 @@ static INLINE void AddLength(Sha256* sha256, word32 len)
 
 void Sha256Update(Sha256* sha256, const byte* data, word32 len)
 {
-    /* do block size increments */
     byte* local = (byte*)sha256->buffer;
 
-    while (len) {
+    /* top up a partial block first */
+    if (sha256->buffLen) {
         word32 add = min(len, SHA256_BLOCK_SIZE - sha256->buffLen);
         XMEMCPY(&local[sha256->buffLen], data, add);
 
@@ -151,14 +468,26 @@ void Sha256Update(Sha256* sha256, const byte* data, word32 len)
         len             -= add;
 
         if (sha256->buffLen == SHA256_BLOCK_SIZE) {
-            #ifdef LITTLE_ENDIAN_ORDER
-                ByteReverseBytes(local, local, SHA256_BLOCK_SIZE);
-            #endif
-            Transform(sha256);
+            Sha256Blocks(sha256, local, 1);
             AddLength(sha256, SHA256_BLOCK_SIZE);
             sha256->buffLen = 0;
         }
     }
+
+    /* whole blocks straight from the input */
+    if (len >= SHA256_BLOCK_SIZE) {
+        word32 blocks = len / SHA256_BLOCK_SIZE;
+
+        Sha256Blocks(sha256, data, blocks);
+        AddLength(sha256, blocks * SHA256_BLOCK_SIZE);
+        data += blocks * SHA256_BLOCK_SIZE;
+        len  -= blocks * SHA256_BLOCK_SIZE;
+    }
+
+    if (len) {
+        XMEMCPY(local, data, len);
+        sha256->buffLen = len;
+    }
 }
 
 
@@ -173,12 +502,7 @@ void Sha256Final(Sha256* sha256, byte* hash)
     /* pad with zeros */
     if (sha256->buffLen > SHA256_PAD_SIZE) {
         XMEMSET(&local[sha256->buffLen], 0, SHA256_BLOCK_SIZE - sha256->buffLen);
-        sha256->buffLen += SHA256_BLOCK_SIZE - sha256->buffLen;
-
-        #ifdef LITTLE_ENDIAN_ORDER
-            ByteReverseBytes(local, local, SHA256_BLOCK_SIZE);
-        #endif
-        Transform(sha256);
+        Sha256Blocks(sha256, local, 1);
         sha256->buffLen = 0;
     }
     XMEMSET(&local[sha256->buffLen], 0, SHA256_PAD_SIZE - sha256->buffLen);
@@ -188,16 +512,16 @@ void Sha256Final(Sha256* sha256, byte* hash)
                  (sha256->hiLen << 3);
     sha256->loLen = sha256->loLen << 3;
 
-    /* store lengths */
+    /* store lengths, big endian like the message */
     #ifdef LITTLE_ENDIAN_ORDER
-        ByteReverseBytes(local, local, SHA256_BLOCK_SIZE);
+        sha256->hiLen = ByteReverseWord32(sha256->hiLen);
+        sha256->loLen = ByteReverseWord32(sha256->loLen);
     #endif
-    /* ! length ordering dependent on digest endian type ! */
     XMEMCPY(&local[SHA256_PAD_SIZE], &sha256->hiLen, sizeof(word32));
     XMEMCPY(&local[SHA256_PAD_SIZE + sizeof(word32)], &sha256->loLen,
             sizeof(word32));
 
-    Transform(sha256);
+    Sha256Blocks(sha256, local, 1);
     #ifdef LITTLE_ENDIAN_ORDER
         ByteReverseWords(sha256->digest, sha256->digest, SHA256_DIGEST_SIZE);
     #endif
@@ -0,0 +1,91 @@
+/* siphash.c
+ *
+ * Copyright (C) 2006-2013 wolfSSL Inc.
+ *
+ * This file is part of CyaSSL.
+ *
+ * CyaSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * CyaSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+
+#include <cyassl/ctaocrypt/settings.h>
+
+#include <cyassl/ctaocrypt/siphash.h>
+#ifdef NO_INLINE
+    #include <cyassl/ctaocrypt/misc.h>
+#else
+    #include <ctaocrypt/src/misc.c>
+#endif
+
+
+/* little endian load, HalfSipHash is defined on little endian words */
+static INLINE word32 GetLE32(const byte* p)
+{
+    return (word32)p[0] | ((word32)p[1] << 8) | ((word32)p[2] << 16) |
+           ((word32)p[3] << 24);
+}
+
+
+#define SIPROUND(v0, v1, v2, v3)                                \
+    do {                                                        \
+        v0 += v1; v1 = rotlFixed(v1,  5); v1 ^= v0;             \
+        v0 = rotlFixed(v0, 16);                                 \
+        v2 += v3; v3 = rotlFixed(v3,  8); v3 ^= v2;             \
+        v0 += v3; v3 = rotlFixed(v3,  7); v3 ^= v0;             \
+        v2 += v1; v1 = rotlFixed(v1, 13); v1 ^= v2;             \
+        v2 = rotlFixed(v2, 16);                                 \
+    } while (0)
+
+
+word32 HalfSipHash24(const byte* key, const byte* in, word32 sz)
+{
+    word32 k0 = GetLE32(key);
+    word32 k1 = GetLE32(key + 4);
+    word32 v0 = k0;
+    word32 v1 = k1;
+    word32 v2 = 0x6c796765 ^ k0;
+    word32 v3 = 0x74656462 ^ k1;
+    word32 b  = sz << 24;
+    word32 m;
+    word32 left = sz & 3;
+    const byte* end = in + sz - left;
+
+    for (; in != end; in += 4) {
+        m = GetLE32(in);
+        v3 ^= m;
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    while (left--)
+        b |= (word32)in[left] << (8 * left);
+
+    v3 ^= b;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+
+    return v1 ^ v3;
+}
@@ -1190,6 +1190,126 @@ int fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
    }
 }
 
+/* precompute the Montgomery constants of odd modulus P */
+int fp_mont_setup(fp_int *P, fp_mont *mont)
+{
+  int err;
+
+  if ((err = fp_montgomery_setup(P, &mont->mp)) != FP_OKAY) {
+     return err;
+  }
+
+  /* R^2 mod P, from R mod P */
+  fp_init(&mont->R2);
+  fp_montgomery_calc_normalization(&mont->R2, P);
+  return fp_mulmod(&mont->R2, &mont->R2, P, &mont->R2);
+}
+
+#define FP_CT_WINSIZE 5
+#define FP_CT_ENTRIES (1 << FP_CT_WINSIZE)
+
+/* window of w bits starting at bit pos of X, X digits past used are zero */
+static INLINE int fp_get_window(fp_int *X, int pos, int w)
+{
+  int      d = pos / DIGIT_BIT, s = pos % DIGIT_BIT;
+  fp_digit v = X->dp[d] >> s;
+
+  if (s + w > (int)DIGIT_BIT && d + 1 < FP_SIZE) {
+     v |= X->dp[d + 1] << (DIGIT_BIT - s);
+  }
+  return (int)(v & ((1 << w) - 1));
+}
+
+/* r = table entry idx, every entry is read so the access pattern doesn't
+   depend on idx, r is left used digits wide, not clamped, so its size
+   doesn't depend on the entry either */
+static void fp_gather(const fp_digit *tab, int used, int idx, fp_int *r)
+{
+  int      x, y;
+  fp_digit mask, d;
+
+  fp_zero(r);
+  for (x = 0; x < used; x++) {
+     d = 0;
+     for (y = 0; y < FP_CT_ENTRIES; y++) {
+        /* all ones when y == idx, without a branch */
+        mask = (fp_digit)0 -
+               (fp_digit)(((unsigned int)(y ^ idx) - 1) >> (sizeof(int)*8 - 1));
+        d |= tab[x * FP_CT_ENTRIES + y] & mask;
+     }
+     r->dp[x] = d;
+  }
+  r->used = used;
+}
+
+/* Y = G**X (mod P) for secret X, P odd with mont from fp_mont_setup()
+ *
+ * Fixed window: every window costs FP_CT_WINSIZE squarings and one multiply,
+ * also for zero windows, over as many bits as P has, so the sequence of
+ * operations only depends on the size of P.  Table entries are stored
+ * digit interleaved and gathered with a full masked scan.
+ */
+int fp_exptmod_ct(fp_int *G, fp_int *X, fp_int *P, fp_mont *mont, fp_int *Y)
+{
+  fp_digit tab[(FP_SIZE/2) * FP_CT_ENTRIES];
+  fp_int   res, t, base;
+  int      used, bits, x, y;
+
+  /* prevent overflows */
+  if (P->used > (FP_SIZE/2) || X->sign == FP_NEG) {
+     return FP_VAL;
+  }
+  used = P->used;
+
+  /* base = G * R mod P */
+  if (fp_cmp_mag(P, G) != FP_GT) {
+     fp_mod(G, P, &t);
+  } else {
+     fp_copy(G, &t);
+  }
+  fp_mul(&t, &mont->R2, &base);
+  fp_montgomery_reduce(&base, P, mont->mp);
+
+  /* table[i] = G**i * R mod P, scattered a digit of each entry at a time */
+  fp_copy(&mont->R2, &t);
+  fp_montgomery_reduce(&t, P, mont->mp);            /* R mod P, G**0 */
+  for (x = 0; x < FP_CT_ENTRIES; x++) {
+     for (y = 0; y < used; y++) {
+        tab[y * FP_CT_ENTRIES + x] = t.dp[y];
+     }
+     fp_mul(&t, &base, &t);
+     fp_montgomery_reduce(&t, P, mont->mp);
+  }
+
+  /* windows from the top */
+  bits = fp_count_bits(P);
+  bits = ((bits + FP_CT_WINSIZE - 1) / FP_CT_WINSIZE) * FP_CT_WINSIZE;
+  bits -= FP_CT_WINSIZE;
+  fp_gather(tab, used, fp_get_window(X, bits, FP_CT_WINSIZE), &res);
+
+  /* res stays used digits wide, res < P so the top digits are just zero */
+  while (bits > 0) {
+     bits -= FP_CT_WINSIZE;
+     for (x = 0; x < FP_CT_WINSIZE; x++) {
+        fp_sqr(&res, &res);
+        fp_montgomery_reduce(&res, P, mont->mp);
+        res.used = used;
+     }
+     fp_gather(tab, used, fp_get_window(X, bits, FP_CT_WINSIZE), &t);
+     fp_mul(&res, &t, &res);
+     fp_montgomery_reduce(&res, P, mont->mp);
+     res.used = used;
+  }
+
+  /* out of the Montgomery domain, only now is res clamped */
+  fp_montgomery_reduce(&res, P, mont->mp);
+  fp_clamp(&res);
+  fp_copy(&res, Y);
+
+  XMEMSET(tab, 0, sizeof(tab));
+  return FP_OKAY;
+}
+
 /* computes a = 2**b */
 void fp_2expt(fp_int *a, int b)
 {
@@ -1918,6 +2038,19 @@ int mp_exptmod (mp_int * G, mp_int * X, mp_int * P, mp_int * Y)
   return fp_exptmod(G, X, P, Y);
 }
 
+/* fast math conversion */
+int mp_mont_setup(mp_int * P, mp_mont * mont)
+{
+  return fp_mont_setup(P, mont);
+}
+
+/* fast math conversion */
+int mp_exptmod_ct(mp_int * G, mp_int * X, mp_int * P, mp_mont * mont,
+                  mp_int * Y)
+{
+  return fp_exptmod_ct(G, X, P, mont, Y);
+}
+
 /* compare two ints (signed)*/
 int mp_cmp (mp_int * a, mp_int * b)
 {
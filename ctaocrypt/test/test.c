@@ -52,6 +52,7 @@
 #include <cyassl/ctaocrypt/rabbit.h>
 #include <cyassl/ctaocrypt/pwdbased.h>
 #include <cyassl/ctaocrypt/ripemd.h>
+#include <cyassl/ctaocrypt/siphash.h>
 #ifdef HAVE_ECC
     #include <cyassl/ctaocrypt/ecc.h>
 #endif    
@@ -158,6 +159,7 @@ int  dsa_test(void);
 int  random_test(void);
 int  pwdbased_test(void);
 int  ripemd_test(void);
+int  siphash_test(void);
 int  openssl_test(void);   /* test mini api */
 int pbkdf1_test(void);
 int pkcs12_test(void);
@@ -276,6 +278,11 @@ void ctaocrypt_test(void* args)
         printf( "BLAKE2b  test passed!\n");
 #endif
 
+    if ( (ret = siphash_test()) != 0) 
+        err_sys("SipHash  test failed!\n", ret);
+    else
+        printf( "SipHash  test passed!\n");
+
 #ifndef NO_HMAC
     #ifndef NO_MD5
         if ( (ret = hmac_md5_test()) != 0) 
@@ -786,6 +793,52 @@ int sha_test(void)
             return -10 - i;
     }
 
+#ifdef USE_INTEL_SPEEDUP
+    {
+        byte   msg[1031];
+        byte   ref[SHA_DIGEST_SIZE];
+        word32 j, n, step;
+        int    best = ShaGetTransform();
+        int    t;
+
+        for (j = 0; j < sizeof(msg); j++)
+            msg[j] = (byte)(j * 7 + 3);
+
+        ShaSetTransform(TRANSFORM_C);
+        ShaUpdate(&sha, msg, sizeof(msg));
+        ShaFinal(&sha, ref);
+
+        /* every backend this cpu has, then against the C one with the
+           message fed in pieces that straddle block edges */
+        for (t = TRANSFORM_C; t <= TRANSFORM_SHANI; t++) {
+            if (ShaSetTransform(t) != 0)
+                continue;
+
+            for (i = 0; i < times; ++i) {
+                ShaUpdate(&sha, (byte*)test_sha[i].input,
+                          (word32)test_sha[i].inLen);
+                ShaFinal(&sha, hash);
+
+                if (memcmp(hash, test_sha[i].output, SHA_DIGEST_SIZE) != 0)
+                    return -14;
+            }
+
+            for (step = 1; step < 200; step += 37) {
+                for (j = 0; j < sizeof(msg); j += n) {
+                    n = sizeof(msg) - j < step ? sizeof(msg) - j : step;
+                    ShaUpdate(&sha, msg + j, n);
+                }
+                ShaFinal(&sha, hash);
+
+                if (memcmp(hash, ref, SHA_DIGEST_SIZE) != 0)
+                    return -15;
+            }
+        }
+
+        ShaSetTransform(best);
+    }
+#endif
+
     return 0;
 }
 
@@ -913,6 +966,49 @@ int blake2b_test(void)
 #endif /* HAVE_BLAKE2 */
 
 
+#define SIPHASH_TESTS 9
+
+/* HalfSipHash-2-4 reference vectors, key 00..07 and input 00..(n-1) */
+static const byte siphash_vec[SIPHASH_TESTS][SIPHASH_DIGEST_SIZE] =
+{
+    { 0xa9, 0x35, 0x9f, 0x5b },
+    { 0x27, 0x47, 0x5a, 0xb8 },
+    { 0xfa, 0x62, 0xa6, 0x03 },
+    { 0x8a, 0xfe, 0xe7, 0x04 },
+    { 0x2a, 0x6e, 0x46, 0x89 },
+    { 0xc5, 0xfa, 0xb6, 0x69 },
+    { 0x58, 0x63, 0xfc, 0x23 },
+    { 0x8b, 0xcf, 0x63, 0xc5 },
+    { 0xd0, 0xb8, 0x84, 0x8f }
+};
+
+
+int siphash_test(void)
+{
+    byte   key[SIPHASH_KEY_SIZE];
+    byte   input[SIPHASH_TESTS];
+    word32 hash;
+    int    i;
+
+    for (i = 0; i < SIPHASH_KEY_SIZE; i++)
+        key[i] = (byte)i;
+    for (i = 0; i < SIPHASH_TESTS; i++)
+        input[i] = (byte)i;
+
+    for (i = 0; i < SIPHASH_TESTS; i++) {
+        hash = HalfSipHash24(key, input, i);
+
+        if ((byte)(hash      ) != siphash_vec[i][0] ||
+            (byte)(hash >>  8) != siphash_vec[i][1] ||
+            (byte)(hash >> 16) != siphash_vec[i][2] ||
+            (byte)(hash >> 24) != siphash_vec[i][3])
+            return -350 - i;
+    }
+
+    return 0;
+}
+
+
 #ifndef NO_SHA256
 int sha256_test(void)
 {
@@ -950,6 +1046,52 @@ int sha256_test(void)
             return -10 - i;
     }
 
+#ifdef USE_INTEL_SPEEDUP
+    {
+        byte   msg[1031];
+        byte   ref[SHA256_DIGEST_SIZE];
+        word32 j, n, step;
+        int    best = Sha256GetTransform();
+        int    t;
+
+        for (j = 0; j < sizeof(msg); j++)
+            msg[j] = (byte)(j * 7 + 3);
+
+        Sha256SetTransform(TRANSFORM_C);
+        Sha256Update(&sha, msg, sizeof(msg));
+        Sha256Final(&sha, ref);
+
+        /* every backend this cpu has, then against the C one with the
+           message fed in pieces that straddle block edges */
+        for (t = TRANSFORM_C; t <= TRANSFORM_SHANI; t++) {
+            if (Sha256SetTransform(t) != 0)
+                continue;
+
+            for (i = 0; i < times; ++i) {
+                Sha256Update(&sha, (byte*)test_sha[i].input,
+                             (word32)test_sha[i].inLen);
+                Sha256Final(&sha, hash);
+
+                if (memcmp(hash, test_sha[i].output, SHA256_DIGEST_SIZE) != 0)
+                    return -12;
+            }
+
+            for (step = 1; step < 200; step += 37) {
+                for (j = 0; j < sizeof(msg); j += n) {
+                    n = sizeof(msg) - j < step ? sizeof(msg) - j : step;
+                    Sha256Update(&sha, msg + j, n);
+                }
+                Sha256Final(&sha, hash);
+
+                if (memcmp(hash, ref, SHA256_DIGEST_SIZE) != 0)
+                    return -13;
+            }
+        }
+
+        Sha256SetTransform(best);
+    }
+#endif
+
     return 0;
 }
 #endif
@@ -1172,6 +1314,14 @@ int hmac_sha_test(void)
 
         if (memcmp(hash, test_hmac[i].output, SHA_DIGEST_SIZE) != 0)
             return -20 - i;
+
+        /* same key again, starts from the pad states kept by HmacSetKey */
+        HmacUpdate(&hmac, (byte*)test_hmac[i].input,
+                   (word32)test_hmac[i].inLen);
+        HmacFinal(&hmac, hash);
+
+        if (memcmp(hash, test_hmac[i].output, SHA_DIGEST_SIZE) != 0)
+            return -30 - i;
 #ifdef HAVE_CAVIUM
         HmacFreeCavium(&hmac);
 #endif
@@ -1854,6 +2004,129 @@ int aes_test(void)
     if (memcmp(cipher, verify, AES_BLOCK_SIZE))
         return -61;
 
+#ifndef HAVE_CAVIUM
+    /* several buffers in one call, mixed key and record sizes and one in
+       place, against decrypting each on its own */
+    {
+        static const word32 blocks[] = { 1, 21, 3, 0, 9 };
+        static const word32 keySz[]  = { 16, 24, 32, 16, 16 };
+        enum { BUFS = sizeof(blocks) / sizeof(blocks[0]), MAX_BLOCKS = 21 };
+
+        Aes         multi[BUFS];
+        Aes*        pMulti[BUFS];
+        byte        big[AES_BLOCK_SIZE * MAX_BLOCKS];
+        byte        cbc[BUFS][AES_BLOCK_SIZE * MAX_BLOCKS];
+        byte        out[BUFS][AES_BLOCK_SIZE * MAX_BLOCKS];
+        byte*       pOut[BUFS];
+        const byte* pIn[BUFS];
+        word32      sz[BUFS];
+        byte        k[32];
+        int         i, j;
+
+        for (i = 0; i < (int)sizeof(big); i++)
+            big[i] = (byte)(i * 3);
+
+        for (i = 0; i < BUFS; i++) {
+            for (j = 0; j < (int)sizeof(k); j++)
+                k[j] = (byte)(i + j);
+            sz[i] = blocks[i] * AES_BLOCK_SIZE;
+
+            AesSetKey(&enc, k, keySz[i], iv, AES_ENCRYPTION);
+            if (sz[i])
+                AesCbcEncrypt(&enc, cbc[i], big, sz[i]);
+            AesSetKey(&multi[i], k, keySz[i], iv, AES_DECRYPTION);
+
+            pMulti[i] = &multi[i];
+            pIn[i]    = cbc[i];
+            pOut[i]   = (i == 1) ? cbc[i] : out[i];
+        }
+
+        if (AesCbcDecryptMulti(pMulti, pOut, pIn, sz, BUFS) != 0)
+            return -93;
+
+        for (i = 0; i < BUFS; i++) {
+            if (memcmp(pOut[i], big, sz[i]))
+                return -94;
+        }
+    }
+#endif
+
+#if !defined(HAVE_CAVIUM) && !defined(NO_HMAC) && \
+    (!defined(NO_SHA) || !defined(NO_SHA256))
+    /* HMAC stitched with CBC, against the MAC then CBC done separately,
+       with a record header already in the HMAC and an explicit IV ahead */
+    {
+        static const int    types[] = {
+        #ifndef NO_SHA
+            SHA,
+        #endif
+        #ifndef NO_SHA256
+            SHA256,
+        #endif
+        };
+        static const word32 lens[] = { 0, 13, 51, 64, 115, 200, 1000 };
+        enum { REC_MAX = 1100 };
+
+        Aes    cbcAes;
+        Hmac   hmac;
+        byte   rec[REC_MAX];
+        byte   ref[REC_MAX];
+        byte   mac[MAX_DIGEST_SIZE];
+        byte   refMac[MAX_DIGEST_SIZE];
+        byte   k[16];
+        word32 recSz, done, ivSz;
+        int    t, l, j;
+
+        for (j = 0; j < (int)sizeof(k); j++)
+            k[j] = (byte)(j + 7);
+
+        for (t = 0; t < (int)(sizeof(types) / sizeof(types[0])); t++)
+        for (l = 0; l < (int)(sizeof(lens) / sizeof(lens[0])); l++)
+        for (ivSz = 0; ivSz <= AES_BLOCK_SIZE; ivSz += AES_BLOCK_SIZE) {
+            recSz = (ivSz + lens[l] + MAX_DIGEST_SIZE + AES_BLOCK_SIZE)
+                  & ~(AES_BLOCK_SIZE - 1);
+            for (j = 0; j < (int)recSz; j++)
+                ref[j] = rec[j] = (byte)(j * 5 + l);
+            memset(mac,    0, sizeof(mac));
+            memset(refMac, 0, sizeof(refMac));
+
+            HmacSetKey(&hmac, types[t], k, sizeof(k));
+            HmacUpdate(&hmac, k, 13);
+            HmacUpdate(&hmac, ref + ivSz, lens[l]);
+            HmacFinal(&hmac, refMac);
+            AesSetKey(&cbcAes, k, sizeof(k), iv, AES_ENCRYPTION);
+            AesCbcEncrypt(&cbcAes, ref, ref, recSz);
+
+            HmacSetKey(&hmac, types[t], k, sizeof(k));
+            HmacUpdate(&hmac, k, 13);
+            AesSetKey(&cbcAes, k, sizeof(k), iv, AES_ENCRYPTION);
+            if (HmacUpdateAesCbcEncrypt(&hmac, rec + ivSz, lens[l], &cbcAes,
+                                        rec, &done) != 0)
+                return -95;
+            HmacFinal(&hmac, mac);
+            AesCbcEncrypt(&cbcAes, rec + done, rec + done, recSz - done);
+
+            if (memcmp(mac, refMac, sizeof(mac)) || memcmp(rec, ref, recSz))
+                return -96;
+
+            HmacSetKey(&hmac, types[t], k, sizeof(k));
+            HmacUpdate(&hmac, k, 13);
+            AesSetKey(&cbcAes, k, sizeof(k), iv, AES_DECRYPTION);
+            if (HmacUpdateAesCbcDecrypt(&hmac, rec + ivSz, lens[l], &cbcAes,
+                                        rec, recSz) != 0)
+                return -97;
+            HmacFinal(&hmac, mac);
+
+            for (j = 0; j < (int)recSz; j++) {
+                if (rec[j] != (byte)(j * 5 + l))
+                    return -98;
+            }
+            if (memcmp(mac, refMac, sizeof(mac)))
+                return -98;
+        }
+    }
+#endif
+
 #ifdef HAVE_CAVIUM
         AesFreeCavium(&enc);
         AesFreeCavium(&dec);
@@ -1909,6 +2182,38 @@ int aes_test(void)
 
         if (memcmp(cipher, ctrCipher, AES_BLOCK_SIZE*4))
             return -67;
+
+        /* a long run in one call against one block per call, with the
+           counter carrying out of the low word */
+        {
+            byte ctrIv2[AES_BLOCK_SIZE];
+            byte big[AES_BLOCK_SIZE * 20], out1[sizeof(big)],
+                 out2[sizeof(big)];
+            int  i;
+
+            memcpy(ctrIv2, ctrIv, AES_BLOCK_SIZE);
+            ctrIv2[AES_BLOCK_SIZE - 5] = 0xff;
+            for (i = 0; i < (int)sizeof(big); i++)
+                big[i] = (byte)i;
+
+            AesSetKeyDirect(&enc, ctrKey, AES_BLOCK_SIZE, ctrIv2,
+                            AES_ENCRYPTION);
+            AesSetKeyDirect(&dec, ctrKey, AES_BLOCK_SIZE, ctrIv2,
+                            AES_ENCRYPTION);
+
+            AesCtrEncrypt(&enc, out1, big, sizeof(big));
+            for (i = 0; i < (int)sizeof(big); i += AES_BLOCK_SIZE)
+                AesCtrEncrypt(&dec, out2 + i, big + i, AES_BLOCK_SIZE);
+            if (memcmp(out1, out2, sizeof(big)))
+                return -91;
+
+            /* in place back to the plain text */
+            AesSetKeyDirect(&dec, ctrKey, AES_BLOCK_SIZE, ctrIv2,
+                            AES_ENCRYPTION);
+            AesCtrEncrypt(&dec, out1, out1, sizeof(big));
+            if (memcmp(out1, big, sizeof(big)))
+                return -92;
+        }
     }
 #endif /* CYASSL_AES_COUNTER */
 
@@ -2038,6 +2343,48 @@ int aesgcm_test(void)
     if (memcmp(p, p2, sizeof(p2)))
         return -71;
 
+#ifdef CYASSL_AESNI
+    if (enc.use_pclmul) {
+        /* the AES-NI path against the generic one, across the eight block
+           stride and partial blocks */
+        static const word32 sizes[] = { 1, 15, 16, 17, 127, 128, 129, 255,
+                                        300, 1029 };
+        byte big[1029], out1[1029], out2[1029];
+        byte t3[16];
+        Aes  gen;
+        word32 i, j;
+
+        for (i = 0; i < sizeof(big); i++)
+            big[i] = (byte)(i * 7 + 3);
+
+        memcpy(&gen, &enc, sizeof(Aes));
+        gen.use_pclmul = 0;
+
+        for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+            for (j = 0; j < sizeof(sizes)/sizeof(sizes[0]); j += 3) {
+                AesGcmEncrypt(&enc, out1, big, sizes[i], iv, sizeof(iv),
+                              t2, sizeof(t2), big, sizes[j]);
+                AesGcmEncrypt(&gen, out2, big, sizes[i], iv, sizeof(iv),
+                              t3, sizeof(t3), big, sizes[j]);
+                if (memcmp(out1, out2, sizes[i]) || memcmp(t2, t3, sizeof(t3)))
+                    return -87;
+
+                /* in place */
+                if (AesGcmDecrypt(&enc, out2, out2, sizes[i], iv, sizeof(iv),
+                                  t3, sizeof(t3), big, sizes[j]) != 0)
+                    return -88;
+                if (memcmp(out2, big, sizes[i]))
+                    return -89;
+
+                out1[sizes[i] - 1] ^= 1;
+                if (AesGcmDecrypt(&enc, out2, out1, sizes[i], iv, sizeof(iv),
+                                  t2, sizeof(t2), big, sizes[j]) == 0)
+                    return -90;
+            }
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -2214,6 +2561,26 @@ int aesccm_test(void)
     if (memcmp(p2, c2, sizeof(p2)))
         return -112;
 
+    /* longer messages, in place, with and without a partial block */
+    {
+        byte big[301], big2[sizeof(big)];
+        word32 i, sz;
+
+        for (i = 0; i < sizeof(big); i++)
+            big[i] = (byte)(i * 5 + 1);
+
+        for (sz = sizeof(big) - 13; sz <= sizeof(big); sz += 13) {
+            memcpy(big2, big, sz);
+            AesCcmEncrypt(&enc, big2, big2, sz, iv, sizeof(iv),
+                                                 t2, sizeof(t2), a, sizeof(a));
+            if (AesCcmDecrypt(&enc, big2, big2, sz, iv, sizeof(iv),
+                                            t2, sizeof(t2), a, sizeof(a)) != 0)
+                return -114;
+            if (memcmp(big, big2, sz))
+                return -115;
+        }
+    }
+
     return 0;
 }
 #endif /* HAVE_AESCCM */
@@ -2440,6 +2807,98 @@ int random_test(void)
 
     RNG_GenerateBlock(&rng, block, sizeof(block));
 
+    /* same seed, same stream; a reseed takes the stream somewhere else */
+    {
+        RNG  a, b;
+        byte blockA[32];
+        byte blockB[32];
+
+        if (InitRngSeed(&a, block, sizeof(block)) != 0) return -2008;
+        if (InitRngSeed(&b, block, sizeof(block)) != 0) return -2008;
+
+        RNG_GenerateBlock(&a, blockA, sizeof(blockA));
+        RNG_GenerateBlock(&b, blockB, sizeof(blockB));
+        if (memcmp(blockA, blockB, sizeof(blockA)) != 0)
+            return -2009;
+
+        if (RNG_Reseed(&b) != 0) return -2010;
+
+        RNG_GenerateBlock(&a, blockA, sizeof(blockA));
+        RNG_GenerateBlock(&b, blockB, sizeof(blockB));
+        if (memcmp(blockA, blockB, sizeof(blockA)) == 0)
+            return -2011;
+
+        if (InitRngSeed(&a, NULL, 0) == 0) return -2012;
+    #if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+        FreeRng(&a);
+        FreeRng(&b);
+    #endif
+    }
+
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    /* buffered output is the same stream cut up, a short request is the
+       front of a long one */
+    {
+        RNG  a, b;
+        byte big[RNG_BUFFER_SZ];
+        byte small[RNG_BUFFER_SZ / 4];
+
+        if (InitRngSeed(&a, block, sizeof(block)) != 0) return -2013;
+        if (InitRngSeed(&b, block, sizeof(block)) != 0) return -2013;
+        if (RNG_SetBuffered(&b, 1) != 0) return -2013;
+
+        RNG_GenerateBlock(&a, big, sizeof(big));
+        RNG_GenerateBlock(&b, small, sizeof(small));
+        if (memcmp(big, small, sizeof(small)) != 0)
+            return -2014;
+        RNG_GenerateBlock(&b, small, 20);
+        if (memcmp(big + sizeof(small), small, 20) != 0)
+            return -2015;
+
+        if (InitRngSeed(&a, block, sizeof(block)) != 0) return -2016;
+        RNG_GenerateBlock(&a, small, 20);
+        if (memcmp(big, small, 20) != 0)
+            return -2016;
+
+        FreeRng(&a);
+        FreeRng(&b);
+    }
+#endif
+
+#ifdef HAVE_CTR_DRBG
+    /* CAVP CTR_DRBG AES-256 use df, no prediction resistance, COUNT 0 */
+    {
+        const byte seedA[] = {  /* EntropyInput || Nonce */
+            0x36, 0x40, 0x19, 0x40, 0xfa, 0x8b, 0x1f, 0xba,
+            0x91, 0xa1, 0x66, 0x1f, 0x21, 0x1d, 0x78, 0xa0,
+            0xb9, 0x38, 0x9a, 0x74, 0xe5, 0xbc, 0xcf, 0xec,
+            0xe8, 0xd7, 0x66, 0xaf, 0x1a, 0x6d, 0x3b, 0x14,
+            0x49, 0x6f, 0x25, 0xb0, 0xf1, 0x30, 0x1b, 0x4f,
+            0x50, 0x1b, 0xe3, 0x03, 0x80, 0xa1, 0x37, 0xeb
+        };
+        const byte outA[] = {
+            0x58, 0x62, 0xeb, 0x38, 0xbd, 0x55, 0x8d, 0xd9,
+            0x78, 0xa6, 0x96, 0xe6, 0xdf, 0x16, 0x47, 0x82,
+            0xdd, 0xd8, 0x87, 0xe7, 0xe9, 0xa6, 0xc9, 0xf3,
+            0xf1, 0xfb, 0xaf, 0xb7, 0x89, 0x41, 0xb5, 0x35,
+            0xa6, 0x49, 0x12, 0xdf, 0xd2, 0x24, 0xc6, 0xdc,
+            0x74, 0x54, 0xe5, 0x25, 0x0b, 0x3d, 0x97, 0x16,
+            0x5e, 0x16, 0x26, 0x0c, 0x2f, 0xaf, 0x1c, 0xc7,
+            0x73, 0x5c, 0xb7, 0x5f, 0xb4, 0xf0, 0x7e, 0x1d
+        };
+        RNG  a;
+        byte out[sizeof(outA)];
+
+        if (InitRngSeed(&a, seedA, sizeof(seedA)) != 0) return -2017;
+        RNG_GenerateBlock(&a, out, sizeof(out));
+        RNG_GenerateBlock(&a, out, sizeof(out));
+        if (memcmp(out, outA, sizeof(out)) != 0)
+            return -2018;
+
+        FreeRng(&a);
+    }
+#endif
+
     return 0;
 }
 
@@ -2580,6 +3039,27 @@ int rsa_test(void)
 
     if (memcmp(plain, in, ret)) return -48;
 
+    /* blinded private key operations give the same answers */
+    {
+        byte sig[256];
+        int  sigSz, i;
+        byte* res = NULL;
+
+        sigSz = RsaSSL_Sign(in, inLen, sig, sizeof(sig), &key, NULL);
+        if (sigSz < 0) return -250;
+        /* enough times to square the key's blinding pair past a refresh */
+        for (i = 0; i < 40; i++) {
+            ret = RsaSSL_Sign(in, inLen, out, sizeof(out), &key, &rng);
+            if (ret != sigSz || memcmp(sig, out, sigSz)) return -251;
+        }
+
+        ret = RsaPublicEncrypt(in, inLen, out, sizeof(out), &key, &rng);
+        if (ret < 0) return -252;
+        ret = RsaPrivateDecryptInline_ex(out, ret, &res, &key, &rng);
+        if (ret != (int)inLen || res == NULL || memcmp(res, in, inLen))
+            return -253;
+    }
+
 #if defined(CYASSL_MDK_ARM)
     #define sizeof(s) strlen((char *)(s))
 #endif
@@ -3591,6 +4071,66 @@ int ecc_test(void)
     if (ret != 0)
         return -1013;
 
+#ifdef HAVE_ECC_P256
+    {
+        /* P-256 code against the generic code, which runs on a copy of the
+           built in params */
+        ecc_set_type generic = *userA.dp;
+        ecc_key      userC;
+
+        for (i = 0; i < 8; i++) {
+            ecc_init(&userC);
+            ret = ecc_make_key_ex(&rng, &userC, &generic);
+            if (ret != 0)
+                return -1014;
+
+            x = sizeof(sharedA);
+            ret = ecc_shared_secret(&userA, &userC, sharedA, &x);
+            if (ret != 0)
+                return -1015;
+
+            y = sizeof(sharedB);
+            ret = ecc_shared_secret(&userC, &userA, sharedB, &y);
+            if (ret != 0)
+                return -1016;
+
+            if (y != x || memcmp(sharedA, sharedB, x))
+                return -1017;
+
+            /* generic signature, P-256 verify */
+            x = sizeof(sig);
+            ret = ecc_sign_hash(digest, sizeof(digest), sig, &x, &rng, &userC);
+            if (ret != 0)
+                return -1018;
+
+            y = sizeof(exportBuf);
+            ret = ecc_export_x963(&userC, exportBuf, &y);
+            if (ret != 0)
+                return -1019;
+
+            ecc_free(&pubKey);
+            ret = ecc_import_x963(exportBuf, y, &pubKey);
+            if (ret != 0)
+                return -1020;
+
+            verify = 0;
+            ret = ecc_verify_hash(sig, x, digest, sizeof(digest), &verify,
+                                  &pubKey);
+            if (ret != 0 || verify != 1)
+                return -1021;
+
+            digest[0] ^= 1;
+            ret = ecc_verify_hash(sig, x, digest, sizeof(digest), &verify,
+                                  &pubKey);
+            digest[0] ^= 1;
+            if (ret != 0 || verify != 0)
+                return -1022;
+
+            ecc_free(&userC);
+        }
+    }
+#endif /* HAVE_ECC_P256 */
+
     ecc_free(&pubKey);
     ecc_free(&userB);
     ecc_free(&userA);
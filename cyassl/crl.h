@@ -40,6 +40,9 @@ CYASSL_LOCAL void FreeCRL(CYASSL_CRL*, int dynamic);
 
 CYASSL_LOCAL int  LoadCRL(CYASSL_CRL* crl, const char* path, int type, int mon);
 CYASSL_LOCAL int  BufferLoadCRL(CYASSL_CRL*, const byte*, long, int);
+CYASSL_LOCAL int  CompileCRL(CYASSL_CERT_MANAGER*, const char* in, int type,
+                             const char* out);
+CYASSL_LOCAL int  LoadCRL_Index(CYASSL_CRL*, const char* file);
 CYASSL_LOCAL int  CheckCertCRL(CYASSL_CRL*, DecodedCert*);
 
 
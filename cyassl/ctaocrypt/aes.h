@@ -82,9 +82,15 @@ typedef struct Aes {
     /* key-based fast multiplication table. */
     ALIGN16 byte M0[256][AES_BLOCK_SIZE];
 #endif /* GCM_TABLE */
+#ifdef CYASSL_AESNI
+    ALIGN16 byte Hp[8][AES_BLOCK_SIZE];  /* H^1..H^8, PCLMULQDQ GHASH */
+#endif /* CYASSL_AESNI */
 #endif /* HAVE_AESGCM */
 #ifdef CYASSL_AESNI
     byte use_aesni;
+#ifdef HAVE_AESGCM
+    byte use_pclmul;         /* AES-NI GCM path, clear to use the generic */
+#endif /* HAVE_AESGCM */
 #endif /* CYASSL_AESNI */
 #ifdef HAVE_CAVIUM
     AesType type;            /* aes key type */
@@ -100,6 +106,8 @@ CYASSL_API int  AesSetKey(Aes* aes, const byte* key, word32 len, const byte* iv,
 CYASSL_API int  AesSetIV(Aes* aes, const byte* iv);
 CYASSL_API int  AesCbcEncrypt(Aes* aes, byte* out, const byte* in, word32 sz);
 CYASSL_API int  AesCbcDecrypt(Aes* aes, byte* out, const byte* in, word32 sz);
+CYASSL_API int  AesCbcDecryptMulti(Aes** aes, byte** out, const byte** in,
+                                   const word32* sz, word32 count);
 CYASSL_API void AesCtrEncrypt(Aes* aes, byte* out, const byte* in, word32 sz);
 CYASSL_API void AesEncryptDirect(Aes* aes, byte* out, const byte* in);
 CYASSL_API void AesDecryptDirect(Aes* aes, byte* out, const byte* in);
@@ -339,6 +339,13 @@ struct DecodedCert {
     #define SIGNER_DIGEST_SIZE 20 
 #endif
 
+/* the cert manager remembers certs whose signature checked out, keyed by a
+   SHA-256 of the cert and its issuer's key, no cache without SHA-256 */
+#if defined(NO_SHA256) && !defined(NO_CERT_VERIFY_CACHE)
+    #define NO_CERT_VERIFY_CACHE
+#endif
+#define CERT_VERIFY_DIGEST_SIZE 32
+
 /* CA Signers */
 /* if change layout change PERSIST_CERT_CACHE functions too */
 struct Signer {
@@ -0,0 +1,64 @@
+/* cpuid.h
+ *
+ * Copyright (C) 2006-2013 wolfSSL Inc.
+ *
+ * This file is part of CyaSSL.
+ *
+ * CyaSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * CyaSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+
+#ifdef USE_INTEL_SPEEDUP
+
+#ifndef CTAO_CRYPT_CPUID_H
+#define CTAO_CRYPT_CPUID_H
+
+#include <cyassl/ctaocrypt/types.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+
+/* x86 features the SIMD transforms are built on */
+enum {
+    CPUID_SSSE3 = 0x01,
+    CPUID_AVX2  = 0x02,     /* AVX2 and BMI2, with OS ymm state support */
+    CPUID_SHA   = 0x04      /* SHA extensions and SSE4.1 */
+};
+
+/* hash transform backends, in order of preference, lowest first */
+enum {
+    TRANSFORM_C     = 0,
+    TRANSFORM_SSSE3 = 1,
+    TRANSFORM_AVX2  = 2,
+    TRANSFORM_SHANI = 3
+};
+
+/* lets one function use instructions the rest of the build doesn't */
+#define INTEL_TARGET(x) __attribute__((target(x)))
+
+
+/* CPUID_* flags of the running cpu, looked up once */
+CYASSL_LOCAL word32 cpuid_get_flags(void);
+
+
+#ifdef __cplusplus
+    } /* extern "C" */
+#endif
+
+#endif /* CTAO_CRYPT_CPUID_H */
+#endif /* USE_INTEL_SPEEDUP */
+
@@ -85,6 +85,8 @@ extern const ecc_set_type ecc_sets[];
 CYASSL_API
 int ecc_make_key(RNG* rng, int keysize, ecc_key* key);
 CYASSL_API
+int ecc_make_key_ex(RNG* rng, ecc_key* key, const ecc_set_type* dp);
+CYASSL_API
 int ecc_shared_secret(ecc_key* private_key, ecc_key* public_key, byte* out,
                       word32* outlen);
 CYASSL_API
@@ -99,6 +101,10 @@ CYASSL_API
 void ecc_free(ecc_key* key);
 CYASSL_API
 void ecc_fp_free(void);
+CYASSL_API
+int ecc_fp_init(void);
+CYASSL_API
+void ecc_fp_cleanup(void);
 
 
 /* ASN key helpers */
@@ -0,0 +1,62 @@
+/* ecc_p256.h
+ *
+ * Copyright (C) 2006-2013 wolfSSL Inc.
+ *
+ * This file is part of CyaSSL.
+ *
+ * CyaSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * CyaSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+
+#if defined(HAVE_ECC) && defined(HAVE_ECC_P256)
+
+#ifndef CTAO_CRYPT_ECC_P256_H
+#define CTAO_CRYPT_ECC_P256_H
+
+#include <cyassl/ctaocrypt/ecc.h>
+
+#if !defined(WORD64_AVAILABLE) || !defined(__SIZEOF_INT128__)
+    #error HAVE_ECC_P256 needs 64 bit words and a 128 bit integer type
+#endif
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+
+/* Dedicated secp256r1 arithmetic, used by ecc.c in place of the generic
+   mp_int code for keys on the built in P-256 parameters. Scalars are handled
+   in constant time, results are affine (z = 1). */
+
+/* R = k * G */
+CYASSL_LOCAL
+int ecc_p256_mulmod_base(mp_int* k, ecc_point* R);
+
+/* R = k * P */
+CYASSL_LOCAL
+int ecc_p256_mulmod(mp_int* k, ecc_point* P, ecc_point* R);
+
+/* R = kG * G + kP * P */
+CYASSL_LOCAL
+int ecc_p256_mul2add(mp_int* kG, mp_int* kP, ecc_point* P, ecc_point* R);
+
+
+#ifdef __cplusplus
+    } /* extern "C" */
+#endif
+
+#endif /* CTAO_CRYPT_ECC_P256_H */
+#endif /* HAVE_ECC && HAVE_ECC_P256 */
+
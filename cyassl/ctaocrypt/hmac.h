@@ -47,6 +47,10 @@
     #include <cyassl/ctaocrypt/blake2.h>
 #endif
 
+#ifndef NO_AES
+    #include <cyassl/ctaocrypt/aes.h>
+#endif
+
 #ifdef HAVE_CAVIUM
     #include <cyassl/ctaocrypt/logging.h>
     #include "cavium_common.h"
@@ -59,6 +63,12 @@
 
 #define CYASSL_HMAC_CAVIUM_MAGIC 0xBEEF0005
 
+/* keep the hashed key pads and clone them per message, can't with hash
+   state held in hardware */
+#ifndef STM32F2_HASH
+    #define HMAC_PAD_STATES
+#endif
+
 enum {
     IPAD    = 0x36,
     OPAD    = 0x5C,
@@ -138,6 +148,10 @@ typedef struct Hmac {
     word32  innerHash[MAX_DIGEST_SIZE / sizeof(word32)];
     byte    macType;                                     /* md5 sha or sha256 */
     byte    innerHashKeyed;                              /* keyed flag */
+#ifdef HMAC_PAD_STATES
+    Hash    innerState;                      /* key ^ ipad hashed */
+    Hash    outerState;                      /* key ^ opad hashed */
+#endif
 #ifdef HAVE_CAVIUM
     word16   keyLen;          /* hmac key length */
     word16   dataLen;
@@ -155,6 +169,14 @@ CYASSL_API int  HmacSetKey(Hmac*, int type, const byte* key, word32 keySz);
 CYASSL_API void HmacUpdate(Hmac*, const byte*, word32);
 CYASSL_API void HmacFinal(Hmac*, byte*);
 
+#ifndef NO_AES
+    /* HMAC stitched with in place AES-CBC, for MAC then encrypt records */
+    CYASSL_API int HmacUpdateAesCbcEncrypt(Hmac*, const byte* msg, word32 sz,
+                                           Aes*, byte* cbc, word32* cbcSz);
+    CYASSL_API int HmacUpdateAesCbcDecrypt(Hmac*, const byte* msg, word32 sz,
+                                           Aes*, byte* cbc, word32 cbcSz);
+#endif
+
 #ifdef HAVE_CAVIUM
     CYASSL_API int  HmacInitCavium(Hmac*, int);
     CYASSL_API void HmacFreeCavium(Hmac*);
@@ -25,7 +25,9 @@
 
 #include <cyassl/ctaocrypt/types.h>
 
-#ifndef NO_RC4
+#if defined(HAVE_CTR_DRBG)
+    #include <cyassl/ctaocrypt/aes.h>
+#elif !defined(NO_RC4)
     #include <cyassl/ctaocrypt/arc4.h>
 #else
     #include <cyassl/ctaocrypt/sha256.h>
@@ -64,7 +66,7 @@ int GenerateSeed(OS_Seed* os, byte* seed, word32 sz);
 #define RNG CyaSSL_RNG   /* for avoiding name conflict in "stm32f2xx.h" */
 #endif
 
-#ifndef NO_RC4
+#if !defined(NO_RC4) && !defined(HAVE_CTR_DRBG)
 
 #define CYASSL_RNG_CAVIUM_MAGIC 0xBEEF0004
 
@@ -85,29 +87,43 @@ typedef struct RNG {
     CYASSL_API int  InitRngCavium(RNG*, int);
 #endif
 
-#else /* NO_RC4 */
+#else /* NO_RC4 || HAVE_CTR_DRBG */
 
 #define DBRG_SEED_LEN (440/8)
 
+#ifndef RNG_BUFFER_SZ
+    #define RNG_BUFFER_SZ 256    /* batch size of buffered output */
+#endif
+
 
 /* secure Random Nnumber Generator */
 typedef struct RNG {
     OS_Seed seed;
 
+#ifdef HAVE_CTR_DRBG
+    Aes  aes;                    /* keyed with the DRBG Key, reg holds V + 1 */
+#else
     Sha256 sha;
     byte digest[SHA256_DIGEST_SIZE];
     byte V[DBRG_SEED_LEN];
     byte C[DBRG_SEED_LEN];
+#endif
     word64 reseed_ctr;
+    byte   buffered;             /* serve small requests from out */
+    word32 outSz;                /* unused bytes at the end of out */
+    byte   out[RNG_BUFFER_SZ];
 } RNG;
 
 #endif
 
 CYASSL_API int  InitRng(RNG*);
+CYASSL_API int  InitRngSeed(RNG*, const byte* seed, word32 sz);
+CYASSL_API int  RNG_Reseed(RNG*);
 CYASSL_API void RNG_GenerateBlock(RNG*, byte*, word32 sz);
 CYASSL_API byte RNG_GenerateByte(RNG*);
 
-#ifdef NO_RC4
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    CYASSL_API int  RNG_SetBuffered(RNG*, int);
     CYASSL_API void FreeRng(RNG*);
 #endif
 
@@ -44,6 +44,15 @@ typedef struct RsaKey {
     mp_int n, e, d, p, q, dP, dQ, u;
     int   type;                               /* public or private */
     void* heap;                               /* for user memory overrides */
+#ifdef USE_FAST_MATH
+    mp_mont pMont, qMont;   /* Montgomery constants for p and q */
+    byte    montSet;        /* pMont and qMont set by RsaPrecompute() */
+    mp_int  blind;          /* r^e mod n for the next blinded operation */
+    mp_int  blindInv;       /* 1/r mod n to take it back out */
+    word32  blindUses;      /* times squared since a fresh r was drawn */
+    byte    blindSet;       /* blind and blindInv hold a pair */
+    CyaSSL_Mutex blindLock; /* a decoded key may be shared across threads */
+#endif
 #ifdef HAVE_CAVIUM
     int    devId;           /* nitrox device id */
     word32 magic;           /* using cavium magic */
@@ -68,6 +77,8 @@ CYASSL_API int  RsaPublicEncrypt(const byte* in, word32 inLen, byte* out,
                                  word32 outLen, RsaKey* key, RNG* rng);
 CYASSL_API int  RsaPrivateDecryptInline(byte* in, word32 inLen, byte** out,
                                         RsaKey* key);
+CYASSL_API int  RsaPrivateDecryptInline_ex(byte* in, word32 inLen, byte** out,
+                                           RsaKey* key, RNG* rng);
 CYASSL_API int  RsaPrivateDecrypt(const byte* in, word32 inLen, byte* out,
                                   word32 outLen, RsaKey* key);
 CYASSL_API int  RsaSSL_Sign(const byte* in, word32 inLen, byte* out,
@@ -82,6 +93,8 @@ CYASSL_API int RsaPrivateKeyDecode(const byte* input, word32* inOutIdx, RsaKey*,
                                    word32);
 CYASSL_API int RsaPublicKeyDecode(const byte* input, word32* inOutIdx, RsaKey*,
                                   word32);
+CYASSL_LOCAL int RsaPrecompute(RsaKey* key);
+
 #ifdef CYASSL_KEY_GEN
     CYASSL_API int MakeRsaKey(RsaKey* key, int size, long e, RNG* rng);
     CYASSL_API int RsaKeyToDer(RsaKey*, byte* output, word32 inLen);
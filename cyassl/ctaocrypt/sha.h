@@ -26,6 +26,9 @@
 #define CTAO_CRYPT_SHA_H
 
 #include <cyassl/ctaocrypt/types.h>
+#ifdef USE_INTEL_SPEEDUP
+    #include <cyassl/ctaocrypt/cpuid.h>
+#endif
 
 #ifdef __cplusplus
     extern "C" {
@@ -58,6 +61,12 @@ CYASSL_API void InitSha(Sha*);
 CYASSL_API void ShaUpdate(Sha*, const byte*, word32);
 CYASSL_API void ShaFinal(Sha*, byte*);
 
+#ifdef USE_INTEL_SPEEDUP
+    /* TRANSFORM_* backend, the best one the cpu has is picked by default */
+    CYASSL_API int ShaSetTransform(int type);
+    CYASSL_API int ShaGetTransform(void);
+#endif
+
 
 #ifdef __cplusplus
     } /* extern "C" */
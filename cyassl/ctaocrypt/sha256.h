@@ -29,6 +29,9 @@
 #define CTAO_CRYPT_SHA256_H
 
 #include <cyassl/ctaocrypt/types.h>
+#ifdef USE_INTEL_SPEEDUP
+    #include <cyassl/ctaocrypt/cpuid.h>
+#endif
 
 #ifdef __cplusplus
     extern "C" {
@@ -58,6 +61,12 @@ CYASSL_API void InitSha256(Sha256*);
 CYASSL_API void Sha256Update(Sha256*, const byte*, word32);
 CYASSL_API void Sha256Final(Sha256*, byte*);
 
+#ifdef USE_INTEL_SPEEDUP
+    /* TRANSFORM_* backend, the best one the cpu has is picked by default */
+    CYASSL_API int Sha256SetTransform(int type);
+    CYASSL_API int Sha256GetTransform(void);
+#endif
+
 
 #ifdef __cplusplus
     } /* extern "C" */
@@ -0,0 +1,48 @@
+/* siphash.h
+ *
+ * Copyright (C) 2006-2013 wolfSSL Inc.
+ *
+ * This file is part of CyaSSL.
+ *
+ * CyaSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * CyaSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+
+
+#ifndef CTAO_CRYPT_SIPHASH_H
+#define CTAO_CRYPT_SIPHASH_H
+
+#include <cyassl/ctaocrypt/types.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+
+enum {
+    SIPHASH_KEY_SIZE    = 8,    /* HalfSipHash 64 bit key */
+    SIPHASH_DIGEST_SIZE = 4     /* HalfSipHash 32 bit output */
+};
+
+
+/* HalfSipHash-2-4, a keyed hash for picking hash table rows from peer
+   chosen data, it is not a MAC */
+CYASSL_API word32 HalfSipHash24(const byte* key, const byte* in, word32 sz);
+
+
+#ifdef __cplusplus
+    } /* extern "C" */
+#endif
+
+#endif /* CTAO_CRYPT_SIPHASH_H */
@@ -467,6 +467,19 @@ void fp_montgomery_reduce(fp_int *a, fp_int *m, fp_digit mp);
 /* d = a**b (mod c) */
 int fp_exptmod(fp_int *a, fp_int *b, fp_int *c, fp_int *d);
 
+/* Montgomery constants of a fixed modulus, set up once and reused */
+typedef struct {
+    fp_int   R2;         /* R**2 mod m */
+    fp_digit mp;         /* -1/m mod 2**DIGIT_BIT */
+} fp_mont;
+
+/* precompute mont for odd modulus a */
+int fp_mont_setup(fp_int *a, fp_mont *mont);
+
+/* d = a**b (mod c) for a secret exponent b, operation sequence and table
+ * access don't depend on b, mont from fp_mont_setup(c) */
+int fp_exptmod_ct(fp_int *a, fp_int *b, fp_int *c, fp_mont *mont, fp_int *d);
+
 /* primality stuff */
 
 /* perform a Miller-Rabin test of a to the base b and store result in "result" */
@@ -620,6 +633,7 @@ void fp_sqr_comba64(fp_int *A, fp_int *B);
     typedef fp_digit mp_digit;
     typedef fp_word  mp_word;
     typedef fp_int mp_int;
+    typedef fp_mont mp_mont;
 
 /* Constants */
     #define MP_LT   FP_LT   /* less than    */
@@ -643,6 +657,9 @@ int  mp_mulmod (mp_int * a, mp_int * b, mp_int * c, mp_int * d);
 int  mp_mod(mp_int *a, mp_int *b, mp_int *c);
 int  mp_invmod(mp_int *a, mp_int *b, mp_int *c);
 int  mp_exptmod (mp_int * G, mp_int * X, mp_int * P, mp_int * Y);
+int  mp_mont_setup(mp_int * P, mp_mont * mont);
+int  mp_exptmod_ct(mp_int * G, mp_int * X, mp_int * P, mp_mont * mont,
+                   mp_int * Y);
 
 int  mp_cmp(mp_int *a, mp_int *b);
 int  mp_cmp_d(mp_int *a, mp_digit b);
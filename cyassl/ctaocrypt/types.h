@@ -265,7 +265,10 @@ enum {
     DYNAMIC_TYPE_CAVIUM_TMP   = 40,
     DYNAMIC_TYPE_CAVIUM_RSA   = 41,
     DYNAMIC_TYPE_X509         = 42,
-    DYNAMIC_TYPE_TLSX         = 43
+    DYNAMIC_TYPE_TLSX         = 43,
+    DYNAMIC_TYPE_SESSION_CACHE = 44,
+    DYNAMIC_TYPE_HASHES       = 45,
+    DYNAMIC_TYPE_CERT_VERIFY  = 46
 };
 
 /* max error buffer string size */
@@ -114,6 +114,8 @@ enum CyaSSL_ErrorCodes {
     CACHE_MATCH_ERROR       = -280,        /* chache hdr match error */
     UNKNOWN_SNI_HOST_NAME_E = -281,        /* Unrecognized host name Error */
     UNKNOWN_MAX_FRAG_LEN_E  = -282,        /* Unrecognized max frag len Error */
+    SESSION_TICKET_E        = -283,        /* Session ticket unusable Error */
+    NO_HANDSHAKE_HASHES_E   = -284,        /* Handshake transcript gone Error */
     /* add strings to SetErrorString !!!!! */
 
     /* begin negotiation parameter errors */
@@ -103,6 +103,10 @@
     #if defined(OPENSSL_EXTRA) || defined(GOAHEAD_WS)
         #include <unistd.h>      /* for close of BIO */
     #endif
+    #if !defined(NO_DEV_RANDOM) && !defined(EBSNET)
+        #include <unistd.h>      /* getpid for ctx rng fork check */
+        #define CYASSL_RNG_FORK_CHECK
+    #endif
 #endif
 
 
@@ -422,6 +426,11 @@ void c32to24(word32 in, word24 out);
     #define BUILD_ARC4
 #endif
 
+#if defined(BUILD_AES) && !defined(NO_TLS) && !defined(NO_HMAC) && \
+    !defined(HAVE_CAVIUM)
+    #define BUILD_AES_CBC_HMAC      /* TLS MAC stitched with AES-CBC records */
+#endif
+
 
 
 #if defined(BUILD_AESGCM) || defined(HAVE_AESCCM)
@@ -622,6 +631,12 @@ enum Misc {
     DTLS_HANDSHAKE_FRAG_SZ   = 3,  /* fragment offset and length are 24 bit */
     DTLS_POOL_SZ             = 5,  /* buffers to hold in the retry pool */
 
+    READ_AHEAD_SZ = RECORD_HEADER_SZ + MAX_RECORD_SIZE + MAX_COMP_EXTRA +
+                    MAX_MSG_EXTRA,     /* input buffer when reading ahead */
+    BUFFER_POOL_SZ = READ_AHEAD_SZ + MAX_MSG_EXTRA, /* one record + slack */
+    CTX_RNG_SEED_SZ = 48,       /* ctx rng output seeding an ssl rng */
+    CTX_RNG_RESEED  = 1024,     /* ssl seeds between ctx rng OS reseeds */
+
     FINISHED_LABEL_SZ   = 15,  /* TLS finished label size */
     TLS_FINISHED_SZ     = 12,  /* TLS has a shorter size  */
     MASTER_LABEL_SZ     = 13,  /* TLS master secret label sz */
@@ -641,6 +656,14 @@ enum Misc {
     AES_IV_SIZE         = 16,  /* always block size       */
     AES_128_KEY_SIZE    = 16,  /* for 128 bit             */
 
+    TICKET_NAME_SZ      = 16,  /* session ticket key name        */
+    TICKET_MAC_SZ       = 32,  /* HMAC-SHA256 ticket mac         */
+    TICKET_STATE_SZ     = 64,  /* encrypted state, block padded  */
+    TICKET_HINT_SZ      =  4,  /* NewSessionTicket lifetime hint */
+    MAX_TICKET_KEYS     =  3,  /* current key plus two retired   */
+    MAX_TICKET_SZ       = TICKET_NAME_SZ + AES_IV_SIZE + OPAQUE16_LEN +
+                          TICKET_STATE_SZ + TICKET_MAC_SZ,
+
     AEAD_SEQ_OFFSET     = 4,        /* Auth Data: Sequence number */
     AEAD_TYPE_OFFSET    = 8,        /* Auth Data: Type            */
     AEAD_VMAJ_OFFSET    = 9,        /* Auth Data: Major Version   */
@@ -877,6 +900,16 @@ enum {
     #define OUTPUT_RECORD_SIZE RECORD_SIZE
 #endif
 
+/* records SSL_write builds into the output buffer before one send callback,
+   1 sends each record on its own like static chunks only has to */
+#ifndef MAX_SEND_RECORDS
+    #ifndef STATIC_CHUNKS_ONLY
+        #define MAX_SEND_RECORDS 4
+    #else
+        #define MAX_SEND_RECORDS 1
+    #endif
+#endif
+
 /* CyaSSL input buffer
 
    RFC 2246:
@@ -901,6 +934,7 @@ typedef struct {
     ALIGN16 byte staticBuffer[STATIC_BUFFER_LEN];
     byte   dynamicFlag;  /* dynamic memory currently in use */
     byte   offset;       /* alignment offset attempt */
+    byte   pooled;       /* dynamic memory borrowed from ctx buffer pool */
 } bufferStatic;
 
 /* Cipher Suites holder */
@@ -981,21 +1015,42 @@ typedef struct OCSP_Entry OCSP_Entry;
 #endif
 
 struct OCSP_Entry {
-    OCSP_Entry* next;                       /* next entry             */
-    byte    issuerHash[OCSP_DIGEST_SIZE];    /* issuer hash            */ 
+    OCSP_Entry* next;                        /* next entry in row      */
+    OCSP_Entry* lruPrev;                     /* more recently used     */
+    OCSP_Entry* lruNext;                     /* less recently used     */
+    byte    issuerHash[OCSP_DIGEST_SIZE];    /* issuer hash            */
     byte    issuerKeyHash[OCSP_DIGEST_SIZE]; /* issuer public key hash */
-    CertStatus* status;                     /* OCSP response list     */
-    int         totalStatus;                /* number on list         */
+    CertStatus* status;                      /* serial and last answer */
+    int         refs;                        /* lookups using entry    */
+    CyaSSL_Mutex lookupLock;                 /* held over the responder
+                                                round trip             */
 };
 
 
+#ifndef OCSP_CACHE_ROWS
+    #define OCSP_CACHE_ROWS 64   /* least hash rows, cert status lookups */
+#endif
+#ifndef OCSP_CACHE_MAX_ROWS
+    #define OCSP_CACHE_MAX_ROWS 65536   /* most, rows follow cacheMax */
+#endif
+#ifndef OCSP_CACHE_SZ
+    #define OCSP_CACHE_SZ   256  /* default max cached cert statuses */
+#endif
+
 /* CyaSSL OCSP controller */
 struct CYASSL_OCSP {
     byte enabled;
     byte useOverrideUrl;
     byte useNonce;
     char overrideUrl[80];
-    OCSP_Entry* ocspList;
+    OCSP_Entry** cache;          /* cacheRows rows, made on first use */
+    word32 cacheRows;            /* power of two, about cacheMax */
+    word32 cacheCount;           /* entries in cache */
+    word32 cacheMax;             /* trim cache back to this many entries */
+    word32 sinceSweep;           /* lookups since stale entries were swept */
+    OCSP_Entry* lruHead;         /* most recently used */
+    OCSP_Entry* lruTail;         /* least recently used, evicted first */
+    CyaSSL_Mutex ocspLock;       /* cache lock */
     void* IOCB_OcspCtx;
     CallbackIOOcsp CBIOOcsp;
     CallbackIOOcspRespFree CBIOOcspRespFree;
@@ -1017,9 +1072,12 @@ typedef struct CRL_Entry CRL_Entry;
     typedef struct RevokedCert RevokedCert;
 #endif
 
+/* revoked serial record, length byte then the serial zero padded, so sorted
+   records compare with one memcmp */
+#define CRL_SERIAL_SZ (EXTERNAL_SERIAL_SIZE + 1)
+
 /* Complete CRL */
 struct CRL_Entry {
-    CRL_Entry* next;                      /* next entry */
     byte    issuerHash[CRL_DIGEST_SIZE];  /* issuer hash                 */ 
     /* byte    crlHash[CRL_DIGEST_SIZE];      raw crl data hash           */ 
     /* restore the hash here if needed for optimized comparisons */
@@ -1027,8 +1085,23 @@ struct CRL_Entry {
     byte    nextDate[MAX_DATE_SIZE]; /* next update date   */
     byte    lastDateFormat;          /* last date format */
     byte    nextDateFormat;          /* next date format */
-    RevokedCert* certs;              /* revoked cert list  */
-    int          totalCerts;         /* number on list     */
+    byte*   serials;                 /* sorted CRL_SERIAL_SZ records */
+    int     totalCerts;              /* number of records  */
+    int     refs;                    /* stores holding this entry */
+    byte*   map;                     /* mapped CRL index serials point in */
+    long    mapSz;                   /* size of the mapping */
+};
+
+
+typedef struct CRL_Store CRL_Store;
+
+/* CRL snapshot, never changed once published; a load builds a new one and
+   swaps it in, readers keep theirs alive with a reference */
+struct CRL_Store {
+    CRL_Entry** table;              /* open addressed by issuer hash */
+    word32      tableSz;            /* power of two, twice count at least */
+    word32      count;              /* entries in table */
+    int         refs;               /* readers plus one while current */
 };
 
 
@@ -1041,6 +1114,15 @@ struct CRL_Monitor {
 };
 
 
+typedef struct CRL_IndexPath CRL_IndexPath;
+
+/* CRL index the application named, mapped again on monitor reloads */
+struct CRL_IndexPath {
+    char*          path;     /* file name as loaded */
+    CRL_IndexPath* next;     /* in load order */
+};
+
+
 #ifndef HAVE_CRL
     typedef struct CYASSL_CRL CYASSL_CRL;
 #endif
@@ -1048,9 +1130,10 @@ struct CRL_Monitor {
 /* CyaSSL CRL controller */
 struct CYASSL_CRL {
     CYASSL_CERT_MANAGER* cm;            /* pointer back to cert manager */
-    CRL_Entry*           crlList;       /* our CRL list */
-    CyaSSL_Mutex         crlLock;       /* CRL list lock */
+    CRL_Store*           store;         /* current CRL snapshot */
+    CyaSSL_Mutex         crlLock;       /* store pointer and refs lock */
     CRL_Monitor          monitors[2];   /* PEM and DER possible */
+    CRL_IndexPath*       indexes;       /* named CRL indexes, crlLock */
 #ifdef HAVE_CRL_MONITOR
     pthread_t            tid;           /* monitoring thread */
 #endif
@@ -1059,6 +1142,9 @@ struct CYASSL_CRL {
 
 #ifdef NO_ASN 
     typedef struct Signer Signer;
+    #ifndef NO_CERT_VERIFY_CACHE
+        #define NO_CERT_VERIFY_CACHE
+    #endif
 #endif
 
 
@@ -1066,6 +1152,18 @@ struct CYASSL_CRL {
     #define CA_TABLE_SIZE 11
 #endif
 
+#ifndef NO_CERT_VERIFY_CACHE
+    #ifndef CERT_VERIFY_CACHE_SZ
+        #define CERT_VERIFY_CACHE_SZ 128  /* verified cert slots */
+    #endif
+
+    /* a cert whose signature checked out against its issuer's key */
+    typedef struct CertVerifyEntry {
+        byte key[CERT_VERIFY_DIGEST_SIZE];  /* sha256 of cert and issuer key */
+        byte used;
+    } CertVerifyEntry;
+#endif
+
 /* CyaSSL Certificate Manager */
 struct CYASSL_CERT_MANAGER {
     Signer*         caTable[CA_TABLE_SIZE]; /* the CA signer table */
@@ -1076,6 +1174,12 @@ struct CYASSL_CERT_MANAGER {
     byte            crlEnabled;         /* is CRL on ? */
     byte            crlCheckAll;        /* always leaf, but all ? */
     CbMissingCRL    cbMissingCRL;       /* notify through cb of missing crl */
+#ifndef NO_CERT_VERIFY_CACHE
+    CertVerifyEntry* verifyCache;       /* CERT_VERIFY_CACHE_SZ slots, made on
+                                           first add, guarded by caLock */
+    word32          verifyHits;         /* signature checks skipped */
+    word32          verifyMisses;       /* signature checks done */
+#endif
 };
 
 CYASSL_LOCAL int CM_SaveCertCache(CYASSL_CERT_MANAGER*, const char*);
@@ -1106,6 +1210,7 @@ typedef enum {
     TRUNCATED_HMAC         =  4,
   /*STATUS_REQUEST         =  5,
     SIGNATURE_ALGORITHMS   = 13,*/
+    SESSION_TICKET         = 35
 } TLSX_Type;
 
 typedef struct TLSX {
@@ -1172,8 +1277,56 @@ CYASSL_LOCAL int TLSX_UseTruncatedHMAC(TLSX** extensions);
 
 #endif /* HAVE_TRUNCATED_HMAC */
 
+/* RFC 5077 Session Tickets, server side */
+#ifdef HAVE_SESSION_TICKET
+
+#if defined(NO_AES) || defined(NO_SHA256)
+    #error "Session tickets require AES and SHA-256"
+#endif
+
+typedef struct TicketKey {
+    byte name[TICKET_NAME_SZ];          /* identifies the key in a ticket */
+    byte encKey[AES_128_KEY_SIZE];      /* AES-128-CBC state key          */
+    byte macKey[TICKET_MAC_SZ];         /* HMAC-SHA256 ticket key         */
+} TicketKey;
+
+typedef struct TicketKeys {
+    TicketKey    keys[MAX_TICKET_KEYS]; /* keys[0] issues, all decrypt    */
+    word16       count;                 /* keys in use, 0 is tickets off  */
+    CyaSSL_Mutex mutex;                 /* rotation vs. handshake lookups */
+} TicketKeys;
+
+#ifndef NO_CYASSL_SERVER
+CYASSL_LOCAL int  CreateTicket(CYASSL* ssl, byte* ticket);
+CYASSL_LOCAL int  SendTicket(CYASSL* ssl);
+#endif
+
+#endif /* HAVE_SESSION_TICKET */
+
 #endif /* HAVE_TLS_EXTENSIONS */
 
+/* record sized io buffers connections borrow while data is in flight */
+typedef struct BufferPool {
+    byte*        head;                  /* free list, next ptr in buffer  */
+    word32       maxFree;               /* free buffers to keep, 0 is off */
+    word32       freeCount;             /* buffers on the free list       */
+    word32       inUse;                 /* buffers lent out               */
+    word32       highWater;             /* most ever lent out at once     */
+    CyaSSL_Mutex mutex;                 /* connections share the pool     */
+} BufferPool;
+
+
+/* ctx rng that seeds each connection's rng, one OS read per CTX_RNG_RESEED
+   connections instead of one per connection */
+typedef struct CtxRng {
+    RNG          rng;
+    word32       draws;                 /* ssl seeds since OS reseed      */
+    long         pid;                   /* seeding process, fork check    */
+    byte         ready;                 /* OS seed worked, else per ssl   */
+    CyaSSL_Mutex mutex;                 /* connections share the rng      */
+} CtxRng;
+
+
 /* CyaSSL context type */
 struct CYASSL_CTX {
     CYASSL_METHOD* method;
@@ -1187,6 +1340,12 @@ struct CYASSL_CTX {
     buffer      serverDH_P;
     buffer      serverDH_G;
     CYASSL_CERT_MANAGER* cm;      /* our cert manager, ctx owns SSL will use */
+#ifndef NO_RSA
+    RsaKey*     rsaKey;           /* privateKey decoded, shared read only */
+#endif
+#ifdef HAVE_ECC
+    ecc_key*    eccKey;           /* privateKey decoded, shared read only */
+#endif
 #endif
     Suites      suites;
     void*       heap;             /* for user memory overrides */
@@ -1204,6 +1363,7 @@ struct CYASSL_CTX {
     byte        partialWrite;     /* only one msg per write call */
     byte        quietShutdown;    /* don't send close notify */
     byte        groupMessages;    /* group handshake messages before sending */
+    byte        readAhead;        /* fill input buffer past current record */
     CallbackIORecv CBIORecv;
     CallbackIOSend CBIOSend;
 #ifdef CYASSL_DTLS
@@ -1233,6 +1393,11 @@ struct CYASSL_CTX {
 #ifdef HAVE_TLS_EXTENSIONS
     TLSX* extensions;                  /* RFC 6066 TLS Extensions data */
 #endif
+#ifdef HAVE_SESSION_TICKET
+    TicketKeys       ticketKeys;       /* RFC 5077 ticket protection keys */
+#endif
+    BufferPool       bufferPool;       /* io buffers lent to connections */
+    CtxRng           rng;              /* seeds connection rngs */
 #ifdef ATOMIC_USER
     CallbackMacEncrypt    MacEncryptCb;    /* Atomic User Mac/Encrypt Cb */
     CallbackDecryptVerify DecryptVerifyCb; /* Atomic User Decrypt/Verify Cb */
@@ -1269,6 +1434,8 @@ int ProcessOldClientHello(CYASSL* ssl, const byte* input, word32* inOutIdx,
     int AddCA(CYASSL_CERT_MANAGER* ctx, buffer der, int type, int verify);
     CYASSL_LOCAL
     int AlreadySigner(CYASSL_CERT_MANAGER* cm, byte* hash);
+    CYASSL_LOCAL
+    void FreeCtxKeys(CYASSL_CTX* ctx);
 #endif
 
 /* All cipher suite related info */
@@ -1415,6 +1582,10 @@ typedef struct Ciphers {
 #endif
 #ifdef BUILD_RABBIT
     Rabbit* rabbit;
+#endif
+    Hmac*   hmac;        /* TLS record MAC, keyed once per key change */
+#if !defined(NO_OLD_TLS) && defined(HMAC_PAD_STATES)
+    Hash*   sslMac;      /* SSLv3 MAC secret + pad1, secret + pad2 hashed */
 #endif
     byte    setup;       /* have we set it up flag for detection */
 } Ciphers;
@@ -1422,6 +1593,7 @@ typedef struct Ciphers {
 
 CYASSL_LOCAL void InitCiphers(CYASSL* ssl);
 CYASSL_LOCAL void FreeCiphers(CYASSL* ssl);
+CYASSL_LOCAL int  SetRecordMacs(CYASSL* ssl);
 
 
 /* hashes type */
@@ -1439,6 +1611,44 @@ typedef struct Hashes {
 } Hashes;
 
 
+/* handshake transcript hashes */
+enum HsHashType {
+    HS_HASH_MD5    = 0x01,
+    HS_HASH_SHA    = 0x02,
+    HS_HASH_SHA256 = 0x04,
+    HS_HASH_SHA384 = 0x08,
+
+    HS_HASH_BUFFER_SZ = 512    /* starting size for msgs held until picked */
+};
+
+
+/* Handshake transcript, messages are held in buffer until the version and
+   suite, set by SetCipherSpecs, say which hashes are needed. Only those are
+   run, the buffer is replayed into them on first use */
+typedef struct HsHashes {
+#ifndef NO_OLD_TLS
+#ifndef NO_SHA
+    Sha             hashSha;            /* sha hash of handshake msgs */
+#endif
+#ifndef NO_MD5
+    Md5             hashMd5;            /* md5 hash of handshake msgs */
+#endif
+#endif
+#ifndef NO_SHA256
+    Sha256          hashSha256;         /* sha256 hash of handshake msgs */
+#endif
+#ifdef CYASSL_SHA384
+    Sha384          hashSha384;         /* sha384 hash of handshake msgs */
+#endif
+    byte*           buffer;             /* msgs before hashes are picked */
+    word32          length;             /* buffer used */
+    word32          bufferSz;           /* buffer allocated */
+    byte            use;                /* HS_HASH_ types needed */
+    byte            running;            /* HS_HASH_ types started, 0 while
+                                           buffering */
+} HsHashes;
+
+
 /* Static x509 buffer */
 typedef struct x509_buffer {
     int  length;                  /* actual size */
@@ -1511,6 +1721,7 @@ enum AcceptState {
     CERT_REQ_SENT,
     SERVER_HELLO_DONE,
     ACCEPT_SECOND_REPLY_DONE,
+    TICKET_SENT,
     CHANGE_CIPHER_SENT,
     ACCEPT_FINISHED_DONE,
     ACCEPT_THIRD_REPLY_DONE
@@ -1536,6 +1747,7 @@ typedef struct Buffers {
                                               when got WANT_WRITE            */
     int             plainSz;               /* plain text bytes in buffer to send
                                               when got WANT_WRITE            */
+    int             reservedSz;            /* zero copy write room handed out */
     byte            weOwnCert;             /* SSL own cert flag */
     byte            weOwnKey;              /* SSL own key  flag */
     byte            weOwnDH;               /* SSL own dh (p,g)  flag */
@@ -1592,9 +1804,14 @@ typedef struct Options {
     byte            quietShutdown;      /* don't send close notify */
     byte            certOnly;           /* stop once we get cert */
     byte            groupMessages;      /* group handshake messages */
+    byte            readAhead;          /* read past the current record */
     byte            usingNonblock;      /* set when using nonblocking socket */
     byte            saveArrays;         /* save array Memory for user get keys
                                            or psk */
+#ifdef HAVE_SESSION_TICKET
+    byte            createTicket;       /* server to send NewSessionTicket */
+    byte            useTicket;          /* resuming from client's ticket */
+#endif
 #ifndef NO_PSK
     byte            havePSK;            /* psk key set by user */
     psk_client_callback client_psk_cb;
@@ -1745,21 +1962,10 @@ struct CYASSL {
     CYASSL_BIO*     biowr;              /* socket bio write to free/close */
     void*           IOCB_ReadCtx;
     void*           IOCB_WriteCtx;
+    word32          recvCalls;          /* CBIORecv calls, for stats */
+    word32          sendCalls;          /* CBIOSend calls, for stats */
     RNG*            rng;
-#ifndef NO_OLD_TLS
-#ifndef NO_SHA
-    Sha             hashSha;            /* sha hash of handshake msgs */
-#endif
-#ifndef NO_MD5
-    Md5             hashMd5;            /* md5 hash of handshake msgs */
-#endif
-#endif
-#ifndef NO_SHA256
-    Sha256          hashSha256;         /* sha256 hash of handshake msgs */
-#endif
-#ifdef CYASSL_SHA384
-    Sha384          hashSha384;         /* sha384 hash of handshake msgs */
-#endif
+    HsHashes*       hsHashes;           /* handshake msgs transcript */
     Hashes          verifyHashes;
     Hashes          certHashes;         /* for cert verify */
     Buffers         buffers;
@@ -1967,11 +2173,15 @@ static const byte tls_server[FINISHED_LABEL_SZ + 1] = "server finished";
 /* internal functions */
 CYASSL_LOCAL int SendChangeCipher(CYASSL*);
 CYASSL_LOCAL int SendData(CYASSL*, const void*, int);
+CYASSL_LOCAL int ReserveData(CYASSL*, byte**);
+CYASSL_LOCAL int CommitData(CYASSL*, int);
 CYASSL_LOCAL int SendCertificate(CYASSL*);
 CYASSL_LOCAL int SendCertificateRequest(CYASSL*);
 CYASSL_LOCAL int SendServerKeyExchange(CYASSL*);
 CYASSL_LOCAL int SendBuffered(CYASSL*);
 CYASSL_LOCAL int ReceiveData(CYASSL*, byte*, int, int);
+CYASSL_LOCAL int ReceiveDataZc(CYASSL*, const byte**);
+CYASSL_LOCAL void ConsumeData(CYASSL*, int);
 CYASSL_LOCAL int SendFinished(CYASSL*);
 CYASSL_LOCAL int SendAlert(CYASSL*, int, int);
 CYASSL_LOCAL int ProcessReply(CYASSL*);
@@ -1985,19 +2195,30 @@ CYASSL_LOCAL int  StoreKeys(CYASSL* ssl, const byte* keyData);
 
 CYASSL_LOCAL int IsTLS(const CYASSL* ssl);
 CYASSL_LOCAL int IsAtLeastTLSv1_2(const CYASSL* ssl);
+CYASSL_LOCAL int ConstantCompare(const byte* a, const byte* b, int length);
 
 CYASSL_LOCAL void FreeHandshakeResources(CYASSL* ssl);
 CYASSL_LOCAL void ShrinkInputBuffer(CYASSL* ssl, int forcedFree);
 CYASSL_LOCAL void ShrinkOutputBuffer(CYASSL* ssl);
+CYASSL_LOCAL void TrimBufferPool(BufferPool* pool, void* heap);
 #ifndef NO_CERTS
     CYASSL_LOCAL Signer* GetCA(void* cm, byte* hash);
     #ifndef NO_SKID
         CYASSL_LOCAL Signer* GetCAByName(void* cm, byte* hash);
     #endif
+    #ifndef NO_CERT_VERIFY_CACHE
+        CYASSL_LOCAL int  CertVerifyCacheFind(void* cm, const byte* der,
+                                    word32 derSz, const Signer* ca, byte* key);
+        CYASSL_LOCAL void CertVerifyCacheAdd(void* cm, const byte* key);
+    #endif
 #endif
 CYASSL_LOCAL void BuildTlsFinished(CYASSL* ssl, Hashes* hashes,
                                    const byte* sender);
 CYASSL_LOCAL void FreeArrays(CYASSL* ssl, int keep);
+CYASSL_LOCAL void InitHandshakeHashes(CYASSL* ssl);
+CYASSL_LOCAL void PickHandshakeHashes(CYASSL* ssl);
+CYASSL_LOCAL void StartHandshakeHashes(CYASSL* ssl);
+CYASSL_LOCAL void FreeHandshakeHashes(CYASSL* ssl);
 CYASSL_LOCAL  int CheckAvailableSize(CYASSL *ssl, int size);
 CYASSL_LOCAL  int GrowInputBuffer(CYASSL* ssl, int size, int usedLength);
 
@@ -2005,6 +2226,14 @@ CYASSL_LOCAL  int GrowInputBuffer(CYASSL* ssl, int size, int usedLength);
     CYASSL_LOCAL int  MakeTlsMasterSecret(CYASSL*);
     CYASSL_LOCAL void TLS_hmac(CYASSL* ssl, byte* digest, const byte* in,
                                word32 sz, int content, int verify);
+    #ifdef BUILD_AES_CBC_HMAC
+        CYASSL_LOCAL int TLS_hmacAesCbcEncrypt(CYASSL* ssl, byte* digest,
+                                    const byte* in, word32 sz, int content,
+                                    byte* enc, word32 encSz);
+        CYASSL_LOCAL int TLS_hmacAesCbcDecrypt(CYASSL* ssl, byte* digest,
+                                    const byte* in, word32 sz, int content,
+                                    byte* dec, word32 decSz);
+    #endif
 #endif
 
 #ifndef NO_CYASSL_CLIENT
@@ -342,6 +342,9 @@ typedef CYASSL_X509_STORE_CTX X509_STORE_CTX;
 #define SSL_CTX_set_mode CyaSSL_CTX_set_mode
 #define SSL_CTX_get_mode CyaSSL_CTX_get_mode
 #define SSL_CTX_set_default_read_ahead CyaSSL_CTX_set_default_read_ahead
+#define SSL_CTX_set_read_ahead CyaSSL_CTX_set_read_ahead
+#define SSL_set_read_ahead CyaSSL_set_read_ahead
+#define SSL_get_read_ahead CyaSSL_get_read_ahead
 
 #define SSL_CTX_sess_set_cache_size CyaSSL_CTX_sess_set_cache_size
 #define SSL_CTX_set_default_verify_paths CyaSSL_CTX_set_default_verify_paths
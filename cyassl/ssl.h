@@ -232,8 +232,14 @@ CYASSL_API int  CyaSSL_get_using_nonblock(CYASSL*);
 CYASSL_API int  CyaSSL_connect(CYASSL*);     /* please see note at top of README
                                              if you get an error from connect */
 CYASSL_API int  CyaSSL_write(CYASSL*, const void*, int);
+/* zero copy write, fill reserved room in CyaSSL then commit it */
+CYASSL_API int  CyaSSL_write_zc_reserve(CYASSL*, unsigned char** data);
+CYASSL_API int  CyaSSL_write_zc_commit(CYASSL*, int sz);
 CYASSL_API int  CyaSSL_read(CYASSL*, void*, int);
 CYASSL_API int  CyaSSL_peek(CYASSL*, void*, int);
+/* zero copy read, data points into CyaSSL until released */
+CYASSL_API int  CyaSSL_read_zc(CYASSL*, const unsigned char** data);
+CYASSL_API int  CyaSSL_read_zc_release(CYASSL*, int sz);
 CYASSL_API int  CyaSSL_accept(CYASSL*);
 CYASSL_API void CyaSSL_CTX_free(CYASSL_CTX*);
 CYASSL_API void CyaSSL_free(CYASSL*);
@@ -903,6 +909,21 @@ CYASSL_API int CyaSSL_make_eap_keys(CYASSL*, void* key, unsigned int len,
 CYASSL_API int CyaSSL_CTX_set_group_messages(CYASSL_CTX*);
 CYASSL_API int CyaSSL_set_group_messages(CYASSL*);
 
+/* read ahead, records already buffered are not visible to select() */
+CYASSL_API int CyaSSL_CTX_set_read_ahead(CYASSL_CTX*, int);
+CYASSL_API int CyaSSL_set_read_ahead(CYASSL*, int);
+CYASSL_API int CyaSSL_get_read_ahead(CYASSL*);
+CYASSL_API int CyaSSL_get_io_calls(CYASSL*, unsigned int* recvCalls,
+                                   unsigned int* sendCalls);
+
+/* io buffer pool, connections borrow record buffers only while busy */
+CYASSL_API int CyaSSL_CTX_set_buffer_pool(CYASSL_CTX*, int maxFree);
+CYASSL_API int CyaSSL_CTX_get_buffer_pool_stats(CYASSL_CTX*,
+                                                unsigned int* inUse,
+                                                unsigned int* freeCount,
+                                                unsigned int* highWater);
+CYASSL_API int CyaSSL_release_buffers(CYASSL*);
+
 /* I/O callbacks */
 typedef int (*CallbackIORecv)(CYASSL *ssl, char *buf, int sz, void *ctx);
 typedef int (*CallbackIOSend)(CYASSL *ssl, char *buf, int sz, void *ctx);
@@ -1111,8 +1132,16 @@ CYASSL_API void* CyaSSL_GetRsaDecCtx(CYASSL* ssl);
     CYASSL_API int CyaSSL_CertManagerDisableCRL(CYASSL_CERT_MANAGER*);
     CYASSL_API int CyaSSL_CertManagerLoadCRL(CYASSL_CERT_MANAGER*, const char*,
                                                                       int, int);
+    CYASSL_API int CyaSSL_CertManagerLoadCRLBuffer(CYASSL_CERT_MANAGER*,
+                                       const unsigned char*, long sz, int type);
+    CYASSL_API int CyaSSL_CertManagerCompileCRL(CYASSL_CERT_MANAGER*,
+                                 const char* in, int type, const char* out);
+    CYASSL_API int CyaSSL_CertManagerLoadCRLIndex(CYASSL_CERT_MANAGER*,
+                                                             const char* file);
     CYASSL_API int CyaSSL_CertManagerSetCRL_Cb(CYASSL_CERT_MANAGER*,
                                                                   CbMissingCRL);
+    CYASSL_API int CyaSSL_CertManagerGetVerifyCacheStats(CYASSL_CERT_MANAGER*,
+                                   unsigned long* hits, unsigned long* misses);
 
     CYASSL_API int CyaSSL_EnableCRL(CYASSL* ssl, int options);
     CYASSL_API int CyaSSL_DisableCRL(CYASSL* ssl);
@@ -1205,6 +1234,20 @@ CYASSL_API int CyaSSL_CTX_UseTruncatedHMAC(CYASSL_CTX* ctx);
 #endif /* NO_CYASSL_CLIENT */
 #endif /* HAVE_TRUNCATED_HMAC */
 
+/* Session Tickets */
+#ifdef HAVE_SESSION_TICKET
+#ifndef NO_CYASSL_SERVER
+
+/* key name (16) | AES-128 key (16) | HMAC-SHA256 key (32) */
+#define CYASSL_TICKET_KEY_SZ 64
+
+CYASSL_API int CyaSSL_CTX_UseSessionTicket(CYASSL_CTX* ctx);
+CYASSL_API int CyaSSL_CTX_AddSessionTicketKey(CYASSL_CTX* ctx,
+                                 const unsigned char* key, unsigned int keySz);
+
+#endif /* NO_CYASSL_SERVER */
+#endif /* HAVE_SESSION_TICKET */
+
 
 #define CYASSL_CRL_MONITOR   0x01   /* monitor this dir flag */
 #define CYASSL_CRL_START_MON 0x02   /* start monitoring flag */
@@ -1229,6 +1272,7 @@ CYASSL_API int CyaSSL_accept_ex(CYASSL*, HandShakeCallBack, TimeoutCallBack,
 
 CYASSL_API int  CyaSSL_CTX_OCSP_set_options(CYASSL_CTX*, int);
 CYASSL_API int  CyaSSL_CTX_OCSP_set_override_url(CYASSL_CTX*, const char*);
+CYASSL_API int  CyaSSL_CTX_OCSP_set_cache_size(CYASSL_CTX*, int);
 
 /* OCSP Options */
 #define CYASSL_OCSP_ENABLE       0x0001 /* Enable OCSP lookups */
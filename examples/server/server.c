@@ -123,6 +123,9 @@ static void Usage(void)
     printf("-f          Fewer packets/group messages\n");
     printf("-N          Use Non-blocking sockets\n");
     printf("-S <str>    Use Host Name Indication\n");
+#ifdef HAVE_SESSION_TICKET
+    printf("-T          Issue and accept Session Tickets\n");
+#endif
 #ifdef HAVE_OCSP
     printf("-o          Perform OCSP lookup on peer certificate\n");
     printf("-O <url>    Perform OCSP lookup using <url> as responder\n");
@@ -172,6 +175,10 @@ THREAD_RETURN CYASSL_THREAD server_test(void* args)
     char*  sniHostName = NULL;
 #endif
 
+#ifdef HAVE_SESSION_TICKET
+    int    useTicket = 0;
+#endif
+
 #ifdef HAVE_OCSP
     int    useOcsp  = 0;
     char*  ocspUrl  = NULL;
@@ -187,7 +194,7 @@ THREAD_RETURN CYASSL_THREAD server_test(void* args)
     (void)trackMemory;
     (void)pkCallbacks;
 
-    while ((ch = mygetopt(argc, argv, "?dbstnNufPp:v:l:A:c:k:S:oO:")) != -1) {
+    while ((ch = mygetopt(argc, argv, "?dbstnNufPTp:v:l:A:c:k:S:oO:")) != -1) {
         switch (ch) {
             case '?' :
                 Usage();
@@ -271,6 +278,12 @@ THREAD_RETURN CYASSL_THREAD server_test(void* args)
                 #endif
                 break;
 
+            case 'T' :
+                #ifdef HAVE_SESSION_TICKET
+                    useTicket = 1;
+                #endif
+                break;
+
             case 'o' :
                 #ifdef HAVE_OCSP
                     useOcsp = 1;
@@ -447,6 +460,12 @@ THREAD_RETURN CYASSL_THREAD server_test(void* args)
             err_sys("UseSNI failed");
 #endif
 
+#ifdef HAVE_SESSION_TICKET
+    if (useTicket)
+        if (CyaSSL_CTX_UseSessionTicket(ctx) != 0)
+            err_sys("UseSessionTicket failed");
+#endif
+
     ssl = SSL_new(ctx);
     if (ssl == NULL)
         err_sys("unable to get SSL");
@@ -32,7 +32,33 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+
+
+/* CRL index, a parsed and verified CRL written by CompileCRL for
+   LoadCRL_Index to map instead of parse; it carries no signature so it is
+   only loaded when the caller names it, never found by a directory scan,
+   and should live where only the compiler can write; a named index is
+   remembered and mapped again whenever the monitor reloads:
+       magic, issuer hash, last and next date, their formats, record size,
+       record count (big endian) then the sorted serial records */
+#define CRL_INDEX_MAGIC "CyaCRLx1"
+#define CRL_INDEX_EXT   ".crlx"
+
+enum {
+    CRL_INDEX_MAGIC_SZ = 8,
+    CRL_INDEX_HASH     = CRL_INDEX_MAGIC_SZ,
+    CRL_INDEX_LAST     = CRL_INDEX_HASH + SHA_DIGEST_SIZE,
+    CRL_INDEX_NEXT     = CRL_INDEX_LAST + MAX_DATE_SIZE,
+    CRL_INDEX_FORMATS  = CRL_INDEX_NEXT + MAX_DATE_SIZE,
+    CRL_INDEX_COUNT    = CRL_INDEX_FORMATS + 4,
+    CRL_INDEX_HDR_SZ   = 128             /* records start here */
+};
 
 
 /* Initialze CRL members */
@@ -41,9 +67,10 @@ int InitCRL(CYASSL_CRL* crl, CYASSL_CERT_MANAGER* cm)
     CYASSL_ENTER("InitCRL");
 
     crl->cm = cm;
-    crl->crlList = NULL;
+    crl->store = NULL;
     crl->monitors[0].path = NULL;
     crl->monitors[1].path = NULL;
+    crl->indexes = NULL;
 #ifdef HAVE_CRL_MONITOR
     crl->tid = 0;
 #endif
@@ -54,9 +81,34 @@ int InitCRL(CYASSL_CRL* crl, CYASSL_CERT_MANAGER* cm)
 }
 
 
-/* Initialze CRL Entry */
+/* serial record for sorting and searching, a DER serial may carry leading
+   zeros a decoded cert serial doesn't, so drop them */
+static void SetSerialRecord(byte* rec, const byte* serial, int sz)
+{
+    while (sz > 0 && serial[0] == 0) {
+        serial++;
+        sz--;
+    }
+    if (sz > EXTERNAL_SERIAL_SIZE)
+        sz = EXTERNAL_SERIAL_SIZE;
+
+    rec[0] = (byte)sz;
+    XMEMCPY(rec + 1, serial, sz);
+    XMEMSET(rec + 1 + sz, 0, CRL_SERIAL_SZ - 1 - sz);
+}
+
+
+static int CompareSerial(const void* a, const void* b)
+{
+    return XMEMCMP(a, b, CRL_SERIAL_SZ);
+}
+
+
+/* Initialze CRL Entry, the revoked list becomes a sorted serial array */
 static int InitCRL_Entry(CRL_Entry* crle, DecodedCRL* dcrl)
 {
+    RevokedCert* rc;
+
     CYASSL_ENTER("InitCRL_Entry");
 
     XMEMCPY(crle->issuerHash, dcrl->issuerHash, SHA_DIGEST_SIZE);
@@ -67,9 +119,27 @@ static int InitCRL_Entry(CRL_Entry* crle, DecodedCRL* dcrl)
     crle->lastDateFormat = dcrl->lastDateFormat;
     crle->nextDateFormat = dcrl->nextDateFormat;
 
-    crle->certs = dcrl->certs;   /* take ownsership */
-    dcrl->certs = NULL;
-    crle->totalCerts = dcrl->totalCerts;
+    crle->serials    = NULL;
+    crle->totalCerts = 0;
+    crle->refs       = 0;
+    crle->map        = NULL;
+    crle->mapSz      = 0;
+
+    if (dcrl->totalCerts <= 0)
+        return 0;
+
+    crle->serials = (byte*)XMALLOC(dcrl->totalCerts * CRL_SERIAL_SZ, NULL,
+                                   DYNAMIC_TYPE_REVOKED);
+    if (crle->serials == NULL)
+        return MEMORY_E;
+
+    for (rc = dcrl->certs; rc && crle->totalCerts < dcrl->totalCerts;
+                                                              rc = rc->next) {
+        SetSerialRecord(crle->serials + crle->totalCerts * CRL_SERIAL_SZ,
+                        rc->serialNumber, rc->serialSz);
+        crle->totalCerts++;
+    }
+    qsort(crle->serials, crle->totalCerts, CRL_SERIAL_SZ, CompareSerial);
 
     return 0;
 }
@@ -78,24 +148,132 @@ static int InitCRL_Entry(CRL_Entry* crle, DecodedCRL* dcrl)
 /* Free all CRL Entry resources */
 static void FreeCRL_Entry(CRL_Entry* crle)
 {
-    RevokedCert* tmp = crle->certs; 
-
     CYASSL_ENTER("FreeCRL_Entry");
 
-    while(tmp) {
-        RevokedCert* next = tmp->next;
-        XFREE(tmp, NULL, DYNAMIC_TYPE_REVOKED);
-        tmp = next;
+    if (crle->map)
+        munmap(crle->map, (size_t)crle->mapSz);
+    else if (crle->serials)
+        XFREE(crle->serials, NULL, DYNAMIC_TYPE_REVOKED);
+    crle->serials = NULL;
+    crle->map     = NULL;
+}
+
+
+/* 1 if the serial record is on crle's sorted list */
+static int FindSerial(const CRL_Entry* crle, const byte* rec)
+{
+    int lo = 0;
+    int hi = crle->totalCerts - 1;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = XMEMCMP(crle->serials + mid * CRL_SERIAL_SZ, rec,
+                          CRL_SERIAL_SZ);
+        if (cmp == 0)
+            return 1;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
     }
+
+    return 0;
 }
 
 
+/* issuer hash is already a SHA-1, its first bytes index well enough */
+static INLINE word32 IssuerSlot(const byte* hash, word32 tableSz)
+{
+    return (((word32)hash[0] << 24) | ((word32)hash[1] << 16) |
+            ((word32)hash[2] <<  8) |  (word32)hash[3]) & (tableSz - 1);
+}
+
+
+/* new empty store with a table for count entries, one reference */
+static CRL_Store* NewStore(word32 count)
+{
+    CRL_Store* store;
+    word32     tableSz = 4;
+
+    while (tableSz < count * 2)
+        tableSz <<= 1;
+
+    store = (CRL_Store*)XMALLOC(sizeof(CRL_Store) +
+                          tableSz * sizeof(CRL_Entry*), NULL, DYNAMIC_TYPE_CRL);
+    if (store == NULL)
+        return NULL;
+
+    store->table   = (CRL_Entry**)(store + 1);
+    store->tableSz = tableSz;
+    store->count   = 0;
+    store->refs    = 1;
+    XMEMSET(store->table, 0, tableSz * sizeof(CRL_Entry*));
+
+    return store;
+}
+
+
+/* CRL Entry for issuer hash, NULL if none */
+static CRL_Entry* FindCRL_Entry(CRL_Store* store, const byte* hash)
+{
+    word32 i;
+
+    if (store == NULL)
+        return NULL;
+
+    i = IssuerSlot(hash, store->tableSz);
+    while (store->table[i]) {
+        if (XMEMCMP(store->table[i]->issuerHash, hash, SHA_DIGEST_SIZE) == 0)
+            return store->table[i];
+        i = (i + 1) & (store->tableSz - 1);
+    }
+
+    return NULL;
+}
+
+
+/* put crle in a store under construction, the first entry for an issuer
+   stays so add the newest first */
+static void StoreCRL_Entry(CRL_Store* store, CRL_Entry* crle)
+{
+    word32 i = IssuerSlot(crle->issuerHash, store->tableSz);
+
+    while (store->table[i]) {
+        if (XMEMCMP(store->table[i]->issuerHash, crle->issuerHash,
+                                                       SHA_DIGEST_SIZE) == 0)
+            return;
+        i = (i + 1) & (store->tableSz - 1);
+    }
+    store->table[i] = crle;
+    store->count++;
+    crle->refs++;
+}
+
+
+/* drop a store reference, the last frees it and the entries no other store
+   holds; caller holds crlLock or the only reference */
+static void ReleaseStore(CRL_Store* store)
+{
+    word32 i;
+
+    if (store == NULL || --store->refs > 0)
+        return;
+
+    for (i = 0; i < store->tableSz; i++) {
+        CRL_Entry* crle = store->table[i];
+
+        if (crle && --crle->refs == 0) {
+            FreeCRL_Entry(crle);
+            XFREE(crle, NULL, DYNAMIC_TYPE_CRL_ENTRY);
+        }
+    }
+    XFREE(store, NULL, DYNAMIC_TYPE_CRL);
+}
+
 
 /* Free all CRL resources */
 void FreeCRL(CYASSL_CRL* crl, int dynamic)
 {
-    CRL_Entry* tmp = crl->crlList;
-
     CYASSL_ENTER("FreeCRL");
 
     if (crl->monitors[0].path)
@@ -104,12 +282,16 @@ void FreeCRL(CYASSL_CRL* crl, int dynamic)
     if (crl->monitors[1].path)
         XFREE(crl->monitors[1].path, NULL, DYNAMIC_TYPE_CRL_MONITOR);
 
-    while(tmp) {
-        CRL_Entry* next = tmp->next;
-        FreeCRL_Entry(tmp);
-        XFREE(tmp, NULL, DYNAMIC_TYPE_CRL_ENTRY);
-        tmp = next;
-    }	
+    while (crl->indexes) {
+        CRL_IndexPath* next = crl->indexes->next;
+
+        XFREE(crl->indexes->path, NULL, DYNAMIC_TYPE_CRL_MONITOR);
+        XFREE(crl->indexes, NULL, DYNAMIC_TYPE_CRL_MONITOR);
+        crl->indexes = next;
+    }
+
+    ReleaseStore(crl->store);
+    crl->store = NULL;
 
 #ifdef HAVE_CRL_MONITOR
     if (crl->tid != 0) {
@@ -126,49 +308,55 @@ void FreeCRL(CYASSL_CRL* crl, int dynamic)
 /* Is the cert ok with CRL, return 0 on success */
 int CheckCertCRL(CYASSL_CRL* crl, DecodedCert* cert)
 {
+    CRL_Store* store;
     CRL_Entry* crle;
     int        foundEntry = 0;
     int        ret = 0;
 
     CYASSL_ENTER("CheckCertCRL");
 
+    /* the lock only covers taking a reference, the lookups run on a store
+       that can't change or go away under us */
     if (LockMutex(&crl->crlLock) != 0) {
         CYASSL_MSG("LockMutex failed");
         return BAD_MUTEX_E;
     }
+    store = crl->store;
+    if (store)
+        store->refs++;
+    UnLockMutex(&crl->crlLock);
 
-    crle = crl->crlList;
-
-    while (crle) {
-        if (XMEMCMP(crle->issuerHash, cert->issuerHash, SHA_DIGEST_SIZE) == 0) {
-            CYASSL_MSG("Found CRL Entry on list");
-            CYASSL_MSG("Checking next date validity");
+    crle = FindCRL_Entry(store, cert->issuerHash);
+    if (crle) {
+        CYASSL_MSG("Found CRL Entry on list");
+        CYASSL_MSG("Checking next date validity");
 
-            if (!ValidateDate(crle->nextDate, crle->nextDateFormat, AFTER)) {
-                CYASSL_MSG("CRL next date is no longer valid");
-                ret = ASN_AFTER_DATE_E;
-            }
-            else
-                foundEntry = 1;
-            break;
+        if (!ValidateDate(crle->nextDate, crle->nextDateFormat, AFTER)) {
+            CYASSL_MSG("CRL next date is no longer valid");
+            ret = ASN_AFTER_DATE_E;
         }
-        crle = crle->next;
+        else
+            foundEntry = 1;
     }
 
     if (foundEntry) {
-        RevokedCert* rc = crle->certs;
+        byte rec[CRL_SERIAL_SZ];
 
-        while (rc) {
-            if (XMEMCMP(rc->serialNumber, cert->serial, rc->serialSz) == 0) {
-                CYASSL_MSG("Cert revoked");
-                ret = CRL_CERT_REVOKED;
-                break;
-            }
-            rc = rc->next;	
+        SetSerialRecord(rec, cert->serial, cert->serialSz);
+        if (FindSerial(crle, rec)) {
+            CYASSL_MSG("Cert revoked");
+            ret = CRL_CERT_REVOKED;
         }
     }
 
-    UnLockMutex(&crl->crlLock);
+    if (store) {
+        if (LockMutex(&crl->crlLock) != 0) {
+            CYASSL_MSG("LockMutex failed");
+            return BAD_MUTEX_E;
+        }
+        ReleaseStore(store);
+        UnLockMutex(&crl->crlLock);
+    }
 
     if (foundEntry == 0) {
         CYASSL_MSG("Couldn't find CRL for status check");
@@ -194,54 +382,60 @@ int CheckCertCRL(CYASSL_CRL* crl, DecodedCert* cert)
 }
 
 
-/* Add Decoded CRL, 0 on success */
-static int AddCRL(CYASSL_CRL* crl, DecodedCRL* dcrl)
+/* Add CRL Entry, takes ownership of crle, 0 on success */
+static int AddCRL(CYASSL_CRL* crl, CRL_Entry* crle)
 {
-    CRL_Entry* crle;
+    CRL_Store* store;
+    CRL_Store* old;
+    word32     i;
 
     CYASSL_ENTER("AddCRL");
 
-    crle = (CRL_Entry*)XMALLOC(sizeof(CRL_Entry), NULL, DYNAMIC_TYPE_CRL_ENTRY);
-    if (crle == NULL) {
-        CYASSL_MSG("alloc CRL Entry failed");
-        return -1;
+    if (LockMutex(&crl->crlLock) != 0) {
+        CYASSL_MSG("LockMutex failed");
+        FreeCRL_Entry(crle);
+        XFREE(crle, NULL, DYNAMIC_TYPE_CRL_ENTRY);
+        return BAD_MUTEX_E;
     }
 
-    if (InitCRL_Entry(crle, dcrl) < 0) {
-        CYASSL_MSG("Init CRL Entry failed");
+    /* copy on write, the new entry goes in first to replace an older CRL
+       from the same issuer */
+    old   = crl->store;
+    store = NewStore(old ? old->count + 1 : 1);
+    if (store == NULL) {
+        UnLockMutex(&crl->crlLock);
+        CYASSL_MSG("alloc CRL Store failed");
+        FreeCRL_Entry(crle);
         XFREE(crle, NULL, DYNAMIC_TYPE_CRL_ENTRY);
         return -1;
     }
 
-    if (LockMutex(&crl->crlLock) != 0) {
-        CYASSL_MSG("LockMutex failed");
-        FreeCRL_Entry(crle);
-        XFREE(crle, NULL, DYNAMIC_TYPE_CRL_ENTRY);
-        return BAD_MUTEX_E;
+    StoreCRL_Entry(store, crle);
+    for (i = 0; old && i < old->tableSz; i++) {
+        if (old->table[i])
+            StoreCRL_Entry(store, old->table[i]);
     }
-    crle->next = crl->crlList;
-    crl->crlList = crle;
+    crl->store = store;
+    ReleaseStore(old);
+
     UnLockMutex(&crl->crlLock);
 
     return 0;
 }
 
 
-/* Load CRL File of type, SSL_SUCCESS on ok */
-int BufferLoadCRL(CYASSL_CRL* crl, const byte* buff, long sz, int type)
+/* Parse and verify a CRL buffer of type into crle, 0 on success */
+static int DecodeCRL_Entry(CYASSL_CERT_MANAGER* cm, CRL_Entry* crle,
+                           const byte* buff, long sz, int type)
 {
-    int          ret = SSL_SUCCESS;
+    int          ret;
     const byte*  myBuffer = buff;    /* if DER ok, otherwise switch */
     buffer       der;
     DecodedCRL   dcrl;
 
+    XMEMSET(crle, 0, sizeof(CRL_Entry));
     der.buffer = NULL;
 
-    CYASSL_ENTER("BufferLoadCRL");
-
-    if (crl == NULL || buff == NULL || sz == 0)
-        return BAD_FUNC_ARG;
-
     if (type == SSL_FILETYPE_PEM) {
         int eccKey = 0;   /* not used */
         EncryptedInfo info;
@@ -259,14 +453,14 @@ int BufferLoadCRL(CYASSL_CRL* crl, const byte* buff, long sz, int type)
     }
 
     InitDecodedCRL(&dcrl);
-    ret = ParseCRL(&dcrl, myBuffer, (word32)sz, crl->cm);
+    ret = ParseCRL(&dcrl, myBuffer, (word32)sz, cm);
     if (ret != 0) {
         CYASSL_MSG("ParseCRL error");
     }
     else {
-        ret = AddCRL(crl, &dcrl);
+        ret = InitCRL_Entry(crle, &dcrl);
         if (ret != 0) {
-            CYASSL_MSG("AddCRL error");
+            CYASSL_MSG("Init CRL Entry failed");
         }
     }
     FreeDecodedCRL(&dcrl);
@@ -274,21 +468,329 @@ int BufferLoadCRL(CYASSL_CRL* crl, const byte* buff, long sz, int type)
     if (der.buffer)
         XFREE(der.buffer, NULL, DYNAMIC_TYPE_CRL);
 
+    return ret;
+}
+
+
+/* Load CRL File of type, SSL_SUCCESS on ok */
+int BufferLoadCRL(CYASSL_CRL* crl, const byte* buff, long sz, int type)
+{
+    int        ret;
+    CRL_Entry* crle;
+
+    CYASSL_ENTER("BufferLoadCRL");
+
+    if (crl == NULL || buff == NULL || sz == 0)
+        return BAD_FUNC_ARG;
+
+    crle = (CRL_Entry*)XMALLOC(sizeof(CRL_Entry), NULL, DYNAMIC_TYPE_CRL_ENTRY);
+    if (crle == NULL) {
+        CYASSL_MSG("alloc CRL Entry failed");
+        return -1;
+    }
+
+    ret = DecodeCRL_Entry(crl->cm, crle, buff, sz, type);
+    if (ret != 0) {
+        FreeCRL_Entry(crle);
+        XFREE(crle, NULL, DYNAMIC_TYPE_CRL_ENTRY);
+    }
+    else {
+        ret = AddCRL(crl, crle);
+        if (ret != 0) {
+            CYASSL_MSG("AddCRL error");
+        }
+    }
+
     if (ret == 0)
         return SSL_SUCCESS;  /* convert */
     return ret;
 }
 
 
+/* write crle as a CRL index, through a temp name and rename so readers
+   see the old file or the whole new one, mappings of the old one stay */
+static int WriteCRL_Index(const CRL_Entry* crle, const char* file)
+{
+    byte   hdr[CRL_INDEX_HDR_SZ];
+    char   tmp[MAX_FILENAME_SZ];
+    word32 count = (word32)crle->totalCerts;
+    word32 len   = (word32)XSTRLEN(file);
+    FILE*  f;
+    int    ret = 0;
+
+    if (len + sizeof(".tmp") > sizeof(tmp))
+        return BAD_PATH_ERROR;
+    XMEMCPY(tmp, file, len);
+    XMEMCPY(tmp + len, ".tmp", sizeof(".tmp"));
+
+    XMEMSET(hdr, 0, sizeof(hdr));
+    XMEMCPY(hdr, CRL_INDEX_MAGIC, CRL_INDEX_MAGIC_SZ);
+    XMEMCPY(hdr + CRL_INDEX_HASH, crle->issuerHash, SHA_DIGEST_SIZE);
+    XMEMCPY(hdr + CRL_INDEX_LAST, crle->lastDate, MAX_DATE_SIZE);
+    XMEMCPY(hdr + CRL_INDEX_NEXT, crle->nextDate, MAX_DATE_SIZE);
+    hdr[CRL_INDEX_FORMATS]     = crle->lastDateFormat;
+    hdr[CRL_INDEX_FORMATS + 1] = crle->nextDateFormat;
+    hdr[CRL_INDEX_FORMATS + 2] = CRL_SERIAL_SZ;
+    hdr[CRL_INDEX_COUNT]       = (byte)(count >> 24);
+    hdr[CRL_INDEX_COUNT + 1]   = (byte)(count >> 16);
+    hdr[CRL_INDEX_COUNT + 2]   = (byte)(count >>  8);
+    hdr[CRL_INDEX_COUNT + 3]   = (byte) count;
+
+    f = fopen(tmp, "wb");
+    if (f == NULL) {
+        CYASSL_MSG("CRL index open failed");
+        return BAD_PATH_ERROR;
+    }
+    if (fwrite(hdr, sizeof(hdr), 1, f) != 1)
+        ret = SSL_BAD_FILE;
+    if (ret == 0 && count > 0 &&
+                    fwrite(crle->serials, CRL_SERIAL_SZ, count, f) != count)
+        ret = SSL_BAD_FILE;
+    if (fclose(f) != 0)
+        ret = SSL_BAD_FILE;
+
+    if (ret == 0 && rename(tmp, file) != 0)
+        ret = SSL_BAD_FILE;
+    if (ret != 0) {
+        CYASSL_MSG("CRL index write failed");
+        remove(tmp);
+    }
+
+    return ret;
+}
+
+
+/* Parse and verify CRL file in of type and write it as CRL index out,
+   SSL_SUCCESS on ok */
+int CompileCRL(CYASSL_CERT_MANAGER* cm, const char* in, int type,
+               const char* out)
+{
+    CRL_Entry crle;
+    byte*     buff;
+    long      sz;
+    FILE*     f;
+    int       ret;
+
+    CYASSL_ENTER("CompileCRL");
+
+    if (cm == NULL || in == NULL || out == NULL)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(&crle, 0, sizeof(crle));
+    f = fopen(in, "rb");
+    if (f == NULL)
+        return SSL_BAD_FILE;
+    fseek(f, 0, SEEK_END);
+    sz = ftell(f);
+    rewind(f);
+    if (sz <= 0) {
+        fclose(f);
+        return SSL_BAD_FILE;
+    }
+
+    buff = (byte*)XMALLOC(sz, NULL, DYNAMIC_TYPE_FILE);
+    if (buff == NULL) {
+        fclose(f);
+        return MEMORY_E;
+    }
+    ret = (fread(buff, sz, 1, f) == 1) ? 0 : SSL_BAD_FILE;
+    fclose(f);
+
+    if (ret == 0)
+        ret = DecodeCRL_Entry(cm, &crle, buff, sz, type);
+    XFREE(buff, NULL, DYNAMIC_TYPE_FILE);
+
+    if (ret == 0)
+        ret = WriteCRL_Index(&crle, out);
+    FreeCRL_Entry(&crle);
+
+    if (ret == 0)
+        return SSL_SUCCESS;  /* convert */
+    return ret;
+}
+
+
+/* FindSerial binary searches the records in place, so each must be a record
+   SetSerialRecord could have made and they must be strictly ascending,
+   0 if so */
+static int CheckSerialRecords(const byte* rec, word32 count)
+{
+    word32 i;
+
+    for (i = 0; i < count; i++, rec += CRL_SERIAL_SZ) {
+        if (rec[0] > EXTERNAL_SERIAL_SIZE)
+            return -1;
+        if (i > 0 && XMEMCMP(rec - CRL_SERIAL_SZ, rec, CRL_SERIAL_SZ) >= 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+/* map CRL index file into crle, the serials are searched in place */
+static int MapCRL_Index(CRL_Entry* crle, const char* file)
+{
+    struct stat s;
+    byte*       map;
+    word32      count;
+    int         fd;
+
+    XMEMSET(crle, 0, sizeof(CRL_Entry));
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return BAD_PATH_ERROR;
+    if (fstat(fd, &s) != 0 || s.st_size < CRL_INDEX_HDR_SZ) {
+        close(fd);
+        return SSL_BAD_FILE;
+    }
+    map = (byte*)mmap(NULL, (size_t)s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == (byte*)MAP_FAILED)
+        return SSL_BAD_FILE;
+
+    count = ((word32)map[CRL_INDEX_COUNT]     << 24) |
+            ((word32)map[CRL_INDEX_COUNT + 1] << 16) |
+            ((word32)map[CRL_INDEX_COUNT + 2] <<  8) |
+             (word32)map[CRL_INDEX_COUNT + 3];
+
+    if (XMEMCMP(map, CRL_INDEX_MAGIC, CRL_INDEX_MAGIC_SZ) != 0 ||
+            map[CRL_INDEX_FORMATS + 2] != CRL_SERIAL_SZ ||
+            count > (word32)(s.st_size - CRL_INDEX_HDR_SZ) / CRL_SERIAL_SZ ||
+            CheckSerialRecords(map + CRL_INDEX_HDR_SZ, count) != 0) {
+        CYASSL_MSG("Not a CRL index");
+        munmap(map, (size_t)s.st_size);
+        return SSL_BAD_FILE;
+    }
+
+    XMEMCPY(crle->issuerHash, map + CRL_INDEX_HASH, SHA_DIGEST_SIZE);
+    XMEMCPY(crle->lastDate, map + CRL_INDEX_LAST, MAX_DATE_SIZE);
+    XMEMCPY(crle->nextDate, map + CRL_INDEX_NEXT, MAX_DATE_SIZE);
+    crle->lastDateFormat = map[CRL_INDEX_FORMATS];
+    crle->nextDateFormat = map[CRL_INDEX_FORMATS + 1];
+    crle->serials        = map + CRL_INDEX_HDR_SZ;
+    crle->totalCerts     = (int)count;
+    crle->map            = map;
+    crle->mapSz          = (long)s.st_size;
+
+    return 0;
+}
+
+
+/* map CRL index file and add it to crl, 0 on success */
+static int AddCRL_Index(CYASSL_CRL* crl, const char* file)
+{
+    int        ret;
+    CRL_Entry* crle;
+
+    crle = (CRL_Entry*)XMALLOC(sizeof(CRL_Entry), NULL, DYNAMIC_TYPE_CRL_ENTRY);
+    if (crle == NULL) {
+        CYASSL_MSG("alloc CRL Entry failed");
+        return -1;
+    }
+
+    ret = MapCRL_Index(crle, file);
+    if (ret != 0) {
+        XFREE(crle, NULL, DYNAMIC_TYPE_CRL_ENTRY);
+        return ret;
+    }
+
+    return AddCRL(crl, crle);
+}
+
+
+/* remember a named CRL index for monitor reloads, once, 0 on success */
+static int KeepCRL_IndexPath(CYASSL_CRL* crl, const char* file)
+{
+    CRL_IndexPath** last;
+    CRL_IndexPath*  idx;
+    word32          len = (word32)XSTRLEN(file) + 1;
+
+    if (LockMutex(&crl->crlLock) != 0)
+        return BAD_MUTEX_E;
+
+    for (last = &crl->indexes; *last; last = &(*last)->next) {
+        if (XSTRNCMP((*last)->path, file, len) == 0) {
+            UnLockMutex(&crl->crlLock);
+            return 0;
+        }
+    }
+
+    idx = (CRL_IndexPath*)XMALLOC(sizeof(CRL_IndexPath), NULL,
+                                  DYNAMIC_TYPE_CRL_MONITOR);
+    if (idx == NULL) {
+        UnLockMutex(&crl->crlLock);
+        return MEMORY_E;
+    }
+    idx->path = (char*)XMALLOC(len, NULL, DYNAMIC_TYPE_CRL_MONITOR);
+    if (idx->path == NULL) {
+        XFREE(idx, NULL, DYNAMIC_TYPE_CRL_MONITOR);
+        UnLockMutex(&crl->crlLock);
+        return MEMORY_E;
+    }
+    XMEMCPY(idx->path, file, len);
+    idx->next = NULL;
+    *last = idx;
+
+    UnLockMutex(&crl->crlLock);
+
+    return 0;
+}
+
+
+/* Load CRL index file, SSL_SUCCESS on ok */
+int LoadCRL_Index(CYASSL_CRL* crl, const char* file)
+{
+    int ret;
+
+    CYASSL_ENTER("LoadCRL_Index");
+
+    if (crl == NULL || file == NULL)
+        return BAD_FUNC_ARG;
+
+    ret = AddCRL_Index(crl, file);
+    if (ret == 0)
+        ret = KeepCRL_IndexPath(crl, file);
+
+    if (ret == 0)
+        return SSL_SUCCESS;  /* convert */
+    return ret;
+}
+
+
+/* does file name end in the CRL index extension */
+static int IsCRL_Index(const char* name)
+{
+    word32 len = (word32)XSTRLEN(name);
+    word32 ext = (word32)XSTRLEN(CRL_INDEX_EXT);
+
+    return len > ext && XSTRNCMP(name + len - ext, CRL_INDEX_EXT, ext) == 0;
+}
+
+
 #ifdef HAVE_CRL_MONITOR
 
 
+/* named CRL index after idx, the first for NULL; the list only grows */
+static CRL_IndexPath* NextCRL_IndexPath(CYASSL_CRL* crl, CRL_IndexPath* idx)
+{
+    if (LockMutex(&crl->crlLock) != 0)
+        return NULL;
+    idx = idx ? idx->next : crl->indexes;
+    UnLockMutex(&crl->crlLock);
+
+    return idx;
+}
+
+
 /* read in new CRL entries and save new list */
 static int SwapLists(CYASSL_CRL* crl)
 {
-    int        ret;
-    CYASSL_CRL tmp;
-    CRL_Entry* newList;
+    int            ret;
+    CYASSL_CRL     tmp;
+    CRL_Store*     old;
+    CRL_IndexPath* idx;
 
     if (InitCRL(&tmp, crl->cm) < 0) {
         CYASSL_MSG("Init tmp CRL failed");
@@ -313,17 +815,26 @@ static int SwapLists(CYASSL_CRL* crl)
         }
     }
 
+    /* named indexes last so they win over a parsed CRL for their issuer,
+       a recompiled one is just mapped again */
+    for (idx = NextCRL_IndexPath(crl, NULL); idx;
+                                         idx = NextCRL_IndexPath(crl, idx)) {
+        if (AddCRL_Index(&tmp, idx->path) != 0) {
+            CYASSL_MSG("CRL index map on dir change failed, continuing");
+        }
+    }
+
     if (LockMutex(&crl->crlLock) != 0) {
         CYASSL_MSG("LockMutex failed");
         FreeCRL(&tmp, 0);
         return -1;
     }
 
-    newList = tmp.crlList;
-
-    /* swap lists */
-    tmp.crlList  = crl->crlList;
-    crl->crlList = newList;
+    /* publish the new snapshot, readers still on the old one finish there */
+    old        = crl->store;
+    crl->store = tmp.store;
+    tmp.store  = NULL;
+    ReleaseStore(old);
 
     UnLockMutex(&crl->crlLock);
 
@@ -432,8 +943,9 @@ static void* DoMonitor(void* arg)
     }
 
     if (crl->monitors[0].path) {
-        wd = inotify_add_watch(notifyFd, crl->monitors[0].path, IN_CLOSE_WRITE |
-                                                                IN_DELETE);
+        /* a compiled CRL index is renamed into place */
+        wd = inotify_add_watch(notifyFd, crl->monitors[0].path,
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
         if (wd < 0) {
             CYASSL_MSG("PEM notify add watch failed");
             return NULL;
@@ -441,8 +953,8 @@ static void* DoMonitor(void* arg)
     }
 
     if (crl->monitors[1].path) {
-        wd = inotify_add_watch(notifyFd, crl->monitors[1].path, IN_CLOSE_WRITE |
-                                                                IN_DELETE);
+        wd = inotify_add_watch(notifyFd, crl->monitors[1].path,
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE);
         if (wd < 0) {
             CYASSL_MSG("DER notify add watch failed");
             return NULL;
@@ -548,6 +1060,13 @@ int LoadCRL(CYASSL_CRL* crl, const char* path, int type, int monitor)
         }
         if (s.st_mode & S_IFREG) {
 
+            /* an index isn't signed, it only loads when named through
+               CyaSSL_CertManagerLoadCRLIndex */
+            if (IsCRL_Index(entry->d_name)) {
+                CYASSL_MSG("CRL index in CRL path, skipping");
+                continue;
+            }
+
             if (type == SSL_FILETYPE_PEM) {
                 if (strstr(entry->d_name, ".pem") == NULL) {
                     CYASSL_MSG("not .pem file, skipping");
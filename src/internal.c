@@ -104,7 +104,7 @@ static void SSL_hmac(CYASSL* ssl, byte* digest, const byte* in, word32 sz,
 #endif
 
 #ifndef NO_CERTS
-static void BuildCertHashes(CYASSL* ssl, Hashes* hashes);
+static int BuildCertHashes(CYASSL* ssl, Hashes* hashes);
 #endif
 
 static void PickHashSigAlgo(CYASSL* ssl,
@@ -345,6 +345,12 @@ int InitSSL_Ctx(CYASSL_CTX* ctx, CYASSL_METHOD* method)
     ctx->privateKey.buffer  = 0;
     ctx->serverDH_P.buffer  = 0;
     ctx->serverDH_G.buffer  = 0;
+    #ifndef NO_RSA
+        ctx->rsaKey         = NULL;
+    #endif
+    #ifdef HAVE_ECC
+        ctx->eccKey         = NULL;
+    #endif
 #endif
     ctx->haveDH             = 0;
     ctx->haveNTRU           = 0;    /* start off */
@@ -419,6 +425,7 @@ int InitSSL_Ctx(CYASSL_CTX* ctx, CYASSL_METHOD* method)
     ctx->sendVerify = 0;
     ctx->quietShutdown = 0;
     ctx->groupMessages = 0;
+    ctx->readAhead     = 0;
 #ifdef HAVE_OCSP
     CyaSSL_OCSP_Init(&ctx->ocsp);
 #endif
@@ -449,6 +456,33 @@ int InitSSL_Ctx(CYASSL_CTX* ctx, CYASSL_METHOD* method)
         CYASSL_MSG("Mutex error on CTX init");
         return BAD_MUTEX_E;
     } 
+    XMEMSET(&ctx->bufferPool, 0, sizeof(ctx->bufferPool));
+    if (InitMutex(&ctx->bufferPool.mutex) < 0) {
+        CYASSL_MSG("Mutex error on CTX buffer pool init");
+        return BAD_MUTEX_E;
+    }
+    XMEMSET(&ctx->rng, 0, sizeof(ctx->rng));
+    if (InitMutex(&ctx->rng.mutex) < 0) {
+        CYASSL_MSG("Mutex error on CTX rng init");
+        return BAD_MUTEX_E;
+    }
+    if (InitRng(&ctx->rng.rng) == 0) {
+        ctx->rng.ready = 1;
+    #ifdef CYASSL_RNG_FORK_CHECK
+        ctx->rng.pid = (long)getpid();
+    #endif
+    }
+    else {
+        CYASSL_MSG("CTX rng init failed, seeding each SSL from the OS");
+    }
+#ifdef HAVE_SESSION_TICKET
+    XMEMSET(ctx->ticketKeys.keys, 0, sizeof(ctx->ticketKeys.keys));
+    ctx->ticketKeys.count = 0;     /* tickets off until keys are added */
+    if (InitMutex(&ctx->ticketKeys.mutex) < 0) {
+        CYASSL_MSG("Mutex error on CTX ticket keys init");
+        return BAD_MUTEX_E;
+    }
+#endif
 #ifndef NO_CERTS
     if (ctx->cm == NULL) {
         CYASSL_MSG("Bad Cert Manager New");
@@ -459,6 +493,92 @@ int InitSSL_Ctx(CYASSL_CTX* ctx, CYASSL_METHOD* method)
 }
 
 
+#ifndef NO_CERTS
+
+/* drop the decoded copies of ctx->privateKey */
+void FreeCtxKeys(CYASSL_CTX* ctx)
+{
+#ifndef NO_RSA
+    if (ctx->rsaKey) {
+        FreeRsaKey(ctx->rsaKey);
+        XFREE(ctx->rsaKey, ctx->heap, DYNAMIC_TYPE_RSA);
+        ctx->rsaKey = NULL;
+    }
+#endif
+#ifdef HAVE_ECC
+    if (ctx->eccKey) {
+        ecc_free(ctx->eccKey);
+        XFREE(ctx->eccKey, ctx->heap, DYNAMIC_TYPE_ECC);
+        ctx->eccKey = NULL;
+    }
+#endif
+    (void)ctx;
+}
+
+
+/* ssl signs with the ctx private key and the ctx kept it decoded */
+static INLINE int UseCtxKey(CYASSL* ssl)
+{
+    CYASSL_CTX* ctx = ssl->ctx;
+
+    if (ssl->buffers.key.buffer == NULL ||
+        ssl->buffers.key.buffer != ctx->privateKey.buffer)
+        return 0;
+#ifndef NO_RSA
+    if (ctx->rsaKey)
+        return 1;
+#endif
+#ifdef HAVE_ECC
+    if (ctx->eccKey)
+        return 1;
+#endif
+    return 0;
+}
+
+
+#ifndef NO_RSA
+
+/* point key at the ctx's decoded key if ssl shares it, otherwise decode
+   ssl's own key into tmp, caller still frees tmp */
+static INLINE int GetRsaPrivateKey(CYASSL* ssl, RsaKey* tmp, RsaKey** key)
+{
+    word32 idx = 0;
+
+    if (UseCtxKey(ssl)) {
+        *key = ssl->ctx->rsaKey;
+        return *key ? 0 : ASN_PARSE_E;
+    }
+
+    *key = tmp;
+    return RsaPrivateKeyDecode(ssl->buffers.key.buffer, &idx, tmp,
+                               ssl->buffers.key.length);
+}
+
+#endif /* NO_RSA */
+
+
+#ifdef HAVE_ECC
+
+/* same as GetRsaPrivateKey() for ECC keys */
+static INLINE int GetEccPrivateKey(CYASSL* ssl, ecc_key* tmp, ecc_key** key)
+{
+    word32 idx = 0;
+
+    if (UseCtxKey(ssl)) {
+        *key = ssl->ctx->eccKey;
+        return *key ? 0 : ASN_PARSE_E;
+    }
+
+    *key = tmp;
+    return EccPrivateKeyDecode(ssl->buffers.key.buffer, &idx, tmp,
+                               ssl->buffers.key.length);
+}
+
+#endif /* HAVE_ECC */
+
+#endif /* NO_CERTS */
+
+
 /* In case contexts are held in array and don't want to free actual ctx */
 void SSL_CtxResourceFree(CYASSL_CTX* ctx)
 {
@@ -470,6 +590,7 @@ void SSL_CtxResourceFree(CYASSL_CTX* ctx)
     XFREE(ctx->privateKey.buffer, ctx->heap, DYNAMIC_TYPE_KEY);
     XFREE(ctx->certificate.buffer, ctx->heap, DYNAMIC_TYPE_CERT);
     XFREE(ctx->certChain.buffer, ctx->heap, DYNAMIC_TYPE_CERT);
+    FreeCtxKeys(ctx);
     CyaSSL_CertManagerFree(ctx->cm);
 #endif
 #ifdef HAVE_OCSP
@@ -478,6 +599,185 @@ void SSL_CtxResourceFree(CYASSL_CTX* ctx)
 #ifdef HAVE_TLS_EXTENSIONS
     TLSX_FreeAll(ctx->extensions);
 #endif
+#ifdef HAVE_SESSION_TICKET
+    XMEMSET(ctx->ticketKeys.keys, 0, sizeof(ctx->ticketKeys.keys));
+    FreeMutex(&ctx->ticketKeys.mutex);
+#endif
+    ctx->bufferPool.maxFree = 0;
+    TrimBufferPool(&ctx->bufferPool, ctx->heap);
+    FreeMutex(&ctx->bufferPool.mutex);
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    if (ctx->rng.ready)
+        FreeRng(&ctx->rng.rng);
+#endif
+    XMEMSET(&ctx->rng.rng, 0, sizeof(ctx->rng.rng));
+    FreeMutex(&ctx->rng.mutex);
+}
+
+
+/* seed an ssl rng from the ctx rng, falls back to the OS if the ctx rng
+   never got seeded; reseeds the ctx rng every CTX_RNG_RESEED seeds and in a
+   forked child so parent and child don't share a stream */
+static int InitSslRng(CYASSL_CTX* ctx, RNG* rng)
+{
+    CtxRng* ctxRng = &ctx->rng;
+    byte    seed[CTX_RNG_SEED_SZ];
+    int     ret = 0;
+    int     forked = 0;
+#ifdef CYASSL_RNG_FORK_CHECK
+    long    pid = (long)getpid();
+#endif
+
+    if (!ctxRng->ready)
+        return InitRng(rng);
+
+    if (LockMutex(&ctxRng->mutex) != 0) {
+        CYASSL_MSG("Couldn't lock ctx rng mutex");
+        return InitRng(rng);
+    }
+
+#ifdef CYASSL_RNG_FORK_CHECK
+    if (ctxRng->pid != pid) {
+        CYASSL_MSG("ctx rng used in new process, reseeding");
+        forked = 1;
+    }
+#endif
+    if (forked || ++ctxRng->draws >= CTX_RNG_RESEED) {
+        ret = RNG_Reseed(&ctxRng->rng);
+        /* only a good reseed moves the pid and count on, a failed one is
+           retried by the next call rather than drawing the old stream */
+        if (ret == 0) {
+            ctxRng->draws = 0;
+        #ifdef CYASSL_RNG_FORK_CHECK
+            ctxRng->pid   = pid;
+        #endif
+        }
+    }
+    if (ret == 0)
+        RNG_GenerateBlock(&ctxRng->rng, seed, sizeof(seed));
+
+    UnLockMutex(&ctxRng->mutex);
+
+    if (ret != 0) {
+        CYASSL_MSG("ctx rng reseed failed");
+        return ret;
+    }
+
+    ret = InitRngSeed(rng, seed, sizeof(seed));
+    XMEMSET(seed, 0, sizeof(seed));
+
+    return ret;
+}
+
+
+/* free pooled buffers beyond maxFree, caller holds no pool lock */
+void TrimBufferPool(BufferPool* pool, void* heap)
+{
+    byte* head = NULL;
+
+    (void)heap;
+
+    if (LockMutex(&pool->mutex) != 0) {
+        CYASSL_MSG("Couldn't lock buffer pool mutex");
+        return;
+    }
+    while (pool->freeCount > pool->maxFree) {
+        byte* buf = pool->head;
+
+        XMEMCPY(&pool->head, buf, sizeof(byte*));
+        pool->freeCount--;
+        XMEMCPY(buf, &head, sizeof(byte*));
+        head = buf;
+    }
+    UnLockMutex(&pool->mutex);
+
+    /* free outside the lock */
+    while (head) {
+        byte* buf = head;
+
+        XMEMCPY(&head, buf, sizeof(byte*));
+        XFREE(buf, heap, DYNAMIC_TYPE_NONE);
+    }
+}
+
+
+/* get an io buffer of at least sz bytes, from the ctx pool when it's on and
+   sz fits a pooled buffer, sets pooled and returns usable size in *outSz */
+static byte* BufferAlloc(CYASSL* ssl, word32 sz, int type, byte* pooled,
+                         word32* outSz)
+{
+    BufferPool* pool = &ssl->ctx->bufferPool;
+    byte*       buf  = NULL;
+
+    (void)type;
+
+    *pooled = 0;
+    *outSz  = sz;
+
+    if (pool->maxFree == 0 || sz > BUFFER_POOL_SZ)
+        return (byte*)XMALLOC(sz, ssl->heap, type);
+
+    if (LockMutex(&pool->mutex) != 0) {
+        CYASSL_MSG("Couldn't lock buffer pool mutex");
+        return (byte*)XMALLOC(sz, ssl->heap, type);
+    }
+    if (pool->head) {
+        buf = pool->head;
+        XMEMCPY(&pool->head, buf, sizeof(byte*));
+        pool->freeCount--;
+    }
+    pool->inUse++;
+    if (pool->inUse > pool->highWater)
+        pool->highWater = pool->inUse;
+    UnLockMutex(&pool->mutex);
+
+    if (buf == NULL)
+        buf = (byte*)XMALLOC(BUFFER_POOL_SZ, ssl->ctx->heap, DYNAMIC_TYPE_NONE);
+
+    if (buf == NULL) {
+        if (LockMutex(&pool->mutex) == 0) {
+            pool->inUse--;
+            UnLockMutex(&pool->mutex);
+        }
+        return NULL;
+    }
+
+    *pooled = 1;
+    *outSz  = BUFFER_POOL_SZ;
+
+    return buf;
+}
+
+
+/* give back a BufferAlloc() buffer, pooled ones go on the free list while
+   it's short of maxFree */
+static void BufferFree(CYASSL* ssl, byte* buf, int type, byte pooled)
+{
+    BufferPool* pool = &ssl->ctx->bufferPool;
+
+    (void)type;
+
+    if (!pooled) {
+        XFREE(buf, ssl->heap, type);
+        return;
+    }
+
+    if (LockMutex(&pool->mutex) != 0) {
+        CYASSL_MSG("Couldn't lock buffer pool mutex");
+        XFREE(buf, ssl->ctx->heap, DYNAMIC_TYPE_NONE);
+        return;
+    }
+    pool->inUse--;
+    if (pool->freeCount < pool->maxFree) {
+        XMEMCPY(buf, &pool->head, sizeof(byte*));
+        pool->head = buf;
+        pool->freeCount++;
+        buf = NULL;
+    }
+    UnLockMutex(&pool->mutex);
+
+    if (buf)
+        XFREE(buf, ssl->ctx->heap, DYNAMIC_TYPE_NONE);
 }
 
 
@@ -533,6 +833,12 @@ void InitCiphers(CYASSL* ssl)
 #ifdef BUILD_RABBIT
     ssl->encrypt.rabbit = NULL;
     ssl->decrypt.rabbit = NULL;
+#endif
+    ssl->encrypt.hmac = NULL;
+    ssl->decrypt.hmac = NULL;
+#if !defined(NO_OLD_TLS) && defined(HMAC_PAD_STATES)
+    ssl->encrypt.sslMac = NULL;
+    ssl->decrypt.sslMac = NULL;
 #endif
     ssl->encrypt.setup = 0;
     ssl->decrypt.setup = 0;
@@ -584,6 +890,12 @@ void FreeCiphers(CYASSL* ssl)
 #ifdef BUILD_RABBIT
     XFREE(ssl->encrypt.rabbit, ssl->heap, DYNAMIC_TYPE_CIPHER);
     XFREE(ssl->decrypt.rabbit, ssl->heap, DYNAMIC_TYPE_CIPHER);
+#endif
+    XFREE(ssl->encrypt.hmac, ssl->heap, DYNAMIC_TYPE_CIPHER);
+    XFREE(ssl->decrypt.hmac, ssl->heap, DYNAMIC_TYPE_CIPHER);
+#if !defined(NO_OLD_TLS) && defined(HMAC_PAD_STATES)
+    XFREE(ssl->encrypt.sslMac, ssl->heap, DYNAMIC_TYPE_CIPHER);
+    XFREE(ssl->decrypt.sslMac, ssl->heap, DYNAMIC_TYPE_CIPHER);
 #endif
 }
 
@@ -1325,12 +1637,14 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
     ssl->buffers.inputBuffer.bufferSize  = STATIC_BUFFER_LEN;
     ssl->buffers.inputBuffer.dynamicFlag = 0;
     ssl->buffers.inputBuffer.offset   = 0;
+    ssl->buffers.inputBuffer.pooled   = 0;
     ssl->buffers.outputBuffer.length  = 0;
     ssl->buffers.outputBuffer.idx     = 0;
     ssl->buffers.outputBuffer.buffer = ssl->buffers.outputBuffer.staticBuffer;
     ssl->buffers.outputBuffer.bufferSize  = STATIC_BUFFER_LEN;
     ssl->buffers.outputBuffer.dynamicFlag = 0;
     ssl->buffers.outputBuffer.offset      = 0;
+    ssl->buffers.outputBuffer.pooled      = 0;
     ssl->buffers.domainName.buffer    = 0;
 #ifndef NO_CERTS
     ssl->buffers.serverDH_P.buffer    = 0;
@@ -1342,6 +1656,7 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
     ssl->buffers.clearOutputBuffer.length  = 0;
     ssl->buffers.prevSent                  = 0;
     ssl->buffers.plainSz                   = 0;
+    ssl->buffers.reservedSz                = 0;
 #ifdef HAVE_PK_CALLBACKS
     #ifdef HAVE_ECC
         ssl->buffers.peerEccDsaKey.buffer = 0;
@@ -1379,6 +1694,8 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
 
     ssl->IOCB_ReadCtx  = &ssl->rfd;  /* prevent invalid pointer access if not */
     ssl->IOCB_WriteCtx = &ssl->wfd;  /* correctly set */
+    ssl->recvCalls = 0;
+    ssl->sendCalls = 0;
 #ifdef HAVE_NETX
     ssl->nxCtx.nxSocket = NULL;
     ssl->nxCtx.nxPacket = NULL;
@@ -1392,20 +1709,6 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
     ssl->dtls_expected_rx = MAX_MTU;
 #endif
 
-#ifndef NO_OLD_TLS
-#ifndef NO_MD5
-    InitMd5(&ssl->hashMd5);
-#endif
-#ifndef NO_SHA
-    InitSha(&ssl->hashSha);
-#endif
-#endif
-#ifndef NO_SHA256
-    InitSha256(&ssl->hashSha256);
-#endif
-#ifdef CYASSL_SHA384
-    InitSha384(&ssl->hashSha384);
-#endif
 #ifndef NO_RSA
     ssl->peerRsaKey = NULL;
     ssl->peerRsaKeyPresent = 0;
@@ -1487,8 +1790,13 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
     ssl->options.quietShutdown = ctx->quietShutdown;
     ssl->options.certOnly = 0;
     ssl->options.groupMessages = ctx->groupMessages;
+    ssl->options.readAhead     = ctx->readAhead;
     ssl->options.usingNonblock = 0;
     ssl->options.saveArrays = 0;
+#ifdef HAVE_SESSION_TICKET
+    ssl->options.createTicket = 0;
+    ssl->options.useTicket    = 0;
+#endif
 
 #ifndef NO_CERTS
     /* ctx still owns certificate, certChain, key, dh, and cm */
@@ -1552,6 +1860,7 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
 
     ssl->rng    = NULL;
     ssl->arrays = NULL;
+    ssl->hsHashes = NULL;
 
     /* default alert state (none) */
     ssl->alert_history.last_rx.code  = -1;
@@ -1596,6 +1905,16 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
         return MEMORY_E;
     }
 
+    /* handshake transcript */
+    ssl->hsHashes = (HsHashes*)XMALLOC(sizeof(HsHashes), ssl->heap,
+                                       DYNAMIC_TYPE_HASHES);
+    if (ssl->hsHashes == NULL) {
+        CYASSL_MSG("HsHashes Memory error");
+        return MEMORY_E;
+    }
+    ssl->hsHashes->buffer = NULL;
+    InitHandshakeHashes(ssl);
+
 #ifndef NO_PSK
     ssl->arrays->client_identity[0] = 0;
     if (ctx->server_hint[0]) {   /* set in CTX */
@@ -1617,10 +1936,14 @@ int InitSSL(CYASSL* ssl, CYASSL_CTX* ctx)
         return MEMORY_E;
     }
 
-    if ( (ret = InitRng(ssl->rng)) != 0) {
+    if ( (ret = InitSslRng(ctx, ssl->rng)) != 0) {
         CYASSL_MSG("RNG Init error");
         return ret;
     }
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    /* randoms, session ids, IVs and premasters are all small draws */
+    RNG_SetBuffered(ssl->rng, 1);
+#endif
 
     /* suites */
     ssl->suites = (Suites*)XMALLOC(sizeof(Suites), ssl->heap,
@@ -1712,6 +2035,11 @@ void SSL_ResourceFree(CYASSL* ssl)
 {
     FreeCiphers(ssl);
     FreeArrays(ssl, 0);
+    FreeHandshakeHashes(ssl);
+#if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+    if (ssl->rng)
+        FreeRng(ssl->rng);
+#endif
     XFREE(ssl->rng, ssl->heap, DYNAMIC_TYPE_RNG);
     XFREE(ssl->suites, ssl->heap, DYNAMIC_TYPE_SUITES);
     XFREE(ssl->buffers.domainName.buffer, ssl->heap, DYNAMIC_TYPE_DOMAIN);
@@ -1815,8 +2143,15 @@ void FreeHandshakeResources(CYASSL* ssl)
     XFREE(ssl->suites, ssl->heap, DYNAMIC_TYPE_SUITES);
     ssl->suites = NULL;
 
+    /* handshake transcript */
+    FreeHandshakeHashes(ssl);
+
     /* RNG */
     if (ssl->specs.cipher_type == stream || ssl->options.tls1_1 == 0) {
+    #if defined(NO_RC4) || defined(HAVE_CTR_DRBG)
+        if (ssl->rng)
+            FreeRng(ssl->rng);
+    #endif
         XFREE(ssl->rng, ssl->heap, DYNAMIC_TYPE_RNG);
         ssl->rng = NULL;
     }
@@ -1896,9 +2231,11 @@ void FreeHandshakeResources(CYASSL* ssl)
 
 void FreeSSL(CYASSL* ssl)
 {
-    FreeSSL_Ctx(ssl->ctx);  /* will decrement and free underyling CTX if 0 */
-    SSL_ResourceFree(ssl);
+    CYASSL_CTX* ctx = ssl->ctx;
+
+    SSL_ResourceFree(ssl);  /* pooled buffers go back while ctx is around */
     XFREE(ssl, ssl->heap, DYNAMIC_TYPE_SSL);
+    FreeSSL_Ctx(ctx);  /* will decrement and free underyling CTX if 0 */
 }
 
 
@@ -2312,68 +2649,206 @@ ProtocolVersion MakeDTLSv1_2(void)
 #endif /* USE_WINDOWS_API */
 
 
-/* add output to md5 and sha handshake hashes, exclude record header */
-static void HashOutput(CYASSL* ssl, const byte* output, int sz, int ivSz)
+/* (re)start the handshake transcript, nothing picked or hashed yet */
+void InitHandshakeHashes(CYASSL* ssl)
 {
-    const byte* adj = output + RECORD_HEADER_SZ + ivSz;
-    sz -= RECORD_HEADER_SZ;
-    
-#ifdef CYASSL_DTLS
-    if (ssl->options.dtls) {
-        adj += DTLS_RECORD_EXTRA;
-        sz  -= DTLS_RECORD_EXTRA;
+    HsHashes* hs = ssl->hsHashes;
+
+    if (hs == NULL)
+        return;
+
+    XFREE(hs->buffer, ssl->heap, DYNAMIC_TYPE_HASHES);
+    hs->buffer   = NULL;
+    hs->length   = 0;
+    hs->bufferSz = 0;
+    hs->use      = 0;
+    hs->running  = 0;
+}
+
+
+void FreeHandshakeHashes(CYASSL* ssl)
+{
+    if (ssl->hsHashes == NULL)
+        return;
+
+    XFREE(ssl->hsHashes->buffer, ssl->heap, DYNAMIC_TYPE_HASHES);
+    XFREE(ssl->hsHashes, ssl->heap, DYNAMIC_TYPE_HASHES);
+    ssl->hsHashes = NULL;
+}
+
+
+/* Which transcript hashes the negotiated version and suite need, called from
+   SetCipherSpecs. Nothing is hashed until the next message or digest so a
+   later suite change, like a ticket resumption, can still pick again. TLS
+   1.2 needs the PRF hash, plus any CertificateVerify may be signed with if
+   this side might send or check one */
+void PickHandshakeHashes(CYASSL* ssl)
+{
+    HsHashes* hs = ssl->hsHashes;
+    byte      use = 0;
+
+    if (hs == NULL || hs->running)
+        return;
+
+    if (!IsAtLeastTLSv1_2(ssl))
+        use = HS_HASH_MD5 | HS_HASH_SHA;
+    else {
+        int certVerify = 0;
+
+    #ifndef NO_CERTS
+        if (ssl->options.side == CYASSL_SERVER_END)
+            certVerify = ssl->options.verifyPeer;
+        else
+            certVerify = ssl->buffers.certificate.buffer != NULL &&
+                         ssl->buffers.key.buffer != NULL;
+    #endif
+
+        if (ssl->specs.mac_algorithm == sha384_mac)
+            use = HS_HASH_SHA384;
+        else
+            use = HS_HASH_SHA256;
+
+        if (certVerify)
+            use |= HS_HASH_SHA | HS_HASH_SHA256 | HS_HASH_SHA384;
     }
-#endif
+
+    hs->use = use;
+}
+
+
+static void UpdateHandshakeHashes(HsHashes* hs, const byte* data, word32 sz)
+{
 #ifndef NO_OLD_TLS
 #ifndef NO_SHA
-    ShaUpdate(&ssl->hashSha, adj, sz);
+    if (hs->running & HS_HASH_SHA)
+        ShaUpdate(&hs->hashSha, data, sz);
 #endif
 #ifndef NO_MD5
-    Md5Update(&ssl->hashMd5, adj, sz);
+    if (hs->running & HS_HASH_MD5)
+        Md5Update(&hs->hashMd5, data, sz);
 #endif
 #endif
-
-    if (IsAtLeastTLSv1_2(ssl)) {
 #ifndef NO_SHA256
-        Sha256Update(&ssl->hashSha256, adj, sz);
+    if (hs->running & HS_HASH_SHA256)
+        Sha256Update(&hs->hashSha256, data, sz);
 #endif
 #ifdef CYASSL_SHA384
-        Sha384Update(&ssl->hashSha384, adj, sz);
+    if (hs->running & HS_HASH_SHA384)
+        Sha384Update(&hs->hashSha384, data, sz);
 #endif
-    }
 }
 
 
-/* add input to md5 and sha handshake hashes, include handshake header */
-static void HashInput(CYASSL* ssl, const byte* input, int sz)
+/* start the picked hashes and catch them up on the buffered messages */
+void StartHandshakeHashes(CYASSL* ssl)
 {
-    const byte* adj = input - HANDSHAKE_HEADER_SZ;
-    sz += HANDSHAKE_HEADER_SZ;
-    
-#ifdef CYASSL_DTLS
-    if (ssl->options.dtls) {
-        adj -= DTLS_HANDSHAKE_EXTRA;
-        sz  += DTLS_HANDSHAKE_EXTRA;
-    }
-#endif
+    HsHashes* hs = ssl->hsHashes;
+
+    if (hs == NULL || hs->running || hs->use == 0)
+        return;
 
 #ifndef NO_OLD_TLS
 #ifndef NO_SHA
-    ShaUpdate(&ssl->hashSha, adj, sz);
+    if (hs->use & HS_HASH_SHA)
+        InitSha(&hs->hashSha);
 #endif
 #ifndef NO_MD5
-    Md5Update(&ssl->hashMd5, adj, sz);
+    if (hs->use & HS_HASH_MD5)
+        InitMd5(&hs->hashMd5);
 #endif
 #endif
-
-    if (IsAtLeastTLSv1_2(ssl)) {
 #ifndef NO_SHA256
-        Sha256Update(&ssl->hashSha256, adj, sz);
+    if (hs->use & HS_HASH_SHA256)
+        InitSha256(&hs->hashSha256);
 #endif
 #ifdef CYASSL_SHA384
-        Sha384Update(&ssl->hashSha384, adj, sz);
+    if (hs->use & HS_HASH_SHA384)
+        InitSha384(&hs->hashSha384);
 #endif
+    hs->running = hs->use;
+
+    if (hs->length)
+        UpdateHandshakeHashes(hs, hs->buffer, hs->length);
+
+    XFREE(hs->buffer, ssl->heap, DYNAMIC_TYPE_HASHES);
+    hs->buffer   = NULL;
+    hs->length   = 0;
+    hs->bufferSz = 0;
+}
+
+
+/* add a handshake message to the transcript, buffered until the hashes are
+   picked */
+static int HashHandshake(CYASSL* ssl, const byte* data, word32 sz)
+{
+    HsHashes* hs = ssl->hsHashes;
+
+    if (hs == NULL)
+        return 0;     /* handshake resources already freed */
+
+    if (hs->running == 0)
+        StartHandshakeHashes(ssl);
+
+    if (hs->running == 0) {
+        if (hs->length + sz > hs->bufferSz) {
+            word32 newSz = hs->bufferSz ? hs->bufferSz : HS_HASH_BUFFER_SZ;
+            byte*  tmp;
+
+            while (newSz < hs->length + sz)
+                newSz *= 2;
+
+            tmp = (byte*)XMALLOC(newSz, ssl->heap, DYNAMIC_TYPE_HASHES);
+            if (tmp == NULL)
+                return MEMORY_E;
+            if (hs->length)
+                XMEMCPY(tmp, hs->buffer, hs->length);
+            XFREE(hs->buffer, ssl->heap, DYNAMIC_TYPE_HASHES);
+            hs->buffer   = tmp;
+            hs->bufferSz = newSz;
+        }
+        XMEMCPY(hs->buffer + hs->length, data, sz);
+        hs->length += sz;
+
+        return 0;
     }
+
+    UpdateHandshakeHashes(hs, data, sz);
+
+    return 0;
+}
+
+
+/* add output to handshake hashes, exclude record header */
+static int HashOutput(CYASSL* ssl, const byte* output, int sz, int ivSz)
+{
+    const byte* adj = output + RECORD_HEADER_SZ + ivSz;
+    sz -= RECORD_HEADER_SZ;
+    
+#ifdef CYASSL_DTLS
+    if (ssl->options.dtls) {
+        adj += DTLS_RECORD_EXTRA;
+        sz  -= DTLS_RECORD_EXTRA;
+    }
+#endif
+
+    return HashHandshake(ssl, adj, sz);
+}
+
+
+/* add input to handshake hashes, include handshake header */
+static int HashInput(CYASSL* ssl, const byte* input, int sz)
+{
+    const byte* adj = input - HANDSHAKE_HEADER_SZ;
+    sz += HANDSHAKE_HEADER_SZ;
+    
+#ifdef CYASSL_DTLS
+    if (ssl->options.dtls) {
+        adj -= DTLS_HANDSHAKE_EXTRA;
+        sz  += DTLS_HANDSHAKE_EXTRA;
+    }
+#endif
+
+    return HashHandshake(ssl, adj, sz);
 }
 
 
@@ -2456,6 +2931,7 @@ static int Receive(CYASSL* ssl, byte* buf, word32 sz)
     }
 
 retry:
+    ssl->recvCalls++;
     recvd = ssl->ctx->CBIORecv(ssl, (char *)buf, (int)sz, ssl->IOCB_ReadCtx);
     if (recvd < 0)
         switch (recvd) {
@@ -2515,11 +2991,13 @@ retry:
 void ShrinkOutputBuffer(CYASSL* ssl)
 {
     CYASSL_MSG("Shrinking output buffer\n");
-    XFREE(ssl->buffers.outputBuffer.buffer - ssl->buffers.outputBuffer.offset,
-          ssl->heap, DYNAMIC_TYPE_OUT_BUFFER);
+    BufferFree(ssl, ssl->buffers.outputBuffer.buffer -
+               ssl->buffers.outputBuffer.offset, DYNAMIC_TYPE_OUT_BUFFER,
+               ssl->buffers.outputBuffer.pooled);
     ssl->buffers.outputBuffer.buffer = ssl->buffers.outputBuffer.staticBuffer;
     ssl->buffers.outputBuffer.bufferSize  = STATIC_BUFFER_LEN;
     ssl->buffers.outputBuffer.dynamicFlag = 0;
+    ssl->buffers.outputBuffer.pooled      = 0;
     ssl->buffers.outputBuffer.offset      = 0;
 }
 
@@ -2533,6 +3011,10 @@ void ShrinkInputBuffer(CYASSL* ssl, int forcedFree)
     if (!forcedFree && usedLength > STATIC_BUFFER_LEN)
         return;
 
+    /* reading ahead keeps its big buffer for the life of the connection */
+    if (!forcedFree && ssl->options.readAhead)
+        return;
+
     CYASSL_MSG("Shrinking input buffer\n");
 
     if (!forcedFree && usedLength)
@@ -2540,11 +3022,13 @@ void ShrinkInputBuffer(CYASSL* ssl, int forcedFree)
                ssl->buffers.inputBuffer.buffer + ssl->buffers.inputBuffer.idx,
                usedLength);
 
-    XFREE(ssl->buffers.inputBuffer.buffer - ssl->buffers.inputBuffer.offset,
-          ssl->heap, DYNAMIC_TYPE_IN_BUFFER);
+    BufferFree(ssl, ssl->buffers.inputBuffer.buffer -
+               ssl->buffers.inputBuffer.offset, DYNAMIC_TYPE_IN_BUFFER,
+               ssl->buffers.inputBuffer.pooled);
     ssl->buffers.inputBuffer.buffer = ssl->buffers.inputBuffer.staticBuffer;
     ssl->buffers.inputBuffer.bufferSize  = STATIC_BUFFER_LEN;
     ssl->buffers.inputBuffer.dynamicFlag = 0;
+    ssl->buffers.inputBuffer.pooled      = 0;
     ssl->buffers.inputBuffer.offset      = 0;
     ssl->buffers.inputBuffer.idx = 0;
     ssl->buffers.inputBuffer.length = usedLength;
@@ -2559,7 +3043,10 @@ int SendBuffered(CYASSL* ssl)
     }
 
     while (ssl->buffers.outputBuffer.length > 0) {
-        int sent = ssl->ctx->CBIOSend(ssl,
+        int sent;
+
+        ssl->sendCalls++;
+        sent = ssl->ctx->CBIOSend(ssl,
                                       (char*)ssl->buffers.outputBuffer.buffer +
                                       ssl->buffers.outputBuffer.idx,
                                       (int)ssl->buffers.outputBuffer.length,
@@ -2607,6 +3094,7 @@ int SendBuffered(CYASSL* ssl)
     }
       
     ssl->buffers.outputBuffer.idx = 0;
+    ssl->buffers.reservedSz = 0;     /* any reserved room got written over */
 
     if (ssl->buffers.outputBuffer.dynamicFlag)
         ShrinkOutputBuffer(ssl);
@@ -2619,6 +3107,8 @@ int SendBuffered(CYASSL* ssl)
 static INLINE int GrowOutputBuffer(CYASSL* ssl, int size)
 {
     byte* tmp;
+    byte  pooled;
+    word32 tmpSz;
     byte  hdrSz = ssl->options.dtls ? DTLS_RECORD_HEADER_SZ :
                                       RECORD_HEADER_SZ; 
     byte  align = CYASSL_GENERAL_ALIGNMENT;
@@ -2631,8 +3121,8 @@ static INLINE int GrowOutputBuffer(CYASSL* ssl, int size)
            align *= 2;
     }
 
-    tmp = (byte*) XMALLOC(size + ssl->buffers.outputBuffer.length + align,
-                          ssl->heap, DYNAMIC_TYPE_OUT_BUFFER);
+    tmp = BufferAlloc(ssl, size + ssl->buffers.outputBuffer.length + align,
+                      DYNAMIC_TYPE_OUT_BUFFER, &pooled, &tmpSz);
     CYASSL_MSG("growing output buffer\n");
    
     if (!tmp) return MEMORY_E;
@@ -2644,17 +3134,17 @@ static INLINE int GrowOutputBuffer(CYASSL* ssl, int size)
                ssl->buffers.outputBuffer.length);
 
     if (ssl->buffers.outputBuffer.dynamicFlag)
-        XFREE(ssl->buffers.outputBuffer.buffer -
-              ssl->buffers.outputBuffer.offset, ssl->heap,
-              DYNAMIC_TYPE_OUT_BUFFER);
+        BufferFree(ssl, ssl->buffers.outputBuffer.buffer -
+                   ssl->buffers.outputBuffer.offset, DYNAMIC_TYPE_OUT_BUFFER,
+                   ssl->buffers.outputBuffer.pooled);
     ssl->buffers.outputBuffer.dynamicFlag = 1;
+    ssl->buffers.outputBuffer.pooled      = pooled;
     if (align)
         ssl->buffers.outputBuffer.offset = align - hdrSz;
     else
         ssl->buffers.outputBuffer.offset = 0;
     ssl->buffers.outputBuffer.buffer = tmp;
-    ssl->buffers.outputBuffer.bufferSize = size +
-                                           ssl->buffers.outputBuffer.length; 
+    ssl->buffers.outputBuffer.bufferSize = tmpSz - align; /* all of it */
     return 0;
 }
 
@@ -2663,6 +3153,8 @@ static INLINE int GrowOutputBuffer(CYASSL* ssl, int size)
 int GrowInputBuffer(CYASSL* ssl, int size, int usedLength)
 {
     byte* tmp;
+    byte  pooled;
+    word32 tmpSz;
     byte  hdrSz = DTLS_RECORD_HEADER_SZ;
     byte  align = ssl->options.dtls ? CYASSL_GENERAL_ALIGNMENT : 0;
     /* the encrypted data will be offset from the front of the buffer by
@@ -2674,8 +3166,8 @@ int GrowInputBuffer(CYASSL* ssl, int size, int usedLength)
        while (align < hdrSz)
            align *= 2;
     }
-    tmp = (byte*) XMALLOC(size + usedLength + align, ssl->heap,
-                          DYNAMIC_TYPE_IN_BUFFER);
+    tmp = BufferAlloc(ssl, size + usedLength + align, DYNAMIC_TYPE_IN_BUFFER,
+                      &pooled, &tmpSz);
     CYASSL_MSG("growing input buffer\n");
    
     if (!tmp) return MEMORY_E;
@@ -2687,16 +3179,18 @@ int GrowInputBuffer(CYASSL* ssl, int size, int usedLength)
                     ssl->buffers.inputBuffer.idx, usedLength);
 
     if (ssl->buffers.inputBuffer.dynamicFlag)
-        XFREE(ssl->buffers.inputBuffer.buffer - ssl->buffers.inputBuffer.offset,
-              ssl->heap,DYNAMIC_TYPE_IN_BUFFER);
+        BufferFree(ssl, ssl->buffers.inputBuffer.buffer -
+                   ssl->buffers.inputBuffer.offset, DYNAMIC_TYPE_IN_BUFFER,
+                   ssl->buffers.inputBuffer.pooled);
 
     ssl->buffers.inputBuffer.dynamicFlag = 1;
+    ssl->buffers.inputBuffer.pooled      = pooled;
     if (align)
         ssl->buffers.inputBuffer.offset = align - hdrSz;
     else
         ssl->buffers.inputBuffer.offset = 0;
     ssl->buffers.inputBuffer.buffer = tmp;
-    ssl->buffers.inputBuffer.bufferSize = size + usedLength;
+    ssl->buffers.inputBuffer.bufferSize = tmpSz - align; /* all of it */
     ssl->buffers.inputBuffer.idx    = 0;
     ssl->buffers.inputBuffer.length = usedLength;
 
@@ -2868,17 +3362,17 @@ static void BuildMD5(CYASSL* ssl, Hashes* hashes, const byte* sender)
     byte md5_result[MD5_DIGEST_SIZE];
 
     /* make md5 inner */    
-    Md5Update(&ssl->hashMd5, sender, SIZEOF_SENDER);
-    Md5Update(&ssl->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
-    Md5Update(&ssl->hashMd5, PAD1, PAD_MD5);
-    Md5Final(&ssl->hashMd5, md5_result);
+    Md5Update(&ssl->hsHashes->hashMd5, sender, SIZEOF_SENDER);
+    Md5Update(&ssl->hsHashes->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
+    Md5Update(&ssl->hsHashes->hashMd5, PAD1, PAD_MD5);
+    Md5Final(&ssl->hsHashes->hashMd5, md5_result);
 
     /* make md5 outer */
-    Md5Update(&ssl->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
-    Md5Update(&ssl->hashMd5, PAD2, PAD_MD5);
-    Md5Update(&ssl->hashMd5, md5_result, MD5_DIGEST_SIZE);
+    Md5Update(&ssl->hsHashes->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
+    Md5Update(&ssl->hsHashes->hashMd5, PAD2, PAD_MD5);
+    Md5Update(&ssl->hsHashes->hashMd5, md5_result, MD5_DIGEST_SIZE);
 
-    Md5Final(&ssl->hashMd5, hashes->md5);
+    Md5Final(&ssl->hsHashes->hashMd5, hashes->md5);
 }
 
 
@@ -2888,38 +3382,32 @@ static void BuildSHA(CYASSL* ssl, Hashes* hashes, const byte* sender)
     byte sha_result[SHA_DIGEST_SIZE];
 
     /* make sha inner */
-    ShaUpdate(&ssl->hashSha, sender, SIZEOF_SENDER);
-    ShaUpdate(&ssl->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
-    ShaUpdate(&ssl->hashSha, PAD1, PAD_SHA);
-    ShaFinal(&ssl->hashSha, sha_result);
+    ShaUpdate(&ssl->hsHashes->hashSha, sender, SIZEOF_SENDER);
+    ShaUpdate(&ssl->hsHashes->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
+    ShaUpdate(&ssl->hsHashes->hashSha, PAD1, PAD_SHA);
+    ShaFinal(&ssl->hsHashes->hashSha, sha_result);
 
     /* make sha outer */
-    ShaUpdate(&ssl->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
-    ShaUpdate(&ssl->hashSha, PAD2, PAD_SHA);
-    ShaUpdate(&ssl->hashSha, sha_result, SHA_DIGEST_SIZE);
+    ShaUpdate(&ssl->hsHashes->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
+    ShaUpdate(&ssl->hsHashes->hashSha, PAD2, PAD_SHA);
+    ShaUpdate(&ssl->hsHashes->hashSha, sha_result, SHA_DIGEST_SIZE);
 
-    ShaFinal(&ssl->hashSha, hashes->sha);
+    ShaFinal(&ssl->hsHashes->hashSha, hashes->sha);
 }
 #endif
 
 
-static void BuildFinished(CYASSL* ssl, Hashes* hashes, const byte* sender)
+static int BuildFinished(CYASSL* ssl, Hashes* hashes, const byte* sender)
 {
+    HsHashes  saved;
+
+    /* no transcript left to finish, hashing zeros would be a bogus Finished */
+    if (ssl->hsHashes == NULL)
+        return NO_HANDSHAKE_HASHES_E;
+
     /* store current states, building requires get_digest which resets state */
-#ifndef NO_OLD_TLS
-#ifndef NO_MD5
-    Md5 md5 = ssl->hashMd5;
-#endif
-#ifndef NO_SHA
-    Sha sha = ssl->hashSha;
-#endif
-#endif
-#ifndef NO_SHA256
-    Sha256 sha256 = ssl->hashSha256;
-#endif
-#ifdef CYASSL_SHA384
-    Sha384 sha384 = ssl->hashSha384;
-#endif
+    StartHandshakeHashes(ssl);
+    saved = *ssl->hsHashes;
 
 #ifndef NO_TLS
     if (ssl->options.tls) {
@@ -2934,22 +3422,9 @@ static void BuildFinished(CYASSL* ssl, Hashes* hashes, const byte* sender)
 #endif
     
     /* restore */
-#ifndef NO_OLD_TLS
-    #ifndef NO_MD5
-        ssl->hashMd5 = md5;
-    #endif
-    #ifndef NO_SHA
-    ssl->hashSha = sha;
-    #endif
-#endif
-    if (IsAtLeastTLSv1_2(ssl)) {
-    #ifndef NO_SHA256
-        ssl->hashSha256 = sha256;
-    #endif
-    #ifdef CYASSL_SHA384
-        ssl->hashSha384 = sha384;
-    #endif
-    }
+    *ssl->hsHashes = saved;
+
+    return 0;
 }
 
 
@@ -3554,29 +4029,12 @@ static int DoCertificate(CYASSL* ssl, byte* input, word32* inOutIdx)
 
 static int DoHelloRequest(CYASSL* ssl, const byte* input, word32* inOutIdx)
 {
-    if (ssl->keys.encryptionOn) {
-        const byte* mac;
-        int         padSz = ssl->keys.encryptSz - HANDSHAKE_HEADER_SZ - 
-                            ssl->specs.hash_size;
-        byte        verify[MAX_DIGEST_SIZE];
-       
-        ssl->hmac(ssl, verify, input + *inOutIdx - HANDSHAKE_HEADER_SZ,
-                  HANDSHAKE_HEADER_SZ, handshake, 1);
-        /* read mac and fill */
-        mac = input + *inOutIdx;
-        *inOutIdx += ssl->specs.hash_size;
-
-        if (ssl->options.tls1_1 && ssl->specs.cipher_type == block)
-            padSz -= ssl->specs.block_size;
-
-        *inOutIdx += padSz;
+    (void)input;
 
-        /* verify */
-        if (XMEMCMP(mac, verify, ssl->specs.hash_size) != 0) {
-            CYASSL_MSG("    hello_request verify mac error");
-            return VERIFY_MAC_ERROR;
-        }
-    }
+    /* the record layer already checked the MAC, or the tag for AEAD suites
+       that have no record Hmac at all, just skip it and the padding */
+    if (ssl->keys.encryptionOn)
+        *inOutIdx += ssl->keys.padSz;
 
     if (ssl->options.side == CYASSL_SERVER_END) {
         SendAlert(ssl, alert_fatal, unexpected_message); /* try */
@@ -3645,7 +4103,9 @@ static int DoHandShakeMsgType(CYASSL* ssl, byte* input, word32* inOutIdx,
 
     CYASSL_ENTER("DoHandShakeMsgType");
 
-    HashInput(ssl, input + *inOutIdx, size);
+    ret = HashInput(ssl, input + *inOutIdx, size);
+    if (ret != 0)
+        return ret;
 #ifdef CYASSL_CALLBACKS
     /* add name later, add on record and handshake header part back on */
     if (ssl->toInfoOn) {
@@ -4374,7 +4834,7 @@ static INLINE void CompressRounds(CYASSL* ssl, int rounds, const byte* dummy)
 
 
 /* check all length bytes for equality, return 0 on success */
-static int ConstantCompare(const byte* a, const byte* b, int length)
+int ConstantCompare(const byte* a, const byte* b, int length)
 {
     int i;
     int good = 0;
@@ -4483,6 +4943,95 @@ static int TimingPadVerify(CYASSL* ssl, const byte* input, int padLen, int t,
 }
 
 
+#ifdef BUILD_AES_CBC_HMAC
+
+/* AES-CBC under the TLS MAC takes the stitched MAC and cipher path */
+static INLINE int UseAesCbcHmac(CYASSL* ssl)
+{
+    return ssl->specs.bulk_cipher_algorithm == cyassl_aes &&
+           ssl->hmac == TLS_hmac;
+}
+
+
+/* Decrypt() and VerifyMac() for a TLS AES-CBC record in one pass, input is
+   the whole record including any explicit IV. The padding is decrypted aside
+   first so the MAC length is known, then the record is decrypted stitched
+   with the MAC. Checks and timing follow TimingPadVerify(). */
+static int DecryptVerifyAesCbc(CYASSL* ssl, byte* input, word32 sz,
+                               int content, word32* padSz)
+{
+    Aes*   aes     = ssl->decrypt.aes;
+    word32 ivExtra = ssl->options.tls1_1 ? ssl->specs.block_size : 0;
+    word32 tailSz  = min(sz, MAX_PAD_SIZE);
+    byte*  plain   = input + ivExtra;
+    int    t       = ssl->specs.hash_size;
+    int    pLen    = (int)(sz - ivExtra);
+    int    padLen;
+    int    macSz;
+    int    ret;
+    int    verifyRet = 0;
+    byte   iv[AES_BLOCK_SIZE];
+    byte   tail[MAX_PAD_SIZE];
+    byte   verify[MAX_DIGEST_SIZE];
+    byte   dummy[MAX_PAD_SIZE];
+
+    if (ssl->decrypt.setup == 0) {
+        CYASSL_MSG("Decrypt ciphers not setup");
+        return DECRYPT_ERROR;
+    }
+
+    /* padding is within the last MAX_PAD_SIZE bytes, chain stays put */
+    XMEMCPY(iv, aes->reg, AES_BLOCK_SIZE);
+    if (sz > tailSz)
+        AesSetIV(aes, input + sz - tailSz - AES_BLOCK_SIZE);
+    ret = AesCbcDecrypt(aes, tail, input + sz - tailSz, tailSz);
+    AesSetIV(aes, iv);
+    if (ret != 0)
+        return ret;
+
+    padLen = tail[tailSz - 1];
+    XMEMSET(dummy, 1, sizeof(dummy));
+
+    if ( (t + padLen + 1) > pLen) {
+        CYASSL_MSG("Plain Len not long enough for pad/mac");
+        PadCheck(dummy, (byte)padLen, MAX_PAD_SIZE);
+        macSz = pLen - t;
+        verifyRet = VERIFY_MAC_ERROR;
+    }
+    else if (PadCheck(tail + tailSz - (padLen + 1), (byte)padLen,
+                      padLen + 1) != 0) {
+        CYASSL_MSG("PadCheck failed");
+        PadCheck(dummy, (byte)padLen, MAX_PAD_SIZE - padLen - 1);
+        macSz = pLen - t;
+        verifyRet = VERIFY_MAC_ERROR;
+    }
+    else {
+        PadCheck(dummy, (byte)padLen, MAX_PAD_SIZE - padLen - 1);
+        macSz = pLen - padLen - 1 - t;
+    }
+
+    ret = TLS_hmacAesCbcDecrypt(ssl, verify, plain, macSz, content, input, sz);
+    if (ret != 0)
+        return ret;
+
+    if (verifyRet == 0)
+        CompressRounds(ssl, GetRounds(pLen, padLen, t), dummy);
+
+    if (ConstantCompare(verify, plain + macSz, t) != 0 && verifyRet == 0) {
+        CYASSL_MSG("Verify MAC compare failed");
+        verifyRet = VERIFY_MAC_ERROR;
+    }
+    if (verifyRet != 0)
+        return verifyRet;
+
+    *padSz = t + padLen + 1;
+
+    return 0;
+}
+
+#endif /* BUILD_AES_CBC_HMAC */
+
+
 int DoApplicationData(CYASSL* ssl, byte* input, word32* inOutIdx)
 {
     word32 msgSz   = ssl->keys.encryptSz;
@@ -4587,6 +5136,7 @@ static int GetInputData(CYASSL *ssl, word32 size)
     int maxLength;
     int usedLength;
     int dtlsExtra = 0;
+    int readAhead = ssl->options.readAhead && !ssl->options.dtls;
 
     
     /* check max input length */
@@ -4594,6 +5144,18 @@ static int GetInputData(CYASSL *ssl, word32 size)
     maxLength  = ssl->buffers.inputBuffer.bufferSize - usedLength;
     inSz       = (int)(size - usedLength);      /* from last partial read */
 
+    /* an earlier read ahead may already have it all */
+    if (readAhead && usedLength >= (int)size)
+        return 0;
+
+    /* reading ahead wants room for a full record whatever size asks for */
+    if (readAhead && size < READ_AHEAD_SZ &&
+                    ssl->buffers.inputBuffer.bufferSize < READ_AHEAD_SZ) {
+        if (GrowInputBuffer(ssl, READ_AHEAD_SZ, usedLength) < 0)
+            return MEMORY_E;
+        maxLength = ssl->buffers.inputBuffer.bufferSize - usedLength;
+    }
+
 #ifdef CYASSL_DTLS
     if (ssl->options.dtls) {
         if (size < ssl->dtls_expected_rx)
@@ -4619,6 +5181,10 @@ static int GetInputData(CYASSL *ssl, word32 size)
     /* remove processed data */
     ssl->buffers.inputBuffer.idx    = 0;
     ssl->buffers.inputBuffer.length = usedLength;
+
+    /* take whatever fits, later records get parsed straight from the buffer */
+    if (readAhead)
+        inSz = (int)(ssl->buffers.inputBuffer.bufferSize - usedLength);
   
     /* read data from network */
     do {
@@ -4861,6 +5427,18 @@ int ProcessReply(CYASSL* ssl)
                         ssl->buffers.inputBuffer.idx += AEAD_EXP_IV_SZ;
                 #endif /* ATOMIC_USER */
                 }
+            #ifdef BUILD_AES_CBC_HMAC
+                else if (ssl->options.tls && UseAesCbcHmac(ssl)) {
+                    ret = DecryptVerifyAesCbc(ssl,
+                                  ssl->buffers.inputBuffer.buffer +
+                                  ssl->buffers.inputBuffer.idx,
+                                  ssl->curSize, ssl->curRL.type,
+                                  &ssl->keys.padSz);
+                    if (ssl->options.tls1_1)
+                        ssl->buffers.inputBuffer.idx += ssl->specs.block_size;
+                        /* go past TLSv1.1 IV */
+                }
+            #endif
                 else {
                     ret = Decrypt(ssl, ssl->buffers.inputBuffer.buffer + 
                                   ssl->buffers.inputBuffer.idx,
@@ -4960,11 +5538,17 @@ int ProcessReply(CYASSL* ssl)
                                 return ret;
                     #endif
                     if (ssl->options.resuming && ssl->options.side ==
-                                                              CYASSL_CLIENT_END)
-                        BuildFinished(ssl, &ssl->verifyHashes, server);
+                                                            CYASSL_CLIENT_END) {
+                        ret = BuildFinished(ssl, &ssl->verifyHashes, server);
+                        if (ret != 0)
+                            return ret;
+                    }
                     else if (!ssl->options.resuming && ssl->options.side ==
-                                                              CYASSL_SERVER_END)
-                        BuildFinished(ssl, &ssl->verifyHashes, client);
+                                                            CYASSL_SERVER_END) {
+                        ret = BuildFinished(ssl, &ssl->verifyHashes, client);
+                        if (ret != 0)
+                            return ret;
+                    }
                     break;
 
                 case application_data:
@@ -5021,6 +5605,11 @@ int ProcessReply(CYASSL* ssl)
             /* more records */
             else {
                 CYASSL_MSG("More records in input");
+                /* hand app data over before the next record reuses the
+                   buffer, the rest stays read ahead for the next call */
+                if (ssl->options.readAhead && !ssl->options.dtls &&
+                               ssl->buffers.clearOutputBuffer.length > 0)
+                    return 0;
                 ssl->options.processReply = doProcessInit;
                 continue;
             }
@@ -5087,20 +5676,54 @@ int SendChangeCipher(CYASSL* ssl)
 
 
 #ifndef NO_OLD_TLS
+/* start an SSLv3 MAC hash with the secret and pad hashed in */
+static void SslMacPads(CYASSL* ssl, Hash* hash, const byte* macSecret,
+                       const byte* pad)
+{
+    word32 digestSz = ssl->specs.hash_size;
+    word32 padSz    = ssl->specs.pad_size;
+
+    if (ssl->specs.mac_algorithm == md5_mac) {
+        InitMd5(&hash->md5);
+        Md5Update(&hash->md5, macSecret, digestSz);
+        Md5Update(&hash->md5, pad, padSz);
+    }
+    else {
+        InitSha(&hash->sha);
+        ShaUpdate(&hash->sha, macSecret, digestSz);
+        ShaUpdate(&hash->sha, pad, padSz);
+    }
+}
+
+
+/* SSLv3 MAC inner or outer hash start, copied from the states SetRecordMacs
+   made if we have them */
+static INLINE void SslMacStart(CYASSL* ssl, Hash* hash, int verify, int outer)
+{
+#ifdef HMAC_PAD_STATES
+    Hash* states = verify ? ssl->decrypt.sslMac : ssl->encrypt.sslMac;
+
+    if (states != NULL) {
+        XMEMCPY(hash, &states[outer], sizeof(Hash));
+        return;
+    }
+#endif
+    SslMacPads(ssl, hash, CyaSSL_GetMacSecret(ssl, verify),
+               outer ? PAD2 : PAD1);
+}
+
+
 static void SSL_hmac(CYASSL* ssl, byte* digest, const byte* in, word32 sz,
                  int content, int verify)
 {
     byte   result[MAX_DIGEST_SIZE];
     word32 digestSz = ssl->specs.hash_size;            /* actual sizes */
-    word32 padSz    = ssl->specs.pad_size;
 
-    Md5 md5;
-    Sha sha;
+    Hash hash;
 
     /* data */
     byte seq[SEQ_SZ];
     byte conLen[ENUM_LEN + LENGTH_SZ];     /* content & length */
-    const byte* macSecret = CyaSSL_GetMacSecret(ssl, verify);
     
     XMEMSET(seq, 0, SEQ_SZ);
     conLen[0] = (byte)content;
@@ -5108,36 +5731,30 @@ static void SSL_hmac(CYASSL* ssl, byte* digest, const byte* in, word32 sz,
     c32toa(GetSEQIncrement(ssl, verify), &seq[sizeof(word32)]);
 
     if (ssl->specs.mac_algorithm == md5_mac) {
-        InitMd5(&md5);
         /* inner */
-        Md5Update(&md5, macSecret, digestSz);
-        Md5Update(&md5, PAD1, padSz);
-        Md5Update(&md5, seq, SEQ_SZ);
-        Md5Update(&md5, conLen, sizeof(conLen));
+        SslMacStart(ssl, &hash, verify, 0);
+        Md5Update(&hash.md5, seq, SEQ_SZ);
+        Md5Update(&hash.md5, conLen, sizeof(conLen));
         /* in buffer */
-        Md5Update(&md5, in, sz);
-        Md5Final(&md5, result);
+        Md5Update(&hash.md5, in, sz);
+        Md5Final(&hash.md5, result);
         /* outer */
-        Md5Update(&md5, macSecret, digestSz);
-        Md5Update(&md5, PAD2, padSz);
-        Md5Update(&md5, result, digestSz);
-        Md5Final(&md5, digest);        
+        SslMacStart(ssl, &hash, verify, 1);
+        Md5Update(&hash.md5, result, digestSz);
+        Md5Final(&hash.md5, digest);        
     }
     else {
-        InitSha(&sha);
         /* inner */
-        ShaUpdate(&sha, macSecret, digestSz);
-        ShaUpdate(&sha, PAD1, padSz);
-        ShaUpdate(&sha, seq, SEQ_SZ);
-        ShaUpdate(&sha, conLen, sizeof(conLen));
+        SslMacStart(ssl, &hash, verify, 0);
+        ShaUpdate(&hash.sha, seq, SEQ_SZ);
+        ShaUpdate(&hash.sha, conLen, sizeof(conLen));
         /* in buffer */
-        ShaUpdate(&sha, in, sz);
-        ShaFinal(&sha, result);
+        ShaUpdate(&hash.sha, in, sz);
+        ShaFinal(&hash.sha, result);
         /* outer */
-        ShaUpdate(&sha, macSecret, digestSz);
-        ShaUpdate(&sha, PAD2, padSz);
-        ShaUpdate(&sha, result, digestSz);
-        ShaFinal(&sha, digest);        
+        SslMacStart(ssl, &hash, verify, 1);
+        ShaUpdate(&hash.sha, result, digestSz);
+        ShaFinal(&hash.sha, digest);        
     }
 }
 
@@ -5147,16 +5764,16 @@ static void BuildMD5_CertVerify(CYASSL* ssl, byte* digest)
     byte md5_result[MD5_DIGEST_SIZE];
 
     /* make md5 inner */
-    Md5Update(&ssl->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
-    Md5Update(&ssl->hashMd5, PAD1, PAD_MD5);
-    Md5Final(&ssl->hashMd5, md5_result);
+    Md5Update(&ssl->hsHashes->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
+    Md5Update(&ssl->hsHashes->hashMd5, PAD1, PAD_MD5);
+    Md5Final(&ssl->hsHashes->hashMd5, md5_result);
 
     /* make md5 outer */
-    Md5Update(&ssl->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
-    Md5Update(&ssl->hashMd5, PAD2, PAD_MD5);
-    Md5Update(&ssl->hashMd5, md5_result, MD5_DIGEST_SIZE);
+    Md5Update(&ssl->hsHashes->hashMd5, ssl->arrays->masterSecret, SECRET_LEN);
+    Md5Update(&ssl->hsHashes->hashMd5, PAD2, PAD_MD5);
+    Md5Update(&ssl->hsHashes->hashMd5, md5_result, MD5_DIGEST_SIZE);
 
-    Md5Final(&ssl->hashMd5, digest);
+    Md5Final(&ssl->hsHashes->hashMd5, digest);
 }
 
 
@@ -5165,69 +5782,115 @@ static void BuildSHA_CertVerify(CYASSL* ssl, byte* digest)
     byte sha_result[SHA_DIGEST_SIZE];
     
     /* make sha inner */
-    ShaUpdate(&ssl->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
-    ShaUpdate(&ssl->hashSha, PAD1, PAD_SHA);
-    ShaFinal(&ssl->hashSha, sha_result);
+    ShaUpdate(&ssl->hsHashes->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
+    ShaUpdate(&ssl->hsHashes->hashSha, PAD1, PAD_SHA);
+    ShaFinal(&ssl->hsHashes->hashSha, sha_result);
 
     /* make sha outer */
-    ShaUpdate(&ssl->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
-    ShaUpdate(&ssl->hashSha, PAD2, PAD_SHA);
-    ShaUpdate(&ssl->hashSha, sha_result, SHA_DIGEST_SIZE);
+    ShaUpdate(&ssl->hsHashes->hashSha, ssl->arrays->masterSecret, SECRET_LEN);
+    ShaUpdate(&ssl->hsHashes->hashSha, PAD2, PAD_SHA);
+    ShaUpdate(&ssl->hsHashes->hashSha, sha_result, SHA_DIGEST_SIZE);
 
-    ShaFinal(&ssl->hashSha, digest);
+    ShaFinal(&ssl->hsHashes->hashSha, digest);
 }
 #endif /* NO_CERTS */
 #endif /* NO_OLD_TLS */
 
 
+/* Hash the MAC secrets into each direction's record MAC once the keys are
+   stored, records then start from copies instead of the secret */
+int SetRecordMacs(CYASSL* ssl)
+{
+    Ciphers* ciphers[2];
+    int      i;
+
+    if (ssl->specs.cipher_type == aead)
+        return 0;
+
+    ciphers[0] = &ssl->encrypt;
+    ciphers[1] = &ssl->decrypt;
+
+    for (i = 0; i < 2; i++) {
+        const byte* macSecret = CyaSSL_GetMacSecret(ssl, i);
+
+#ifndef NO_TLS
+        if (ssl->hmac == TLS_hmac) {
+            int ret;
+
+            if (ciphers[i]->hmac == NULL)
+                ciphers[i]->hmac = (Hmac*)XMALLOC(sizeof(Hmac), ssl->heap,
+                                                  DYNAMIC_TYPE_CIPHER);
+            if (ciphers[i]->hmac == NULL)
+                return MEMORY_E;
+
+            ret = HmacSetKey(ciphers[i]->hmac, CyaSSL_GetHmacType(ssl),
+                             macSecret, ssl->specs.hash_size);
+            if (ret != 0)
+                return ret;
+            continue;
+        }
+#endif
+#if !defined(NO_OLD_TLS) && defined(HMAC_PAD_STATES)
+        if (ciphers[i]->sslMac == NULL)
+            ciphers[i]->sslMac = (Hash*)XMALLOC(sizeof(Hash) * 2, ssl->heap,
+                                                DYNAMIC_TYPE_CIPHER);
+        if (ciphers[i]->sslMac == NULL)
+            return MEMORY_E;
+
+        SslMacPads(ssl, &ciphers[i]->sslMac[0], macSecret, PAD1);
+        SslMacPads(ssl, &ciphers[i]->sslMac[1], macSecret, PAD2);
+#endif
+        (void)macSecret;
+    }
+
+    return 0;
+}
+
+
 #ifndef NO_CERTS
 
-static void BuildCertHashes(CYASSL* ssl, Hashes* hashes)
+static int BuildCertHashes(CYASSL* ssl, Hashes* hashes)
 {
+    HsHashes* hs = ssl->hsHashes;
+    HsHashes  saved;
+
+    if (hs == NULL)
+        return NO_HANDSHAKE_HASHES_E;
+
+    /* digests of hashes not picked for this handshake stay zero */
+    XMEMSET(hashes, 0, sizeof(Hashes));
+
     /* store current states, building requires get_digest which resets state */
-    #ifndef NO_OLD_TLS
-    Md5 md5 = ssl->hashMd5;
-    Sha sha = ssl->hashSha;
-    #endif
-    #ifndef NO_SHA256
-        Sha256 sha256 = ssl->hashSha256;
-    #endif
-    #ifdef CYASSL_SHA384
-        Sha384 sha384 = ssl->hashSha384;
-    #endif
-    
+    StartHandshakeHashes(ssl);
+    saved = *hs;
+
     if (ssl->options.tls) {
 #if ! defined( NO_OLD_TLS )
-        Md5Final(&ssl->hashMd5, hashes->md5);
-        ShaFinal(&ssl->hashSha, hashes->sha);
+        if (hs->running & HS_HASH_MD5)
+            Md5Final(&hs->hashMd5, hashes->md5);
+        if (hs->running & HS_HASH_SHA)
+            ShaFinal(&hs->hashSha, hashes->sha);
 #endif
-        if (IsAtLeastTLSv1_2(ssl)) {
-            #ifndef NO_SHA256
-                Sha256Final(&ssl->hashSha256, hashes->sha256);
-            #endif
-            #ifdef CYASSL_SHA384
-                Sha384Final(&ssl->hashSha384, hashes->sha384);
-            #endif
-        }
+        #ifndef NO_SHA256
+            if (hs->running & HS_HASH_SHA256)
+                Sha256Final(&hs->hashSha256, hashes->sha256);
+        #endif
+        #ifdef CYASSL_SHA384
+            if (hs->running & HS_HASH_SHA384)
+                Sha384Final(&hs->hashSha384, hashes->sha384);
+        #endif
     }
 #if ! defined( NO_OLD_TLS )
     else {
         BuildMD5_CertVerify(ssl, hashes->md5);
         BuildSHA_CertVerify(ssl, hashes->sha);
     }
-    
-    /* restore */
-    ssl->hashMd5 = md5;
-    ssl->hashSha = sha;
 #endif
-    if (IsAtLeastTLSv1_2(ssl)) {
-        #ifndef NO_SHA256
-            ssl->hashSha256 = sha256;
-        #endif
-        #ifdef CYASSL_SHA384
-            ssl->hashSha384 = sha384;
-        #endif
-    }
+
+    /* restore */
+    *hs = saved;
+
+    return 0;
 }
 
 #endif /* CYASSL_LEANPSK */
@@ -5288,11 +5951,14 @@ static int BuildMessage(CYASSL* ssl, byte* output, const byte* input, int inSz,
         XMEMCPY(output + idx, iv, min(ivSz, sizeof(iv)));
         idx += ivSz;
     }
-    XMEMCPY(output + idx, input, inSz);
+    if (input != output + idx)    /* caller may have built it in place */
+        XMEMCPY(output + idx, input, inSz);
     idx += inSz;
 
     if (type == handshake) {
-        HashOutput(ssl, output, headerSz + inSz, ivSz);
+        ret = HashOutput(ssl, output, headerSz + inSz, ivSz);
+        if (ret != 0)
+            return ret;
     }
 
     if (ssl->specs.cipher_type == block) {
@@ -5311,6 +5977,19 @@ static int BuildMessage(CYASSL* ssl, byte* output, const byte* input, int inSz,
             return ret;
 #endif
     }
+#ifdef BUILD_AES_CBC_HMAC
+    else if (UseAesCbcHmac(ssl)) {
+        if (ssl->encrypt.setup == 0) {
+            CYASSL_MSG("Encrypt ciphers not setup");
+            return ENCRYPT_ERROR;
+        }
+        ret = TLS_hmacAesCbcEncrypt(ssl, output + idx,
+                                    output + headerSz + ivSz, inSz, type,
+                                    output + headerSz, size);
+        if (ret != 0)
+            return ret;
+    }
+#endif
     else {  
         if (ssl->specs.cipher_type != aead)
             ssl->hmac(ssl, output+idx, output + headerSz + ivSz, inSz, type, 0);
@@ -5362,8 +6041,10 @@ int SendFinished(CYASSL* ssl)
 
     /* make finished hashes */
     hashes = (Hashes*)&input[headerSz];
-    BuildFinished(ssl, hashes, ssl->options.side == CYASSL_CLIENT_END ? client :
-                  server);
+    ret = BuildFinished(ssl, hashes, ssl->options.side == CYASSL_CLIENT_END ?
+                        client : server);
+    if (ret != 0)
+        return ret;
 
     sendSz = BuildMessage(ssl, output, input, headerSz + finishedSz, handshake);
 
@@ -5382,7 +6063,8 @@ int SendFinished(CYASSL* ssl)
         AddSession(ssl);    /* just try */
 #endif
         if (ssl->options.side == CYASSL_CLIENT_END) {
-            BuildFinished(ssl, &ssl->verifyHashes, server);
+            if ((ret = BuildFinished(ssl, &ssl->verifyHashes, server)) != 0)
+                return ret;
         }
         else {
             ssl->options.handShakeState = HANDSHAKE_DONE;
@@ -5409,7 +6091,8 @@ int SendFinished(CYASSL* ssl)
             #endif
         }
         else {
-            BuildFinished(ssl, &ssl->verifyHashes, client);
+            if ((ret = BuildFinished(ssl, &ssl->verifyHashes, client)) != 0)
+                return ret;
         }
     }
     #ifdef CYASSL_DTLS
@@ -5502,7 +6185,9 @@ int SendCertificate(CYASSL* ssl)
                 return ret;
         }
     #endif
-    HashOutput(ssl, output, sendSz, 0);
+    ret = HashOutput(ssl, output, sendSz, 0);
+    if (ret != 0)
+        return ret;
     #ifdef CYASSL_CALLBACKS
         if (ssl->hsInfoOn) AddPacketName("Certificate", &ssl->handShakeInfo);
         if (ssl->toInfoOn)
@@ -5578,7 +6263,9 @@ int SendCertificateRequest(CYASSL* ssl)
                 return ret;
         }
     #endif
-    HashOutput(ssl, output, sendSz, 0);
+    ret = HashOutput(ssl, output, sendSz, 0);
+    if (ret != 0)
+        return ret;
 
     #ifdef CYASSL_CALLBACKS
         if (ssl->hsInfoOn)
@@ -5601,6 +6288,9 @@ int SendData(CYASSL* ssl, const void* data, int sz)
     int sent = 0,  /* plainText size */
         sendSz,
         ret;
+    int batchSz = 0;   /* plainText size built but not yet sent */
+    int records = 0;   /* records built but not yet sent */
+    int maxRecords = MAX_SEND_RECORDS;
 
     if (ssl->error == WANT_WRITE)
         ssl->error = 0;
@@ -5625,18 +6315,28 @@ int SendData(CYASSL* ssl, const void* data, int sz)
             /* advance sent to previous sent + plain size just sent */
             sent = ssl->buffers.prevSent + ssl->buffers.plainSz;
             CYASSL_MSG("sent write buffered data");
+            if (sent > sz) {
+                CYASSL_MSG("Retried write shorter than the buffered one");
+                return ssl->error = BAD_FUNC_ARG;
+            }
         }
     }
 
+    /* datagrams and partial writes go out a record at a time */
+    if (ssl->options.dtls || ssl->options.partialWrite == 1)
+        maxRecords = 1;
+
     for (;;) {
 #ifdef HAVE_MAX_FRAGMENT
-        int   len = min(sz - sent, min(ssl->max_fragment, OUTPUT_RECORD_SIZE));
+        int   len = min(sz - sent - batchSz,
+                        min(ssl->max_fragment, OUTPUT_RECORD_SIZE));
 #else
-        int   len = min(sz - sent, OUTPUT_RECORD_SIZE);
+        int   len = min(sz - sent - batchSz, OUTPUT_RECORD_SIZE);
 #endif
         byte* out;
-        byte* sendBuffer = (byte*)data + sent;  /* may switch on comp */
+        byte* sendBuffer = (byte*)data + sent + batchSz; /* may switch on comp */
         int   buffSz = len;                       /* may switch on comp */
+        int   recSz;
 #ifdef HAVE_LIBZ
         byte  comp[MAX_RECORD_SIZE + MAX_COMP_EXTRA];
 #endif
@@ -5649,10 +6349,15 @@ int SendData(CYASSL* ssl, const void* data, int sz)
             buffSz = len;
         }
 #endif
+        recSz = len + COMP_EXTRA + MAX_MSG_EXTRA;
+
+        /* room for the whole batch up front, growing per record would copy
+           the records already built */
+        if (records == 0 && maxRecords > 1)
+            recSz *= min(maxRecords, (sz - sent + len - 1) / len);
 
         /* check for available size */
-        if ((ret = CheckAvailableSize(ssl, len + COMP_EXTRA +
-                                      MAX_MSG_EXTRA)) != 0)
+        if ((ret = CheckAvailableSize(ssl, recSz)) != 0)
             return ssl->error = ret;
 
         /* get ouput buffer */
@@ -5672,19 +6377,27 @@ int SendData(CYASSL* ssl, const void* data, int sz)
                               application_data);
 
         ssl->buffers.outputBuffer.length += sendSz;
+        batchSz += len;
+        records++;
+
+        /* keep building until the batch is full or the data runs out */
+        if (records < maxRecords && sent + batchSz < sz)
+            continue;
 
         if ( (ret = SendBuffered(ssl)) < 0) {
             CYASSL_ERROR(ret);
             /* store for next call if WANT_WRITE or user embedSend() that
                doesn't present like WANT_WRITE */
-            ssl->buffers.plainSz  = len;
+            ssl->buffers.plainSz  = batchSz;
             ssl->buffers.prevSent = sent;
             if (ret == SOCKET_ERROR_E && ssl->options.connReset)
                 return 0;  /* peer reset */
             return ssl->error = ret;
         }
 
-        sent += len;
+        sent   += batchSz;
+        batchSz = 0;
+        records = 0;
 
         /* only one message per attempt */
         if (ssl->options.partialWrite == 1) {
@@ -5696,13 +6409,143 @@ int SendData(CYASSL* ssl, const void* data, int sz)
     return sent;
 }
 
-/* process input data */
-int ReceiveData(CYASSL* ssl, byte* output, int sz, int peek)
+/* largest app data record SendData would build */
+static INLINE int MaxRecordData(CYASSL* ssl)
 {
-    int size;
+#ifdef HAVE_MAX_FRAGMENT
+    int len = min(ssl->max_fragment, OUTPUT_RECORD_SIZE);
+#else
+    int len = OUTPUT_RECORD_SIZE;
+#endif
 
-    CYASSL_ENTER("ReceiveData()");
+    (void)ssl;
+
+#ifdef CYASSL_DTLS
+    if (ssl->options.dtls)
+        len = min(len, MAX_UDP_SIZE);
+#endif
+
+    return len;
+}
+
+
+/* where BuildMessage puts the plaintext, past header and explicit IV */
+static INLINE word32 RecordDataOffset(CYASSL* ssl)
+{
+    word32 offset = RECORD_HEADER_SZ;
+
+#ifdef CYASSL_DTLS
+    if (ssl->options.dtls)
+        offset += DTLS_RECORD_EXTRA;
+#endif
+
+    if (ssl->specs.cipher_type == block && ssl->options.tls1_1)
+        offset += ssl->specs.block_size;
+#ifdef HAVE_AEAD
+    else if (ssl->specs.cipher_type == aead)
+        offset += AEAD_EXP_IV_SZ;
+#endif
+
+    return offset;
+}
+
+
+/* point data at room for one record of plaintext inside the output buffer,
+   CommitData() then seals it there, returns room size */
+int ReserveData(CYASSL* ssl, byte** data)
+{
+    int len;
+    int ret;
+
+    if (ssl->error == WANT_WRITE)
+        ssl->error = 0;
+
+    if (ssl->options.handShakeState != HANDSHAKE_DONE) {
+        int err;
+        CYASSL_MSG("handshake not complete, trying to finish");
+        if ( (err = CyaSSL_negotiate(ssl)) != SSL_SUCCESS) 
+            return  err;
+    }
+
+    /* last commit may still be queued, the room starts on an empty buffer */
+    if (ssl->buffers.outputBuffer.length > 0) {
+        CYASSL_MSG("output buffer was full, trying to send again");
+        if ( (ssl->error = SendBuffered(ssl)) < 0) {
+            CYASSL_ERROR(ssl->error);
+            return ssl->error;
+        }
+    }
+
+    len = MaxRecordData(ssl);
+
+    if ((ret = CheckAvailableSize(ssl, len + COMP_EXTRA + MAX_MSG_EXTRA)) != 0)
+        return ssl->error = ret;
+
+    *data = ssl->buffers.outputBuffer.buffer + RecordDataOffset(ssl);
+    ssl->buffers.reservedSz = len;
+
+    return len;
+}
+
+
+/* seal sz bytes the caller wrote into ReserveData() room and send them,
+   a record that can't go out yet stays queued for the next reserve */
+int CommitData(CYASSL* ssl, int sz)
+{
+    byte* out    = ssl->buffers.outputBuffer.buffer;
+    byte* input  = out + RecordDataOffset(ssl);
+    int   plainSz = sz;
+    int   sendSz;
+    int   ret;
+#ifdef HAVE_LIBZ
+    byte  comp[MAX_RECORD_SIZE + MAX_COMP_EXTRA];
+#endif
+
+    if (ssl->buffers.outputBuffer.length != 0 ||
+                                          sz > ssl->buffers.reservedSz) {
+        CYASSL_MSG("Commit without matching reserve");
+        return BAD_FUNC_ARG;
+    }
+    ssl->buffers.reservedSz = 0;
+
+    if (sz == 0)
+        return 0;
+
+#ifdef HAVE_LIBZ
+    if (ssl->options.usingCompression) {
+        sz = myCompress(ssl, input, sz, comp, sizeof(comp));
+        if (sz < 0)
+            return sz;
+        input = comp;
+    }
+#endif
+    sendSz = BuildMessage(ssl, out, input, sz, application_data);
+    if (sendSz < 0)
+        return ssl->error = sendSz;
+
+    ssl->buffers.outputBuffer.length += sendSz;
 
+    if ( (ret = SendBuffered(ssl)) < 0) {
+        if (ret == WANT_WRITE) {
+            /* queued record is all ours, the next SendData flushes it
+               before starting on its own data */
+            ssl->buffers.plainSz  = 0;
+            ssl->buffers.prevSent = 0;
+            return plainSz;
+        }
+        CYASSL_ERROR(ret);
+        if (ret == SOCKET_ERROR_E && ssl->options.connReset)
+            return 0;  /* peer reset */
+        return ssl->error = ret;
+    }
+
+    return plainSz;
+}
+
+
+/* process input until decrypted app data is ready, length or error */
+static int GetAppData(CYASSL* ssl)
+{
     if (ssl->error == WANT_READ)
         ssl->error = 0;
 
@@ -5729,27 +6572,61 @@ int ReceiveData(CYASSL* ssl, byte* output, int sz, int peek)
             return ssl->error;
         }
 
-    if (sz < (int)ssl->buffers.clearOutputBuffer.length)
+    return (int)ssl->buffers.clearOutputBuffer.length;
+}
+
+
+/* process input data */
+int ReceiveData(CYASSL* ssl, byte* output, int sz, int peek)
+{
+    int size;
+
+    CYASSL_ENTER("ReceiveData()");
+
+    if ( (size = GetAppData(ssl)) <= 0)
+        return size;
+
+    if (sz < size)
         size = sz;
-    else
-        size = ssl->buffers.clearOutputBuffer.length;
 
     XMEMCPY(output, ssl->buffers.clearOutputBuffer.buffer, size);
 
-    if (peek == 0) {
-        ssl->buffers.clearOutputBuffer.length -= size;
-        ssl->buffers.clearOutputBuffer.buffer += size;
-    }
-   
-    if (ssl->buffers.clearOutputBuffer.length == 0 && 
-                                           ssl->buffers.inputBuffer.dynamicFlag)
-       ShrinkInputBuffer(ssl, NO_FORCED_FREE);
+    if (peek == 0)
+        ConsumeData(ssl, size);
 
     CYASSL_LEAVE("ReceiveData()", size);
     return size;
 }
 
 
+/* point data at decrypted app data still in the input buffer, stays put
+   until ConsumeData() releases it */
+int ReceiveDataZc(CYASSL* ssl, const byte** data)
+{
+    int size;
+
+    CYASSL_ENTER("ReceiveDataZc()");
+
+    if ( (size = GetAppData(ssl)) > 0)
+        *data = ssl->buffers.clearOutputBuffer.buffer;
+
+    CYASSL_LEAVE("ReceiveDataZc()", size);
+    return size;
+}
+
+
+/* done with sz bytes of app data, input buffer can move once it's all gone */
+void ConsumeData(CYASSL* ssl, int sz)
+{
+    ssl->buffers.clearOutputBuffer.length -= sz;
+    ssl->buffers.clearOutputBuffer.buffer += sz;
+
+    if (ssl->buffers.clearOutputBuffer.length == 0 && 
+                                           ssl->buffers.inputBuffer.dynamicFlag)
+       ShrinkInputBuffer(ssl, NO_FORCED_FREE);
+}
+
+
 /* send alert message */
 int SendAlert(CYASSL* ssl, int severity, int type)
 {
@@ -6175,6 +7052,14 @@ void SetErrorString(int error, char* str)
         XSTRNCPY(str, "Unrecognized host name Error", max);
         break;
 
+    case SESSION_TICKET_E:
+        XSTRNCPY(str, "Session ticket unusable Error", max);
+        break;
+
+    case NO_HANDSHAKE_HASHES_E:
+        XSTRNCPY(str, "Handshake transcript gone Error", max);
+        break;
+
     default :
         XSTRNCPY(str, "unknown error number", max);
     }
@@ -7229,7 +8114,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                     return ret;
             }
         #endif
-        HashOutput(ssl, output, sendSz, 0);
+        ret = HashOutput(ssl, output, sendSz, 0);
+        if (ret != 0)
+            return ret;
 
         ssl->options.clientState = CLIENT_HELLO_COMPLETE;
 
@@ -8034,7 +8921,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                         return ret;
                 }
             #endif
-            HashOutput(ssl, output, sendSz, 0);
+            ret = HashOutput(ssl, output, sendSz, 0);
+            if (ret != 0)
+                return ret;
 
             #ifdef CYASSL_CALLBACKS
                 if (ssl->hsInfoOn)
@@ -8074,10 +8963,12 @@ static void PickHashSigAlgo(CYASSL* ssl,
         word32             sigOutSz = 0;
 #ifndef NO_RSA
         RsaKey             key;
+        RsaKey*            rsaKey = NULL;
 #endif
         int                usingEcc = 0;
 #ifdef HAVE_ECC
         ecc_key            eccKey;
+        ecc_key*           eccSignKey = NULL;
 #endif
 
         (void)idx;
@@ -8093,26 +8984,24 @@ static void PickHashSigAlgo(CYASSL* ssl,
         output = ssl->buffers.outputBuffer.buffer +
                  ssl->buffers.outputBuffer.length;
 
-        BuildCertHashes(ssl, &ssl->certHashes);
+        if ((ret = BuildCertHashes(ssl, &ssl->certHashes)) != 0)
+            return ret;
 
 #ifdef HAVE_ECC
         ecc_init(&eccKey);
 #endif
 #ifndef NO_RSA
         InitRsaKey(&key, ssl->heap);
-        ret = RsaPrivateKeyDecode(ssl->buffers.key.buffer, &idx, &key,
-                                  ssl->buffers.key.length);
+        ret = GetRsaPrivateKey(ssl, &key, &rsaKey);
         if (ret == 0)
-            sigOutSz = RsaEncryptSize(&key);
+            sigOutSz = RsaEncryptSize(rsaKey);
         else 
 #endif
         {
     #ifdef HAVE_ECC
             CYASSL_MSG("Trying ECC client cert, RSA didn't work");
            
-            idx = 0; 
-            ret = EccPrivateKeyDecode(ssl->buffers.key.buffer, &idx, &eccKey,
-                                      ssl->buffers.key.length);
+            ret = GetEccPrivateKey(ssl, &eccKey, &eccSignKey);
             if (ret == 0) {
                 CYASSL_MSG("Using ECC client cert");
                 usingEcc = 1;
@@ -8207,7 +9096,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
                 }
                 else {
                     ret = ecc_sign_hash(digest, digestSz, encodedSig,
-                                        &localSz, ssl->rng, &eccKey);
+                                        &localSz, ssl->rng, eccSignKey);
                 }
                 if (ret == 0) {
                     length = localSz;
@@ -8278,7 +9167,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
                 }
                 else {
                     ret = RsaSSL_Sign(signBuffer, signSz, verify + extraSz +
-                                  VERIFY_HEADER, ENCRYPT_LEN, &key, ssl->rng);
+                                  VERIFY_HEADER, ENCRYPT_LEN, rsaKey, ssl->rng);
                 }
 
                 if (ret > 0)
@@ -8298,7 +9187,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                             return ret;
                     }
                 #endif
-                HashOutput(ssl, output, sendSz, 0);
+                ret = HashOutput(ssl, output, sendSz, 0);
+                if (ret != 0)
+                    return ret;
             }
         }
 #ifndef NO_RSA
@@ -8416,7 +9307,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                     return ret;
             }
         #endif
-        HashOutput(ssl, output, sendSz, 0);
+        ret = HashOutput(ssl, output, sendSz, 0);
+        if (ret != 0)
+            return ret;
 
         #ifdef CYASSL_CALLBACKS
             if (ssl->hsInfoOn)
@@ -8500,7 +9393,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
             idx += HINT_LEN_SZ;
             XMEMCPY(output + idx, ssl->arrays->server_hint,length -HINT_LEN_SZ);
 
-            HashOutput(ssl, output, sendSz, 0);
+            ret = HashOutput(ssl, output, sendSz, 0);
+            if (ret != 0)
+                return ret;
 
             #ifdef CYASSL_CALLBACKS
                 if (ssl->hsInfoOn)
@@ -8531,8 +9426,10 @@ static void PickHashSigAlgo(CYASSL* ssl,
             word32   preSigSz, preSigIdx;
 #ifndef NO_RSA
             RsaKey   rsaKey;
+            RsaKey*  rsaSigKey = NULL;
 #endif
             ecc_key  dsaKey;
+            ecc_key* eccSigKey = NULL;
 
             if (ssl->specs.static_ecdh) {
                 CYASSL_MSG("Using Static ECDH, not sending ServerKeyExchagne");
@@ -8569,20 +9466,16 @@ static void PickHashSigAlgo(CYASSL* ssl,
 #ifndef NO_RSA
             if (ssl->specs.sig_algo == rsa_sa_algo) {
                 /* rsa sig size */
-                word32 i = 0;
-                ret = RsaPrivateKeyDecode(ssl->buffers.key.buffer, &i,
-                                          &rsaKey, ssl->buffers.key.length);
+                ret = GetRsaPrivateKey(ssl, &rsaKey, &rsaSigKey);
                 if (ret != 0) return ret;
-                sigSz = RsaEncryptSize(&rsaKey); 
+                sigSz = RsaEncryptSize(rsaSigKey);
             } else 
 #endif
             if (ssl->specs.sig_algo == ecc_dsa_sa_algo) {
                 /* ecdsa sig size */
-                word32 i = 0;
-                ret = EccPrivateKeyDecode(ssl->buffers.key.buffer, &i,
-                                          &dsaKey, ssl->buffers.key.length);
+                ret = GetEccPrivateKey(ssl, &dsaKey, &eccSigKey);
                 if (ret != 0) return ret;
-                sigSz = ecc_sig_size(&dsaKey);  /* worst case estimate */
+                sigSz = ecc_sig_size(eccSigKey);  /* worst case estimate */
             }
             else {
 #ifndef NO_RSA
@@ -8736,7 +9629,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
                     }
                     else {
                         ret = RsaSSL_Sign(signBuffer, signSz, output + idx,
-                                          sigSz, &rsaKey, ssl->rng);
+                                          sigSz, rsaSigKey, ssl->rng);
                         if (ret > 0)
                             ret = 0; /* reset on success */
                     }
@@ -8798,7 +9691,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
                     }
                     else {
                         ret = ecc_sign_hash(digest, digestSz,
-                              output + LENGTH_SZ + idx, &sz, ssl->rng, &dsaKey);
+                              output + LENGTH_SZ + idx, &sz, ssl->rng, eccSigKey);
                     }
 #ifndef NO_RSA
                     FreeRsaKey(&rsaKey);
@@ -8816,7 +9709,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
             }
 
             AddHeaders(output, length, server_key_exchange, ssl);
-            HashOutput(ssl, output, sendSz, 0);
+            ret = HashOutput(ssl, output, sendSz, 0);
+            if (ret != 0)
+                return ret;
 
             #ifdef CYASSL_CALLBACKS
                 if (ssl->hsInfoOn)
@@ -8840,9 +9735,10 @@ static void PickHashSigAlgo(CYASSL* ssl,
             byte    *output;
             word32   length = 0, idx = RECORD_HEADER_SZ + HANDSHAKE_HEADER_SZ;
             int      sendSz;
-            word32   sigSz = 0, i = 0;
+            word32   sigSz = 0;
             word32   preSigSz = 0, preSigIdx = 0;
             RsaKey   rsaKey;
+            RsaKey*  rsaSigKey = NULL;
             DhKey    dhKey;
             
             if (ssl->buffers.serverDH_P.buffer == NULL ||
@@ -8894,10 +9790,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                 if (!ssl->buffers.key.buffer)
                     return NO_PRIVATE_KEY;
 
-                ret = RsaPrivateKeyDecode(ssl->buffers.key.buffer, &i, &rsaKey,
-                                          ssl->buffers.key.length);
+                ret = GetRsaPrivateKey(ssl, &rsaKey, &rsaSigKey);
                 if (ret == 0) {
-                    sigSz = RsaEncryptSize(&rsaKey);
+                    sigSz = RsaEncryptSize(rsaSigKey);
                     length += sigSz;
                 }
             }
@@ -9056,7 +9951,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
                     }
                     else {
                         ret = RsaSSL_Sign(signBuffer, signSz, output + idx,
-                                          sigSz, &rsaKey, ssl->rng);
+                                          sigSz, rsaSigKey, ssl->rng);
                     }
                     FreeRsaKey(&rsaKey);
                     if (ret < 0)
@@ -9071,7 +9966,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                         return ret;
                 }
             #endif
-            HashOutput(ssl, output, sendSz, 0);
+            ret = HashOutput(ssl, output, sendSz, 0);
+            if (ret != 0)
+                return ret;
 
             #ifdef CYASSL_CALLBACKS
                 if (ssl->hsInfoOn)
@@ -9640,6 +10537,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
         word16          i, j;
         ProtocolVersion pv;
         Suites          clSuites;
+        int             ret;
 
         (void)inSz;
         CYASSL_MSG("Got old format client hello");
@@ -9651,18 +10549,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
 #endif
 
         /* manually hash input since different format */
-#ifndef NO_OLD_TLS
-#ifndef NO_MD5
-        Md5Update(&ssl->hashMd5, input + idx, sz);
-#endif
-#ifndef NO_SHA
-        ShaUpdate(&ssl->hashSha, input + idx, sz);
-#endif
-#endif
-#ifndef NO_SHA256
-    if (IsAtLeastTLSv1_2(ssl))
-        Sha256Update(&ssl->hashSha256, input + idx, sz);
-#endif
+        ret = HashHandshake(ssl, input + idx, sz);
+        if (ret != 0)
+            return ret;
 
         /* does this value mean client_hello? */
         idx++;
@@ -9764,7 +10653,6 @@ static void PickHashSigAlgo(CYASSL* ssl,
         ssl->options.haveSessionId = 1;
         /* DoClientHello uses same resume code */
         if (ssl->options.resuming) {  /* let's try */
-            int ret = -1; 
             CYASSL_SESSION* session = GetSession(ssl,ssl->arrays->masterSecret);
             if (!session) {
                 CYASSL_MSG("Session lookup for resume failed");
@@ -9999,17 +10887,32 @@ static void PickHashSigAlgo(CYASSL* ssl,
         if (ssl->options.resuming && (!ssl->options.dtls ||
             ssl->options.acceptState == HELLO_VERIFY_SENT)) {  /* let's try */
             int ret = -1;            
-            CYASSL_SESSION* session = GetSession(ssl,ssl->arrays->masterSecret);
+            CYASSL_SESSION* session;
+            #ifdef HAVE_SESSION_TICKET
+                if (ssl->options.useTicket)
+                    session = &ssl->session;  /* state came from ticket */
+                else
+            #endif
+                    session = GetSession(ssl, ssl->arrays->masterSecret);
             if (!session) {
                 CYASSL_MSG("Session lookup for resume failed");
                 ssl->options.resuming = 0;
             } else {
+                #ifdef HAVE_SESSION_TICKET
+                    /* ticket parse already picked the original suite */
+                    if (ssl->options.useTicket) {
+                        if (SetCipherSpecs(ssl) != 0)
+                            return UNSUPPORTED_SUITE;
+                    }
+                    else
+                #endif
                 if (MatchSuite(ssl, &clSuites) < 0) {
                     CYASSL_MSG("Unsupported cipher suite, ClientHello");
                     return UNSUPPORTED_SUITE;
                 }
                 #ifdef SESSION_CERTS
-                    ssl->session = *session; /* restore session certs. */
+                    if (session != &ssl->session)
+                        ssl->session = *session; /* restore session certs. */
                 #endif
                 RNG_GenerateBlock(ssl->rng, ssl->arrays->serverRandom, RAN_LEN);
                 #ifdef NO_OLD_TLS
@@ -10191,6 +11094,69 @@ static void PickHashSigAlgo(CYASSL* ssl,
     }
 #endif /* !NO_RSA || HAVE_ECC */
 
+#ifdef HAVE_SESSION_TICKET
+    /* NewSessionTicket, sent right before the server's ChangeCipherSpec */
+    int SendTicket(CYASSL* ssl)
+    {
+        byte              *output;
+        word32             length = TICKET_HINT_SZ + OPAQUE16_LEN +
+                                    MAX_TICKET_SZ;
+        word32             idx    = RECORD_HEADER_SZ + HANDSHAKE_HEADER_SZ;
+        int                sendSz = length + RECORD_HEADER_SZ +
+                                    HANDSHAKE_HEADER_SZ;
+        int                ret;
+
+        #ifdef CYASSL_DTLS
+            if (ssl->options.dtls) {
+                idx    += DTLS_RECORD_EXTRA + DTLS_HANDSHAKE_EXTRA;
+                sendSz += DTLS_RECORD_EXTRA + DTLS_HANDSHAKE_EXTRA;
+            }
+        #endif
+        /* check for available size */
+        if ((ret = CheckAvailableSize(ssl, sendSz)) != 0)
+            return ret;
+
+        /* get ouput buffer */
+        output = ssl->buffers.outputBuffer.buffer +
+                 ssl->buffers.outputBuffer.length;
+
+        AddHeaders(output, length, session_ticket, ssl);
+
+        /* lifetime hint, then the opaque ticket */
+        c32toa(ssl->timeout, output + idx);
+        idx += TICKET_HINT_SZ;
+        c16toa(MAX_TICKET_SZ, output + idx);
+        idx += OPAQUE16_LEN;
+
+        if ((ret = CreateTicket(ssl, output + idx)) != 0)
+            return ret;
+
+        #ifdef CYASSL_DTLS
+            if (ssl->options.dtls) {
+                if ((ret = DtlsPoolSave(ssl, output, sendSz)) != 0)
+                    return ret;
+            }
+        #endif
+        ret = HashOutput(ssl, output, sendSz, 0);
+        if (ret != 0)
+            return ret;
+#ifdef CYASSL_CALLBACKS
+        if (ssl->hsInfoOn)
+            AddPacketName("SessionTicket", &ssl->handShakeInfo);
+        if (ssl->toInfoOn)
+            AddPacketInfo("SessionTicket", &ssl->timeoutInfo, output, sendSz,
+                          ssl->heap);
+#endif
+        ssl->buffers.outputBuffer.length += sendSz;
+
+        if (ssl->options.groupMessages)
+            return 0;
+        else
+            return SendBuffered(ssl);
+    }
+#endif /* HAVE_SESSION_TICKET */
+
+
     int SendServerHelloDone(CYASSL* ssl)
     {
         byte              *output;
@@ -10217,7 +11183,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                     return 0;
             }
         #endif
-        HashOutput(ssl, output, sendSz, 0);
+        ret = HashOutput(ssl, output, sendSz, 0);
+        if (ret != 0)
+            return ret;
 #ifdef CYASSL_CALLBACKS
         if (ssl->hsInfoOn)
             AddPacketName("ServerHelloDone", &ssl->handShakeInfo);
@@ -10264,7 +11232,9 @@ static void PickHashSigAlgo(CYASSL* ssl,
                                         ssl->IOCB_CookieCtx)) < 0)
             return ret;
 
-        HashOutput(ssl, output, sendSz, 0);
+        ret = HashOutput(ssl, output, sendSz, 0);
+        if (ret != 0)
+            return ret;
 #ifdef CYASSL_CALLBACKS
         if (ssl->hsInfoOn)
             AddPacketName("HelloVerifyRequest", &ssl->handShakeInfo);
@@ -10318,8 +11288,8 @@ static void PickHashSigAlgo(CYASSL* ssl,
         #ifndef NO_RSA
             case rsa_kea: 
             {
-                word32 idx = 0;
                 RsaKey key;
+                RsaKey* decKey = NULL;
                 byte*  tmp = 0;
                 byte   doUserRsa = 0;
 
@@ -10333,13 +11303,12 @@ static void PickHashSigAlgo(CYASSL* ssl,
                 InitRsaKey(&key, ssl->heap);
 
                 if (ssl->buffers.key.buffer)
-                    ret = RsaPrivateKeyDecode(ssl->buffers.key.buffer, &idx,
-                                             &key, ssl->buffers.key.length);
+                    ret = GetRsaPrivateKey(ssl, &key, &decKey);
                 else
                     return NO_PRIVATE_KEY;
 
                 if (ret == 0) {
-                    length = RsaEncryptSize(&key);
+                    length = RsaEncryptSize(decKey);
                     ssl->arrays->preMasterSz = SECRET_LEN;
 
                     if (ssl->options.tls) {
@@ -10373,7 +11342,8 @@ static void PickHashSigAlgo(CYASSL* ssl,
                         #endif /*HAVE_PK_CALLBACKS */
                     }
                     else {
-                        ret = RsaPrivateDecryptInline(tmp, length, &out, &key);
+                        ret = RsaPrivateDecryptInline_ex(tmp, length, &out,
+                                                         decKey, ssl->rng);
                     }
 
                     if (ret == SECRET_LEN) {
@@ -10483,14 +11453,13 @@ static void PickHashSigAlgo(CYASSL* ssl,
 
                 size = sizeof(ssl->arrays->preMasterSecret);
                 if (ssl->specs.static_ecdh) {
-                    ecc_key staticKey;
-                    word32 i = 0;
+                    ecc_key  staticKey;
+                    ecc_key* privKey = NULL;
 
                     ecc_init(&staticKey);
-                    ret = EccPrivateKeyDecode(ssl->buffers.key.buffer, &i,
-                                           &staticKey, ssl->buffers.key.length);
+                    ret = GetEccPrivateKey(ssl, &staticKey, &privKey);
                     if (ret == 0)
-                        ret = ecc_shared_secret(&staticKey, ssl->peerEccKey,
+                        ret = ecc_shared_secret(privKey, ssl->peerEccKey,
                                            ssl->arrays->preMasterSecret, &size);
                     ecc_free(&staticKey);
                 }
@@ -10549,7 +11518,7 @@ static void PickHashSigAlgo(CYASSL* ssl,
             ssl->options.clientState = CLIENT_KEYEXCHANGE_COMPLETE;
             #ifndef NO_CERTS
                 if (ssl->options.verifyPeer)
-                    BuildCertHashes(ssl, &ssl->certHashes);
+                    ret = BuildCertHashes(ssl, &ssl->certHashes);
             #endif
         }
 
@@ -1419,6 +1419,8 @@ int SetCipherSpecs(CYASSL* ssl)
         ssl->hmac = TLS_hmac;
 #endif
 
+    PickHandshakeHashes(ssl);
+
     return 0;
 }
 
@@ -1773,6 +1775,7 @@ static int SetKeys(Ciphers* enc, Ciphers* dec, Keys* keys, CipherSpecs* specs,
 int StoreKeys(CYASSL* ssl, const byte* keyData)
 {
     int sz, i = 0;
+    int ret;
     int devId = NO_CAVIUM_DEVICE;
 
 #ifdef HAVE_CAVIUM
@@ -1804,6 +1807,10 @@ int StoreKeys(CYASSL* ssl, const byte* keyData)
     }
 #endif
 
+    ret = SetRecordMacs(ssl);
+    if (ret != 0)
+        return ret;
+
     return SetKeys(&ssl->encrypt, &ssl->decrypt, &ssl->keys, &ssl->specs,
                    ssl->options.side, ssl->heap, devId);
 }
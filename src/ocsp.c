@@ -68,10 +68,13 @@ int CyaSSL_OCSP_Init(CYASSL_OCSP* ocsp)
     if (ocsp != NULL) {
         XMEMSET(ocsp, 0, sizeof(*ocsp));
         ocsp->useNonce = 1;
+        ocsp->cacheMax = OCSP_CACHE_SZ;
         #ifndef CYASSL_USER_IO
             ocsp->CBIOOcsp = EmbedOcspLookup;
             ocsp->CBIOOcspRespFree = EmbedOcspRespFree;
         #endif
+        if (InitMutex(&ocsp->ocspLock) != 0)
+            return -1;
         return 0;
     }
 
@@ -81,29 +84,34 @@ int CyaSSL_OCSP_Init(CYASSL_OCSP* ocsp)
 
 static void FreeOCSP_Entry(OCSP_Entry* ocspe)
 {
-    CertStatus* tmp = ocspe->status;
-
     CYASSL_ENTER("FreeOCSP_Entry");
 
-    while (tmp) {
-        CertStatus* next = tmp->next;
-        XFREE(tmp, NULL, DYNAMIC_TYPE_OCSP_STATUS);
-        tmp = next;
-    }
+    FreeMutex(&ocspe->lookupLock);
+    XFREE(ocspe->status, NULL, DYNAMIC_TYPE_OCSP_STATUS);
+    XFREE(ocspe, NULL, DYNAMIC_TYPE_OCSP_ENTRY);
 }
 
 
 void CyaSSL_OCSP_Cleanup(CYASSL_OCSP* ocsp)
 {
-    OCSP_Entry* tmp = ocsp->ocspList;
+    word32 row;
 
     ocsp->enabled = 0;
-    while (tmp) {
-        OCSP_Entry* next = tmp->next;
-        FreeOCSP_Entry(tmp);
-        XFREE(tmp, NULL, DYNAMIC_TYPE_OCSP_ENTRY);
-        tmp = next;
+    if (ocsp->cache != NULL) {
+        for (row = 0; row < ocsp->cacheRows; row++) {
+            OCSP_Entry* tmp = ocsp->cache[row];
+            while (tmp) {
+                OCSP_Entry* next = tmp->next;
+                FreeOCSP_Entry(tmp);
+                tmp = next;
+            }
+        }
+        XFREE(ocsp->cache, NULL, DYNAMIC_TYPE_OCSP_ENTRY);
+        ocsp->cache = NULL;
     }
+    ocsp->cacheCount = 0;
+    ocsp->lruHead = ocsp->lruTail = NULL;
+    FreeMutex(&ocsp->ocspLock);
 }
 
 
@@ -121,90 +129,283 @@ int CyaSSL_OCSP_set_override_url(CYASSL_OCSP* ocsp, const char* url)
 }
 
 
-static int InitOCSP_Entry(OCSP_Entry* ocspe, DecodedCert* cert)
+/* a cached status can answer a lookup only inside its thisUpdate..nextUpdate
+   window, responses without a nextUpdate always go back to the responder */
+static int OcspStatusFresh(CertStatus* cs)
+{
+    return cs->status != -1 && cs->nextDate[0] != 0 &&
+           ValidateDate(cs->thisDate, cs->thisDateFormat, BEFORE) &&
+           ValidateDate(cs->nextDate, cs->nextDateFormat, AFTER);
+}
+
+
+/* issuerHash is already a digest, so mix the serial into its first word */
+static INLINE word32 OcspCacheRow(const byte* issuerHash, const byte* serial,
+                                  int serialSz, word32 rows)
+{
+    word32 h = ((word32)issuerHash[0] << 24) |
+               ((word32)issuerHash[1] << 16) |
+               ((word32)issuerHash[2] <<  8) |
+                (word32)issuerHash[3];
+    int i;
+
+    for (i = 0; i < serialSz; i++)
+        h = h * 31 + serial[i];
+
+    return h & (rows - 1);
+}
+
+
+/* rows for a cache of max entries, chains stay about one long */
+static word32 OcspCacheRows(word32 max)
+{
+    word32 rows = OCSP_CACHE_ROWS;
+
+    while (rows < max && rows < OCSP_CACHE_MAX_ROWS)
+        rows <<= 1;
+
+    return rows;
+}
+
+
+/* put entry at the recently used end, caller holds ocspLock */
+static void OcspLruUse(CYASSL_OCSP* ocsp, OCSP_Entry* entry)
+{
+    if (ocsp->lruHead == entry)
+        return;
+
+    /* unlink, a new entry isn't on the list yet */
+    if (entry->lruPrev)
+        entry->lruPrev->lruNext = entry->lruNext;
+    if (entry->lruNext)
+        entry->lruNext->lruPrev = entry->lruPrev;
+    else if (ocsp->lruTail == entry)
+        ocsp->lruTail = entry->lruPrev;
+
+    entry->lruPrev = NULL;
+    entry->lruNext = ocsp->lruHead;
+    if (ocsp->lruHead)
+        ocsp->lruHead->lruPrev = entry;
+    ocsp->lruHead = entry;
+    if (ocsp->lruTail == NULL)
+        ocsp->lruTail = entry;
+}
+
+
+/* unlink and free an entry nobody is using, caller holds ocspLock */
+static void RemoveOCSP_Entry(CYASSL_OCSP* ocsp, OCSP_Entry* entry)
+{
+    OCSP_Entry** prev = &ocsp->cache[OcspCacheRow(entry->issuerHash,
+                   entry->status->serial, entry->status->serialSz,
+                   ocsp->cacheRows)];
+
+    while (*prev != entry)
+        prev = &(*prev)->next;
+    *prev = entry->next;
+
+    if (entry->lruPrev)
+        entry->lruPrev->lruNext = entry->lruNext;
+    else
+        ocsp->lruHead = entry->lruNext;
+    if (entry->lruNext)
+        entry->lruNext->lruPrev = entry->lruPrev;
+    else
+        ocsp->lruTail = entry->lruPrev;
+
+    FreeOCSP_Entry(entry);
+    ocsp->cacheCount--;
+}
+
+
+/* move the entries to rows sized for cacheMax, caller holds ocspLock; the
+   old rows stay if there's no memory for new ones */
+static void ResizeOCSP_Cache(CYASSL_OCSP* ocsp)
+{
+    word32       rows = OcspCacheRows(ocsp->cacheMax);
+    OCSP_Entry** cache;
+    word32       row;
+
+    if (ocsp->cache == NULL || rows == ocsp->cacheRows)
+        return;
+
+    cache = (OCSP_Entry**)XMALLOC(rows * sizeof(OCSP_Entry*), NULL,
+                                  DYNAMIC_TYPE_OCSP_ENTRY);
+    if (cache == NULL)
+        return;
+    XMEMSET(cache, 0, rows * sizeof(OCSP_Entry*));
+
+    for (row = 0; row < ocsp->cacheRows; row++) {
+        OCSP_Entry* entry = ocsp->cache[row];
+
+        while (entry) {
+            OCSP_Entry* next = entry->next;
+            word32      to   = OcspCacheRow(entry->issuerHash,
+                                 entry->status->serial,
+                                 entry->status->serialSz, rows);
+
+            entry->next = cache[to];
+            cache[to]   = entry;
+            entry       = next;
+        }
+    }
+
+    XFREE(ocsp->cache, NULL, DYNAMIC_TYPE_OCSP_ENTRY);
+    ocsp->cache     = cache;
+    ocsp->cacheRows = rows;
+}
+
+
+static OCSP_Entry* NewOCSP_Entry(DecodedCert* cert)
 {
-    CYASSL_ENTER("InitOCSP_Entry");
+    OCSP_Entry* ocspe;
+
+    CYASSL_ENTER("NewOCSP_Entry");
+
+    ocspe = (OCSP_Entry*)XMALLOC(sizeof(OCSP_Entry), NULL,
+                                                     DYNAMIC_TYPE_OCSP_ENTRY);
+    if (ocspe == NULL)
+        return NULL;
+    XMEMSET(ocspe, 0, sizeof(OCSP_Entry));
+
+    ocspe->status = (CertStatus*)XMALLOC(sizeof(CertStatus), NULL,
+                                                     DYNAMIC_TYPE_OCSP_STATUS);
+    if (ocspe->status == NULL || InitMutex(&ocspe->lookupLock) != 0) {
+        XFREE(ocspe->status, NULL, DYNAMIC_TYPE_OCSP_STATUS);
+        XFREE(ocspe, NULL, DYNAMIC_TYPE_OCSP_ENTRY);
+        return NULL;
+    }
 
-    ocspe->next = NULL;
     XMEMCPY(ocspe->issuerHash, cert->issuerHash, SHA_DIGEST_SIZE);
     XMEMCPY(ocspe->issuerKeyHash, cert->issuerKeyHash, SHA_DIGEST_SIZE);
-    ocspe->status = NULL;
-    ocspe->totalStatus = 0;
+    XMEMSET(ocspe->status, 0, sizeof(CertStatus));
+    XMEMCPY(ocspe->status->serial, cert->serial, cert->serialSz);
+    ocspe->status->serialSz = cert->serialSz;
+    ocspe->status->status = -1;
 
-    return 0;
+    return ocspe;
 }
 
 
-static OCSP_Entry* find_ocsp_entry(CYASSL_OCSP* ocsp, DecodedCert* cert)
+static void SweepOCSP_Cache(CYASSL_OCSP* ocsp);
+
+
+/* find or add the entry for cert, caller holds ocspLock, returned entry has
+   a reference the caller has to drop with ReleaseOCSP_Entry() */
+static OCSP_Entry* FindOCSP_Entry(CYASSL_OCSP* ocsp, DecodedCert* cert)
 {
-    OCSP_Entry* entry = ocsp->ocspList;
+    OCSP_Entry* entry;
+    word32 row;
+
+    if (ocsp->cache == NULL) {
+        word32 rows = OcspCacheRows(ocsp->cacheMax);
+
+        ocsp->cache = (OCSP_Entry**)XMALLOC(rows * sizeof(OCSP_Entry*),
+                                            NULL, DYNAMIC_TYPE_OCSP_ENTRY);
+        if (ocsp->cache == NULL)
+            return NULL;
+        XMEMSET(ocsp->cache, 0, rows * sizeof(OCSP_Entry*));
+        ocsp->cacheRows = rows;
+    }
 
-    while (entry)
-    {
-        if (XMEMCMP(entry->issuerHash, cert->issuerHash, SHA_DIGEST_SIZE) == 0
+    /* stale entries only go in a sweep every cache's worth of lookups, so
+       a lookup pays for it in amortized constant time */
+    if (++ocsp->sinceSweep >= ocsp->cacheRows)
+        SweepOCSP_Cache(ocsp);
+
+    row = OcspCacheRow(cert->issuerHash, cert->serial, cert->serialSz,
+                       ocsp->cacheRows);
+    for (entry = ocsp->cache[row]; entry != NULL; entry = entry->next) {
+        if (entry->status->serialSz == cert->serialSz &&
+            XMEMCMP(entry->status->serial, cert->serial, cert->serialSz) == 0
+            && XMEMCMP(entry->issuerHash, cert->issuerHash,
+                                                        SHA_DIGEST_SIZE) == 0
             && XMEMCMP(entry->issuerKeyHash, cert->issuerKeyHash,
                                                         SHA_DIGEST_SIZE) == 0)
         {
-            CYASSL_MSG("Found OCSP responder");
+            CYASSL_MSG("Found OCSP cache entry");
             break;
         }
-        else
-        {
-            entry = entry->next;
-        }
     }
 
-    if (entry == NULL)
-    {
-        CYASSL_MSG("Add a new OCSP entry");
-        entry = (OCSP_Entry*)XMALLOC(sizeof(OCSP_Entry),
-                                                NULL, DYNAMIC_TYPE_OCSP_ENTRY);
-        if (entry != NULL)
-        {
-            InitOCSP_Entry(entry, cert);
-            entry->next = ocsp->ocspList;
-            ocsp->ocspList = entry;
-        }
+    if (entry == NULL) {
+        CYASSL_MSG("Add a new OCSP cache entry");
+        entry = NewOCSP_Entry(cert);
+        if (entry == NULL)
+            return NULL;
+        entry->next = ocsp->cache[row];
+        ocsp->cache[row] = entry;
+        ocsp->cacheCount++;
     }
 
+    OcspLruUse(ocsp, entry);
+    entry->refs++;
+
     return entry;
 }
 
 
-static CertStatus* find_cert_status(OCSP_Entry* ocspe, DecodedCert* cert)
+/* drop entries nobody is using that can't answer a lookup anymore, caller
+   holds ocspLock */
+static void SweepOCSP_Cache(CYASSL_OCSP* ocsp)
 {
-    CertStatus* stat = ocspe->status;
+    OCSP_Entry* entry = ocsp->lruHead;
 
-    while (stat)
-    {
-        if(stat->serialSz == cert->serialSz &&
-            (XMEMCMP(stat->serial, cert->serial, cert->serialSz) == 0))
-        {
-            break;
-        }
-        else
-        {
-            stat = stat->next;
-        }
+    CYASSL_ENTER("SweepOCSP_Cache");
+
+    ocsp->sinceSweep = 0;
+    while (entry) {
+        OCSP_Entry* next = entry->lruNext;
+
+        if (entry->refs == 0 && !OcspStatusFresh(entry->status))
+            RemoveOCSP_Entry(ocsp, entry);
+        entry = next;
     }
-    if (stat == NULL)
-    {
-        stat = (CertStatus*)XMALLOC(sizeof(CertStatus),
-                                            NULL, DYNAMIC_TYPE_OCSP_STATUS);
-        if (stat != NULL)
-        {
-            XMEMCPY(stat->serial, cert->serial, cert->serialSz);
-            stat->serialSz = cert->serialSz;
-            stat->status = -1;
-            stat->nextDate[0] = 0;
-            ocspe->totalStatus++;
-
-            stat->next = ocspe->status;
-            ocspe->status = stat;
-        }
+}
+
+
+/* evict least recently used entries nobody is using until the cache is back
+   under cacheMax, caller holds ocspLock */
+static void TrimOCSP_Cache(CYASSL_OCSP* ocsp)
+{
+    OCSP_Entry* entry = ocsp->lruTail;
+
+    while (entry && ocsp->cacheCount > ocsp->cacheMax) {
+        OCSP_Entry* newer = entry->lruPrev;
+
+        /* ones in use are trimmed when they're released */
+        if (entry->refs == 0)
+            RemoveOCSP_Entry(ocsp, entry);
+        entry = newer;
+    }
+}
+
+
+static void ReleaseOCSP_Entry(CYASSL_OCSP* ocsp, OCSP_Entry* ocspe)
+{
+    if (LockMutex(&ocsp->ocspLock) != 0) {
+        CYASSL_MSG("Couldn't lock ocspLock, leaking OCSP entry ref");
+        return;
     }
+    ocspe->refs--;
+    if (ocsp->cacheCount > ocsp->cacheMax)
+        TrimOCSP_Cache(ocsp);
+    UnLockMutex(&ocsp->ocspLock);
+}
 
-    return stat;
+
+int CyaSSL_OCSP_set_cache_size(CYASSL_OCSP* ocsp, int sz)
+{
+    if (ocsp == NULL || sz < 0)
+        return BAD_FUNC_ARG;
+
+    if (LockMutex(&ocsp->ocspLock) != 0)
+        return BAD_MUTEX_E;
+    ocsp->cacheMax = (word32)sz;
+    TrimOCSP_Cache(ocsp);
+    ResizeOCSP_Cache(ocsp);
+    UnLockMutex(&ocsp->ocspLock);
+
+    return 0;
 }
 
 
@@ -224,7 +425,10 @@ static int xstat2err(int stat)
 }
 
 
-int CyaSSL_OCSP_Lookup_Cert(CYASSL_OCSP* ocsp, DecodedCert* cert)
+/* ask the responder about cert, on a matching response the answer is left in
+   status, otherwise status->status stays -1 */
+static int OcspRoundTrip(CYASSL_OCSP* ocsp, DecodedCert* cert,
+                         CertStatus* status)
 {
     byte* ocspReqBuf = NULL;
     int ocspReqSz = 2048;
@@ -232,48 +436,11 @@ int CyaSSL_OCSP_Lookup_Cert(CYASSL_OCSP* ocsp, DecodedCert* cert)
     OcspRequest ocspRequest;
     OcspResponse ocspResponse;
     int result = 0;
-    OCSP_Entry* ocspe;
-    CertStatus* certStatus;
     const char *url;
     int urlSz;
 
-    /* If OCSP lookups are disabled, return success. */
-    if (!ocsp->enabled) {
-        CYASSL_MSG("OCSP lookup disabled, assuming CERT_GOOD");
-        return 0;
-    }
-
-    ocspe = find_ocsp_entry(ocsp, cert);
-    if (ocspe == NULL) {
-        CYASSL_MSG("alloc OCSP entry failed");
-        return MEMORY_ERROR;
-    }
-
-    certStatus = find_cert_status(ocspe, cert);
-    if (certStatus == NULL)
-    {
-        CYASSL_MSG("alloc OCSP cert status failed");
-        return MEMORY_ERROR;
-    }
-
-    if (certStatus->status != -1)
-    {
-        if (!ValidateDate(certStatus->thisDate,
-                                        certStatus->thisDateFormat, BEFORE) ||
-            (certStatus->nextDate[0] == 0) ||
-            !ValidateDate(certStatus->nextDate,
-                                        certStatus->nextDateFormat, AFTER))
-        {
-            CYASSL_MSG("\tinvalid status date, looking up cert");
-            certStatus->status = -1;
-        }
-        else
-        {
-            CYASSL_MSG("\tusing cached status");
-            result = xstat2err(certStatus->status);
-            return result;
-        }
-    }
+    XMEMSET(status, 0, sizeof(CertStatus));
+    status->status = -1;
 
     if (ocsp->useOverrideUrl) {
         if (ocsp->overrideUrl[0] != '\0') {
@@ -306,7 +473,7 @@ int CyaSSL_OCSP_Lookup_Cert(CYASSL_OCSP* ocsp, DecodedCert* cert)
     }
 
     if (result >= 0 && ocspRespBuf) {
-        InitOcspResponse(&ocspResponse, certStatus, ocspRespBuf, result);
+        InitOcspResponse(&ocspResponse, status, ocspRespBuf, result);
         OcspResponseDecode(&ocspResponse);
     
         if (ocspResponse.responseStatus != OCSP_SUCCESSFUL) {
@@ -323,6 +490,8 @@ int CyaSSL_OCSP_Lookup_Cert(CYASSL_OCSP* ocsp, DecodedCert* cert)
                 result = OCSP_LOOKUP_FAIL;
             }
         }
+        if (result == OCSP_LOOKUP_FAIL)
+            status->status = -1;
     }
     else {
         result = OCSP_LOOKUP_FAIL;
@@ -339,5 +508,67 @@ int CyaSSL_OCSP_Lookup_Cert(CYASSL_OCSP* ocsp, DecodedCert* cert)
 }
 
 
+int CyaSSL_OCSP_Lookup_Cert(CYASSL_OCSP* ocsp, DecodedCert* cert)
+{
+    OCSP_Entry* ocspe;
+    CertStatus  fresh;
+    int result;
+
+    /* If OCSP lookups are disabled, return success. */
+    if (!ocsp->enabled) {
+        CYASSL_MSG("OCSP lookup disabled, assuming CERT_GOOD");
+        return 0;
+    }
+
+    if (LockMutex(&ocsp->ocspLock) != 0) {
+        CYASSL_MSG("Couldn't lock ocspLock");
+        return BAD_MUTEX_E;
+    }
+    ocspe = FindOCSP_Entry(ocsp, cert);
+    if (ocspe == NULL) {
+        UnLockMutex(&ocsp->ocspLock);
+        CYASSL_MSG("alloc OCSP entry failed");
+        return MEMORY_ERROR;
+    }
+    if (OcspStatusFresh(ocspe->status)) {
+        CYASSL_MSG("\tusing cached status");
+        result = xstat2err(ocspe->status->status);
+        ocspe->refs--;
+        UnLockMutex(&ocsp->ocspLock);
+        return result;
+    }
+    UnLockMutex(&ocsp->ocspLock);
+
+    /* only one lookup per cert talks to the responder, anyone else asking
+       for the same cert meanwhile waits here and takes its answer */
+    if (LockMutex(&ocspe->lookupLock) != 0) {
+        ReleaseOCSP_Entry(ocsp, ocspe);
+        CYASSL_MSG("Couldn't lock OCSP entry lookupLock");
+        return BAD_MUTEX_E;
+    }
+
+    /* status only changes under lookupLock, safe to read here */
+    if (OcspStatusFresh(ocspe->status)) {
+        CYASSL_MSG("\tusing status from concurrent lookup");
+        result = xstat2err(ocspe->status->status);
+    }
+    else {
+        CYASSL_MSG("\tno fresh status, looking up cert");
+        result = OcspRoundTrip(ocsp, cert, &fresh);
+        if (fresh.status != -1) {
+            if (LockMutex(&ocsp->ocspLock) == 0) {
+                XMEMCPY(ocspe->status, &fresh, sizeof(CertStatus));
+                UnLockMutex(&ocsp->ocspLock);
+            }
+        }
+    }
+
+    UnLockMutex(&ocspe->lookupLock);
+    ReleaseOCSP_Entry(ocsp, ocspe);
+
+    return result;
+}
+
+
 #endif /* HAVE_OCSP */
 
@@ -47,6 +47,7 @@
 #include <cyassl/error.h>
 #include <cyassl/sniffer.h>
 #include <cyassl/sniffer_error.h>
+#include <cyassl/ctaocrypt/siphash.h>
 
 
 #ifndef min
@@ -322,14 +323,20 @@ static CyaSSL_Mutex ServerListMutex;
 static SnifferSession* SessionTable[HASH_SIZE];
 static CyaSSL_Mutex SessionMutex;
 static int SessionCount = 0;
+static byte SessionHashKey[SIPHASH_KEY_SIZE];  /* keyed row hash */
 
 
 /* Initialize overall Sniffer */
 void ssl_InitSniffer(void)
 {
+    RNG rng;
+
     CyaSSL_Init();
     InitMutex(&ServerListMutex);
     InitMutex(&SessionMutex);
+
+    if (InitRng(&rng) == 0)
+        RNG_GenerateBlock(&rng, SessionHashKey, sizeof(SessionHashKey));
 }
 
 
@@ -845,13 +852,35 @@ static SnifferServer* GetSnifferServer(IpInfo* ipInfo, TcpInfo* tcpInfo)
 }
 
 
+/* Put one address and port end point into out, return bytes used */
+static int SetEndPoint(byte* out, word32 addr, int port)
+{
+    XMEMCPY(out, &addr, sizeof(addr));
+    out[sizeof(addr)]     = (byte)(port >> 8);
+    out[sizeof(addr) + 1] = (byte)port;
+
+    return (int)sizeof(addr) + 2;
+}
+
+
 /* Hash the Session Info, return hash row */
 static word32 SessionHash(IpInfo* ipInfo, TcpInfo* tcpInfo)
 {
-    word32 hash = ipInfo->src * ipInfo->dst;
-    hash *= tcpInfo->srcPort * tcpInfo->dstPort;
-    
-    return hash % HASH_SIZE;
+    byte tuple[2 * (sizeof(word32) + 2)];
+    int  idx = 0;
+
+    /* both directions of a connection need the same row, so lower end first */
+    if (ipInfo->src < ipInfo->dst || (ipInfo->src == ipInfo->dst &&
+                                      tcpInfo->srcPort < tcpInfo->dstPort)) {
+        idx += SetEndPoint(tuple + idx, ipInfo->src, tcpInfo->srcPort);
+        idx += SetEndPoint(tuple + idx, ipInfo->dst, tcpInfo->dstPort);
+    }
+    else {
+        idx += SetEndPoint(tuple + idx, ipInfo->dst, tcpInfo->dstPort);
+        idx += SetEndPoint(tuple + idx, ipInfo->src, tcpInfo->srcPort);
+    }
+
+    return HalfSipHash24(SessionHashKey, tuple, idx) % HASH_SIZE;
 }
 
 
@@ -34,6 +34,7 @@
 #include <cyassl/internal.h>
 #include <cyassl/error.h>
 #include <cyassl/ctaocrypt/coding.h>
+#include <cyassl/ctaocrypt/siphash.h>
 
 #if defined(OPENSSL_EXTRA) || defined(HAVE_WEBSERVER)
     #include <cyassl/openssl/evp.h>
@@ -443,6 +444,61 @@ int CyaSSL_write(CYASSL* ssl, const void* data, int sz)
 }
 
 
+/* zero copy write, points data at room for up to the returned number of
+   plaintext bytes inside CyaSSL, fill it then CyaSSL_write_zc_commit() */
+int CyaSSL_write_zc_reserve(CYASSL* ssl, unsigned char** data)
+{
+    int ret;
+
+    CYASSL_ENTER("CyaSSL_write_zc_reserve()");
+
+    if (ssl == NULL || data == NULL)
+        return BAD_FUNC_ARG;
+
+    *data = NULL;
+
+#ifdef HAVE_ERRNO_H 
+    errno = 0;
+#endif
+
+    ret = ReserveData(ssl, data);
+
+    CYASSL_LEAVE("CyaSSL_write_zc_reserve()", ret);
+
+    if (ret < 0)
+        return SSL_FATAL_ERROR;
+    else
+        return ret;
+}
+
+
+/* seal and send the first sz bytes written to the reserved room, the
+   record is taken even if the socket would block, the next reserve
+   flushes it */
+int CyaSSL_write_zc_commit(CYASSL* ssl, int sz)
+{
+    int ret;
+
+    CYASSL_ENTER("CyaSSL_write_zc_commit()");
+
+    if (ssl == NULL || sz < 0)
+        return BAD_FUNC_ARG;
+
+#ifdef HAVE_ERRNO_H 
+    errno = 0;
+#endif
+
+    ret = CommitData(ssl, sz);
+
+    CYASSL_LEAVE("CyaSSL_write_zc_commit()", ret);
+
+    if (ret < 0)
+        return SSL_FATAL_ERROR;
+    else
+        return ret;
+}
+
+
 static int CyaSSL_read_internal(CYASSL* ssl, void* data, int sz, int peek)
 {
     int ret; 
@@ -492,6 +548,53 @@ int CyaSSL_read(CYASSL* ssl, void* data, int sz)
 }
 
 
+/* zero copy read, points data at the decrypted record in the input buffer,
+   returns its size; data stays valid until CyaSSL_read_zc_release() */
+int CyaSSL_read_zc(CYASSL* ssl, const unsigned char** data)
+{
+    int ret;
+
+    CYASSL_ENTER("CyaSSL_read_zc()");
+
+    if (ssl == NULL || data == NULL)
+        return BAD_FUNC_ARG;
+
+    *data = NULL;
+
+#ifdef HAVE_ERRNO_H 
+        errno = 0;
+#endif
+#ifdef CYASSL_DTLS
+    if (ssl->options.dtls)
+        ssl->dtls_expected_rx = max(OUTPUT_RECORD_SIZE + 100, MAX_MTU);
+#endif
+
+    ret = ReceiveDataZc(ssl, data);
+
+    CYASSL_LEAVE("CyaSSL_read_zc()", ret);
+
+    if (ret < 0)
+        return SSL_FATAL_ERROR;
+    else
+        return ret;
+}
+
+
+/* give back sz bytes from the front of the last CyaSSL_read_zc() */
+int CyaSSL_read_zc_release(CYASSL* ssl, int sz)
+{
+    CYASSL_ENTER("CyaSSL_read_zc_release()");
+
+    if (ssl == NULL || sz < 0 ||
+                          sz > (int)ssl->buffers.clearOutputBuffer.length)
+        return BAD_FUNC_ARG;
+
+    ConsumeData(ssl, sz);
+
+    return SSL_SUCCESS;
+}
+
+
 #ifdef HAVE_CAVIUM
 
 /* let's use cavium, SSL_SUCCESS on ok */
@@ -613,6 +716,65 @@ int CyaSSL_CTX_UseTruncatedHMAC(CYASSL_CTX* ctx)
 #endif /* NO_CYASSL_CLIENT */
 #endif /* HAVE_TRUNCATED_HMAC */
 
+#ifdef HAVE_SESSION_TICKET
+#ifndef NO_CYASSL_SERVER
+/* make key the ticket issuing key, retired keys still decrypt old tickets */
+int CyaSSL_CTX_AddSessionTicketKey(CYASSL_CTX* ctx, const byte* key,
+                                                                   word32 keySz)
+{
+    TicketKeys* keys;
+    int         i;
+
+    if (ctx == NULL || key == NULL || keySz != CYASSL_TICKET_KEY_SZ)
+        return BAD_FUNC_ARG;
+
+    keys = &ctx->ticketKeys;
+
+    if (LockMutex(&keys->mutex) != 0)
+        return BAD_MUTEX_E;
+
+    for (i = MAX_TICKET_KEYS - 1; i > 0; i--)
+        keys->keys[i] = keys->keys[i - 1];
+
+    XMEMCPY(keys->keys[0].name, key, TICKET_NAME_SZ);
+    key += TICKET_NAME_SZ;
+    XMEMCPY(keys->keys[0].encKey, key, AES_128_KEY_SIZE);
+    key += AES_128_KEY_SIZE;
+    XMEMCPY(keys->keys[0].macKey, key, TICKET_MAC_SZ);
+
+    if (keys->count < MAX_TICKET_KEYS)
+        keys->count++;
+
+    UnLockMutex(&keys->mutex);
+
+    return 0;
+}
+
+/* turn on tickets, with a random key if the user hasn't added one */
+int CyaSSL_CTX_UseSessionTicket(CYASSL_CTX* ctx)
+{
+    byte key[CYASSL_TICKET_KEY_SZ];
+    RNG  rng;
+    int  ret;
+
+    if (ctx == NULL)
+        return BAD_FUNC_ARG;
+
+    if (ctx->ticketKeys.count)
+        return 0;
+
+    if ((ret = InitRng(&rng)) != 0)
+        return ret;
+
+    RNG_GenerateBlock(&rng, key, sizeof(key));
+    ret = CyaSSL_CTX_AddSessionTicketKey(ctx, key, sizeof(key));
+    XMEMSET(key, 0, sizeof(key));
+
+    return ret;
+}
+#endif /* NO_CYASSL_SERVER */
+#endif /* HAVE_SESSION_TICKET */
+
 #ifndef CYASSL_LEANPSK
 int CyaSSL_send(CYASSL* ssl, const void* data, int sz, int flags)
 {
@@ -977,6 +1139,19 @@ int CyaSSL_GetHmacSize(CYASSL* ssl)
 
 #ifndef NO_CERTS
 
+#ifndef NO_CERT_VERIFY_CACHE
+
+/* forget all verified certs, caller holds caLock */
+static void FlushCertVerifyCache(CYASSL_CERT_MANAGER* cm)
+{
+    if (cm->verifyCache)
+        XMEMSET(cm->verifyCache, 0,
+                CERT_VERIFY_CACHE_SZ * sizeof(CertVerifyEntry));
+}
+
+#endif /* NO_CERT_VERIFY_CACHE */
+
+
 CYASSL_CERT_MANAGER* CyaSSL_CertManagerNew(void)
 {
     CYASSL_CERT_MANAGER* cm = NULL;
@@ -996,6 +1171,11 @@ CYASSL_CERT_MANAGER* CyaSSL_CertManagerNew(void)
         cm->crlEnabled      = 0;
         cm->crlCheckAll     = 0;
         cm->cbMissingCRL    = NULL;
+        #ifndef NO_CERT_VERIFY_CACHE
+            cm->verifyCache  = NULL;
+            cm->verifyHits   = 0;
+            cm->verifyMisses = 0;
+        #endif
 
         if (InitMutex(&cm->caLock) != 0) {
             CYASSL_MSG("Bad mutex init");
@@ -1018,6 +1198,9 @@ void CyaSSL_CertManagerFree(CYASSL_CERT_MANAGER* cm)
                 FreeCRL(cm->crl, 1);
         #endif
         FreeSignerTable(cm->caTable, CA_TABLE_SIZE, NULL);
+        #ifndef NO_CERT_VERIFY_CACHE
+            XFREE(cm->verifyCache, cm->heap, DYNAMIC_TYPE_CERT_VERIFY);
+        #endif
         FreeMutex(&cm->caLock);
         XFREE(cm, NULL, DYNAMIC_TYPE_CERT_MANAGER);
     }
@@ -1037,6 +1220,9 @@ int CyaSSL_CertManagerUnloadCAs(CYASSL_CERT_MANAGER* cm)
         return BAD_MUTEX_E;
 
     FreeSignerTable(cm->caTable, CA_TABLE_SIZE, NULL);
+    #ifndef NO_CERT_VERIFY_CACHE
+        FlushCertVerifyCache(cm);
+    #endif
 
     UnLockMutex(&cm->caLock);
 
@@ -1045,6 +1231,36 @@ int CyaSSL_CertManagerUnloadCAs(CYASSL_CERT_MANAGER* cm)
 }
 
 
+/* signature checks answered by the verified cert cache (hits) and ones that
+   had to do the public key operation (misses), SSL_SUCCESS on ok */
+int CyaSSL_CertManagerGetVerifyCacheStats(CYASSL_CERT_MANAGER* cm,
+                                   unsigned long* hits, unsigned long* misses)
+{
+    CYASSL_ENTER("CyaSSL_CertManagerGetVerifyCacheStats");
+#ifndef NO_CERT_VERIFY_CACHE
+    if (cm == NULL)
+        return BAD_FUNC_ARG;
+
+    if (LockMutex(&cm->caLock) != 0)
+        return BAD_MUTEX_E;
+
+    if (hits)
+        *hits = cm->verifyHits;
+    if (misses)
+        *misses = cm->verifyMisses;
+
+    UnLockMutex(&cm->caLock);
+
+    return SSL_SUCCESS;
+#else
+    (void)cm;
+    (void)hits;
+    (void)misses;
+    return NOT_COMPILED_IN;
+#endif
+}
+
+
 #endif /* !NO_CERTS */
 
 
@@ -1084,6 +1300,118 @@ int CyaSSL_CTX_set_group_messages(CYASSL_CTX* ctx)
 #endif
 
 
+/* turn read ahead on or off for context, recv() fills the input buffer and
+   later records get parsed from it without going back to the socket */
+int CyaSSL_CTX_set_read_ahead(CYASSL_CTX* ctx, int on)
+{
+    if (ctx == NULL)
+       return BAD_FUNC_ARG;
+
+    ctx->readAhead = on ? 1 : 0;
+
+    return SSL_SUCCESS;
+}
+
+
+/* turn read ahead on or off for ssl object */
+int CyaSSL_set_read_ahead(CYASSL* ssl, int on)
+{
+    if (ssl == NULL)
+       return BAD_FUNC_ARG;
+
+    ssl->options.readAhead = on ? 1 : 0;
+
+    return SSL_SUCCESS;
+}
+
+
+/* 1 if reading ahead, 0 if not */
+int CyaSSL_get_read_ahead(CYASSL* ssl)
+{
+    if (ssl == NULL)
+       return BAD_FUNC_ARG;
+
+    return ssl->options.readAhead;
+}
+
+
+/* keep up to maxFree record sized io buffers on ctx for its connections to
+   borrow while data is in flight, 0 turns pooling off */
+int CyaSSL_CTX_set_buffer_pool(CYASSL_CTX* ctx, int maxFree)
+{
+    if (ctx == NULL || maxFree < 0)
+        return BAD_FUNC_ARG;
+
+    if (LockMutex(&ctx->bufferPool.mutex) != 0)
+        return BAD_MUTEX_E;
+    ctx->bufferPool.maxFree = (word32)maxFree;
+    UnLockMutex(&ctx->bufferPool.mutex);
+
+    TrimBufferPool(&ctx->bufferPool, ctx->heap);
+
+    return SSL_SUCCESS;
+}
+
+
+/* buffers lent out now, sitting free, and most ever lent out at once */
+int CyaSSL_CTX_get_buffer_pool_stats(CYASSL_CTX* ctx, unsigned int* inUse,
+                                     unsigned int* freeCount,
+                                     unsigned int* highWater)
+{
+    if (ctx == NULL)
+        return BAD_FUNC_ARG;
+
+    if (LockMutex(&ctx->bufferPool.mutex) != 0)
+        return BAD_MUTEX_E;
+    if (inUse)
+        *inUse = ctx->bufferPool.inUse;
+    if (freeCount)
+        *freeCount = ctx->bufferPool.freeCount;
+    if (highWater)
+        *highWater = ctx->bufferPool.highWater;
+    UnLockMutex(&ctx->bufferPool.mutex);
+
+    return SSL_SUCCESS;
+}
+
+
+/* hand back io buffers with nothing in them, e.g. read ahead's, before a
+   connection goes idle; buffers holding data are left alone */
+int CyaSSL_release_buffers(CYASSL* ssl)
+{
+    if (ssl == NULL)
+        return BAD_FUNC_ARG;
+
+    if (ssl->buffers.inputBuffer.dynamicFlag &&
+            ssl->buffers.inputBuffer.idx == ssl->buffers.inputBuffer.length &&
+            ssl->buffers.clearOutputBuffer.length == 0)
+        ShrinkInputBuffer(ssl, FORCED_FREE);
+
+    if (ssl->buffers.outputBuffer.dynamicFlag &&
+            ssl->buffers.outputBuffer.length == 0 &&
+            ssl->buffers.reservedSz == 0)
+        ShrinkOutputBuffer(ssl);
+
+    return SSL_SUCCESS;
+}
+
+
+/* number of CBIORecv and CBIOSend calls made by this ssl object */
+int CyaSSL_get_io_calls(CYASSL* ssl, unsigned int* recvCalls,
+                        unsigned int* sendCalls)
+{
+    if (ssl == NULL)
+       return BAD_FUNC_ARG;
+
+    if (recvCalls)
+        *recvCalls = ssl->recvCalls;
+    if (sendCalls)
+        *sendCalls = ssl->sendCalls;
+
+    return SSL_SUCCESS;
+}
+
+
 #ifndef NO_CYASSL_CLIENT
 /* connect enough to get peer cert chain */
 int CyaSSL_connect_cert(CYASSL* ssl)
@@ -1170,7 +1498,7 @@ int CyaSSL_SetVersion(CYASSL* ssl, int version)
 #endif /* !leanpsk */
 
 
-#if !defined(NO_CERTS) || !defined(NO_SESSION_CACHE)
+#ifndef NO_CERTS
 
 /* Make a work from the front of random hash */
 static INLINE word32 MakeWordFromHash(const byte* hashID)
@@ -1179,10 +1507,6 @@ static INLINE word32 MakeWordFromHash(const byte* hashID)
             hashID[3];
 }
 
-#endif /* !NO_CERTS || !NO_SESSION_CACHE */
-
-
-#ifndef NO_CERTS
 
 /* hash is the SHA digest of name, just use first 32 bits as hash */
 static INLINE word32 HashSigner(const byte* hash)
@@ -1285,6 +1609,89 @@ Signer* GetCAByName(void* vp, byte* hash)
 #endif
 
 
+#ifndef NO_CERT_VERIFY_CACHE
+
+/* a cert is known by its whole DER and the key of the issuer that signed it,
+   a reissued CA key or any change to the cert gives a new key */
+static void CertVerifyKey(const byte* der, word32 derSz, const Signer* ca,
+                          byte* key)
+{
+    Sha256 sha;
+
+    InitSha256(&sha);
+    Sha256Update(&sha, der, derSz);
+    Sha256Update(&sha, ca->publicKey, ca->pubKeySize);
+    Sha256Final(&sha, key);
+}
+
+
+/* has der already been verified against ca, fills in key for a later
+   CertVerifyCacheAdd either way, 1 on hit */
+int CertVerifyCacheFind(void* vp, const byte* der, word32 derSz,
+                        const Signer* ca, byte* key)
+{
+    CYASSL_CERT_MANAGER* cm = (CYASSL_CERT_MANAGER*)vp;
+    CertVerifyEntry*     entry;
+    int                  ret = 0;
+
+    if (cm == NULL)
+        return 0;
+
+    CertVerifyKey(der, derSz, ca, key);
+
+    if (LockMutex(&cm->caLock) != 0)
+        return 0;
+
+    if (cm->verifyCache) {
+        entry = &cm->verifyCache[MakeWordFromHash(key) % CERT_VERIFY_CACHE_SZ];
+        if (entry->used &&
+                XMEMCMP(entry->key, key, CERT_VERIFY_DIGEST_SIZE) == 0)
+            ret = 1;
+    }
+    if (ret)
+        cm->verifyHits++;
+    else
+        cm->verifyMisses++;
+
+    UnLockMutex(&cm->caLock);
+
+    return ret;
+}
+
+
+/* remember a cert whose signature checked out, key from CertVerifyCacheFind,
+   takes over whatever slot the key maps to */
+void CertVerifyCacheAdd(void* vp, const byte* key)
+{
+    CYASSL_CERT_MANAGER* cm = (CYASSL_CERT_MANAGER*)vp;
+    CertVerifyEntry*     entry;
+
+    if (cm == NULL)
+        return;
+
+    if (LockMutex(&cm->caLock) != 0)
+        return;
+
+    if (cm->verifyCache == NULL) {
+        cm->verifyCache = (CertVerifyEntry*)XMALLOC(
+                                CERT_VERIFY_CACHE_SZ * sizeof(CertVerifyEntry),
+                                cm->heap, DYNAMIC_TYPE_CERT_VERIFY);
+        if (cm->verifyCache)
+            XMEMSET(cm->verifyCache, 0,
+                    CERT_VERIFY_CACHE_SZ * sizeof(CertVerifyEntry));
+    }
+    if (cm->verifyCache) {
+        entry = &cm->verifyCache[MakeWordFromHash(key) % CERT_VERIFY_CACHE_SZ];
+        XMEMCPY(entry->key, key, CERT_VERIFY_DIGEST_SIZE);
+        entry->used = 1;
+    }
+
+    UnLockMutex(&cm->caLock);
+}
+
+#endif /* NO_CERT_VERIFY_CACHE */
+
+
 /* owns der, internal now uses too */
 /* type flag ids from user or from chain received during verify
    don't allow chain ones to be added w/o isCA extension */
@@ -1408,15 +1815,39 @@ int AddCA(CYASSL_CERT_MANAGER* cm, buffer der, int type, int verify)
         #define SESSION_ROWS 11
     #endif
 
+    /* rows are guarded by a striped set of mutexes so lookups and inserts
+       on different rows don't contend, row r uses stripe r % STRIPES.
+       session_mutex is taken before any stripe for whole cache operations
+       (resize, persistence, stats) and also guards the ClientCache */
+    #ifndef SESSION_CACHE_STRIPES
+        #ifdef SINGLE_THREADED
+            #define SESSION_CACHE_STRIPES 1
+        #else
+            #define SESSION_CACHE_STRIPES 16
+        #endif
+    #endif
+
+    /* ClientSession stores the server row as a word16 */
+    #define MAX_SESSION_ROWS 0xFFFF
+
     typedef struct SessionRow {
         int nextIdx;                           /* where to place next one   */
         int totalCount;                        /* sessions ever on this row */
         CYASSL_SESSION Sessions[SESSIONS_PER_ROW];
     } SessionRow;
 
-    static SessionRow SessionCache[SESSION_ROWS];
+    static SessionRow  SessionCacheStatic[SESSION_ROWS];
+    static SessionRow* SessionCache = SessionCacheStatic; /* current table  */
+    static word32      SessionRows  = SESSION_ROWS;       /* rows in table  */
+
+    static CyaSSL_Mutex session_mutex;   /* whole cache and ClientCache mutex */
+    static CyaSSL_Mutex session_row_mutex[SESSION_CACHE_STRIPES];
 
-    static CyaSSL_Mutex session_mutex;   /* SessionCache mutex */
+    /* keyed row hash so peer chosen IDs can't be aimed at one row, seeded
+       once by CyaSSL_Init, cached sessions outlive Cleanup, and saved along
+       with a persisted cache */
+    static byte SessionHashKey[SIPHASH_KEY_SIZE];
+    static int  SessionHashKeySet = 0;
 
     #ifndef NO_CLIENT_CACHE
 
@@ -1431,14 +1862,47 @@ int AddCA(CYASSL_CERT_MANAGER* cm, buffer der, int type, int verify)
             ClientSession Clients[SESSIONS_PER_ROW];
         } ClientRow;
 
-        static ClientRow ClientCache[SESSION_ROWS];  /* Client Cache */
+        static ClientRow  ClientCacheStatic[SESSION_ROWS];
+        static ClientRow* ClientCache = ClientCacheStatic;  /* Client Cache */
                                                      /* uses session mutex */
 
     #endif  /* NO_CLIENT_CACHE */
 
     /* for persistance, if changes to layout need to increment and modify
        save_session_cache() and restore_session_cache and memory versions too */
-    #define CYASSL_CACHE_VERSION 2
+    #define CYASSL_CACHE_VERSION 3
+
+
+    /* lock the whole cache, session_mutex first then each row stripe */
+    static INLINE int LockSessionCache(void)
+    {
+        int i;
+
+        if (LockMutex(&session_mutex) != 0)
+            return BAD_MUTEX_E;
+
+        for (i = 0; i < SESSION_CACHE_STRIPES; i++) {
+            if (LockMutex(&session_row_mutex[i]) != 0) {
+                while (--i >= 0)
+                    UnLockMutex(&session_row_mutex[i]);
+                UnLockMutex(&session_mutex);
+                return BAD_MUTEX_E;
+            }
+        }
+
+        return 0;
+    }
+
+
+    static INLINE void UnLockSessionCache(void)
+    {
+        int i;
+
+        for (i = SESSION_CACHE_STRIPES - 1; i >= 0; i--)
+            UnLockMutex(&session_row_mutex[i]);
+
+        UnLockMutex(&session_mutex);
+    }
 
 #endif /* NO_SESSION_CACHE */
 
@@ -1451,11 +1915,32 @@ int CyaSSL_Init(void)
 
     if (initRefCount == 0) {
 #ifndef NO_SESSION_CACHE
+        int i;
+        RNG rng;
+
         if (InitMutex(&session_mutex) != 0)
             ret = BAD_MUTEX_E;
+        for (i = 0; i < SESSION_CACHE_STRIPES; i++) {
+            if (InitMutex(&session_row_mutex[i]) != 0)
+                ret = BAD_MUTEX_E;
+        }
+
+        if (!SessionHashKeySet) {
+            if (InitRng(&rng) == 0) {
+                RNG_GenerateBlock(&rng, SessionHashKey, sizeof(SessionHashKey));
+                SessionHashKeySet = 1;
+            }
+            else {
+                CYASSL_MSG("Bad RNG Init, session hash key not seeded");
+            }
+        }
 #endif
         if (InitMutex(&count_mutex) != 0)
             ret = BAD_MUTEX_E;
+#if defined(HAVE_ECC) && defined(FP_ECC)
+        if (ecc_fp_init() != 0)
+            ret = BAD_MUTEX_E;
+#endif
     }
     if (ret == SSL_SUCCESS) {
         if (LockMutex(&count_mutex) != 0) {
@@ -1883,6 +2368,7 @@ int CyaSSL_Init(void)
                 if (ctx->privateKey.buffer)
                     XFREE(ctx->privateKey.buffer, heap, dynamicType);
                 ctx->privateKey = der;      /* takes der over */
+                FreeCtxKeys(ctx);           /* decoded below for new key */
             }
         }
         else {
@@ -1893,25 +2379,40 @@ int CyaSSL_Init(void)
         if (type == PRIVATEKEY_TYPE && format != SSL_FILETYPE_RAW) {
 #ifndef NO_RSA
             if (!eccKey) { 
-                /* make sure RSA key can be used */
-                RsaKey key;
-                word32 idx = 0;
-        
-                InitRsaKey(&key, 0);
-                if (RsaPrivateKeyDecode(der.buffer,&idx,&key,der.length) != 0) {
+                /* make sure RSA key can be used, ctx keeps it decoded for
+                   the handshakes, decoded in place since the key holds a
+                   lock that can't be copied */
+                RsaKey  key;
+                RsaKey* decoded = &key;
+                word32  idx = 0;
+
+                if (ssl == NULL && ctx) {
+                    ctx->rsaKey = (RsaKey*)XMALLOC(sizeof(RsaKey), heap,
+                                                   DYNAMIC_TYPE_RSA);
+                    if (ctx->rsaKey)
+                        decoded = ctx->rsaKey;
+                }
+
+                InitRsaKey(decoded, 0);
+                if (RsaPrivateKeyDecode(der.buffer, &idx, decoded,
+                                        der.length) != 0) {
+                    FreeRsaKey(decoded);
+                    if (decoded != &key) {
+                        XFREE(ctx->rsaKey, heap, DYNAMIC_TYPE_RSA);
+                        ctx->rsaKey = NULL;
+                    }
 #ifdef HAVE_ECC  
                     /* could have DER ECC (or pkcs8 ecc), no easy way to tell */
                     eccKey = 1;  /* so try it out */
 #endif
-                    if (!eccKey) {
-                        FreeRsaKey(&key);
+                    if (!eccKey)
                         return SSL_BAD_FILE;
-                    }
                 } else {
                     rsaKey = 1;
                     (void)rsaKey;  /* for no ecc builds */
+                    if (decoded == &key)
+                        FreeRsaKey(&key);
                 }
-                FreeRsaKey(&key);
             }
 #endif
 #ifdef HAVE_ECC  
@@ -1925,11 +2426,18 @@ int CyaSSL_Init(void)
                     ecc_free(&key);
                     return SSL_BAD_FILE;
                 }
-                ecc_free(&key);
                 eccKey = 1;
                 ctx->haveStaticECC = 1;
                 if (ssl)
                     ssl->options.haveStaticECC = 1;
+                else
+                    ctx->eccKey = (ecc_key*)XMALLOC(sizeof(ecc_key), heap,
+                                                    DYNAMIC_TYPE_ECC);
+                if (ssl == NULL && ctx->eccKey)
+                    XMEMCPY(ctx->eccKey, &key, sizeof(ecc_key)); /* ctx keeps
+                                          it decoded for the handshakes */
+                else
+                    ecc_free(&key);
             }
 #endif /* HAVE_ECC */
         }
@@ -2444,26 +2952,79 @@ int CyaSSL_CertManagerCheckCRL(CYASSL_CERT_MANAGER* cm, byte* der, int sz)
     if (ret == 0)
         return SSL_SUCCESS;  /* convert */
 
-    return ret;
+    return ret;
+}
+
+
+int CyaSSL_CertManagerSetCRL_Cb(CYASSL_CERT_MANAGER* cm, CbMissingCRL cb)
+{
+    CYASSL_ENTER("CyaSSL_CertManagerSetCRL_Cb");
+    if (cm == NULL)
+        return BAD_FUNC_ARG;
+
+    cm->cbMissingCRL = cb;
+
+    return SSL_SUCCESS;
+}
+
+
+int CyaSSL_CertManagerLoadCRL(CYASSL_CERT_MANAGER* cm, const char* path,
+                              int type, int monitor)
+{
+    CYASSL_ENTER("CyaSSL_CertManagerLoadCRL");
+    if (cm == NULL)
+        return BAD_FUNC_ARG;
+
+    if (cm->crl == NULL) {
+        if (CyaSSL_CertManagerEnableCRL(cm, 0) != SSL_SUCCESS) {
+            CYASSL_MSG("Enable CRL failed");
+            return SSL_FATAL_ERROR;
+        }
+    }
+
+    return LoadCRL(cm->crl, path, type, monitor);
+}
+
+
+/* load one CRL from memory, SSL_SUCCESS on ok */
+int CyaSSL_CertManagerLoadCRLBuffer(CYASSL_CERT_MANAGER* cm,
+                                    const unsigned char* buff, long sz, int type)
+{
+    CYASSL_ENTER("CyaSSL_CertManagerLoadCRLBuffer");
+    if (cm == NULL)
+        return BAD_FUNC_ARG;
+
+    if (cm->crl == NULL) {
+        if (CyaSSL_CertManagerEnableCRL(cm, 0) != SSL_SUCCESS) {
+            CYASSL_MSG("Enable CRL failed");
+            return SSL_FATAL_ERROR;
+        }
+    }
+
+    return BufferLoadCRL(cm->crl, buff, sz, type);
 }
 
 
-int CyaSSL_CertManagerSetCRL_Cb(CYASSL_CERT_MANAGER* cm, CbMissingCRL cb)
+/* parse and verify CRL file in against the loaded CAs and write it out as a
+   CRL index for LoadCRL to map, SSL_SUCCESS on ok */
+int CyaSSL_CertManagerCompileCRL(CYASSL_CERT_MANAGER* cm, const char* in,
+                                 int type, const char* out)
 {
-    CYASSL_ENTER("CyaSSL_CertManagerSetCRL_Cb");
+    CYASSL_ENTER("CyaSSL_CertManagerCompileCRL");
     if (cm == NULL)
         return BAD_FUNC_ARG;
 
-    cm->cbMissingCRL = cb;
-
-    return SSL_SUCCESS;
+    return CompileCRL(cm, in, type, out);
 }
 
 
-int CyaSSL_CertManagerLoadCRL(CYASSL_CERT_MANAGER* cm, const char* path,
-                              int type, int monitor)
+/* map one CRL index written by CyaSSL_CertManagerCompileCRL, the index
+   carries no signature so only name files the application wrote itself;
+   the file is mapped again on each monitor reload, so recompiling it into
+   a monitored directory updates it */
+int CyaSSL_CertManagerLoadCRLIndex(CYASSL_CERT_MANAGER* cm, const char* file)
 {
-    CYASSL_ENTER("CyaSSL_CertManagerLoadCRL");
+    CYASSL_ENTER("CyaSSL_CertManagerLoadCRLIndex");
     if (cm == NULL)
         return BAD_FUNC_ARG;
 
@@ -2474,7 +3035,7 @@ int CyaSSL_CertManagerLoadCRL(CYASSL_CERT_MANAGER* cm, const char* path,
         }
     }
 
-    return LoadCRL(cm->crl, path, type, monitor);
+    return LoadCRL_Index(cm->crl, file);
 }
 
 
@@ -3094,6 +3655,7 @@ typedef struct {
     int rows;        /* session rows */
     int columns;     /* session columns */
     int sessionSz;   /* sizeof CYASSL_SESSION */
+    byte hashKey[SIPHASH_KEY_SIZE];   /* rows were picked with this key */
 } cache_header_t;
 
 /* current persistence layout is:
@@ -3110,10 +3672,10 @@ typedef struct {
 /* get how big the the session cache save buffer needs to be */
 int CyaSSL_get_session_cache_memsize(void)
 {
-    int sz  = (int)(sizeof(SessionCache) + sizeof(cache_header_t));
+    int sz  = (int)(SessionRows * sizeof(SessionRow) + sizeof(cache_header_t));
 
     #ifndef NO_CLIENT_CACHE
-        sz += (int)(sizeof(ClientCache));
+        sz += (int)(SessionRows * sizeof(ClientRow));
     #endif
 
     return sz;
@@ -3132,22 +3694,24 @@ int CyaSSL_memsave_session_cache(void* mem, int sz)
 
     CYASSL_ENTER("CyaSSL_memsave_session_cache");
 
+    if (LockSessionCache() != 0) {
+        CYASSL_MSG("Session cache mutex lock failed");
+        return BAD_MUTEX_E;
+    }
+
     if (sz < CyaSSL_get_session_cache_memsize()) {
         CYASSL_MSG("Memory buffer too small");
+        UnLockSessionCache();
         return BUFFER_E;
     }
 
     cache_header.version   = CYASSL_CACHE_VERSION;
-    cache_header.rows      = SESSION_ROWS;
+    cache_header.rows      = (int)SessionRows;
     cache_header.columns   = SESSIONS_PER_ROW;
     cache_header.sessionSz = (int)sizeof(CYASSL_SESSION);
+    XMEMCPY(cache_header.hashKey, SessionHashKey, SIPHASH_KEY_SIZE);
     XMEMCPY(mem, &cache_header, sizeof(cache_header));
 
-    if (LockMutex(&session_mutex) != 0) {
-        CYASSL_MSG("Session cache mutex lock failed");
-        return BAD_MUTEX_E;
-    }
-
     for (i = 0; i < cache_header.rows; ++i)
         XMEMCPY(row++, SessionCache + i, sizeof(SessionRow));
 
@@ -3157,7 +3721,7 @@ int CyaSSL_memsave_session_cache(void* mem, int sz)
         XMEMCPY(clRow++, ClientCache + i, sizeof(ClientRow));
 #endif
 
-    UnLockMutex(&session_mutex);
+    UnLockSessionCache();
 
     CYASSL_LEAVE("CyaSSL_memsave_session_cache", SSL_SUCCESS);
 
@@ -3177,25 +3741,29 @@ int CyaSSL_memrestore_session_cache(const void* mem, int sz)
 
     CYASSL_ENTER("CyaSSL_memrestore_session_cache");
 
+    if (LockSessionCache() != 0) {
+        CYASSL_MSG("Session cache mutex lock failed");
+        return BAD_MUTEX_E; 
+    }
+
     if (sz < CyaSSL_get_session_cache_memsize()) {
         CYASSL_MSG("Memory buffer too small");
+        UnLockSessionCache();
         return BUFFER_E;
     }
 
     XMEMCPY(&cache_header, mem, sizeof(cache_header));
     if (cache_header.version   != CYASSL_CACHE_VERSION ||
-        cache_header.rows      != SESSION_ROWS ||
+        cache_header.rows      != (int)SessionRows ||
         cache_header.columns   != SESSIONS_PER_ROW ||
         cache_header.sessionSz != (int)sizeof(CYASSL_SESSION)) {
 
         CYASSL_MSG("Session cache header match failed");
+        UnLockSessionCache();
         return CACHE_MATCH_ERROR;
     }
-
-    if (LockMutex(&session_mutex) != 0) {
-        CYASSL_MSG("Session cache mutex lock failed");
-        return BAD_MUTEX_E; 
-    }
+    XMEMCPY(SessionHashKey, cache_header.hashKey, SIPHASH_KEY_SIZE);
+    SessionHashKeySet = 1;
 
     for (i = 0; i < cache_header.rows; ++i)
         XMEMCPY(SessionCache + i, row++, sizeof(SessionRow));
@@ -3206,7 +3774,7 @@ int CyaSSL_memrestore_session_cache(const void* mem, int sz)
         XMEMCPY(ClientCache + i, clRow++, sizeof(ClientRow));
 #endif
 
-    UnLockMutex(&session_mutex);
+    UnLockSessionCache();
 
     CYASSL_LEAVE("CyaSSL_memrestore_session_cache", SSL_SUCCESS);
 
@@ -3232,25 +3800,28 @@ int CyaSSL_save_session_cache(const char *fname)
         CYASSL_MSG("Couldn't open session cache save file");
         return SSL_BAD_FILE;
     }
+
+    if (LockSessionCache() != 0) {
+        CYASSL_MSG("Session cache mutex lock failed");
+        XFCLOSE(file);
+        return BAD_MUTEX_E;
+    }
+
     cache_header.version   = CYASSL_CACHE_VERSION;
-    cache_header.rows      = SESSION_ROWS;
+    cache_header.rows      = (int)SessionRows;
     cache_header.columns   = SESSIONS_PER_ROW;
     cache_header.sessionSz = (int)sizeof(CYASSL_SESSION);
+    XMEMCPY(cache_header.hashKey, SessionHashKey, SIPHASH_KEY_SIZE);
 
     /* cache header */
     ret = (int)XFWRITE(&cache_header, sizeof cache_header, 1, file);
     if (ret != 1) {
         CYASSL_MSG("Session cache header file write failed");
+        UnLockSessionCache();
         XFCLOSE(file);
         return FWRITE_ERROR;
     }
 
-    if (LockMutex(&session_mutex) != 0) {
-        CYASSL_MSG("Session cache mutex lock failed");
-        XFCLOSE(file);
-        return BAD_MUTEX_E;
-    }
-
     /* session cache */
     for (i = 0; i < cache_header.rows; ++i) {
         ret = (int)XFWRITE(SessionCache + i, sizeof(SessionRow), 1, file);
@@ -3273,7 +3844,7 @@ int CyaSSL_save_session_cache(const char *fname)
     }
 #endif /* NO_CLIENT_CACHE */
 
-    UnLockMutex(&session_mutex);
+    UnLockSessionCache();
 
     XFCLOSE(file);
     CYASSL_LEAVE("CyaSSL_save_session_cache", rc);
@@ -3306,28 +3877,32 @@ int CyaSSL_restore_session_cache(const char *fname)
         XFCLOSE(file);
         return FREAD_ERROR;
     }
+
+    if (LockSessionCache() != 0) {
+        CYASSL_MSG("Session cache mutex lock failed");
+        XFCLOSE(file);
+        return BAD_MUTEX_E; 
+    }
+
     if (cache_header.version   != CYASSL_CACHE_VERSION ||
-        cache_header.rows      != SESSION_ROWS ||
+        cache_header.rows      != (int)SessionRows ||
         cache_header.columns   != SESSIONS_PER_ROW ||
         cache_header.sessionSz != (int)sizeof(CYASSL_SESSION)) {
 
         CYASSL_MSG("Session cache header match failed");
+        UnLockSessionCache();
         XFCLOSE(file);
         return CACHE_MATCH_ERROR;
     }
-
-    if (LockMutex(&session_mutex) != 0) {
-        CYASSL_MSG("Session cache mutex lock failed");
-        XFCLOSE(file);
-        return BAD_MUTEX_E; 
-    }
+    XMEMCPY(SessionHashKey, cache_header.hashKey, SIPHASH_KEY_SIZE);
+    SessionHashKeySet = 1;
 
     /* session cache */
     for (i = 0; i < cache_header.rows; ++i) {
         ret = (int)XFREAD(SessionCache + i, sizeof(SessionRow), 1, file);
         if (ret != 1) {
             CYASSL_MSG("Session cache member file read failed");
-            XMEMSET(SessionCache, 0, sizeof SessionCache);
+            XMEMSET(SessionCache, 0, SessionRows * sizeof(SessionRow));
             rc = FREAD_ERROR;
             break;
         }
@@ -3339,7 +3914,7 @@ int CyaSSL_restore_session_cache(const char *fname)
         ret = (int)XFREAD(ClientCache + i, sizeof(ClientRow), 1, file);
         if (ret != 1) {
             CYASSL_MSG("Client cache member file read failed");
-            XMEMSET(ClientCache, 0, sizeof ClientCache);
+            XMEMSET(ClientCache, 0, SessionRows * sizeof(ClientRow));
             rc = FREAD_ERROR;
             break;
         }
@@ -3347,7 +3922,7 @@ int CyaSSL_restore_session_cache(const char *fname)
 
 #endif /* NO_CLIENT_CACHE */
 
-    UnLockMutex(&session_mutex);
+    UnLockSessionCache();
 
     XFCLOSE(file);
     CYASSL_LEAVE("CyaSSL_restore_session_cache", rc);
@@ -3799,6 +4374,9 @@ int CM_MemRestoreCertCache(CYASSL_CERT_MANAGER* cm, const void* mem, int sz)
     }
 
     FreeSignerTable(cm->caTable, CA_TABLE_SIZE, cm->heap);
+    #ifndef NO_CERT_VERIFY_CACHE
+        FlushCertVerifyCache(cm);
+    #endif
 
     for (i = 0; i < CA_TABLE_SIZE; ++i) {
         int added = RestoreCertRow(cm, current, i, hdr->columns[i], end);
@@ -4066,18 +4644,7 @@ int CyaSSL_dtls_got_timeout(CYASSL* ssl)
             #ifdef CYASSL_DTLS
                 if (ssl->options.dtls) {
                     /* re-init hashes, exclude first hello and verify request */
-#ifndef NO_OLD_TLS
-                    InitMd5(&ssl->hashMd5);
-                    InitSha(&ssl->hashSha);
-#endif
-                    if (IsAtLeastTLSv1_2(ssl)) {
-                        #ifndef NO_SHA256
-                            InitSha256(&ssl->hashSha256);
-                        #endif
-                        #ifdef CYASSL_SHA384
-                            InitSha384(&ssl->hashSha384);
-                        #endif
-                    }
+                    InitHandshakeHashes(ssl);
                     if ( (ssl->error = SendClientHello(ssl)) != 0) {
                         CYASSL_ERROR(ssl->error);
                         return SSL_FATAL_ERROR;
@@ -4337,18 +4904,7 @@ int CyaSSL_dtls_got_timeout(CYASSL* ssl)
                 if (ssl->options.dtls) {
                     ssl->options.clientState = NULL_STATE;  /* get again */
                     /* re-init hashes, exclude first hello and verify request */
-#ifndef NO_OLD_TLS
-                    InitMd5(&ssl->hashMd5);
-                    InitSha(&ssl->hashSha);
-#endif
-                    if (IsAtLeastTLSv1_2(ssl)) {
-                        #ifndef NO_SHA256
-                             InitSha256(&ssl->hashSha256);
-                        #endif
-                        #ifdef CYASSL_SHA384
-                            InitSha384(&ssl->hashSha384);
-                        #endif
-                    }
+                    InitHandshakeHashes(ssl);
 
                     while (ssl->options.clientState < CLIENT_HELLO_COMPLETE)
                         if ( (ssl->error = ProcessReply(ssl)) < 0) {
@@ -4421,6 +4977,17 @@ int CyaSSL_dtls_got_timeout(CYASSL* ssl)
             CYASSL_MSG("accept state  ACCEPT_SECOND_REPLY_DONE");
           
         case ACCEPT_SECOND_REPLY_DONE : 
+            #ifdef HAVE_SESSION_TICKET
+                if (ssl->options.createTicket)
+                    if ( (ssl->error = SendTicket(ssl)) != 0) {
+                        CYASSL_ERROR(ssl->error);
+                        return SSL_FATAL_ERROR;
+                    }
+            #endif
+            ssl->options.acceptState = TICKET_SENT;
+            CYASSL_MSG("accept state  TICKET_SENT");
+
+        case TICKET_SENT:
             if ( (ssl->error = SendChangeCipher(ssl)) != 0) {
                 CYASSL_ERROR(ssl->error);
                 return SSL_FATAL_ERROR;
@@ -4487,6 +5054,22 @@ int CyaSSL_Cleanup(void)
         return ret;
 
 #ifndef NO_SESSION_CACHE
+    if (SessionCache != SessionCacheStatic) {
+        XFREE(SessionCache, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+        SessionCache = SessionCacheStatic;
+        #ifndef NO_CLIENT_CACHE
+            XFREE(ClientCache, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+            ClientCache = ClientCacheStatic;
+        #endif
+        SessionRows = SESSION_ROWS;
+    }
+    {
+        int i;
+        for (i = 0; i < SESSION_CACHE_STRIPES; i++) {
+            if (FreeMutex(&session_row_mutex[i]) != 0)
+                ret = BAD_MUTEX_E;
+        }
+    }
     if (FreeMutex(&session_mutex) != 0)
         ret = BAD_MUTEX_E;
 #endif
@@ -4495,6 +5078,7 @@ int CyaSSL_Cleanup(void)
 
 #if defined(HAVE_ECC) && defined(FP_ECC)
     ecc_fp_free();
+    ecc_fp_cleanup();
 #endif
 
     return ret;
@@ -4503,56 +5087,13 @@ int CyaSSL_Cleanup(void)
 
 #ifndef NO_SESSION_CACHE
 
-#ifndef NO_MD5
-
-/* some session IDs aren't random afterall, let's make them random */
-
-static INLINE word32 HashSession(const byte* sessionID, word32 len)
-{
-    byte digest[MD5_DIGEST_SIZE];
-    Md5  md5;
-
-    InitMd5(&md5);
-    Md5Update(&md5, sessionID, len);
-    Md5Final(&md5, digest);
-
-    return MakeWordFromHash(digest);
-}
-
-#elif !defined(NO_SHA)
-
+/* some session IDs aren't random afterall, and clients pick the server IDs,
+   so use the keyed hash to spread them over the rows */
 static INLINE word32 HashSession(const byte* sessionID, word32 len)
 {
-    byte digest[SHA_DIGEST_SIZE];
-    Sha  sha;
-
-    InitSha(&sha);
-    ShaUpdate(&sha, sessionID, len);
-    ShaFinal(&sha, digest);
-
-    return MakeWordFromHash(digest);
-}
-
-#elif !defined(NO_SHA256)
-
-static INLINE word32 HashSession(const byte* sessionID, word32 len)
-{
-    byte    digest[SHA256_DIGEST_SIZE];
-    Sha256  sha256;
-
-    InitSha256(&sha256);
-    Sha256Update(&sha256, sessionID, len);
-    Sha256Final(&sha256, digest);
-
-    return MakeWordFromHash(digest);
+    return HalfSipHash24(SessionHashKey, sessionID, len);
 }
 
-#else
-
-#error "We need a digest to hash the session IDs"
-
-#endif /* NO_MD5 */
-
 
 void CyaSSL_flush_sessions(CYASSL_CTX* ctx, long tm)
 {
@@ -4586,6 +5127,33 @@ int CyaSSL_CTX_set_timeout(CYASSL_CTX* ctx, unsigned int to)
 }
 
 
+/* lock the row stripe for hash and set row, the row count is re-checked
+   once the stripe is held since a resize holds every stripe */
+static INLINE int LockSessionRow(word32 hash, word32* row)
+{
+    for (;;) {
+        word32 rows = SessionRows;
+        word32 r    = hash % rows;
+
+        if (LockMutex(&session_row_mutex[r % SESSION_CACHE_STRIPES]) != 0)
+            return BAD_MUTEX_E;
+
+        if (rows == SessionRows) {
+            *row = r;
+            return 0;
+        }
+
+        UnLockMutex(&session_row_mutex[r % SESSION_CACHE_STRIPES]);
+    }
+}
+
+
+static INLINE void UnLockSessionRow(word32 row)
+{
+    UnLockMutex(&session_row_mutex[row % SESSION_CACHE_STRIPES]);
+}
+
+
 #ifndef NO_CLIENT_CACHE
 
 /* Get Session from Client cache based on id/len, return NULL on failure */
@@ -4602,13 +5170,15 @@ CYASSL_SESSION* GetSessionClient(CYASSL* ssl, const byte* id, int len)
         return NULL;
 
     len = min(SERVER_ID_LEN, (word32)len);
-    row = HashSession(id, len) % SESSION_ROWS;
 
+    /* session_mutex keeps the table from being resized under us */
     if (LockMutex(&session_mutex) != 0) {
         CYASSL_MSG("Lock session mutex failed");
         return NULL;
     }
  
+    row = HashSession(id, len) % SessionRows;
+
     /* start from most recently used */
     count = min((word32)ClientCache[row].totalCount, SESSIONS_PER_ROW);
     idx = ClientCache[row].nextIdx - 1;
@@ -4618,6 +5188,7 @@ CYASSL_SESSION* GetSessionClient(CYASSL* ssl, const byte* id, int len)
     for (; count > 0; --count, idx = idx ? idx - 1 : SESSIONS_PER_ROW - 1) {
         CYASSL_SESSION* current;
         ClientSession   clSess;
+        int             match;
 
         if (idx >= SESSIONS_PER_ROW || idx < 0) { /* sanity check */
             CYASSL_MSG("Bad idx");
@@ -4626,16 +5197,32 @@ CYASSL_SESSION* GetSessionClient(CYASSL* ssl, const byte* id, int len)
        
         clSess = ClientCache[row].Clients[idx];
 
+        if (clSess.serverRow >= SessionRows) {   /* sanity check */
+            CYASSL_MSG("Bad server row");
+            break;
+        }
+
+        if (LockMutex(&session_row_mutex[clSess.serverRow %
+                                         SESSION_CACHE_STRIPES]) != 0) {
+            CYASSL_MSG("Lock session row mutex failed");
+            break;
+        }
+
         current = &SessionCache[clSess.serverRow].Sessions[clSess.serverIdx];
-        if (XMEMCMP(current->serverID, id, len) == 0) {
+        match   = XMEMCMP(current->serverID, id, len) == 0;
+        if (match && LowResTimer() >= (current->bornOn + current->timeout))
+            match = -1;
+
+        UnLockSessionRow(clSess.serverRow);
+
+        if (match == 1) {
             CYASSL_MSG("Found a serverid match for client");
-            if (LowResTimer() < (current->bornOn + current->timeout)) {
-                CYASSL_MSG("Session valid");
-                ret = current;
-                break;
-            } else {
-                CYASSL_MSG("Session timed out");  /* could have more for id */
-            }
+            CYASSL_MSG("Session valid");
+            ret = current;
+            break;
+        } else if (match == -1) {
+            CYASSL_MSG("Found a serverid match for client");
+            CYASSL_MSG("Session timed out");  /* could have more for id */
         } else {
             CYASSL_MSG("ServerID not a match from client table");
         }
@@ -4668,9 +5255,7 @@ CYASSL_SESSION* GetSession(CYASSL* ssl, byte* masterSecret)
     else
         id = ssl->session.sessionID;
 
-    row = HashSession(id, ID_LEN) % SESSION_ROWS;
-
-    if (LockMutex(&session_mutex) != 0)
+    if (LockSessionRow(HashSession(id, ID_LEN), &row) != 0)
         return 0;
    
     /* start from most recently used */ 
@@ -4704,7 +5289,7 @@ CYASSL_SESSION* GetSession(CYASSL* ssl, byte* masterSecret)
         }   
     }
 
-    UnLockMutex(&session_mutex);
+    UnLockSessionRow(row);
     
     return ret;
 }
@@ -4734,6 +5319,9 @@ int SetSession(CYASSL* ssl, CYASSL_SESSION* session)
 int AddSession(CYASSL* ssl)
 {
     word32 row, idx;
+#ifndef NO_CLIENT_CACHE
+    int    addClient;
+#endif
 
     if (ssl->options.sessionCacheOff)
         return 0;
@@ -4741,10 +5329,20 @@ int AddSession(CYASSL* ssl)
     if (ssl->options.haveSessionId == 0)
         return 0;
 
-    row = HashSession(ssl->arrays->sessionID, ID_LEN) % SESSION_ROWS;
+#ifndef NO_CLIENT_CACHE
+    /* client entries point at server rows, hold session_mutex across both */
+    addClient = ssl->options.side == CYASSL_CLIENT_END && ssl->session.idLen;
+    if (addClient && LockMutex(&session_mutex) != 0)
+        return BAD_MUTEX_E;
+#endif
 
-    if (LockMutex(&session_mutex) != 0)
+    if (LockSessionRow(HashSession(ssl->arrays->sessionID, ID_LEN), &row) != 0){
+#ifndef NO_CLIENT_CACHE
+        if (addClient)
+            UnLockMutex(&session_mutex);
+#endif
         return BAD_MUTEX_E;
+    }
 
     idx = SessionCache[row].nextIdx++;
 #ifdef SESSION_INDEX
@@ -4774,17 +5372,25 @@ int AddSession(CYASSL* ssl)
         SessionCache[row].nextIdx = 0;
 
 #ifndef NO_CLIENT_CACHE
-    if (ssl->options.side == CYASSL_CLIENT_END && ssl->session.idLen) {
-        word32 clientRow, clientIdx;
-
-        CYASSL_MSG("Adding client cache entry");
-
+    if (addClient) {
         SessionCache[row].Sessions[idx].idLen = ssl->session.idLen;
         XMEMCPY(SessionCache[row].Sessions[idx].serverID, ssl->session.serverID,
                 ssl->session.idLen);
+    }
+    else
+        SessionCache[row].Sessions[idx].idLen = 0;
+#endif /* NO_CLIENT_CACHE */
+
+    UnLockSessionRow(row);
+
+#ifndef NO_CLIENT_CACHE
+    if (addClient) {
+        word32 clientRow, clientIdx;
+
+        CYASSL_MSG("Adding client cache entry");
 
         clientRow = HashSession(ssl->session.serverID, ssl->session.idLen)
-                                % SESSION_ROWS;
+                                % SessionRows;
         clientIdx = ClientCache[clientRow].nextIdx++;
 
         ClientCache[clientRow].Clients[clientIdx].serverRow = (word16)row;
@@ -4793,17 +5399,135 @@ int AddSession(CYASSL* ssl)
         ClientCache[clientRow].totalCount++;
         if (ClientCache[clientRow].nextIdx == SESSIONS_PER_ROW)
             ClientCache[clientRow].nextIdx = 0;
+
+        if (UnLockMutex(&session_mutex) != 0)
+            return BAD_MUTEX_E;
     }
-    else
-        SessionCache[row].Sessions[idx].idLen = 0;
 #endif /* NO_CLIENT_CACHE */
 
-    if (UnLockMutex(&session_mutex) != 0)
+    return 0;
+}
+
+
+#if defined(OPENSSL_EXTRA) || defined(GOAHEAD_WS)
+
+/* Replace the session cache with an empty one holding at least sz sessions,
+   sz <= 0 goes back to the compile time table. Cached sessions are dropped,
+   and pointers from GetSession() into the old table become invalid, so this
+   is meant for startup. Returns the previous size, 0 on failure */
+static long SessionCacheResize(long sz)
+{
+    SessionRow* rows     = SessionCacheStatic;
+    SessionRow* oldRows;
+#ifndef NO_CLIENT_CACHE
+    ClientRow*  clRows   = ClientCacheStatic;
+    ClientRow*  oldClRows;
+#endif
+    word32      rowCount = SESSION_ROWS;
+    long        prev;
+
+    if (sz > 0) {
+        if (sz > (long)MAX_SESSION_ROWS * SESSIONS_PER_ROW)
+            sz = (long)MAX_SESSION_ROWS * SESSIONS_PER_ROW;
+        rowCount = (word32)((sz + SESSIONS_PER_ROW - 1) / SESSIONS_PER_ROW);
+
+        rows = (SessionRow*)XMALLOC(rowCount * sizeof(SessionRow), NULL,
+                                    DYNAMIC_TYPE_SESSION_CACHE);
+        if (rows == NULL)
+            return 0;
+        XMEMSET(rows, 0, rowCount * sizeof(SessionRow));
+
+    #ifndef NO_CLIENT_CACHE
+        clRows = (ClientRow*)XMALLOC(rowCount * sizeof(ClientRow), NULL,
+                                     DYNAMIC_TYPE_SESSION_CACHE);
+        if (clRows == NULL) {
+            XFREE(rows, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+            return 0;
+        }
+        XMEMSET(clRows, 0, rowCount * sizeof(ClientRow));
+    #endif
+    }
+
+    if (LockSessionCache() != 0) {
+        if (rows != SessionCacheStatic) {
+            XFREE(rows, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+        #ifndef NO_CLIENT_CACHE
+            XFREE(clRows, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+        #endif
+        }
+        return 0;
+    }
+
+    prev    = (long)SessionRows * SESSIONS_PER_ROW;
+    oldRows = SessionCache;
+    if (rows == SessionCacheStatic)
+        XMEMSET(SessionCacheStatic, 0, sizeof(SessionCacheStatic));
+    SessionCache = rows;
+    SessionRows  = rowCount;
+#ifndef NO_CLIENT_CACHE
+    oldClRows = ClientCache;
+    if (clRows == ClientCacheStatic)
+        XMEMSET(ClientCacheStatic, 0, sizeof(ClientCacheStatic));
+    ClientCache = clRows;
+#endif
+
+    UnLockSessionCache();
+
+    if (oldRows != SessionCacheStatic)
+        XFREE(oldRows, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+#ifndef NO_CLIENT_CACHE
+    if (oldClRows != ClientCacheStatic)
+        XFREE(oldClRows, NULL, DYNAMIC_TYPE_SESSION_CACHE);
+#endif
+
+    return prev;
+}
+
+#endif /* OPENSSL_EXTRA || GOAHEAD_WS */
+
+
+#ifdef OPENSSL_EXTRA
+
+/* Count sessions held now and those evicted from full rows, a row keeps at
+   most SESSIONS_PER_ROW so anything else it has seen was overwritten */
+static int SessionCacheCounts(long* cached, long* evicted)
+{
+    word32 i;
+    int    stripe;
+
+    *cached  = 0;
+    *evicted = 0;
+
+    if (LockMutex(&session_mutex) != 0)
         return BAD_MUTEX_E;
 
+    for (stripe = 0; stripe < SESSION_CACHE_STRIPES; stripe++) {
+        if (LockMutex(&session_row_mutex[stripe]) != 0) {
+            UnLockMutex(&session_mutex);
+            return BAD_MUTEX_E;
+        }
+
+        for (i = stripe; i < SessionRows; i += SESSION_CACHE_STRIPES) {
+            long seen = SessionCache[i].totalCount;
+
+            if (seen > SESSIONS_PER_ROW) {
+                *cached  += SESSIONS_PER_ROW;
+                *evicted += seen - SESSIONS_PER_ROW;
+            }
+            else
+                *cached  += seen;
+        }
+
+        UnLockMutex(&session_row_mutex[stripe]);
+    }
+
+    UnLockMutex(&session_mutex);
+
     return 0;
 }
 
+#endif /* OPENSSL_EXTRA */
+
 
 #ifdef SESSION_INDEX
 
@@ -4828,11 +5552,19 @@ int CyaSSL_GetSessionAtIndex(int idx, CYASSL_SESSION* session)
         return BAD_MUTEX_E;
     }
 
-    if (row < SESSION_ROWS &&
-        col < (int)min(SessionCache[row].totalCount, SESSIONS_PER_ROW)) {
-        XMEMCPY(session,
-                 &SessionCache[row].Sessions[col], sizeof(CYASSL_SESSION));
-        result = SSL_SUCCESS;
+    if (row < (int)SessionRows) {
+        if (LockMutex(&session_row_mutex[row % SESSION_CACHE_STRIPES]) != 0) {
+            UnLockMutex(&session_mutex);
+            return BAD_MUTEX_E;
+        }
+
+        if (col < (int)min(SessionCache[row].totalCount, SESSIONS_PER_ROW)) {
+            XMEMCPY(session,
+                     &SessionCache[row].Sessions[col], sizeof(CYASSL_SESSION));
+            result = SSL_SUCCESS;
+        }
+
+        UnLockSessionRow(row);
     }
 
     if (UnLockMutex(&session_mutex) != 0)
@@ -4873,7 +5605,7 @@ CYASSL_X509_CHAIN* CyaSSL_SESSION_get_peer_chain(CYASSL_SESSION* session)
         double E;               /* expected freq */
         double chiSquare = 0;
         
-        for (i = 0; i < SESSION_ROWS; i++) {
+        for (i = 0; i < (int)SessionRows; i++) {
             totalSessionsSeen += SessionCache[i].totalCount;
 
             if (SessionCache[i].totalCount >= SESSIONS_PER_ROW)
@@ -4889,9 +5621,9 @@ CYASSL_X509_CHAIN* CyaSSL_SESSION_get_peer_chain(CYASSL_SESSION* session)
         printf("Total Sessions Seen = %d\n", totalSessionsSeen);
         printf("Total Sessions Now  = %d\n", totalSessionsNow);
 
-        E = (double)totalSessionsSeen / SESSION_ROWS;
+        E = (double)totalSessionsSeen / SessionRows;
 
-        for (i = 0; i < SESSION_ROWS; i++) {
+        for (i = 0; i < (int)SessionRows; i++) {
             double diff = SessionCache[i].totalCount - E;
             diff *= diff;                /* square    */
             diff /= E;                   /* normalize */
@@ -4899,16 +5631,16 @@ CYASSL_X509_CHAIN* CyaSSL_SESSION_get_peer_chain(CYASSL_SESSION* session)
             chiSquare += diff;
         }
         printf("  chi-square = %5.1f, d.f. = %d\n", chiSquare,
-                                                     SESSION_ROWS - 1);
-        if (SESSION_ROWS == 11)
+                                                 (int)SessionRows - 1);
+        if (SessionRows == 11)
             printf(" .05 p value =  18.3, chi-square should be less\n");
-        else if (SESSION_ROWS == 211)
+        else if (SessionRows == 211)
             printf(".05 p value  = 244.8, chi-square should be less\n");
-        else if (SESSION_ROWS == 5981)
+        else if (SessionRows == 5981)
             printf(".05 p value  = 6161.0, chi-square should be less\n");
-        else if (SESSION_ROWS == 3)
+        else if (SessionRows == 3)
             printf(".05 p value  =   6.0, chi-square should be less\n");
-        else if (SESSION_ROWS == 2861)
+        else if (SessionRows == 2861)
             printf(".05 p value  = 2985.5, chi-square should be less\n");
         printf("\n");
     }
@@ -5422,12 +6154,21 @@ int CyaSSL_set_compression(CYASSL* ssl)
     }
 
 
+    /* the session cache is shared by all CTXs, resizing drops its contents,
+       sz <= 0 restores the compile time size, returns the previous size */
     long CyaSSL_CTX_sess_set_cache_size(CYASSL_CTX* ctx, long sz)
     {
-        /* cache size fixed at compile time in CyaSSL */
-        (void)ctx;
+        CYASSL_ENTER("CyaSSL_CTX_sess_set_cache_size");
+
+        if (ctx == NULL)
+            return 0;
+
+    #ifndef NO_SESSION_CACHE
+        return SessionCacheResize(sz);
+    #else
         (void)sz;
         return 0;
+    #endif
     }
 
 
@@ -6951,9 +7692,7 @@ int CyaSSL_set_compression(CYASSL* ssl)
 
     void CyaSSL_CTX_set_default_read_ahead(CYASSL_CTX* ctx, int m)
     {
-        /* TODO: maybe? */
-        (void)ctx; 
-        (void)m; 
+        CyaSSL_CTX_set_read_ahead(ctx, m);
     }
 
 
@@ -6971,9 +7710,12 @@ int CyaSSL_set_compression(CYASSL* ssl)
 
     long CyaSSL_CTX_sess_get_cache_size(CYASSL_CTX* ctx)
     {
-        /* TODO: maybe? */
         (void)ctx; 
-        return (~0);
+    #ifndef NO_SESSION_CACHE
+        return (long)SessionRows * SESSIONS_PER_ROW;
+    #else
+        return 0;
+    #endif
     }
 
     unsigned long CyaSSL_ERR_get_error_line_data(const char** file, int* line,
@@ -8570,10 +9312,18 @@ CYASSL_X509* CyaSSL_X509_load_certificate_file(const char* fname, int format)
     }
 
 
+    /* sessions evicted because their cache row was full */
     long CyaSSL_CTX_sess_cache_full(CYASSL_CTX* ctx)
     {
+        long evicted = 0;
+    #ifndef NO_SESSION_CACHE
+        long cached;
+
+        if (SessionCacheCounts(&cached, &evicted) != 0)
+            evicted = 0;
+    #endif
         (void)ctx;
-        return 0;
+        return evicted;
     }
 
 
@@ -8591,10 +9341,18 @@ CYASSL_X509* CyaSSL_X509_load_certificate_file(const char* fname, int format)
     }
 
 
+    /* sessions currently in the cache */
     long CyaSSL_CTX_sess_number(CYASSL_CTX* ctx)
     {
+        long cached = 0;
+    #ifndef NO_SESSION_CACHE
+        long evicted;
+
+        if (SessionCacheCounts(&cached, &evicted) != 0)
+            cached = 0;
+    #endif
         (void)ctx;
-        return 0;
+        return cached;
     }
 
 
@@ -10717,6 +11475,27 @@ int CyaSSL_CTX_OCSP_set_override_url(CYASSL_CTX* ctx, const char* url)
 }
 
 
+/* max cert statuses the ctx OCSP cache keeps, 0 only shares in flight
+   lookups, returns SSL_SUCCESS on ok */
+int CyaSSL_CTX_OCSP_set_cache_size(CYASSL_CTX* ctx, int sz)
+{
+    CYASSL_ENTER("CyaSSL_CTX_OCSP_set_cache_size");
+#ifdef HAVE_OCSP
+    int ret;
+
+    if (ctx == NULL)
+        return BAD_FUNC_ARG;
+
+    ret = CyaSSL_OCSP_set_cache_size(&ctx->ocsp, sz);
+    return ret == 0 ? SSL_SUCCESS : ret;
+#else
+    (void)ctx;
+    (void)sz;
+    return NOT_COMPILED_IN;
+#endif
+}
+
+
 #ifndef NO_CERTS
 #ifdef  HAVE_PK_CALLBACKS
 
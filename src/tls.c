@@ -224,25 +224,26 @@ void BuildTlsFinished(CYASSL* ssl, Hashes* hashes, const byte* sender)
     byte        handshake_hash[HSHASH_SZ];
     word32      hashSz = FINISHED_SZ;
 
-#ifndef NO_OLD_TLS
-    Md5Final(&ssl->hashMd5, handshake_hash);
-    ShaFinal(&ssl->hashSha, &handshake_hash[MD5_DIGEST_SIZE]);
-#endif
-    
     if (IsAtLeastTLSv1_2(ssl)) {
 #ifndef NO_SHA256
         if (ssl->specs.mac_algorithm <= sha256_mac) {
-            Sha256Final(&ssl->hashSha256, handshake_hash);
+            Sha256Final(&ssl->hsHashes->hashSha256, handshake_hash);
             hashSz = SHA256_DIGEST_SIZE;
         }
 #endif
 #ifdef CYASSL_SHA384
         if (ssl->specs.mac_algorithm == sha384_mac) {
-            Sha384Final(&ssl->hashSha384, handshake_hash);
+            Sha384Final(&ssl->hsHashes->hashSha384, handshake_hash);
             hashSz = SHA384_DIGEST_SIZE;
         }
 #endif
     }
+#ifndef NO_OLD_TLS
+    else {
+        Md5Final(&ssl->hsHashes->hashMd5, handshake_hash);
+        ShaFinal(&ssl->hsHashes->hashSha, &handshake_hash[MD5_DIGEST_SIZE]);
+    }
+#endif
    
     if ( XSTRNCMP((const char*)sender, (const char*)client, SIZEOF_SENDER) == 0)
         side = tls_client;
@@ -387,6 +388,14 @@ static INLINE void c32toa(word32 u32, byte* c)
     c[3] =  u32 & 0xff;
 }
 
+#ifdef HAVE_SESSION_TICKET
+/* convert opaque to 32 bit integer */
+static INLINE void ato32(const byte* c, word32* u32)
+{
+    *u32 = (c[0] << 24) | (c[1] << 16) | (c[2] << 8) | c[3];
+}
+#endif
+
 
 static INLINE word32 GetSEQIncrement(CYASSL* ssl, int verify)
 {
@@ -489,22 +498,68 @@ int CyaSSL_SetTlsHmacInner(CYASSL* ssl, byte* inner, word32 sz, int content,
 }
 
 
-/* TLS type HMAC */
+/* TLS type HMAC, the connection's Hmac was keyed by SetRecordMacs and each
+   HmacFinal leaves it ready for the next record */
 void TLS_hmac(CYASSL* ssl, byte* digest, const byte* in, word32 sz,
               int content, int verify)
 {
-    Hmac hmac;
-    byte myInner[CYASSL_TLS_HMAC_INNER_SZ];
+    Hmac* hmac = verify ? ssl->decrypt.hmac : ssl->encrypt.hmac;
+    byte  myInner[CYASSL_TLS_HMAC_INNER_SZ];
     
     CyaSSL_SetTlsHmacInner(ssl, myInner, sz, content, verify);
 
-    HmacSetKey(&hmac, CyaSSL_GetHmacType(ssl), CyaSSL_GetMacSecret(ssl, verify),
-               ssl->specs.hash_size);
-    HmacUpdate(&hmac, myInner, sizeof(myInner));
-    HmacUpdate(&hmac, in, sz);                                /* content */
-    HmacFinal(&hmac, digest);
+    HmacUpdate(hmac, myInner, sizeof(myInner));
+    HmacUpdate(hmac, in, sz);                                 /* content */
+    HmacFinal(hmac, digest);
+}
+
+#ifdef BUILD_AES_CBC_HMAC
+
+/* TLS_hmac stitched with the AES-CBC record encryption, MACs sz bytes at in
+   into digest and encrypts encSz bytes in place from enc, which covers in,
+   the digest and the padding */
+int TLS_hmacAesCbcEncrypt(CYASSL* ssl, byte* digest, const byte* in,
+                          word32 sz, int content, byte* enc, word32 encSz)
+{
+    Hmac*  hmac = ssl->encrypt.hmac;
+    byte   myInner[CYASSL_TLS_HMAC_INNER_SZ];
+    word32 done;
+    int    ret;
+
+    CyaSSL_SetTlsHmacInner(ssl, myInner, sz, content, 0);
+
+    HmacUpdate(hmac, myInner, sizeof(myInner));
+    ret = HmacUpdateAesCbcEncrypt(hmac, in, sz, ssl->encrypt.aes, enc, &done);
+    HmacFinal(hmac, digest);        /* even on error, resets for next record */
+    if (ret != 0)
+        return ret;
+
+    /* the MAC and padding, plus whatever didn't fill a hash block */
+    return AesCbcEncrypt(ssl->encrypt.aes, enc + done, enc + done,
+                         encSz - done);
+}
+
+
+/* TLS_hmac of the peer's sz bytes at in, stitched with decrypting decSz
+   bytes of the record in place from dec, which covers in */
+int TLS_hmacAesCbcDecrypt(CYASSL* ssl, byte* digest, const byte* in,
+                          word32 sz, int content, byte* dec, word32 decSz)
+{
+    Hmac* hmac = ssl->decrypt.hmac;
+    byte  myInner[CYASSL_TLS_HMAC_INNER_SZ];
+    int   ret;
+
+    CyaSSL_SetTlsHmacInner(ssl, myInner, sz, content, 1);
+
+    HmacUpdate(hmac, myInner, sizeof(myInner));
+    ret = HmacUpdateAesCbcDecrypt(hmac, in, sz, ssl->decrypt.aes, dec, decSz);
+    HmacFinal(hmac, digest);        /* even on error, resets for next record */
+
+    return ret;
 }
 
+#endif /* BUILD_AES_CBC_HMAC */
+
 #ifdef HAVE_TLS_EXTENSIONS
 
 static int TLSX_Append(TLSX** list, TLSX_Type type)
@@ -1018,6 +1073,230 @@ static int TLSX_THM_Parse(CYASSL* ssl, byte* input, word16 length,
 
 #endif /* HAVE_TRUNCATED_HMAC */
 
+#if defined(HAVE_SESSION_TICKET) && !defined(NO_CYASSL_SERVER)
+
+/* Ticket layout, all sizes fixed:
+ *   key name | iv | state length | AES-128-CBC(state) | HMAC-SHA256(prior)
+ * state is version, cipher suite, master secret, born on and timeout,
+ * zero padded to TICKET_STATE_SZ. */
+
+/* encrypt the current session into ticket, MAX_TICKET_SZ bytes */
+int CreateTicket(CYASSL* ssl, byte* ticket)
+{
+    TicketKeys* keys  = &ssl->ctx->ticketKeys;
+    byte*       iv    = ticket + TICKET_NAME_SZ;
+    byte*       enc   = iv + AES_IV_SIZE + OPAQUE16_LEN;
+    byte*       mac   = enc + TICKET_STATE_SZ;
+    byte        state[TICKET_STATE_SZ];
+    word32      idx   = 0;
+    TicketKey   key;
+    Aes         aes;
+    Hmac        hmac;
+    int         ret;
+
+    if (LockMutex(&keys->mutex) != 0)
+        return BAD_MUTEX_E;
+    ret = keys->count ? 0 : SESSION_TICKET_E;
+    if (ret == 0)
+        key = keys->keys[0];
+    UnLockMutex(&keys->mutex);
+    if (ret != 0)
+        return ret;
+
+    XMEMSET(state, 0, sizeof(state));
+    state[idx++] = ssl->version.major;
+    state[idx++] = ssl->version.minor;
+    state[idx++] = ssl->options.cipherSuite0;
+    state[idx++] = ssl->options.cipherSuite;
+    XMEMCPY(state + idx, ssl->arrays->masterSecret, SECRET_LEN);
+    idx += SECRET_LEN;
+    /* a reissued ticket keeps the original lifetime */
+    c32toa(ssl->options.useTicket ? ssl->session.bornOn : LowResTimer(),
+                                                                  state + idx);
+    idx += sizeof(word32);
+    c32toa(ssl->timeout, state + idx);
+
+    XMEMCPY(ticket, key.name, TICKET_NAME_SZ);
+    RNG_GenerateBlock(ssl->rng, iv, AES_IV_SIZE);
+    c16toa(TICKET_STATE_SZ, iv + AES_IV_SIZE);
+
+    ret = AesSetKey(&aes, key.encKey, AES_128_KEY_SIZE, iv, AES_ENCRYPTION);
+    if (ret == 0)
+        ret = AesCbcEncrypt(&aes, enc, state, TICKET_STATE_SZ);
+    if (ret == 0)
+        ret = HmacSetKey(&hmac, SHA256, key.macKey, TICKET_MAC_SZ);
+    if (ret == 0) {
+        HmacUpdate(&hmac, ticket, MAX_TICKET_SZ - TICKET_MAC_SZ);
+        HmacFinal(&hmac, mac);
+    }
+
+    XMEMSET(state, 0, sizeof(state));
+    XMEMSET(&key,  0, sizeof(key));
+
+    return ret;
+}
+
+/* verify and decrypt a client's ticket, restore session state on success */
+static int DoClientTicket(CYASSL* ssl, const byte* input, word16 length,
+                                                Suites* suites, byte* retired)
+{
+    TicketKeys* keys  = &ssl->ctx->ticketKeys;
+    const byte* iv    = input + TICKET_NAME_SZ;
+    const byte* enc   = iv + AES_IV_SIZE + OPAQUE16_LEN;
+    const byte* mac   = enc + TICKET_STATE_SZ;
+    byte        state[TICKET_STATE_SZ];
+    byte        digest[TICKET_MAC_SZ];
+    word32      idx   = 0;
+    word32      bornOn;
+    word32      timeout;
+    word16      encSz;
+    word16      i;
+    int         found = -1;
+    TicketKey   key;
+    Aes         aes;
+    Hmac        hmac;
+    int         ret;
+
+    if (length != MAX_TICKET_SZ)
+        return BUFFER_ERROR;
+
+    ato16(iv + AES_IV_SIZE, &encSz);
+    if (encSz != TICKET_STATE_SZ)
+        return BUFFER_ERROR;
+
+    if (LockMutex(&keys->mutex) != 0)
+        return BAD_MUTEX_E;
+    for (i = 0; i < keys->count; i++)
+        if (XMEMCMP(input, keys->keys[i].name, TICKET_NAME_SZ) == 0) {
+            key   = keys->keys[i];
+            found = i;
+            break;
+        }
+    UnLockMutex(&keys->mutex);
+
+    if (found < 0) {
+        CYASSL_MSG("Ticket key name unknown");
+        return SESSION_TICKET_E;
+    }
+
+    ret = HmacSetKey(&hmac, SHA256, key.macKey, TICKET_MAC_SZ);
+    if (ret == 0) {
+        HmacUpdate(&hmac, input, MAX_TICKET_SZ - TICKET_MAC_SZ);
+        HmacFinal(&hmac, digest);
+        if (ConstantCompare(digest, mac, TICKET_MAC_SZ) != 0)
+            ret = VERIFY_MAC_ERROR;
+    }
+    if (ret == 0)
+        ret = AesSetKey(&aes, key.encKey, AES_128_KEY_SIZE, iv, AES_DECRYPTION);
+    if (ret == 0)
+        ret = AesCbcDecrypt(&aes, state, enc, TICKET_STATE_SZ);
+    XMEMSET(&key, 0, sizeof(key));
+    if (ret != 0)
+        return ret;
+
+    /* same protocol version */
+    if (state[idx] != ssl->version.major || state[idx + 1] !=
+                                                         ssl->version.minor) {
+        CYASSL_MSG("Ticket version mismatch");
+        ret = VERSION_ERROR;
+    }
+    idx += 2;
+
+    /* the original suite, still offered by the client and allowed by us */
+    if (ret == 0) {
+        int offered = 0;
+        int allowed = 0;
+
+        for (i = 0; i + 1 < suites->suiteSz; i += 2)
+            if (suites->suites[i]     == state[idx] &&
+                suites->suites[i + 1] == state[idx + 1])
+                offered = 1;
+
+        for (i = 0; i + 1 < ssl->suites->suiteSz; i += 2)
+            if (ssl->suites->suites[i]     == state[idx] &&
+                ssl->suites->suites[i + 1] == state[idx + 1])
+                allowed = 1;
+
+        if (!offered || !allowed) {
+            CYASSL_MSG("Ticket cipher suite not available");
+            ret = MATCH_SUITE_ERROR;
+        }
+    }
+    idx += 2;
+
+    ato32(state + idx + SECRET_LEN, &bornOn);
+    ato32(state + idx + SECRET_LEN + sizeof(word32), &timeout);
+
+    if (ret == 0 && LowResTimer() - bornOn > timeout) {
+        CYASSL_MSG("Ticket expired");
+        ret = SESSION_TICKET_E;
+    }
+
+    if (ret == 0) {
+        ssl->options.cipherSuite0 = state[idx - 2];
+        ssl->options.cipherSuite  = state[idx - 1];
+        XMEMCPY(ssl->arrays->masterSecret, state + idx, SECRET_LEN);
+        ssl->session.bornOn  = bornOn;
+        ssl->session.timeout = timeout;
+        *retired = found > 0;
+    }
+
+    XMEMSET(state, 0, sizeof(state));
+
+    return ret;
+}
+
+static int TLSX_SessionTicket_Parse(CYASSL* ssl, byte* input, word16 length,
+                                                byte isRequest, Suites* suites)
+{
+    byte retired = 0;
+    int  ret;
+
+    /* keys are only ever added, so a zero count means tickets are off */
+    if (!isRequest || ssl->ctx->ticketKeys.count == 0)
+        return 0;
+
+    if (length) {
+        ret = DoClientTicket(ssl, input, length, suites, &retired);
+
+        if (ret == 0) {
+            CYASSL_MSG("Resuming from session ticket");
+
+            /* echo a session id so the client can tell we're resuming */
+            if (!ssl->options.resuming)
+                RNG_GenerateBlock(ssl->rng, ssl->arrays->sessionID, ID_LEN);
+
+            ssl->options.resuming  = 1;
+            ssl->options.useTicket = 1;
+
+            if (!retired)
+                return 0;
+
+            CYASSL_MSG("Ticket used a retired key, issuing a fresh one");
+        }
+        else {
+            CYASSL_MSG("Session ticket rejected, not resuming from it");
+        }
+    }
+
+    if (!TLSX_Find(ssl->extensions, SESSION_TICKET))
+        if ((ret = TLSX_Append(&ssl->extensions, SESSION_TICKET)) != 0)
+            return ret;
+
+    TLSX_SetResponse(ssl, SESSION_TICKET);
+    ssl->options.createTicket = 1;
+
+    return 0;
+}
+
+#define STK_PARSE TLSX_SessionTicket_Parse
+
+#else
+
+#define STK_PARSE(a, b, c, d, e) 0
+
+#endif /* HAVE_SESSION_TICKET && !NO_CYASSL_SERVER */
+
 TLSX* TLSX_Find(TLSX* list, TLSX_Type type)
 {
     TLSX* extension = list;
@@ -1045,6 +1324,7 @@ void TLSX_FreeAll(TLSX* list)
                 break;
 
             case TRUNCATED_HMAC:
+            case SESSION_TICKET:
                 /* Nothing to do. */
                 break;
         }
@@ -1084,6 +1364,7 @@ static word16 TLSX_GetSize(TLSX* list, byte* semaphore, byte isRequest)
                     break;
 
                 case TRUNCATED_HMAC:
+                case SESSION_TICKET:
                     /* empty extension. */
                     break;
             }
@@ -1128,6 +1409,7 @@ static word16 TLSX_Write(TLSX* list, byte* output, byte* semaphore,
                     break;
 
                 case TRUNCATED_HMAC:
+                case SESSION_TICKET:
                     /* empty extension. */
                     break;
             }
@@ -1296,6 +1578,12 @@ int TLSX_Parse(CYASSL* ssl, byte* input, word16 length, byte isRequest,
                 ret = THM_PARSE(ssl, input + offset, size, isRequest);
                 break;
 
+            case SESSION_TICKET:
+                CYASSL_MSG("Session Ticket extension received");
+
+                ret = STK_PARSE(ssl, input + offset, size, isRequest, suites);
+                break;
+
             case HELLO_EXT_SIG_ALGO:
                 if (isRequest) {
                     /* do not mess with offset inside the switch! */
@@ -29,6 +29,15 @@
 #include <cyassl/ssl.h>
 #include <cyassl/test.h>
 #include <tests/unit.h>
+#ifdef HAVE_CRL
+    #include <sys/stat.h>   /* mkdir for the CRL path test */
+#endif
+#ifdef HAVE_CRL_MONITOR
+    #include <unistd.h>     /* usleep while the monitor reloads */
+#endif
+#if defined(ATOMIC_USER) && defined(HAVE_AESGCM)
+    #include <cyassl/ctaocrypt/aes.h>   /* seals the HelloRequest record */
+#endif
 
 #define TEST_FAIL       (-1)
 #define TEST_SUCCESS    (0)
@@ -56,6 +65,39 @@ static void test_CyaSSL_UseMaxFragment(void);
 #ifdef HAVE_TRUNCATED_HMAC
 static void test_CyaSSL_UseTruncatedHMAC(void);
 #endif /* HAVE_TRUNCATED_HMAC */
+#if defined(HAVE_SESSION_TICKET) && !defined(NO_CYASSL_SERVER)
+static void test_CyaSSL_CTX_UseSessionTicket(void);
+#endif
+#if defined(OPENSSL_EXTRA) && !defined(NO_SESSION_CACHE)
+static void test_CyaSSL_CTX_sess_set_cache_size(void);
+#endif
+#if !defined(NO_FILESYSTEM) && !defined(NO_CERTS) && !defined(NO_RSA)
+static void test_CyaSSL_set_read_ahead(void);
+static void test_CyaSSL_read_write_zc(void);
+static void test_CyaSSL_write_coalesce(void);
+static void test_CyaSSL_write_zc_commit_blocked(void);
+static void test_CyaSSL_CTX_set_buffer_pool(void);
+static void test_CyaSSL_CTX_decoded_PrivateKey(void);
+static void test_CyaSSL_handshake_hashes(void);
+#if defined(ATOMIC_USER) && defined(HAVE_AESGCM)
+static void test_CyaSSL_HelloRequest_aead(void);
+#endif
+#endif
+#if defined(HAVE_CRL) && !defined(NO_FILESYSTEM) && !defined(NO_RSA)
+static void test_CyaSSL_CertManagerLoadCRLBuffer(void);
+static void test_CyaSSL_CertManagerCompileCRL(void);
+static void test_CyaSSL_CertManagerCRLIndexTrust(void);
+#ifdef HAVE_CRL_MONITOR
+static void test_CyaSSL_CertManagerCRLIndexMonitor(void);
+#endif
+#endif
+#if !defined(NO_FILESYSTEM) && !defined(NO_CERTS) && !defined(NO_RSA) && \
+    !defined(NO_SHA256) && !defined(NO_CERT_VERIFY_CACHE)
+static void test_CyaSSL_CertManagerVerifyCache(void);
+#endif
+#ifdef HAVE_OCSP
+static void test_CyaSSL_CTX_OCSP_set_cache_size(void);
+#endif
 
 /* test function helpers */
 static int test_method(CYASSL_METHOD *method, const char *name);
@@ -116,6 +158,39 @@ int ApiTest(void)
 #ifdef HAVE_TRUNCATED_HMAC
     test_CyaSSL_UseTruncatedHMAC();
 #endif /* HAVE_TRUNCATED_HMAC */
+#if defined(HAVE_SESSION_TICKET) && !defined(NO_CYASSL_SERVER)
+    test_CyaSSL_CTX_UseSessionTicket();
+#endif
+#if defined(OPENSSL_EXTRA) && !defined(NO_SESSION_CACHE)
+    test_CyaSSL_CTX_sess_set_cache_size();
+#endif
+#if !defined(NO_FILESYSTEM) && !defined(NO_CERTS) && !defined(NO_RSA)
+    test_CyaSSL_set_read_ahead();
+    test_CyaSSL_read_write_zc();
+    test_CyaSSL_write_coalesce();
+    test_CyaSSL_write_zc_commit_blocked();
+    test_CyaSSL_CTX_set_buffer_pool();
+    test_CyaSSL_CTX_decoded_PrivateKey();
+    test_CyaSSL_handshake_hashes();
+#if defined(ATOMIC_USER) && defined(HAVE_AESGCM)
+    test_CyaSSL_HelloRequest_aead();
+#endif
+#endif
+#if defined(HAVE_CRL) && !defined(NO_FILESYSTEM) && !defined(NO_RSA)
+    test_CyaSSL_CertManagerLoadCRLBuffer();
+    test_CyaSSL_CertManagerCompileCRL();
+    test_CyaSSL_CertManagerCRLIndexTrust();
+#ifdef HAVE_CRL_MONITOR
+    test_CyaSSL_CertManagerCRLIndexMonitor();
+#endif
+#endif
+#if !defined(NO_FILESYSTEM) && !defined(NO_CERTS) && !defined(NO_RSA) && \
+    !defined(NO_SHA256) && !defined(NO_CERT_VERIFY_CACHE)
+    test_CyaSSL_CertManagerVerifyCache();
+#endif
+#ifdef HAVE_OCSP
+    test_CyaSSL_CTX_OCSP_set_cache_size();
+#endif
     test_CyaSSL_Cleanup();
     printf(" End API Tests\n");
 
@@ -449,8 +524,929 @@ static void test_CyaSSL_UseTruncatedHMAC(void)
 }
 #endif /* HAVE_TRUNCATED_HMAC */
 
+#if defined(HAVE_SESSION_TICKET) && !defined(NO_CYASSL_SERVER)
+static void test_CyaSSL_CTX_UseSessionTicket(void)
+{
+    CYASSL_CTX   *ctx = CyaSSL_CTX_new(CyaSSLv23_server_method());
+    unsigned char key[CYASSL_TICKET_KEY_SZ];
+    int           i;
+
+    AssertNotNull(ctx);
+
+    for (i = 0; i < CYASSL_TICKET_KEY_SZ; i++)
+        key[i] = (unsigned char) i;
+
+    /* error cases */
+    AssertIntNE(0, CyaSSL_CTX_UseSessionTicket(NULL));
+    AssertIntNE(0, CyaSSL_CTX_AddSessionTicketKey(NULL, key, sizeof(key)));
+    AssertIntNE(0, CyaSSL_CTX_AddSessionTicketKey(ctx, NULL, sizeof(key)));
+    AssertIntNE(0, CyaSSL_CTX_AddSessionTicketKey(ctx, key, sizeof(key) - 1));
+
+    /* success cases, rotating past the key ring size */
+    AssertIntEQ(0, CyaSSL_CTX_UseSessionTicket(ctx));
+    for (i = 0; i < 4; i++) {
+        key[0] = (unsigned char) i;
+        AssertIntEQ(0, CyaSSL_CTX_AddSessionTicketKey(ctx, key, sizeof(key)));
+    }
+    AssertIntEQ(0, CyaSSL_CTX_UseSessionTicket(ctx));
+
+    CyaSSL_CTX_free(ctx);
+}
+#endif /* HAVE_SESSION_TICKET && !NO_CYASSL_SERVER */
+
 #endif /* HAVE_TLS_EXTENSIONS */
 
+#if defined(OPENSSL_EXTRA) && !defined(NO_SESSION_CACHE)
+static void test_CyaSSL_CTX_sess_set_cache_size(void)
+{
+    CYASSL_CTX *ctx = CyaSSL_CTX_new(CyaSSLv23_server_method());
+    long        defaultSz;
+
+    AssertNotNull(ctx);
+
+    defaultSz = CyaSSL_CTX_sess_get_cache_size(ctx);
+    AssertIntGT(defaultSz, 0);
+
+    /* error case */
+    AssertIntEQ(0, CyaSSL_CTX_sess_set_cache_size(NULL, 100));
+
+    /* grow, returns previous size and starts out empty */
+    AssertIntEQ(defaultSz, CyaSSL_CTX_sess_set_cache_size(ctx, 1000));
+    AssertIntGE(CyaSSL_CTX_sess_get_cache_size(ctx), 1000);
+    AssertIntEQ(0, CyaSSL_CTX_sess_number(ctx));
+    AssertIntEQ(0, CyaSSL_CTX_sess_cache_full(ctx));
+
+    /* back to compile time size */
+    AssertIntGE(CyaSSL_CTX_sess_set_cache_size(ctx, 0), 1000);
+    AssertIntEQ(defaultSz, CyaSSL_CTX_sess_get_cache_size(ctx));
+
+    CyaSSL_CTX_free(ctx);
+}
+#endif /* OPENSSL_EXTRA && !NO_SESSION_CACHE */
+
+#if !defined(NO_FILESYSTEM) && !defined(NO_CERTS) && !defined(NO_RSA)
+static unsigned int serverRecvCalls;
+
+static void use_read_ahead_at_ctx(CYASSL_CTX* ctx)
+{
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_set_read_ahead(ctx, 1));
+}
+
+static void count_server_recv_calls(CYASSL* ssl)
+{
+    unsigned int sendCalls = 0;
+
+    AssertIntEQ(SSL_SUCCESS,
+                CyaSSL_get_io_calls(ssl, &serverRecvCalls, &sendCalls));
+    AssertIntGT(serverRecvCalls, 0);
+    AssertIntGT(sendCalls, 0);
+}
+
+static void verify_read_ahead(CYASSL* ssl)
+{
+    AssertIntEQ(1, CyaSSL_get_read_ahead(ssl));
+}
+
+static void test_CyaSSL_set_read_ahead(void)
+{
+    callback_functions client_callbacks = {CyaSSLv23_client_method, 0, 0, 0};
+    callback_functions server_callbacks = {CyaSSLv23_server_method, 0, 0, 0};
+    unsigned int       plainRecvCalls;
+
+    CYASSL_CTX *ctx = CyaSSL_CTX_new(CyaSSLv23_client_method());
+    CYASSL     *ssl;
+
+    AssertNotNull(ctx);
+
+    /* error cases */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CTX_set_read_ahead(NULL, 1));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_set_read_ahead(NULL, 1));
+    AssertIntLT(CyaSSL_get_read_ahead(NULL), 0);
+    AssertIntNE(SSL_SUCCESS, CyaSSL_get_io_calls(NULL, NULL, NULL));
+
+    /* off by default, ssl inherits from ctx, ssl setting overrides */
+    ssl = CyaSSL_new(ctx);
+    AssertNotNull(ssl);
+    AssertIntEQ(0, CyaSSL_get_read_ahead(ssl));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_set_read_ahead(ssl, 1));
+    AssertIntEQ(1, CyaSSL_get_read_ahead(ssl));
+    CyaSSL_free(ssl);
+
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_set_read_ahead(ctx, 1));
+    ssl = CyaSSL_new(ctx);
+    AssertNotNull(ssl);
+    AssertIntEQ(1, CyaSSL_get_read_ahead(ssl));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_set_read_ahead(ssl, 0));
+    AssertIntEQ(0, CyaSSL_get_read_ahead(ssl));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_get_io_calls(ssl, NULL, NULL));
+    CyaSSL_free(ssl);
+
+    CyaSSL_CTX_free(ctx);
+
+    /* baseline without read ahead */
+    server_callbacks.on_result = count_server_recv_calls;
+
+    test_CyaSSL_client_server(&client_callbacks, &server_callbacks);
+    plainRecvCalls = serverRecvCalls;
+
+    /* both sides reading ahead, server needs no more recv() calls */
+    client_callbacks.ctx_ready = server_callbacks.ctx_ready =
+                                                         use_read_ahead_at_ctx;
+    client_callbacks.on_result = verify_read_ahead;
+
+    test_CyaSSL_client_server(&client_callbacks, &server_callbacks);
+    AssertIntLE(serverRecvCalls, plainRecvCalls);
+}
+
+/* in memory transport so one thread can drive both ends */
+typedef struct {
+    byte buf[8 * 1024 * 10];
+    int  len;
+    int  max;     /* would block past this many bytes, 0 for all of buf */
+    int  sends;   /* send callback calls */
+} mem_pipe;
+
+static int mem_pipe_recv(CYASSL* ssl, char* buf, int sz, void* ctx)
+{
+    mem_pipe* pipe = (mem_pipe*)ctx;
+
+    (void)ssl;
+
+    if (pipe->len == 0)
+        return CYASSL_CBIO_ERR_WANT_READ;
+
+    if (sz > pipe->len)
+        sz = pipe->len;
+
+    XMEMCPY(buf, pipe->buf, sz);
+    XMEMMOVE(pipe->buf, pipe->buf + sz, pipe->len - sz);
+    pipe->len -= sz;
+
+    return sz;
+}
+
+static int mem_pipe_send(CYASSL* ssl, char* buf, int sz, void* ctx)
+{
+    mem_pipe* pipe = (mem_pipe*)ctx;
+    int       max  = pipe->max ? pipe->max : (int)sizeof(pipe->buf);
+
+    (void)ssl;
+
+    pipe->sends++;
+    if (sz > max - pipe->len)
+        sz = max - pipe->len;
+
+    if (sz == 0)
+        return CYASSL_CBIO_ERR_WANT_WRITE;
+
+    XMEMCPY(pipe->buf + pipe->len, buf, sz);
+    pipe->len += sz;
+
+    return sz;
+}
+
+static mem_pipe toServer, toClient;
+
+/* client and server ctx on the in memory transport, 0 if suite isn't built */
+static int mem_pipe_ctx_pair_ex(CYASSL_CTX** cliCtx, CYASSL_CTX** svrCtx,
+                                const char* suite, CYASSL_METHOD* cliMethod,
+                                CYASSL_METHOD* svrMethod)
+{
+    AssertNotNull(*cliCtx = CyaSSL_CTX_new(cliMethod));
+    AssertNotNull(*svrCtx = CyaSSL_CTX_new(svrMethod));
+
+    if (CyaSSL_CTX_set_cipher_list(*svrCtx, suite) != SSL_SUCCESS) {
+        CyaSSL_CTX_free(*cliCtx);
+        CyaSSL_CTX_free(*svrCtx);
+        return 0;
+    }
+
+    CyaSSL_CTX_set_verify(*cliCtx, SSL_VERIFY_NONE, 0);
+    AssertIntEQ(SSL_SUCCESS,
+            CyaSSL_CTX_use_certificate_file(*svrCtx, svrCert, SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS,
+             CyaSSL_CTX_use_PrivateKey_file(*svrCtx, svrKey, SSL_FILETYPE_PEM));
+    CyaSSL_SetIORecv(*cliCtx, mem_pipe_recv);
+    CyaSSL_SetIOSend(*cliCtx, mem_pipe_send);
+    CyaSSL_SetIORecv(*svrCtx, mem_pipe_recv);
+    CyaSSL_SetIOSend(*svrCtx, mem_pipe_send);
+
+    return 1;
+}
+
+static int mem_pipe_ctx_pair(CYASSL_CTX** cliCtx, CYASSL_CTX** svrCtx,
+                             const char* suite)
+{
+    return mem_pipe_ctx_pair_ex(cliCtx, svrCtx, suite,
+                      CyaTLSv1_2_client_method(), CyaTLSv1_2_server_method());
+}
+
+/* new client and server joined by the pipes, handshake done */
+static void mem_pipe_connect(CYASSL_CTX* cliCtx, CYASSL_CTX* svrCtx,
+                             CYASSL** cli, CYASSL** svr)
+{
+    int cliDone = 0, svrDone = 0;
+    int i;
+
+    XMEMSET(&toServer, 0, sizeof(toServer));
+    XMEMSET(&toClient, 0, sizeof(toClient));
+    AssertNotNull(*cli = CyaSSL_new(cliCtx));
+    AssertNotNull(*svr = CyaSSL_new(svrCtx));
+    CyaSSL_SetIOReadCtx(*cli, &toClient);
+    CyaSSL_SetIOWriteCtx(*cli, &toServer);
+    CyaSSL_SetIOReadCtx(*svr, &toServer);
+    CyaSSL_SetIOWriteCtx(*svr, &toClient);
+
+    for (i = 0; i < 100 && !(cliDone && svrDone); i++) {
+        if (!cliDone)
+            cliDone = CyaSSL_connect(*cli) == SSL_SUCCESS;
+        if (!svrDone)
+            svrDone = CyaSSL_accept(*svr) == SSL_SUCCESS;
+    }
+    AssertTrue(cliDone && svrDone);
+}
+
+static void test_CyaSSL_read_write_zc(void)
+{
+    static const char* suites[] = { "AES128-SHA", "AES128-GCM-SHA256",
+                                     "AES128-CCM-8", "RC4-SHA" };
+    byte                 msg[3000];
+    const unsigned char* data;
+    unsigned char*       room;
+    int                  i, j, got, ret;
+
+    /* error cases */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_read_zc(NULL, &data));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_read_zc_release(NULL, 0));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_write_zc_reserve(NULL, &room));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_write_zc_commit(NULL, 0));
+
+    for (i = 0; i < (int)sizeof(msg); i++)
+        msg[i] = (byte)i;
+
+    for (i = 0; i < (int)(sizeof(suites) / sizeof(suites[0])); i++) {
+        CYASSL_CTX* cliCtx;
+        CYASSL_CTX* svrCtx;
+        CYASSL*     cli;
+        CYASSL*     svr;
+
+        if (!mem_pipe_ctx_pair(&cliCtx, &svrCtx, suites[i]))
+            continue;   /* suite not built in */
+
+        mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+
+        /* two records, the second sealed where the caller wrote it */
+        AssertIntEQ(sizeof(msg), CyaSSL_write(cli, msg, sizeof(msg)));
+        AssertIntGE(CyaSSL_write_zc_reserve(cli, &room), (int)sizeof(msg));
+        XMEMCPY(room, msg, sizeof(msg));
+        AssertIntEQ(sizeof(msg), CyaSSL_write_zc_commit(cli, sizeof(msg)));
+        AssertIntEQ(SSL_FATAL_ERROR, CyaSSL_write_zc_commit(cli, 1));
+
+        /* read back in place, partly released in between */
+        for (got = 0; got < 2 * (int)sizeof(msg); ) {
+            AssertIntGT(ret = CyaSSL_read_zc(svr, &data), 0);
+            AssertNotNull(data);
+            if (ret > 100)
+                ret = 100 + got % 7;
+            for (j = 0; j < ret; j++)
+                AssertIntEQ(msg[(got + j) % sizeof(msg)], data[j]);
+            AssertIntNE(SSL_SUCCESS,
+                   CyaSSL_read_zc_release(svr, CyaSSL_pending(svr) + 1));
+            AssertIntEQ(SSL_SUCCESS, CyaSSL_read_zc_release(svr, ret));
+            got += ret;
+        }
+        AssertIntEQ(0, CyaSSL_pending(svr));
+
+        /* nothing left, would block */
+        AssertIntEQ(SSL_FATAL_ERROR, CyaSSL_read_zc(svr, &data));
+        AssertIntEQ(SSL_ERROR_WANT_READ, CyaSSL_get_error(svr, 0));
+        AssertNull(data);
+
+        CyaSSL_free(cli);
+        CyaSSL_free(svr);
+        CyaSSL_CTX_free(cliCtx);
+        CyaSSL_CTX_free(svrCtx);
+    }
+}
+
+/* read what the server has, checking it against big from offset got */
+static int mem_pipe_drain(CYASSL* svr, const byte* big, int got)
+{
+    static byte reply[16384];
+    int         ret, j;
+
+    while ((ret = CyaSSL_read(svr, reply, sizeof(reply))) > 0) {
+        for (j = 0; j < ret; j++)
+            AssertIntEQ(big[got + j], reply[j]);
+        got += ret;
+    }
+    AssertIntEQ(SSL_ERROR_WANT_READ, CyaSSL_get_error(svr, ret));
+
+    return got;
+}
+
+/* a write of several records goes out in one send, and one that would block
+   picks up where it left off when retried */
+static void test_CyaSSL_write_coalesce(void)
+{
+    static byte big[3 * 16384 + 100];
+    CYASSL_CTX* cliCtx;
+    CYASSL_CTX* svrCtx;
+    CYASSL*     cli;
+    CYASSL*     svr;
+    int         i, ret, got;
+
+    for (i = 0; i < (int)sizeof(big); i++)
+        big[i] = (byte)(i * 7);
+
+    AssertTrue(mem_pipe_ctx_pair(&cliCtx, &svrCtx, "AES128-SHA"));
+    mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+
+    toServer.sends = 0;
+    AssertIntEQ(sizeof(big), CyaSSL_write(cli, big, sizeof(big)));
+#ifndef STATIC_CHUNKS_ONLY
+    AssertIntEQ(1, toServer.sends);
+#endif
+    AssertIntEQ(sizeof(big), mem_pipe_drain(svr, big, 0));
+
+    /* room for about one record at a time */
+    toServer.max = 20000;
+    ret = CyaSSL_write(cli, big, sizeof(big));
+    AssertIntEQ(SSL_FATAL_ERROR, ret);
+    AssertIntEQ(SSL_ERROR_WANT_WRITE, CyaSSL_get_error(cli, ret));
+
+    got = 0;
+    for (i = 0; i < 100 && got < (int)sizeof(big); i++) {
+        got = mem_pipe_drain(svr, big, got);
+        if (ret != (int)sizeof(big)) {
+            ret = CyaSSL_write(cli, big, sizeof(big));
+            if (ret < 0)
+                AssertIntEQ(SSL_ERROR_WANT_WRITE, CyaSSL_get_error(cli, ret));
+        }
+    }
+    AssertIntEQ(sizeof(big), ret);
+    AssertIntEQ(sizeof(big), got);
+
+    CyaSSL_free(cli);
+    CyaSSL_free(svr);
+    CyaSSL_CTX_free(cliCtx);
+    CyaSSL_CTX_free(svrCtx);
+}
+
+/* a commit that would block stays queued, the next write sends it first and
+   then all of its own data */
+static void test_CyaSSL_write_zc_commit_blocked(void)
+{
+    static byte    big[3 * 16384 + 100];
+    CYASSL_CTX*    cliCtx;
+    CYASSL_CTX*    svrCtx;
+    CYASSL*        cli;
+    CYASSL*        svr;
+    unsigned char* room;
+    int            i, ret, got;
+
+    for (i = 0; i < (int)sizeof(big); i++)
+        big[i] = (byte)(i * 7);
+
+    AssertTrue(mem_pipe_ctx_pair(&cliCtx, &svrCtx, "AES128-SHA"));
+    mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+
+    /* a big write resumed after blocking leaves its offsets behind */
+    toServer.max = 20000;
+    got = 0;
+    ret = SSL_FATAL_ERROR;
+    for (i = 0; i < 100 && ret != (int)sizeof(big); i++) {
+        ret = CyaSSL_write(cli, big, sizeof(big));
+        got = mem_pipe_drain(svr, big, got);
+    }
+    AssertIntEQ(sizeof(big), ret);
+    got = mem_pipe_drain(svr, big, got);
+    AssertIntEQ(sizeof(big), got);
+
+    /* fill the pipe so the committed record can't go out */
+    toServer.max = toServer.len + 100;
+    AssertIntGE(CyaSSL_write_zc_reserve(cli, &room), 3000);
+    XMEMCPY(room, big, 3000);
+    AssertIntEQ(3000, CyaSSL_write_zc_commit(cli, 3000));
+
+    /* the write goes out after the queued record, none of it skipped */
+    toServer.max = 0;
+    AssertIntEQ(3000, CyaSSL_write(cli, big + 3000, 3000));
+    AssertIntEQ(6000, mem_pipe_drain(svr, big, 0));
+
+    CyaSSL_free(cli);
+    CyaSSL_free(svr);
+    CyaSSL_CTX_free(cliCtx);
+    CyaSSL_CTX_free(svrCtx);
+}
+
+static void test_CyaSSL_CTX_set_buffer_pool(void)
+{
+    CYASSL_CTX*  cliCtx;
+    CYASSL_CTX*  svrCtx;
+    CYASSL*      cli;
+    CYASSL*      svr;
+    char         msg[] = "pooled";
+    char         reply[sizeof(msg)];
+    unsigned int inUse, freeCount, highWater;
+
+    /* error cases */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CTX_set_buffer_pool(NULL, 1));
+    AssertIntNE(SSL_SUCCESS,
+                CyaSSL_CTX_get_buffer_pool_stats(NULL, NULL, NULL, NULL));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_release_buffers(NULL));
+
+    AssertTrue(mem_pipe_ctx_pair(&cliCtx, &svrCtx, "AES128-SHA"));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CTX_set_buffer_pool(svrCtx, -1));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_set_buffer_pool(svrCtx, 4));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_set_read_ahead(svrCtx, 1));
+
+    mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+
+    AssertIntEQ(sizeof(msg), CyaSSL_write(cli, msg, sizeof(msg)));
+    AssertIntEQ(sizeof(msg), CyaSSL_read(svr, reply, sizeof(reply)));
+    AssertStrEQ(msg, reply);
+
+    /* read ahead holds on to its buffer until told the connection is idle */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_get_buffer_pool_stats(svrCtx, &inUse,
+                                                    &freeCount, &highWater));
+    AssertIntEQ(1, inUse);
+    AssertIntGE(highWater, 1);
+
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_release_buffers(svr));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_get_buffer_pool_stats(svrCtx, &inUse,
+                                                    &freeCount, NULL));
+    AssertIntEQ(0, inUse);
+    AssertIntGE(freeCount, 1);
+    AssertIntLE(freeCount, 4);
+
+    /* next record borrows it back */
+    AssertIntEQ(sizeof(msg), CyaSSL_write(cli, msg, sizeof(msg)));
+    AssertIntEQ(sizeof(msg), CyaSSL_read(svr, reply, sizeof(reply)));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_get_buffer_pool_stats(svrCtx, &inUse,
+                                                    NULL, &highWater));
+    AssertIntEQ(1, inUse);
+    AssertIntLE(highWater, 4);
+
+    /* turning the pool off frees what it kept */
+    CyaSSL_free(svr);
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_set_buffer_pool(svrCtx, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_get_buffer_pool_stats(svrCtx, &inUse,
+                                                    &freeCount, NULL));
+    AssertIntEQ(0, inUse);
+    AssertIntEQ(0, freeCount);
+
+    CyaSSL_free(cli);
+    CyaSSL_CTX_free(cliCtx);
+    CyaSSL_CTX_free(svrCtx);
+}
+
+/* connections share the key the ctx decoded at load time, reloading the ctx
+   key replaces it */
+static void test_CyaSSL_CTX_decoded_PrivateKey(void)
+{
+    CYASSL_CTX* cliCtx;
+    CYASSL_CTX* svrCtx;
+    CYASSL*     cli;
+    CYASSL*     svr;
+    char        msg[] = "shared key";
+    char        reply[sizeof(msg)];
+    int         i;
+
+    AssertTrue(mem_pipe_ctx_pair(&cliCtx, &svrCtx, "AES128-SHA"));
+
+    for (i = 0; i < 3; i++) {
+        if (i == 2)
+            AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_use_PrivateKey_file(svrCtx,
+                                                    svrKey, SSL_FILETYPE_PEM));
+        mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+        AssertIntEQ(sizeof(msg), CyaSSL_write(cli, msg, sizeof(msg)));
+        AssertIntEQ(sizeof(msg), CyaSSL_read(svr, reply, sizeof(reply)));
+        AssertStrEQ(msg, reply);
+        CyaSSL_free(cli);
+        CyaSSL_free(svr);
+    }
+
+    CyaSSL_CTX_free(cliCtx);
+    CyaSSL_CTX_free(svrCtx);
+}
+
+/* the transcript is only hashed once the suite picks its hashes, so the
+   Finished and CertificateVerify hashes have to come out right for each
+   PRF hash and for versions before TLS 1.2, with and without client auth */
+static void test_CyaSSL_handshake_hashes(void)
+{
+    static const struct {
+        const char* suite;
+        int         tls12;      /* 0 for TLS 1.0 */
+    } cases[] = {
+        { "AES128-SHA256",           1 },
+        { "AES256-GCM-SHA384",       1 },
+        { "ECDHE-RSA-AES256-SHA384", 1 },
+        { "AES128-SHA",              1 },
+        { "AES128-SHA",              0 },
+    };
+    char msg[] = "transcript";
+    char reply[sizeof(msg)];
+    int  i, clientAuth;
+
+    for (i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        for (clientAuth = 0; clientAuth < 2; clientAuth++) {
+            CYASSL_CTX* cliCtx;
+            CYASSL_CTX* svrCtx;
+            CYASSL*     cli;
+            CYASSL*     svr;
+            int         built;
+
+            if (cases[i].tls12)
+                built = mem_pipe_ctx_pair(&cliCtx, &svrCtx, cases[i].suite);
+            else {
+            #ifndef NO_OLD_TLS
+                built = mem_pipe_ctx_pair_ex(&cliCtx, &svrCtx, cases[i].suite,
+                          CyaTLSv1_client_method(), CyaTLSv1_server_method());
+            #else
+                built = 0;
+            #endif
+            }
+            if (!built)
+                continue;   /* suite or version not built in */
+
+            if (clientAuth) {
+                CyaSSL_CTX_set_verify(svrCtx, SSL_VERIFY_PEER |
+                                      SSL_VERIFY_FAIL_IF_NO_PEER_CERT, 0);
+                AssertIntEQ(SSL_SUCCESS,
+                        CyaSSL_CTX_load_verify_locations(svrCtx, cliCert, 0));
+                AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_use_certificate_file(
+                                         cliCtx, cliCert, SSL_FILETYPE_PEM));
+                AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_use_PrivateKey_file(
+                                         cliCtx, cliKey, SSL_FILETYPE_PEM));
+            }
+
+            mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+            AssertStrEQ(cases[i].tls12 ? "TLSv1.2" : "TLSv1",
+                        CyaSSL_get_version(svr));
+            AssertIntEQ(sizeof(msg), CyaSSL_write(cli, msg, sizeof(msg)));
+            AssertIntEQ(sizeof(msg), CyaSSL_read(svr, reply, sizeof(reply)));
+            AssertStrEQ(msg, reply);
+
+            CyaSSL_free(cli);
+            CyaSSL_free(svr);
+            CyaSSL_CTX_free(cliCtx);
+            CyaSSL_CTX_free(svrCtx);
+        }
+    }
+}
+
+#if defined(ATOMIC_USER) && defined(HAVE_AESGCM)
+/* AEAD suites have no record Hmac, a HelloRequest from the server is only
+   checked by its tag, the client turns it down and the connection goes on */
+static void test_CyaSSL_HelloRequest_aead(void)
+{
+    static const byte helloRequest[4] = { 0, 0, 0, 0 };
+    byte        rec[5 + 8 + sizeof(helloRequest) + 16];
+    byte        aad[13];
+    byte        nonce[12];
+    Aes         aes;
+    CYASSL_CTX* cliCtx;
+    CYASSL_CTX* svrCtx;
+    CYASSL*     cli;
+    CYASSL*     svr;
+    char        msg[] = "no renegotiation";
+    char        reply[sizeof(msg)];
+
+    if (!mem_pipe_ctx_pair(&cliCtx, &svrCtx, "AES128-GCM-SHA256"))
+        return;     /* suite not built in */
+    mem_pipe_connect(cliCtx, svrCtx, &cli, &svr);
+
+    /* seal it as the server's next record, its Finished was sequence 0 */
+    XMEMSET(aad, 0, sizeof(aad));
+    aad[7]  = 1;
+    aad[8]  = 22;                       /* handshake */
+    aad[9]  = 3;
+    aad[10] = 3;
+    aad[12] = sizeof(helloRequest);
+
+    XMEMCPY(nonce, CyaSSL_GetServerWriteIV(svr), 4);
+    XMEMSET(nonce + 4, 0x5a, 8);        /* explicit part, sent in the clear */
+
+    rec[0] = 22;
+    rec[1] = 3;
+    rec[2] = 3;
+    rec[3] = 0;
+    rec[4] = sizeof(rec) - 5;
+    XMEMCPY(rec + 5, nonce + 4, 8);
+    AesGcmSetKey(&aes, CyaSSL_GetServerWriteKey(svr), CyaSSL_GetKeySize(svr));
+    AesGcmEncrypt(&aes, rec + 13, helloRequest, sizeof(helloRequest),
+                  nonce, sizeof(nonce), rec + 13 + sizeof(helloRequest), 16,
+                  aad, sizeof(aad));
+
+    XMEMCPY(toClient.buf + toClient.len, rec, sizeof(rec));
+    toClient.len += sizeof(rec);
+
+    /* no_renegotiation warning goes back, nothing for the caller to read */
+    AssertIntEQ(SSL_FATAL_ERROR, CyaSSL_read(cli, reply, sizeof(reply)));
+    AssertIntEQ(SSL_ERROR_WANT_READ, CyaSSL_get_error(cli, 0));
+    AssertIntGT(toServer.len, 0);
+
+    AssertIntEQ(sizeof(msg), CyaSSL_write(cli, msg, sizeof(msg)));
+    AssertIntEQ(sizeof(msg), CyaSSL_read(svr, reply, sizeof(reply)));
+    AssertStrEQ(msg, reply);
+
+    CyaSSL_free(cli);
+    CyaSSL_free(svr);
+    CyaSSL_CTX_free(cliCtx);
+    CyaSSL_CTX_free(svrCtx);
+}
+#endif /* ATOMIC_USER && HAVE_AESGCM */
+#endif /* !NO_FILESYSTEM && !NO_CERTS && !NO_RSA */
+
+#if defined(HAVE_CRL) && !defined(NO_FILESYSTEM) && !defined(NO_RSA)
+static void test_CyaSSL_CertManagerLoadCRLBuffer(void)
+{
+    CYASSL_CERT_MANAGER* cm;
+    unsigned char        revoked[4096];
+    unsigned char        clean[4096];
+    long                 revokedSz;
+    long                 cleanSz;
+    FILE*                file;
+    const char*          eccRsaCert = "./certs/server-ecc-rsa.pem";
+
+    AssertNotNull(file = fopen("./certs/crl/crl.revoked", "rb"));
+    revokedSz = (long)fread(revoked, 1, sizeof(revoked), file);
+    fclose(file);
+    AssertNotNull(file = fopen("./certs/crl/crl.pem", "rb"));
+    cleanSz = (long)fread(clean, 1, sizeof(clean), file);
+    fclose(file);
+
+    AssertNotNull(cm = CyaSSL_CertManagerNew());
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerEnableCRL(cm, 0));
+
+    /* no CRL for the issuer yet */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, eccRsaCert,
+                                                            SSL_FILETYPE_PEM));
+
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLBuffer(NULL, revoked,
+                                                revokedSz, SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLBuffer(cm, revoked,
+                                                revokedSz, SSL_FILETYPE_PEM));
+
+    /* serial 02 is on the list, 09 from the same CA isn't */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+#ifdef HAVE_ECC
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, eccRsaCert,
+                                                            SSL_FILETYPE_PEM));
+#endif
+
+    /* a later CRL from the same issuer takes over */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLBuffer(cm, clean,
+                                                cleanSz, SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    CyaSSL_CertManagerFree(cm);
+}
+
+
+static void test_CyaSSL_CertManagerCompileCRL(void)
+{
+    CYASSL_CERT_MANAGER* cm;
+    const char*          revokedIdx = "./crl-revoked-test.crlx";
+    const char*          cleanIdx   = "./crl-clean-test.crlx";
+
+    AssertNotNull(cm = CyaSSL_CertManagerNew());
+
+    /* compiling verifies the signature, so no CA no index */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(NULL,
+                    "./certs/crl/crl.pem", SSL_FILETYPE_PEM, cleanIdx));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                    "./certs/crl/crl.pem", SSL_FILETYPE_PEM, cleanIdx));
+
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                    "./certs/crl/crl.pem", SSL_FILETYPE_PEM, cleanIdx));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                    "./certs/crl/crl.revoked", SSL_FILETYPE_PEM, revokedIdx));
+    CyaSSL_CertManagerFree(cm);
+
+    AssertNotNull(cm = CyaSSL_CertManagerNew());
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerEnableCRL(cm, 0));
+
+    /* only index files map */
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm,
+                                                    "./certs/crl/crl.pem"));
+
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, cleanIdx));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, revokedIdx));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    CyaSSL_CertManagerFree(cm);
+    remove(cleanIdx);
+    remove(revokedIdx);
+}
+
+
+/* write the header of index from with count records, recs of them, 0 on ok */
+static int write_crl_index(const char* from, const char* to, const byte* recs,
+                           int count)
+{
+    byte  hdr[128];
+    FILE* file;
+
+    AssertNotNull(file = fopen(from, "rb"));
+    AssertIntEQ(1, (int)fread(hdr, sizeof(hdr), 1, file));
+    fclose(file);
+
+    hdr[8 + 20 + 32 + 32 + 4 + 3] = (byte)count;   /* low count byte */
+
+    AssertNotNull(file = fopen(to, "wb"));
+    AssertIntEQ(1, (int)fwrite(hdr, sizeof(hdr), 1, file));
+    AssertIntEQ(count, (int)fwrite(recs, 33, count, file));
+    fclose(file);
+
+    return 0;
+}
+
+
+/* indexes aren't signed, a CRL directory scan must not pick them up and a
+   named one must hold sane, sorted records */
+static void test_CyaSSL_CertManagerCRLIndexTrust(void)
+{
+    CYASSL_CERT_MANAGER* cm;
+    const char*          dir      = "./crlx-dir-test";
+    const char*          cleanIdx = "./crlx-dir-test/clean.crlx";
+    const char*          badIdx   = "./crl-bad-test.crlx";
+    byte                 recs[2 * 33];
+    FILE*                file;
+
+    /* left behind by a run that died half way */
+    remove(cleanIdx);
+    remove(badIdx);
+    rmdir(dir);
+
+    AssertIntEQ(0, mkdir(dir, 0700));
+    AssertNotNull(cm = CyaSSL_CertManagerNew());
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                    "./certs/crl/crl.pem", SSL_FILETYPE_PEM, cleanIdx));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                    "./certs/crl/crl.revoked", SSL_FILETYPE_PEM, badIdx));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerEnableCRL(cm, 0));
+
+    /* the scan skips the index, so there is still no CRL for the issuer */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRL(cm, dir,
+                                                        SSL_FILETYPE_PEM, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRL(cm, dir,
+                                                        SSL_FILETYPE_ASN1, 0));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    /* named, it loads */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, cleanIdx));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    /* the revoked list's one record, out of order after a smaller copy */
+    AssertNotNull(file = fopen(badIdx, "rb"));
+    AssertIntEQ(0, fseek(file, 128, SEEK_SET));
+    AssertIntEQ(1, (int)fread(recs, 33, 1, file));
+    fclose(file);
+    XMEMCPY(recs + 33, recs, 33);
+    recs[33 + 1]--;
+    AssertIntEQ(0, write_crl_index(badIdx, badIdx, recs, 2));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, badIdx));
+
+    /* duplicates aren't ascending either */
+    recs[33 + 1]++;
+    AssertIntEQ(0, write_crl_index(badIdx, badIdx, recs, 2));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, badIdx));
+
+    /* a serial longer than a record holds */
+    recs[0] = 0xFF;
+    AssertIntEQ(0, write_crl_index(badIdx, badIdx, recs, 1));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, badIdx));
+
+    /* none of those replaced the good one */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    CyaSSL_CertManagerFree(cm);
+    remove(cleanIdx);
+    remove(badIdx);
+    rmdir(dir);
+}
+
+#ifdef HAVE_CRL_MONITOR
+/* a named index is mapped again on monitor reloads, so recompiling it into
+   the watched directory is the whole update */
+static void test_CyaSSL_CertManagerCRLIndexMonitor(void)
+{
+    CYASSL_CERT_MANAGER* cm;
+    const char*          dir = "./crlx-mon-test";
+    const char*          idx = "./crlx-mon-test/ca.crlx";
+    int                  i;
+
+    remove(idx);
+    rmdir(dir);
+
+    AssertIntEQ(0, mkdir(dir, 0700));
+    AssertNotNull(cm = CyaSSL_CertManagerNew());
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                        "./certs/crl/crl.revoked", SSL_FILETYPE_PEM, idx));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerEnableCRL(cm, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRL(cm, dir,
+                SSL_FILETYPE_PEM, CYASSL_CRL_MONITOR | CYASSL_CRL_START_MON));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCRLIndex(cm, idx));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+
+    /* a reload that lost the index would leave no CRL and still fail, the
+       monitor may not be watching yet so compile again now and then */
+    for (i = 0; i < 100; i++) {
+        if (i % 10 == 0)
+            AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerCompileCRL(cm,
+                            "./certs/crl/crl.pem", SSL_FILETYPE_PEM, idx));
+        if (CyaSSL_CertManagerVerify(cm, svrCert, SSL_FILETYPE_PEM)
+                                                               == SSL_SUCCESS)
+            break;
+        usleep(50000);
+    }
+    AssertIntLT(i, 100);
+
+    usleep(200000);     /* let the monitor finish reloads still queued */
+    CyaSSL_CertManagerFree(cm);
+    remove(idx);
+    rmdir(dir);
+}
+#endif /* HAVE_CRL_MONITOR */
+#endif /* HAVE_CRL && !NO_FILESYSTEM && !NO_RSA */
+
+#if !defined(NO_FILESYSTEM) && !defined(NO_CERTS) && !defined(NO_RSA) && \
+    !defined(NO_SHA256) && !defined(NO_CERT_VERIFY_CACHE)
+static void test_CyaSSL_CertManagerVerifyCache(void)
+{
+    CYASSL_CERT_MANAGER* cm;
+    unsigned long        hits;
+    unsigned long        misses;
+
+    AssertNotNull(cm = CyaSSL_CertManagerNew());
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerGetVerifyCacheStats(NULL,
+                                                             &hits, &misses));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+
+    /* first check does the signature, the repeat is answered from cache */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerGetVerifyCacheStats(cm,
+                                                             &hits, &misses));
+    AssertIntEQ(0, (int)hits);
+    AssertIntEQ(1, (int)misses);
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerGetVerifyCacheStats(cm,
+                                                             &hits, &misses));
+    AssertIntEQ(1, (int)hits);
+    AssertIntEQ(1, (int)misses);
+
+    /* unloading the CAs forgets what they verified */
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerUnloadCAs(cm));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerLoadCA(cm, caCert, 0));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerVerify(cm, svrCert,
+                                                            SSL_FILETYPE_PEM));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CertManagerGetVerifyCacheStats(cm,
+                                                             &hits, &misses));
+    AssertIntEQ(1, (int)hits);
+    AssertIntEQ(2, (int)misses);
+
+    CyaSSL_CertManagerFree(cm);
+}
+#endif
+
+#ifdef HAVE_OCSP
+static void test_CyaSSL_CTX_OCSP_set_cache_size(void)
+{
+    CYASSL_CTX* ctx;
+
+    AssertNotNull(ctx = CyaSSL_CTX_new(CyaSSLv23_client_method()));
+
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CTX_OCSP_set_cache_size(NULL, 16));
+    AssertIntNE(SSL_SUCCESS, CyaSSL_CTX_OCSP_set_cache_size(ctx, -1));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_OCSP_set_cache_size(ctx, 16));
+    AssertIntEQ(SSL_SUCCESS, CyaSSL_CTX_OCSP_set_cache_size(ctx, 0));
+
+    CyaSSL_CTX_free(ctx);
+}
+#endif /* HAVE_OCSP */
+
 #if !defined(NO_FILESYSTEM) && !defined(NO_CERTS)
 /* Helper for testing CyaSSL_CTX_use_certificate_file() */
 int test_ucf(CYASSL_CTX *ctx, const char* file, int type, int cond,